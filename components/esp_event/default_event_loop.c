@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2018-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2018-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -76,6 +76,27 @@ esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
                              event_data, event_data_size, ticks_to_wait);
 }
 
+esp_err_t esp_event_post_batch(const esp_event_batch_item_t* events, size_t count, TickType_t ticks_to_wait)
+{
+    if (s_default_loop == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return esp_event_post_batch_to(s_default_loop, events, count, ticks_to_wait);
+}
+
+esp_err_t esp_event_post_ref(esp_event_base_t event_base, int32_t event_id,
+                             void* event_data, esp_event_data_release_t release, void* release_arg,
+                             TickType_t ticks_to_wait)
+{
+    if (s_default_loop == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return esp_event_post_ref_to(s_default_loop, event_base, event_id,
+                                 event_data, release, release_arg, ticks_to_wait);
+}
+
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
 esp_err_t esp_event_isr_post(esp_event_base_t event_base, int32_t event_id,
                              const void* event_data, size_t event_data_size, BaseType_t* task_unblocked)
@@ -100,7 +121,9 @@ esp_err_t esp_event_loop_create_default(void)
         .task_name = "sys_evt",
         .task_stack_size = ESP_TASKD_EVENT_STACK,
         .task_priority = ESP_TASKD_EVENT_PRIO,
-        .task_core_id = 0
+        .task_core_id = 0,
+        .payload_pool_size = CONFIG_ESP_EVENT_DEFAULT_LOOP_PAYLOAD_POOL_SIZE,
+        .payload_pool_buffer_size = CONFIG_ESP_EVENT_DEFAULT_LOOP_PAYLOAD_BUFFER_SIZE,
     };
 
     esp_err_t err;
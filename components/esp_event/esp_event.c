@@ -39,6 +39,7 @@
 static const char* TAG = "event";
 static const char* esp_event_any_base = "any";
 static const char* esp_event_handler_cleanup = "cleanup";
+static const char* esp_event_batch = "batch";
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
 static SLIST_HEAD(esp_event_loop_instance_list_t, esp_event_loop_instance) s_event_loops =
@@ -93,6 +94,103 @@ static int esp_event_dump_prepare(void)
 
     return size;
 }
+
+static void time_histogram_add(esp_event_time_histogram_t* histogram, int64_t duration)
+{
+    uint32_t us = (duration <= 0) ? 0 : (duration >= UINT32_MAX ? UINT32_MAX : (uint32_t) duration);
+    uint32_t bucket = (us == 0) ? 0 : 32 - __builtin_clz(us);
+
+    if (bucket >= ESP_EVENT_TIME_HISTOGRAM_BUCKETS) {
+        bucket = ESP_EVENT_TIME_HISTOGRAM_BUCKETS - 1;
+    }
+
+    histogram->buckets[bucket]++;
+    if (us > histogram->max) {
+        histogram->max = us;
+    }
+}
+
+// Returns the upper bound of the bucket holding the given percentile, but not more than the longest duration
+static uint32_t time_histogram_percentile(const esp_event_time_histogram_t* histogram, uint32_t percent)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < ESP_EVENT_TIME_HISTOGRAM_BUCKETS; i++) {
+        total += histogram->buckets[i];
+    }
+
+    uint64_t rank = (total * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < ESP_EVENT_TIME_HISTOGRAM_BUCKETS - 1; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = (1UL << i) - 1;
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+static void time_stats_get(esp_event_time_stats_t* stats, const esp_event_time_histogram_t* histogram)
+{
+    stats->p50 = time_histogram_percentile(histogram, 50);
+    stats->p99 = time_histogram_percentile(histogram, 99);
+    stats->max = histogram->max;
+}
+
+static void queue_depth_update_max(atomic_uint_least32_t* depth_max, uint32_t depth)
+{
+    uint_least32_t current = atomic_load(depth_max);
+    while (depth > current && !atomic_compare_exchange_weak(depth_max, &current, depth)) {
+    }
+}
+
+// Returns the profiling data slot of the event, NULL if all slots are taken by other events
+static esp_event_stats_t* loop_event_stats(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id)
+{
+    const size_t slots = CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS;
+    size_t slot = ((uint32_t)(uintptr_t) base ^ ((uint32_t) id * 0x9e3779b1u)) % slots;
+
+    for (size_t i = 0; i < slots; i++) {
+        esp_event_stats_t* stats = &(loop->event_stats[slot]);
+        if (stats->base == NULL) {
+            stats->base = base;
+            stats->id = id;
+            return stats;
+        }
+        if (stats->base == base && stats->id == id) {
+            return stats;
+        }
+        slot = (slot + 1) % slots;
+    }
+
+    return NULL;
+}
+
+static void handler_profile_add(esp_event_handler_profile_t* profiles, size_t capacity, size_t* count,
+                                esp_event_handler_node_t* handler, esp_event_base_t base, int32_t id)
+{
+    if (handler->unregistered) {
+        return;
+    }
+
+    if (profiles != NULL) {
+        if (*count >= capacity) {
+            return;
+        }
+
+        esp_event_handler_profile_t* profile = &profiles[*count];
+        profile->handler = handler->handler_ctx->handler;
+        profile->handler_arg = handler->handler_ctx->arg;
+        profile->event_base = (base == esp_event_any_base) ? ESP_EVENT_ANY_BASE : base;
+        profile->event_id = id;
+        profile->invoked = handler->invoked;
+        profile->total_time = handler->time;
+        time_stats_get(&(profile->exec_time), &(handler->exec_time));
+    }
+
+    (*count)++;
+}
 #endif
 
 static void esp_event_loop_run_task(void* args)
@@ -143,9 +241,154 @@ static void handler_execute(esp_event_loop_instance_t* loop, esp_event_handler_n
 
     handler->invoked++;
     handler->time += diff;
+    time_histogram_add(&(handler->exec_time), diff);
 #endif
 }
 
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+
+static inline void handler_collect(esp_event_handler_node_t* handler, esp_event_handler_node_t** handlers, size_t* count)
+{
+    if (!handler->unregistered) {
+        if (handlers) {
+            handlers[*count] = handler;
+        }
+        (*count)++;
+    }
+}
+
+// Walks the lists of the loop the same way esp_event_loop_run does without the dispatch table, storing the handlers
+// to be executed for the event to handlers unless it is NULL. Returns the number of handlers.
+static size_t loop_collect_handlers(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id, esp_event_handler_node_t** handlers)
+{
+    esp_event_handler_node_t *handler;
+    esp_event_loop_node_t *loop_node;
+    esp_event_base_node_t *base_node;
+    esp_event_id_node_t *id_node;
+    size_t count = 0;
+
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(handler, &(loop_node->handlers), next) {
+            handler_collect(handler, handlers, &count);
+        }
+
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            if (base_node->base == base) {
+                SLIST_FOREACH(handler, &(base_node->handlers), next) {
+                    handler_collect(handler, handlers, &count);
+                }
+
+                SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                    if (id_node->id == id) {
+                        SLIST_FOREACH(handler, &(id_node->handlers), next) {
+                            handler_collect(handler, handlers, &count);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static inline void dispatch_table_invalidate(esp_event_loop_instance_t* loop)
+{
+    loop->dispatch_table.generation++;
+}
+
+static inline size_t dispatch_table_slot(const esp_event_dispatch_table_t* table, esp_event_base_t base, int32_t id)
+{
+    uint32_t hash = ((uint32_t)(uintptr_t) base ^ ((uint32_t) id * 0x9e3779b1u)) * 0x9e3779b1u;
+    return (hash ^ (hash >> 16)) & (table->capacity - 1);
+}
+
+static void dispatch_table_clear(esp_event_dispatch_table_t* table)
+{
+    for (size_t i = 0; i < table->capacity; i++) {
+        free(table->entries[i].handlers);
+    }
+    memset(table->entries, 0, table->capacity * sizeof(*table->entries));
+    table->count = 0;
+}
+
+static void dispatch_table_delete(esp_event_dispatch_table_t* table)
+{
+    if (table->entries) {
+        dispatch_table_clear(table);
+        free(table->entries);
+        table->entries = NULL;
+        table->capacity = 0;
+    }
+}
+
+// Returns the entry of the table holding the handlers to be executed for the event, resolving them again if
+// handlers have been added or removed since. Returns NULL if memory runs out, the caller walks the lists then.
+static esp_event_dispatch_entry_t* dispatch_table_resolve(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id)
+{
+    esp_event_dispatch_table_t* table = &(loop->dispatch_table);
+
+    if (table->entries == NULL) {
+        size_t capacity = 1;
+        // keep at least half of the slots free so that probe sequences stay short
+        while (capacity < 2 * CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE_SIZE) {
+            capacity <<= 1;
+        }
+
+        table->entries = calloc(capacity, sizeof(*table->entries));
+        if (table->entries == NULL) {
+            return NULL;
+        }
+        table->capacity = capacity;
+    }
+
+    size_t slot = dispatch_table_slot(table, base, id);
+    esp_event_dispatch_entry_t* entry = &(table->entries[slot]);
+
+    while (entry->base != NULL) {
+        if (entry->base == base && entry->id == id) {
+            if (entry->generation == table->generation) {
+                return entry;
+            }
+            break;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+        entry = &(table->entries[slot]);
+    }
+
+    if (entry->base == NULL && table->count >= CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE_SIZE) {
+        dispatch_table_clear(table);
+        entry = &(table->entries[dispatch_table_slot(table, base, id)]);
+    }
+
+    esp_event_handler_node_t** handlers = NULL;
+    size_t handlers_count = loop_collect_handlers(loop, base, id, NULL);
+
+    if (handlers_count > 0) {
+        handlers = malloc(handlers_count * sizeof(*handlers));
+        if (handlers == NULL) {
+            return NULL;
+        }
+        loop_collect_handlers(loop, base, id, handlers);
+    }
+
+    if (entry->base == NULL) {
+        table->count++;
+    }
+
+    free(entry->handlers);
+    entry->base = base;
+    entry->id = id;
+    entry->generation = table->generation;
+    entry->handlers_count = handlers_count;
+    entry->handlers = handlers;
+
+    return entry;
+}
+
+#endif
+
 static esp_err_t handler_instances_add(esp_event_handler_nodes_t* handlers, esp_event_handler_t event_handler, void* event_handler_arg, esp_event_handler_instance_context_t **handler_ctx, bool legacy)
 {
     esp_event_handler_node_t *handler_instance = calloc(1, sizeof(*handler_instance));
@@ -386,6 +629,9 @@ static esp_err_t loop_remove_handler(esp_event_remove_handler_context_t* ctx)
                 SLIST_REMOVE(&(ctx->loop->loop_nodes), it, esp_event_loop_node, next);
                 free(it);
             }
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+            dispatch_table_invalidate(ctx->loop);
+#endif
             return ESP_OK;
         }
     }
@@ -426,17 +672,126 @@ static void loop_node_remove_all_handler(esp_event_loop_node_t* loop_node)
     }
 }
 
+static esp_err_t payload_pool_init(esp_event_payload_pool_t* pool, uint32_t buffers_count, size_t buffer_size)
+{
+    if (buffers_count == 0 || buffer_size == 0) {
+        // no reserved buffers, payload_pool_take always fails as buffer_size is 0
+        return ESP_OK;
+    }
+
+    size_t stride = (buffer_size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+    pool->buffers = malloc(stride * buffers_count);
+    if (pool->buffers == NULL) {
+        ESP_LOGE(TAG, "alloc for event data buffers failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->buffer_size = buffer_size;
+    pool->buffer_stride = stride;
+    pool->buffers_count = buffers_count;
+    atomic_store(&pool->free_mask, buffers_count == 32 ? UINT32_MAX : (1UL << buffers_count) - 1);
+    atomic_store(&pool->free_min, buffers_count);
+
+    return ESP_OK;
+}
+
+// Takes a free buffer able to hold size bytes, returns NULL if there is none.
+// Buffers are taken and released without lock so that events can be posted from any task concurrently.
+static void* payload_pool_take(esp_event_payload_pool_t* pool, size_t size)
+{
+    if (size > pool->buffer_size) {
+        return NULL;
+    }
+
+    uint_least32_t mask = atomic_load(&pool->free_mask);
+    uint32_t index;
+
+    do {
+        if (mask == 0) {
+            return NULL;
+        }
+        index = __builtin_ctz(mask);
+    } while (!atomic_compare_exchange_weak(&pool->free_mask, &mask, mask & ~(1UL << index)));
+
+    uint_least32_t free_count = __builtin_popcount(mask) - 1;
+    uint_least32_t free_min = atomic_load(&pool->free_min);
+    while (free_count < free_min && !atomic_compare_exchange_weak(&pool->free_min, &free_min, free_count)) {
+    }
+
+    return pool->buffers + index * pool->buffer_stride;
+}
+
+static void payload_pool_release(void* data, void* arg)
+{
+    esp_event_payload_pool_t* pool = (esp_event_payload_pool_t*) arg;
+    uint32_t index = ((uint8_t*) data - pool->buffers) / pool->buffer_stride;
+
+    atomic_fetch_or(&pool->free_mask, 1UL << index);
+}
+
+static void post_data_keep(void* data, void* arg)
+{
+    // data posted by reference without release function, nothing to do
+}
+
 static void inline __attribute__((always_inline)) post_instance_delete(esp_event_post_instance_t* post)
 {
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
     if (post->data_allocated)
 #endif
     {
-        free(post->data.ptr);
+        if (post->release) {
+            post->release(post->data.ptr, post->release_arg);
+        } else {
+            free(post->data.ptr);
+        }
     }
     memset(post, 0, sizeof(*post));
 }
 
+static BaseType_t post_instance_send(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post, TickType_t ticks_to_wait)
+{
+    BaseType_t result = pdFALSE;
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    post->time_posted = esp_timer_get_time();
+    post->queue_depth = uxQueueMessagesWaiting(loop->queue) + 1;
+#endif
+
+    // Find the task that currently executes the loop. It is safe to query loop->task since it is
+    // not mutated since loop creation. ENSURE THIS REMAINS TRUE.
+    if (loop->task == NULL) {
+        // The loop has no dedicated task. Find out what task is currently running it.
+        result = xSemaphoreTakeRecursive(loop->mutex, ticks_to_wait);
+
+        if (result == pdTRUE) {
+            if (loop->running_task != xTaskGetCurrentTaskHandle()) {
+                xSemaphoreGiveRecursive(loop->mutex);
+                result = xQueueSendToBack(loop->queue, post, ticks_to_wait);
+            } else {
+                xSemaphoreGiveRecursive(loop->mutex);
+                result = xQueueSendToBack(loop->queue, post, 0);
+            }
+        }
+    } else {
+        // The loop has a dedicated task.
+        if (loop->task != xTaskGetCurrentTaskHandle()) {
+            result = xQueueSendToBack(loop->queue, post, ticks_to_wait);
+        } else {
+            result = xQueueSendToBack(loop->queue, post, 0);
+        }
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    if (result == pdTRUE) {
+        queue_depth_update_max(&(loop->queue_depth_max), post->queue_depth);
+    }
+#endif
+
+    return result;
+}
+
 static esp_err_t find_and_unregister_handler(esp_event_remove_handler_context_t* ctx)
 {
     esp_event_handler_node_t *handler_to_unregister = NULL;
@@ -535,6 +890,140 @@ static esp_err_t find_and_unregister_handler(esp_event_remove_handler_context_t*
     return esp_event_post_to(ctx->loop, esp_event_handler_cleanup, 0, ctx, sizeof(esp_event_remove_handler_context_t), portMAX_DELAY);
 }
 
+// Executes the handlers registered for the event, the loop mutex must be held
+static void loop_dispatch(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post)
+{
+    bool exec = false;
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    int64_t start = esp_timer_get_time();
+#endif
+
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+    // A handler running the loop again must not replace the handlers the outer run is iterating over,
+    // nested runs walk the lists instead.
+    esp_event_dispatch_entry_t* entry = NULL;
+    if (loop->dispatch_depth == 0) {
+        entry = dispatch_table_resolve(loop, post->base, post->id);
+    }
+    loop->dispatch_depth++;
+
+    if (entry != NULL) {
+        // Handlers unregistered by the handlers executed before are only marked, they are freed
+        // once the cleanup event gets processed.
+        for (size_t i = 0; i < entry->handlers_count; i++) {
+            if (!entry->handlers[i]->unregistered) {
+                handler_execute(loop, entry->handlers[i], *post);
+                exec |= true;
+            }
+        }
+    } else
+#endif
+    {
+        esp_event_handler_node_t *handler, *temp_handler;
+        esp_event_loop_node_t *loop_node, *temp_node;
+        esp_event_base_node_t *base_node, *temp_base;
+        esp_event_id_node_t *id_node, *temp_id_node;
+
+        SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
+            // Execute loop level handlers
+            SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
+                if (!handler->unregistered) {
+                    handler_execute(loop, handler, *post);
+                    exec |= true;
+                }
+            }
+
+            SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
+                if (base_node->base == post->base) {
+                    // Execute base level handlers
+                    SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
+                        if (!handler->unregistered) {
+                            handler_execute(loop, handler, *post);
+                            exec |= true;
+                        }
+                    }
+
+                    SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
+                        if (id_node->id == post->id) {
+                            // Execute id level handlers
+                            SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
+                                if (!handler->unregistered) {
+                                    handler_execute(loop, handler, *post);
+                                    exec |= true;
+                                }
+                            }
+                            // Skip to next base node
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+    loop->dispatch_depth--;
+#endif
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    if (post->base != esp_event_handler_cleanup) {
+        esp_event_stats_t* stats = loop_event_stats(loop, post->base, post->id);
+
+        if (stats != NULL) {
+            stats->dispatched++;
+            if (post->queue_depth > stats->queue_depth_max) {
+                stats->queue_depth_max = post->queue_depth;
+            }
+            time_histogram_add(&(stats->queue_delay), start - post->time_posted);
+            time_histogram_add(&(stats->exec_time), esp_timer_get_time() - start);
+        } else {
+            loop->events_untracked++;
+        }
+    }
+#endif
+
+    if (!exec) {
+        // No handlers were registered, not even loop/base level handlers
+        ESP_LOGD(TAG, "no handlers have been registered for event %s:%"PRIu32" posted to loop %p", post->base, post->id, loop);
+    }
+}
+
+// Processes an event taken from the queue and deletes it, the loop mutex must be held
+static void loop_process_post(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post)
+{
+    // check if the event retrieve from the queue is the internal event that is
+    // triggered when a handler needs to be removed..
+    if (post->base == esp_event_handler_cleanup) {
+        assert(post->data.ptr != NULL);
+        esp_event_remove_handler_context_t* ctx = (esp_event_remove_handler_context_t*)post->data.ptr;
+        loop_remove_handler(ctx);
+
+        // if the handler unregistration request came from legacy code,
+        // we have to free handler_ctx pointer since it points to memory
+        // allocated by esp_event_handler_unregister_with_internal
+        if (ctx->legacy) {
+            free(ctx->handler_ctx);
+        }
+    }
+
+    if (post->base == esp_event_batch) {
+        // events posted by esp_event_post_batch_to, their data is part of the same allocation
+        esp_event_post_instance_t* batch = (esp_event_post_instance_t*) post->data.ptr;
+        for (int32_t i = 0; i < post->id; i++) {
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+            batch[i].time_posted = post->time_posted;
+            batch[i].queue_depth = post->queue_depth;
+#endif
+            loop_dispatch(loop, &batch[i]);
+        }
+    } else {
+        loop_dispatch(loop, post);
+    }
+
+    post_instance_delete(post);
+}
+
 /* ---------------------------- Public API --------------------------------- */
 
 esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, esp_event_loop_handle_t* event_loop)
@@ -549,6 +1038,11 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (event_loop_args->payload_pool_size > ESP_EVENT_PAYLOAD_POOL_MAX_BUFFERS) {
+        ESP_LOGE(TAG, "payload_pool_size larger than %d", ESP_EVENT_PAYLOAD_POOL_MAX_BUFFERS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_event_loop_instance_t* loop;
     esp_err_t err = ESP_ERR_NO_MEM; // most likely error
 
@@ -570,6 +1064,19 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         goto on_err;
     }
 
+    if (payload_pool_init(&(loop->payload_pool), event_loop_args->payload_pool_size,
+                          event_loop_args->payload_pool_buffer_size) != ESP_OK) {
+        goto on_err;
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    loop->event_stats = calloc(CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS, sizeof(*(loop->event_stats)));
+    if (loop->event_stats == NULL) {
+        ESP_LOGE(TAG, "alloc for event profiling data failed");
+        goto on_err;
+    }
+#endif
+
     SLIST_INIT(&(loop->loop_nodes));
 
     // Create the loop task if requested
@@ -615,6 +1122,10 @@ on_err:
         vSemaphoreDelete(loop->mutex);
     }
 
+    free(loop->payload_pool.buffers);
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    free(loop->event_stats);
+#endif
     free(loop);
 
     return err;
@@ -626,6 +1137,8 @@ on_err:
 // indicate that the difference is not that substantial, especially considering the additional
 // pointers per node of rbtrees. Code for the rbtree implementation of the event loop library is archived
 // in feature/esp_event_loop_library_rbtrees if needed.
+// With CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE, the handlers found by the walk are kept in a hash table keyed by the
+// event base and id, so the lists are only walked again for an event after handlers have been added or removed.
 esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t ticks_to_run)
 {
     assert(event_loop);
@@ -645,93 +1158,57 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
         // The event has already been unqueued, so ensure it gets executed.
         xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
 
-        // check if the event retrieve from the queue is the internal event that is
-        // triggered when a handler needs to be removed..
-        if (post.base == esp_event_handler_cleanup) {
-            assert(post.data.ptr != NULL);
-            esp_event_remove_handler_context_t* ctx = (esp_event_remove_handler_context_t*)post.data.ptr;
-            loop_remove_handler(ctx);
-
-            // if the handler unregistration request came from legacy code,
-            // we have to free handler_ctx pointer since it points to memory
-            // allocated by esp_event_handler_unregister_with_internal
-            if (ctx->legacy) {
-                free(ctx->handler_ctx);
-            }
-        }
-
         loop->running_task = xTaskGetCurrentTaskHandle();
 
-        bool exec = false;
-
-        esp_event_handler_node_t *handler, *temp_handler;
-        esp_event_loop_node_t *loop_node, *temp_node;
-        esp_event_base_node_t *base_node, *temp_base;
-        esp_event_id_node_t *id_node, *temp_id_node;
-
-        SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
-            // Execute loop level handlers
-            SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
-                if (!handler->unregistered) {
-                    handler_execute(loop, handler, post);
-                    exec |= true;
-                }
-            }
+        // Events queued meanwhile are dispatched under the same mutex acquisition, up to
+        // CONFIG_ESP_EVENT_LOOP_DISPATCH_BATCH_SIZE of them.
+        bool expired = false;
+        int dispatched = 0;
 
-            SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
-                if (base_node->base == post.base) {
-                    // Execute base level handlers
-                    SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
-                        if (!handler->unregistered) {
-                            handler_execute(loop, handler, post);
-                            exec |= true;
-                        }
-                    }
+        do {
+            loop_process_post(loop, &post);
+            dispatched++;
 
-                    SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
-                        if (id_node->id == post.id) {
-                            // Execute id level handlers
-                            SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
-                                if (!handler->unregistered) {
-                                    handler_execute(loop, handler, post);
-                                    exec |= true;
-                                }
-                            }
-                            // Skip to next base node
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
-        esp_event_base_t base = post.base;
-        int32_t id = post.id;
-
-        post_instance_delete(&post);
-
-        if (ticks_to_run != portMAX_DELAY) {
-            end = xTaskGetTickCount();
-            remaining_ticks -= end - marker;
-            // If the ticks to run expired, return to the caller
-            if (remaining_ticks <= 0) {
-                xSemaphoreGiveRecursive(loop->mutex);
-                break;
-            } else {
+            if (ticks_to_run != portMAX_DELAY) {
+                end = xTaskGetTickCount();
+                remaining_ticks -= end - marker;
                 marker = end;
+                expired = (remaining_ticks <= 0);
             }
+        } while (!expired && dispatched < CONFIG_ESP_EVENT_LOOP_DISPATCH_BATCH_SIZE &&
+                 xQueueReceive(loop->queue, &post, 0) == pdTRUE);
+
+        // If the ticks to run expired, return to the caller
+        if (expired) {
+            xSemaphoreGiveRecursive(loop->mutex);
+            break;
         }
 
         loop->running_task = NULL;
 
         xSemaphoreGiveRecursive(loop->mutex);
+    }
 
-        if (!exec) {
-            // No handlers were registered, not even loop/base level handlers
-            ESP_LOGD(TAG, "no handlers have been registered for event %s:%"PRIu32" posted to loop %p", base, id, event_loop);
-        }
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_get_payload_stats(esp_event_loop_handle_t event_loop, esp_event_loop_payload_stats_t* stats)
+{
+    assert(event_loop);
+
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
+    esp_event_payload_pool_t* pool = &(((esp_event_loop_instance_t*) event_loop)->payload_pool);
+
+    stats->buffer_size = pool->buffer_size;
+    stats->buffers = pool->buffers_count;
+    stats->buffers_free = __builtin_popcount(atomic_load(&pool->free_mask));
+    stats->buffers_free_min = atomic_load(&pool->free_min);
+    stats->data_pooled = atomic_load(&pool->data_pooled);
+    stats->data_allocated = atomic_load(&pool->data_allocated);
+
     return ESP_OK;
 }
 
@@ -756,6 +1233,10 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
         vTaskDelete(loop->task);
     }
 
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+    dispatch_table_delete(&(loop->dispatch_table));
+#endif
+
     // Remove all registered events and handlers in the loop
     esp_event_loop_node_t *it, *temp;
     SLIST_FOREACH_SAFE(it, &(loop->loop_nodes), next, temp) {
@@ -772,6 +1253,10 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
 
     // Cleanup loop
     vQueueDelete(loop->queue);
+    free(loop->payload_pool.buffers);
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    free(loop->event_stats);
+#endif
     free(loop);
     // Free loop mutex before deleting
     xSemaphoreGiveRecursive(loop_mutex);
@@ -838,6 +1323,12 @@ esp_err_t esp_event_handler_register_with_internal(esp_event_loop_handle_t event
         err = loop_node_add_handler(last_loop_node, event_base, event_id, event_handler, event_handler_arg, handler_ctx_arg, legacy);
     }
 
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+    if (err == ESP_OK) {
+        dispatch_table_invalidate(loop);
+    }
+#endif
+
 on_err:
     xSemaphoreGiveRecursive(loop->mutex);
     return err;
@@ -924,11 +1415,20 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     memset((void*)(&post), 0, sizeof(post));
 
     if (event_data != NULL && event_data_size != 0) {
-        // Make persistent copy of event data on heap.
-        void* event_data_copy = calloc(1, event_data_size);
+        // Make persistent copy of event data, in a reserved buffer if one is free or on heap otherwise.
+        void* event_data_copy = payload_pool_take(&(loop->payload_pool), event_data_size);
 
-        if (event_data_copy == NULL) {
-            return ESP_ERR_NO_MEM;
+        if (event_data_copy != NULL) {
+            post.release = payload_pool_release;
+            post.release_arg = &(loop->payload_pool);
+            atomic_fetch_add(&(loop->payload_pool.data_pooled), 1);
+        } else {
+            event_data_copy = calloc(1, event_data_size);
+
+            if (event_data_copy == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            atomic_fetch_add(&(loop->payload_pool.data_allocated), 1);
         }
 
         memcpy(event_data_copy, event_data, event_data_size);
@@ -941,35 +1441,130 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     post.base = event_base;
     post.id = event_id;
 
-    BaseType_t result = pdFALSE;
+    BaseType_t result = post_instance_send(loop, &post, ticks_to_wait);
 
-    // Find the task that currently executes the loop. It is safe to query loop->task since it is
-    // not mutated since loop creation. ENSURE THIS REMAINS TRUE.
-    if (loop->task == NULL) {
-        // The loop has no dedicated task. Find out what task is currently running it.
-        result = xSemaphoreTakeRecursive(loop->mutex, ticks_to_wait);
+    if (result != pdTRUE) {
+        post_instance_delete(&post);
 
-        if (result == pdTRUE) {
-            if (loop->running_task != xTaskGetCurrentTaskHandle()) {
-                xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
-            } else {
-                xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, 0);
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+        atomic_fetch_add(&loop->events_dropped, 1);
+#endif
+        return ESP_ERR_TIMEOUT;
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    atomic_fetch_add(&loop->events_received, 1);
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post_batch_to(esp_event_loop_handle_t event_loop, const esp_event_batch_item_t* events, size_t count,
+                                  TickType_t ticks_to_wait)
+{
+    assert(event_loop);
+
+    if (events == NULL || count == 0 || count > INT32_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The events and copies of their data are kept in one allocation, posted to the queue as a single item
+    size_t size;
+    if (__builtin_mul_overflow(count, sizeof(esp_event_post_instance_t), &size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].event_base == ESP_EVENT_ANY_BASE || events[i].event_id == ESP_EVENT_ANY_ID) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (events[i].event_data != NULL) {
+            size_t data_size;
+            if (__builtin_add_overflow(events[i].event_data_size, sizeof(uint64_t) - 1, &data_size) ||
+                    __builtin_add_overflow(size, data_size & ~(sizeof(uint64_t) - 1), &size)) {
+                return ESP_ERR_INVALID_ARG;
             }
         }
-    } else {
-        // The loop has a dedicated task.
-        if (loop->task != xTaskGetCurrentTaskHandle()) {
-            result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
-        } else {
-            result = xQueueSendToBack(loop->queue, &post, 0);
+    }
+
+    esp_event_post_instance_t* batch = calloc(1, size);
+    if (batch == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t* data = (uint8_t*) &batch[count];
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].event_data != NULL && events[i].event_data_size != 0) {
+            memcpy(data, events[i].event_data, events[i].event_data_size);
+            batch[i].data.ptr = data;
+#if CONFIG_ESP_EVENT_POST_FROM_ISR
+            batch[i].data_allocated = true;
+            batch[i].data_set = true;
+#endif
+            data += (events[i].event_data_size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
         }
+        batch[i].base = events[i].event_base;
+        batch[i].id = events[i].event_id;
     }
 
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    esp_event_post_instance_t post;
+    memset((void*)(&post), 0, sizeof(post));
+
+    post.data.ptr = batch;
+#if CONFIG_ESP_EVENT_POST_FROM_ISR
+    post.data_allocated = true;
+    post.data_set = true;
+#endif
+    post.base = esp_event_batch;
+    post.id = (int32_t) count;
+
+    BaseType_t result = post_instance_send(loop, &post, ticks_to_wait);
+
     if (result != pdTRUE) {
         post_instance_delete(&post);
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+        atomic_fetch_add(&loop->events_dropped, count);
+#endif
+        return ESP_ERR_TIMEOUT;
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    atomic_fetch_add(&loop->events_received, count);
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post_ref_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                                void* event_data, esp_event_data_release_t release, void* release_arg, TickType_t ticks_to_wait)
+{
+    assert(event_loop);
+
+    if (event_base == ESP_EVENT_ANY_BASE || event_id == ESP_EVENT_ANY_ID) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    esp_event_post_instance_t post;
+    memset((void*)(&post), 0, sizeof(post));
+
+    post.data.ptr = event_data;
+#if CONFIG_ESP_EVENT_POST_FROM_ISR
+    post.data_allocated = true;
+    post.data_set = (event_data != NULL);
+#endif
+    post.release = release ? release : post_data_keep;
+    post.release_arg = release_arg;
+    post.base = event_base;
+    post.id = event_id;
+
+    BaseType_t result = post_instance_send(loop, &post, ticks_to_wait);
+
+    if (result != pdTRUE) {
+        // the caller keeps ownership of the data, don't release it
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
 #endif
@@ -1012,6 +1607,11 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
 
     BaseType_t result = pdFALSE;
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    post.time_posted = esp_timer_get_time();
+    post.queue_depth = uxQueueMessagesWaitingFromISR(loop->queue) + 1;
+#endif
+
     // Post the event from an ISR,
     result = xQueueSendToBackFromISR(loop->queue, &post, task_unblocked);
 
@@ -1026,12 +1626,145 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_fetch_add(&loop->events_received, 1);
+    queue_depth_update_max(&(loop->queue_depth_max), post.queue_depth);
 #endif
 
     return ESP_OK;
 }
 #endif
 
+esp_err_t esp_event_loop_get_profile(esp_event_loop_handle_t event_loop, esp_event_loop_profile_t* profile)
+{
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    assert(event_loop);
+
+    if (profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+
+    profile->events_received = atomic_load(&loop->events_received);
+    profile->events_dropped = atomic_load(&loop->events_dropped);
+    profile->events_untracked = loop->events_untracked;
+    profile->queue_depth_max = atomic_load(&loop->queue_depth_max);
+
+    profile->handlers = 0;
+    esp_event_loop_get_handler_profiles(event_loop, NULL, &(profile->handlers));
+
+    profile->events = 0;
+    for (size_t i = 0; i < CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS; i++) {
+        if (loop->event_stats[i].base != NULL) {
+            profile->events++;
+        }
+    }
+
+    xSemaphoreGiveRecursive(loop->mutex);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_event_loop_get_handler_profiles(esp_event_loop_handle_t event_loop, esp_event_handler_profile_t* profiles,
+                                              size_t* count)
+{
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    assert(event_loop);
+
+    if (count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+    esp_event_loop_node_t *loop_node;
+    esp_event_base_node_t* base_node;
+    esp_event_id_node_t* id_node;
+    esp_event_handler_node_t* handler;
+    size_t capacity = *count;
+
+    *count = 0;
+
+    xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(handler, &(loop_node->handlers), next) {
+            handler_profile_add(profiles, capacity, count, handler, esp_event_any_base, ESP_EVENT_ANY_ID);
+        }
+
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            SLIST_FOREACH(handler, &(base_node->handlers), next) {
+                handler_profile_add(profiles, capacity, count, handler, base_node->base, ESP_EVENT_ANY_ID);
+            }
+
+            SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                SLIST_FOREACH(handler, &(id_node->handlers), next) {
+                    handler_profile_add(profiles, capacity, count, handler, base_node->base, id_node->id);
+                }
+            }
+        }
+    }
+
+    xSemaphoreGiveRecursive(loop->mutex);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_event_loop_get_event_profiles(esp_event_loop_handle_t event_loop, esp_event_event_profile_t* profiles,
+                                            size_t* count)
+{
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    assert(event_loop);
+
+    if (count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+    size_t capacity = *count;
+
+    *count = 0;
+
+    xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+
+    for (size_t i = 0; i < CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS; i++) {
+        esp_event_stats_t* stats = &(loop->event_stats[i]);
+
+        if (stats->base == NULL) {
+            continue;
+        }
+
+        if (profiles != NULL) {
+            if (*count >= capacity) {
+                break;
+            }
+
+            esp_event_event_profile_t* profile = &profiles[*count];
+            profile->event_base = stats->base;
+            profile->event_id = stats->id;
+            profile->dispatched = stats->dispatched;
+            profile->queue_depth_max = stats->queue_depth_max;
+            time_stats_get(&(profile->queue_delay), &(stats->queue_delay));
+            time_stats_get(&(profile->exec_time), &(stats->exec_time));
+        }
+
+        (*count)++;
+    }
+
+    xSemaphoreGiveRecursive(loop->mutex);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 esp_err_t esp_event_dump(FILE* file)
 {
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
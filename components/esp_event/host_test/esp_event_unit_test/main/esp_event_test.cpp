@@ -8,6 +8,11 @@
 */
 
 #include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <chrono>
+#include <deque>
+#include <vector>
 #include "esp_event.h"
 
 #include <catch2/catch_test_macros.hpp>
@@ -40,6 +45,137 @@ static esp_event_loop_args_t test_event_get_default_loop_args(void)
 
 void dummy_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data) { }
 
+/**
+ * Single threaded stand-in for the queue and the mutex of an event loop without dedicated task, so that events can
+ * be posted and dispatched with the FreeRTOS mocks. The mutex is always available.
+ */
+struct FakeLoopQueue : public CMockFix {
+    FakeLoopQueue()
+    {
+        s_items.clear();
+        reset_counters();
+        xQueueGenericCreate_Stub(create);
+        xQueueGenericSend_Stub(send);
+        xQueueReceive_Stub(receive);
+        xQueueCreateMutex_IgnoreAndReturn(reinterpret_cast<QueueHandle_t>(0xdeadbeef));
+        vQueueDelete_Ignore();
+        xQueueTakeMutexRecursive_Stub(take_mutex);
+        xQueueGiveMutexRecursive_IgnoreAndReturn(pdTRUE);
+        xQueueSemaphoreTake_IgnoreAndReturn(pdTRUE);
+        xTaskGetTickCount_IgnoreAndReturn(0);
+        xTaskGetCurrentTaskHandle_IgnoreAndReturn(nullptr);
+    }
+
+    ~FakeLoopQueue()
+    {
+        xQueueCreateMutex_StopIgnore();
+        vQueueDelete_StopIgnore();
+        xQueueGiveMutexRecursive_StopIgnore();
+        xQueueSemaphoreTake_StopIgnore();
+        xTaskGetTickCount_StopIgnore();
+        xTaskGetCurrentTaskHandle_StopIgnore();
+    }
+
+    static QueueHandle_t create(const UBaseType_t length, const UBaseType_t item_size, const uint8_t type, int calls)
+    {
+        s_item_size = item_size;
+        return reinterpret_cast<QueueHandle_t>(0xcafe);
+    }
+
+    static BaseType_t send(QueueHandle_t queue, const void * const item, TickType_t ticks, const BaseType_t pos, int calls)
+    {
+        // xSemaphoreGive() is a send without item
+        if (item != nullptr) {
+            const uint8_t *bytes = static_cast<const uint8_t*>(item);
+            s_items.emplace_back(bytes, bytes + s_item_size);
+            s_sends++;
+        }
+        return pdTRUE;
+    }
+
+    static BaseType_t receive(QueueHandle_t queue, void * const item, TickType_t ticks, int calls)
+    {
+        if (s_items.empty()) {
+            return pdFALSE;
+        }
+        memcpy(item, s_items.front().data(), s_item_size);
+        s_items.pop_front();
+        // a receive which may block is where the loop task would be woken up by the item
+        if (ticks != 0) {
+            s_wakeups++;
+        }
+        return pdTRUE;
+    }
+
+    static BaseType_t take_mutex(QueueHandle_t mutex, TickType_t ticks, int calls)
+    {
+        s_mutex_takes++;
+        return pdTRUE;
+    }
+
+    static void reset_counters()
+    {
+        s_sends = 0;
+        s_wakeups = 0;
+        s_mutex_takes = 0;
+    }
+
+    static UBaseType_t s_item_size;
+    static std::deque<std::vector<uint8_t> > s_items;
+    static size_t s_sends;
+    static size_t s_wakeups;
+    static size_t s_mutex_takes;
+};
+
+UBaseType_t FakeLoopQueue::s_item_size;
+std::deque<std::vector<uint8_t> > FakeLoopQueue::s_items;
+size_t FakeLoopQueue::s_sends;
+size_t FakeLoopQueue::s_wakeups;
+size_t FakeLoopQueue::s_mutex_takes;
+
+ESP_EVENT_DEFINE_BASE(s_test_base1);
+ESP_EVENT_DEFINE_BASE(s_test_base2);
+
+std::vector<int> s_dispatched;
+
+void record_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    s_dispatched.push_back(static_cast<int>(reinterpret_cast<intptr_t>(event_handler_arg)));
+}
+
+void *tag(int value)
+{
+    return reinterpret_cast<void*>(static_cast<intptr_t>(value));
+}
+
+void id_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    s_dispatched.push_back(event_id);
+}
+
+std::vector<std::vector<uint8_t> > s_received_data;
+
+void data_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    const uint8_t *bytes = static_cast<const uint8_t*>(event_data);
+    s_received_data.emplace_back(bytes, bytes + event_id);
+}
+
+std::vector<void*> s_released;
+
+void release_data(void* event_data, void* release_arg)
+{
+    s_released.push_back(event_data);
+    CHECK(release_arg == tag(42));
+}
+
+void post_and_run(esp_event_loop_handle_t loop, esp_event_base_t base, int32_t id)
+{
+    s_dispatched.clear();
+    REQUIRE(esp_event_post_to(loop, base, id, nullptr, 0, 0) == ESP_OK);
+    REQUIRE(esp_event_loop_run(loop, 1) == ESP_OK);
+}
+
 }
 
 // TODO: IDF-2693, function definition just to satisfy linker, implement esp_common instead
@@ -149,3 +285,335 @@ TEST_CASE("registering with ANY_BASE but specific ID fails")
                                           dummy_handler,
                                           nullptr) == ESP_ERR_INVALID_ARG);
 }
+
+TEST_CASE("handlers are dispatched in registration order across ANY_BASE, ANY_ID and specific id registrations")
+{
+    FakeLoopQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+    esp_event_handler_instance_t instance3;
+    CHECK(esp_event_handler_register_with(loop, s_test_base1, 1, record_handler, tag(1)) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_handler, tag(2), nullptr) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, record_handler, tag(3), &instance3) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, s_test_base1, 1, record_handler, tag(4), nullptr) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_handler, tag(5), nullptr) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, s_test_base2, 1, record_handler, tag(6), nullptr) == ESP_OK);
+
+    post_and_run(loop, s_test_base1, 1);
+    CHECK(s_dispatched == std::vector<int>({1, 2, 3, 4, 5}));
+    post_and_run(loop, s_test_base1, 1);
+    CHECK(s_dispatched == std::vector<int>({1, 2, 3, 4, 5}));
+    post_and_run(loop, s_test_base2, 1);
+    CHECK(s_dispatched == std::vector<int>({2, 5, 6}));
+
+    // events already dispatched once see the handlers registered and unregistered since
+    CHECK(esp_event_handler_instance_register_with(loop, s_test_base1, 1, record_handler, tag(7), nullptr) == ESP_OK);
+    post_and_run(loop, s_test_base1, 1);
+    CHECK(s_dispatched == std::vector<int>({1, 2, 3, 4, 5, 7}));
+
+    CHECK(esp_event_handler_instance_unregister_with(loop, s_test_base1, ESP_EVENT_ANY_ID, instance3) == ESP_OK);
+    post_and_run(loop, s_test_base1, 1);
+    CHECK(s_dispatched == std::vector<int>({1, 2, 4, 5, 7}));
+    post_and_run(loop, s_test_base1, 2);
+    CHECK(s_dispatched == std::vector<int>({2, 5}));
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("dispatch cost per posted event as the number of registered handlers grows")
+{
+    FakeLoopQueue queue;
+    const size_t POSTS = 20000;
+
+    for (int id_count : {1, 10, 100, 1000}) {
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_name = nullptr;
+        REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+        // one handler per id of the first base, the event posted is the one registered last
+        CHECK(esp_event_handler_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_handler, tag(0)) == ESP_OK);
+        CHECK(esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, record_handler, tag(0)) == ESP_OK);
+        for (int id = 0; id < id_count; id++) {
+            CHECK(esp_event_handler_register_with(loop, s_test_base2, id, dummy_handler, nullptr) == ESP_OK);
+            CHECK(esp_event_handler_register_with(loop, s_test_base1, id, record_handler, tag(id)) == ESP_OK);
+        }
+
+        s_dispatched.clear();
+        s_dispatched.reserve(3 * POSTS);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < POSTS; i += QUEUE_SIZE) {
+            for (size_t j = 0; j < QUEUE_SIZE; j++) {
+                esp_event_post_to(loop, s_test_base1, id_count - 1, nullptr, 0, 0);
+            }
+            esp_event_loop_run(loop, 1);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        size_t posted = (POSTS + QUEUE_SIZE - 1) / QUEUE_SIZE * QUEUE_SIZE;
+        CHECK(s_dispatched.size() == 3 * posted);
+        printf("dispatch with %5d ids per base: %6.0f ns per posted event\n", id_count,
+               std::chrono::duration<double, std::nano>(elapsed).count() / posted);
+
+        CHECK(esp_event_loop_delete(loop) == ESP_OK);
+    }
+}
+
+TEST_CASE("creating an event loop with more than 32 reserved event data buffers fails")
+{
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.payload_pool_size = 33;
+    loop_args.payload_pool_buffer_size = 16;
+    CHECK(esp_event_loop_create(&loop_args, &loop) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("event data is copied to reserved buffers while they last")
+{
+    FakeLoopQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    loop_args.payload_pool_size = 4;
+    loop_args.payload_pool_buffer_size = 24;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, data_handler, nullptr) == ESP_OK);
+
+    // the event id is the size of the data
+    std::vector<uint8_t> data(64);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i;
+    }
+    const int32_t sizes[] = {24, 1, 25, 8, 16, 24};
+    for (int32_t size : sizes) {
+        CHECK(esp_event_post_to(loop, s_test_base1, size, data.data(), size, 0) == ESP_OK);
+    }
+
+    esp_event_loop_payload_stats_t stats;
+    REQUIRE(esp_event_loop_get_payload_stats(loop, &stats) == ESP_OK);
+    CHECK(stats.buffer_size == 24);
+    CHECK(stats.buffers == 4);
+    CHECK(stats.buffers_free == 0);
+    CHECK(stats.buffers_free_min == 0);
+    CHECK(stats.data_pooled == 4);
+    CHECK(stats.data_allocated == 2);
+
+    s_received_data.clear();
+    CHECK(esp_event_loop_run(loop, 1) == ESP_OK);
+    REQUIRE(s_received_data.size() == 6);
+    for (size_t i = 0; i < 6; i++) {
+        CHECK(s_received_data[i] == std::vector<uint8_t>(data.begin(), data.begin() + sizes[i]));
+    }
+
+    REQUIRE(esp_event_loop_get_payload_stats(loop, &stats) == ESP_OK);
+    CHECK(stats.buffers_free == 4);
+    CHECK(stats.buffers_free_min == 0);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("event data posted by reference is released once dispatched or dropped")
+{
+    FakeLoopQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, data_handler, nullptr) == ESP_OK);
+
+    uint8_t data[2][8] = {{1, 2, 3, 4, 5, 6, 7, 8}, {8, 7, 6, 5, 4, 3, 2, 1}};
+    s_released.clear();
+    s_received_data.clear();
+    CHECK(esp_event_post_ref_to(loop, s_test_base1, 8, data[0], release_data, tag(42), 0) == ESP_OK);
+    CHECK(esp_event_post_ref_to(loop, s_test_base1, ESP_EVENT_ANY_ID, data[0], release_data, tag(42), 0) == ESP_ERR_INVALID_ARG);
+    CHECK(s_released.empty());
+
+    CHECK(esp_event_loop_run(loop, 1) == ESP_OK);
+    REQUIRE(s_received_data.size() == 1);
+    CHECK(s_received_data[0] == std::vector<uint8_t>(data[0], data[0] + 8));
+    CHECK(s_released == std::vector<void*>({data[0]}));
+
+    // posting without release function only passes the data on
+    CHECK(esp_event_post_ref_to(loop, s_test_base1, 8, data[1], nullptr, nullptr, 0) == ESP_OK);
+    CHECK(esp_event_loop_run(loop, 1) == ESP_OK);
+    CHECK(s_received_data.size() == 2);
+    CHECK(s_released.size() == 1);
+
+    esp_event_loop_payload_stats_t stats;
+    REQUIRE(esp_event_loop_get_payload_stats(loop, &stats) == ESP_OK);
+    CHECK(stats.buffers == 0);
+    CHECK(stats.data_pooled == 0);
+    CHECK(stats.data_allocated == 0);
+
+    // events still queued when the loop is deleted release their data as well
+    CHECK(esp_event_post_ref_to(loop, s_test_base1, 8, data[1], release_data, tag(42), 0) == ESP_OK);
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+    CHECK(s_released == std::vector<void*>({data[0], data[1]}));
+}
+
+#if !CONFIG_ESP_EVENT_LOOP_PROFILING
+TEST_CASE("profile queries are not supported without profiling")
+{
+    FakeLoopQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+    esp_event_loop_profile_t profile;
+    size_t count = 0;
+    CHECK(esp_event_loop_get_profile(loop, &profile) == ESP_ERR_NOT_SUPPORTED);
+    CHECK(esp_event_loop_get_handler_profiles(loop, nullptr, &count) == ESP_ERR_NOT_SUPPORTED);
+    CHECK(esp_event_loop_get_event_profiles(loop, nullptr, &count) == ESP_ERR_NOT_SUPPORTED);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+#endif
+
+TEST_CASE("post latency and allocations with and without reserved event data buffers")
+{
+    FakeLoopQueue queue;
+    const size_t POSTS = 20000;
+    uint8_t data[48] = { };
+
+    for (uint32_t pool_size : {0, 32}) {
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_name = nullptr;
+        loop_args.payload_pool_size = pool_size;
+        loop_args.payload_pool_buffer_size = sizeof(data);
+        REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+        CHECK(esp_event_handler_register_with(loop, s_test_base1, 1, dummy_handler, nullptr) == ESP_OK);
+
+        std::chrono::steady_clock::duration post_time {};
+        for (size_t i = 0; i < POSTS; i += QUEUE_SIZE) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t j = 0; j < QUEUE_SIZE; j++) {
+                esp_event_post_to(loop, s_test_base1, 1, data, sizeof(data), 0);
+            }
+            post_time += std::chrono::steady_clock::now() - start;
+            esp_event_loop_run(loop, 1);
+        }
+
+        size_t posted = (POSTS + QUEUE_SIZE - 1) / QUEUE_SIZE * QUEUE_SIZE;
+        esp_event_loop_payload_stats_t stats;
+        REQUIRE(esp_event_loop_get_payload_stats(loop, &stats) == ESP_OK);
+        CHECK(stats.data_pooled + stats.data_allocated == posted);
+        if (pool_size != 0) {
+            CHECK(stats.data_allocated == 0);
+        }
+        printf("post with %2" PRIu32 " reserved buffers: %5.0f ns per event, %6" PRIu32 " allocations for %zu events\n",
+               pool_size, std::chrono::duration<double, std::nano>(post_time).count() / posted, stats.data_allocated, posted);
+
+        CHECK(esp_event_loop_delete(loop) == ESP_OK);
+    }
+}
+
+TEST_CASE("events posted as batch are dispatched in order")
+{
+    FakeLoopQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, id_handler, nullptr) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, s_test_base2, ESP_EVENT_ANY_ID, data_handler, nullptr) == ESP_OK);
+
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    const esp_event_batch_item_t batch[] = {
+        {s_test_base1, 2, nullptr, 0},
+        {s_test_base2, 3, data, 3},
+        {s_test_base1, 3, nullptr, 0},
+        {s_test_base2, 11, data, 11},
+        {s_test_base2, 0, data, 0},
+        {s_test_base1, 4, nullptr, 0},
+    };
+
+    CHECK(esp_event_post_batch_to(loop, nullptr, 1, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_post_batch_to(loop, batch, 0, 0) == ESP_ERR_INVALID_ARG);
+    const esp_event_batch_item_t invalid[] = {
+        {s_test_base1, 1, nullptr, 0},
+        {s_test_base1, ESP_EVENT_ANY_ID, nullptr, 0},
+    };
+    CHECK(esp_event_post_batch_to(loop, invalid, 2, 0) == ESP_ERR_INVALID_ARG);
+    // sizes wrapping around the size of the allocation
+    const esp_event_batch_item_t huge[] = {
+        {s_test_base2, 1, data, SIZE_MAX - 2},
+        {s_test_base2, 2, data, SIZE_MAX / 2},
+        {s_test_base2, 3, data, SIZE_MAX / 2},
+    };
+    CHECK(esp_event_post_batch_to(loop, huge, 1, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_post_batch_to(loop, huge + 1, 2, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(FakeLoopQueue::s_sends == 0);
+
+    s_dispatched.clear();
+    s_received_data.clear();
+    CHECK(esp_event_post_to(loop, s_test_base1, 1, nullptr, 0, 0) == ESP_OK);
+    CHECK(esp_event_post_batch_to(loop, batch, sizeof(batch) / sizeof(batch[0]), 0) == ESP_OK);
+    CHECK(esp_event_post_to(loop, s_test_base1, 5, nullptr, 0, 0) == ESP_OK);
+    CHECK(FakeLoopQueue::s_sends == 3);
+
+    CHECK(esp_event_loop_run(loop, 1) == ESP_OK);
+    CHECK(s_dispatched == std::vector<int>({1, 2, 3, 4, 5}));
+    REQUIRE(s_received_data.size() == 3);
+    CHECK(s_received_data[0] == std::vector<uint8_t>(data, data + 3));
+    CHECK(s_received_data[1] == std::vector<uint8_t>(data, data + 11));
+    CHECK(s_received_data[2].empty());
+
+    // batches still queued are freed with the loop
+    CHECK(esp_event_post_batch_to(loop, batch, sizeof(batch) / sizeof(batch[0]), 0) == ESP_OK);
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("events per second and loop wakeups per event of single and batch posts")
+{
+    FakeLoopQueue queue;
+    const size_t ROUNDS = 2000;
+    const size_t BURST = 32;
+    uint32_t data = 0;
+
+    std::vector<esp_event_batch_item_t> batch(BURST, esp_event_batch_item_t {s_test_base1, 1, &data, sizeof(data)});
+
+    // 0: the loop task preempts the poster on every event, 1: a burst is posted before the loop task runs,
+    // 2: the burst is posted as one batch
+    for (int mode = 0; mode < 3; mode++) {
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_name = nullptr;
+        REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+        CHECK(esp_event_handler_register_with(loop, s_test_base1, 1, dummy_handler, nullptr) == ESP_OK);
+        FakeLoopQueue::reset_counters();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ROUNDS; i++) {
+            if (mode == 2) {
+                esp_event_post_batch_to(loop, batch.data(), BURST, 0);
+            } else {
+                for (size_t j = 0; j < BURST; j++) {
+                    esp_event_post_to(loop, s_test_base1, 1, &data, sizeof(data), 0);
+                    if (mode == 0) {
+                        esp_event_loop_run(loop, 1);
+                    }
+                }
+            }
+            esp_event_loop_run(loop, 1);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        const char *names[] = {"post, dispatch each", "post burst, dispatch", "post batch, dispatch"};
+        double events = ROUNDS * BURST;
+        printf("%-20s: %5.2f Mevents/s, %5.3f queue sends, %5.3f wakeups, %5.3f mutex takes per event\n", names[mode],
+               events / std::chrono::duration<double, std::micro>(elapsed).count(),
+               FakeLoopQueue::s_sends / events, FakeLoopQueue::s_wakeups / events, FakeLoopQueue::s_mutex_takes / events);
+
+        CHECK(FakeLoopQueue::s_wakeups <= FakeLoopQueue::s_sends);
+        if (mode == 2) {
+            CHECK(FakeLoopQueue::s_sends == ROUNDS);
+        }
+
+        CHECK(esp_event_loop_delete(loop) == ESP_OK);
+    }
+}
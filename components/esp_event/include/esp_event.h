@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2018-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2018-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -29,8 +29,31 @@ typedef struct {
     uint32_t task_stack_size;                   /**< stack size of the event loop task, ignored if task name is NULL */
     BaseType_t task_core_id;                    /**< core to which the event loop task is pinned to,
                                                         ignored if task name is NULL */
+    uint32_t payload_pool_size;                 /**< number of buffers reserved for event data at loop creation,
+                                                        at most 32; 0 to allocate the copy of every event data */
+    size_t payload_pool_buffer_size;            /**< size of each reserved buffer; event data up to this size is
+                                                        copied to a free buffer instead of memory allocated on post */
 } esp_event_loop_args_t;
 
+/// Event posted as part of a batch, see esp_event_post_batch_to
+typedef struct {
+    esp_event_base_t event_base;                /**< the event base that identifies the event */
+    int32_t event_id;                           /**< the event ID that identifies the event */
+    const void *event_data;                     /**< the data, specific to the event occurrence, that gets passed to
+                                                        the handler */
+    size_t event_data_size;                     /**< the size of the event data */
+} esp_event_batch_item_t;
+
+/// Statistics of the event data copies made by an event loop
+typedef struct {
+    size_t buffer_size;                         /**< size of the reserved buffers, 0 if the loop has none */
+    uint32_t buffers;                           /**< number of reserved buffers */
+    uint32_t buffers_free;                      /**< number of reserved buffers not in use */
+    uint32_t buffers_free_min;                  /**< lowest number of reserved buffers not in use since loop creation */
+    uint32_t data_pooled;                       /**< number of event data copied to a reserved buffer */
+    uint32_t data_allocated;                    /**< number of event data copied to memory allocated on post */
+} esp_event_loop_payload_stats_t;
+
 /**
  * @brief Create a new event loop.
  *
@@ -39,13 +62,29 @@ typedef struct {
  *
  * @return
  *  - ESP_OK: Success
- *  - ESP_ERR_INVALID_ARG: event_loop_args or event_loop was NULL
+ *  - ESP_ERR_INVALID_ARG: event_loop_args or event_loop was NULL, or payload_pool_size is larger than 32
  *  - ESP_ERR_NO_MEM: Cannot allocate memory for event loops list
  *  - ESP_FAIL: Failed to create task loop
  *  - Others: Fail
  */
 esp_err_t esp_event_loop_create(const esp_event_loop_args_t *event_loop_args, esp_event_loop_handle_t *event_loop);
 
+/**
+ * @brief Get statistics of the event data copies made by an event loop.
+ *
+ * Events posted with esp_event_post_to and esp_event_post are copied to one of the buffers reserved according to
+ * payload_pool_size and payload_pool_buffer_size of esp_event_loop_args_t if their data fits and a buffer is free,
+ * to memory allocated for the event otherwise.
+ *
+ * @param[in] event_loop event loop to get the statistics of, must not be NULL
+ * @param[out] stats statistics of the event loop
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: stats was NULL
+ */
+esp_err_t esp_event_loop_get_payload_stats(esp_event_loop_handle_t event_loop, esp_event_loop_payload_stats_t *stats);
+
 /**
  * @brief Delete an existing event loop.
  *
@@ -397,6 +436,111 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
                             size_t event_data_size,
                             TickType_t ticks_to_wait);
 
+/**
+ * @brief Posts several events to the specified event loop at once.
+ *
+ * The events and copies of their data are placed in a single allocation which takes one item of the event queue,
+ * so posting them costs one queue operation and wakes the loop once. The events are dispatched in the order of the
+ * array, one after the other, while no other event is dispatched in between.
+ *
+ * @param[in] event_loop the event loop to post to, must not be NULL
+ * @param[in] events the events to post
+ * @param[in] count number of events in the array
+ * @param[in] ticks_to_wait number of ticks to block on a full event queue
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for event queue to unblock expired, none of the events has been posted
+ *  - ESP_ERR_INVALID_ARG: events is NULL, count is 0 or an event has an invalid combination of event base and ID,
+ *                        or the events and their data don't fit in one allocation
+ *  - ESP_ERR_NO_MEM: Cannot allocate memory for the events
+ *  - Others: Fail
+ */
+esp_err_t esp_event_post_batch_to(esp_event_loop_handle_t event_loop,
+                                  const esp_event_batch_item_t *events,
+                                  size_t count,
+                                  TickType_t ticks_to_wait);
+
+/**
+ * @brief Posts several events to the system default event loop at once.
+ *
+ * This function behaves in the same manner as esp_event_post_batch_to, except that it posts the events to the
+ * default event loop.
+ *
+ * @param[in] events the events to post
+ * @param[in] count number of events in the array
+ * @param[in] ticks_to_wait number of ticks to block on a full event queue
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for event queue to unblock expired, none of the events has been posted
+ *  - ESP_ERR_INVALID_ARG: events is NULL, count is 0 or an event has an invalid combination of event base and ID
+ *  - ESP_ERR_NO_MEM: Cannot allocate memory for the events
+ *  - ESP_ERR_INVALID_STATE: Default event loop has not been created
+ *  - Others: Fail
+ */
+esp_err_t esp_event_post_batch(const esp_event_batch_item_t *events,
+                               size_t count,
+                               TickType_t ticks_to_wait);
+
+/**
+ * @brief Posts an event to the specified event loop without copying its data.
+ *
+ * The handlers receive event_data itself. The event loop calls release with event_data and release_arg once the
+ * event has been dispatched to all handlers, or dropped because the loop is deleted. Until then, event_data must
+ * stay valid and must not be modified.
+ *
+ * @param[in] event_loop the event loop to post to, must not be NULL
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event ID that identifies the event
+ * @param[in] event_data the data, specific to the event occurrence, that gets passed to the handler
+ * @param[in] release function called when the event loop does not use event_data anymore, can be NULL
+ * @param[in] release_arg argument passed to release
+ * @param[in] ticks_to_wait number of ticks to block on a full event queue
+ *
+ * @note if the event could not be posted, release is not called and the caller keeps ownership of event_data
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for event queue to unblock expired
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event ID
+ *  - Others: Fail
+ */
+esp_err_t esp_event_post_ref_to(esp_event_loop_handle_t event_loop,
+                                esp_event_base_t event_base,
+                                int32_t event_id,
+                                void *event_data,
+                                esp_event_data_release_t release,
+                                void *release_arg,
+                                TickType_t ticks_to_wait);
+
+/**
+ * @brief Posts an event to the system default event loop without copying its data.
+ *
+ * This function behaves in the same manner as esp_event_post_ref_to, except that it posts the event to the
+ * default event loop.
+ *
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event ID that identifies the event
+ * @param[in] event_data the data, specific to the event occurrence, that gets passed to the handler
+ * @param[in] release function called when the event loop does not use event_data anymore, can be NULL
+ * @param[in] release_arg argument passed to release
+ * @param[in] ticks_to_wait number of ticks to block on a full event queue
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for event queue to unblock expired
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event ID
+ *  - ESP_ERR_INVALID_STATE: Default event loop has not been created
+ *  - Others: Fail
+ */
+esp_err_t esp_event_post_ref(esp_event_base_t event_base,
+                             int32_t event_id,
+                             void *event_data,
+                             esp_event_data_release_t release,
+                             void *release_arg,
+                             TickType_t ticks_to_wait);
+
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
 /**
  * @brief Special variant of esp_event_post for posting events from interrupt handlers.
@@ -457,6 +601,101 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
                                 BaseType_t *task_unblocked);
 #endif
 
+/// Distribution of durations in microseconds, percentiles are upper bounds of power of two histogram buckets
+typedef struct {
+    uint32_t p50;                               /**< median */
+    uint32_t p99;                               /**< 99th percentile */
+    uint32_t max;                               /**< longest duration */
+} esp_event_time_stats_t;
+
+/// Profiling data of an event loop
+typedef struct {
+    uint32_t events_received;                   /**< number of events successfully posted to the loop */
+    uint32_t events_dropped;                    /**< number of events dropped due to the queue being full */
+    uint32_t events_untracked;                  /**< number of dispatched events missing from the event profiles as
+                                                        CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS pairs were tracked already */
+    uint32_t queue_depth_max;                   /**< highest number of events in the queue once an event was posted */
+    size_t handlers;                            /**< number of registered handlers */
+    size_t events;                              /**< number of event base and ID pairs with an event profile */
+} esp_event_loop_profile_t;
+
+/// Profiling data of a registered handler
+typedef struct {
+    esp_event_handler_t handler;                /**< the handler function */
+    void *handler_arg;                          /**< the argument the handler was registered with */
+    esp_event_base_t event_base;                /**< the event base the handler is registered for, ESP_EVENT_ANY_BASE
+                                                        for all bases */
+    int32_t event_id;                           /**< the event ID the handler is registered for, ESP_EVENT_ANY_ID
+                                                        for all IDs */
+    uint32_t invoked;                           /**< number of times the handler has been invoked */
+    int64_t total_time;                         /**< total runtime of the handler in microseconds */
+    esp_event_time_stats_t exec_time;           /**< runtime of a single invocation */
+} esp_event_handler_profile_t;
+
+/// Profiling data of the events with the same base and ID dispatched by an event loop
+typedef struct {
+    esp_event_base_t event_base;                /**< the event base */
+    int32_t event_id;                           /**< the event ID */
+    uint32_t dispatched;                        /**< number of events dispatched */
+    uint32_t queue_depth_max;                   /**< highest number of events in the queue once one of these events
+                                                        was posted */
+    esp_event_time_stats_t queue_delay;         /**< time from posting an event to the start of its dispatch */
+    esp_event_time_stats_t exec_time;           /**< time to execute all handlers of an event */
+} esp_event_event_profile_t;
+
+/**
+ * @brief Get the profiling data of an event loop.
+ *
+ * @param[in] event_loop the event loop, must not be NULL
+ * @param[out] profile profiling data of the loop
+ *
+ * @note the data is only collected when CONFIG_ESP_EVENT_LOOP_PROFILING is enabled
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: profile was NULL
+ *  - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP_EVENT_LOOP_PROFILING is disabled
+ */
+esp_err_t esp_event_loop_get_profile(esp_event_loop_handle_t event_loop, esp_event_loop_profile_t *profile);
+
+/**
+ * @brief Get the profiling data of the handlers registered to an event loop.
+ *
+ * Handlers are reported in the order they are executed for an event matching all of them.
+ *
+ * @param[in] event_loop the event loop, must not be NULL
+ * @param[out] profiles array receiving the profiling data, can be NULL to only get the number of handlers
+ * @param[inout] count on input the size of the profiles array, on output the number of entries written to it,
+ *                     or the number of registered handlers if profiles is NULL
+ *
+ * @note the data is only collected when CONFIG_ESP_EVENT_LOOP_PROFILING is enabled
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: count was NULL
+ *  - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP_EVENT_LOOP_PROFILING is disabled
+ */
+esp_err_t esp_event_loop_get_handler_profiles(esp_event_loop_handle_t event_loop, esp_event_handler_profile_t *profiles,
+                                              size_t *count);
+
+/**
+ * @brief Get the profiling data of the events dispatched by an event loop, one entry per event base and ID.
+ *
+ * @param[in] event_loop the event loop, must not be NULL
+ * @param[out] profiles array receiving the profiling data, can be NULL to only get the number of entries
+ * @param[inout] count on input the size of the profiles array, on output the number of entries written to it,
+ *                     or the number of entries available if profiles is NULL
+ *
+ * @note the data is only collected when CONFIG_ESP_EVENT_LOOP_PROFILING is enabled
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: count was NULL
+ *  - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP_EVENT_LOOP_PROFILING is disabled
+ */
+esp_err_t esp_event_loop_get_event_profiles(esp_event_loop_handle_t event_loop, esp_event_event_profile_t *profiles,
+                                            size_t *count);
+
 /**
  * @brief Dumps statistics of all event loops.
  *
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2018-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2018-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -24,6 +24,9 @@ typedef void (*esp_event_handler_t)(void* event_handler_arg,
                                     int32_t event_id,
                                     void* event_data); /**< function called when an event is posted to the queue */
 typedef void*        esp_event_handler_instance_t; /**< context identifying an instance of a registered event handler */
+typedef void (*esp_event_data_release_t)(void* event_data,
+                                         void* release_arg); /**< function called once the data of an event posted by
+                                                                    reference is not used by the event loop anymore */
 
 // Defines for registering/unregistering event handlers
 #define ESP_EVENT_ANY_BASE     NULL             /**< register handler for any event base */
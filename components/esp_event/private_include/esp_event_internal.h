@@ -18,6 +18,18 @@ extern "C" {
 
 typedef SLIST_HEAD(base_nodes, base_node) base_nodes_t;
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+#define ESP_EVENT_TIME_HISTOGRAM_BUCKETS 24
+
+/// Histogram of durations in microseconds
+typedef struct esp_event_time_histogram {
+    uint32_t buckets[ESP_EVENT_TIME_HISTOGRAM_BUCKETS];             /**< bucket 0 counts durations of 0 us, bucket n
+                                                                            the ones from 2^(n-1) to 2^n - 1 us, the
+                                                                            last one all longer ones as well */
+    uint32_t max;                                                   /**< longest duration */
+} esp_event_time_histogram_t;
+#endif
+
 typedef struct esp_event_handler_context {
     esp_event_handler_t handler;                                    /**< event handler function*/
     void* arg;
@@ -29,6 +41,7 @@ typedef struct esp_event_handler_node {
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     uint32_t invoked;                                               /**< number of times this handler has been invoked */
     int64_t time;                                                   /**< total runtime of this handler across all calls */
+    esp_event_time_histogram_t exec_time;                           /**< runtime of the calls of this handler */
 #endif
     SLIST_ENTRY(esp_event_handler_node) next;                   /**< next event handler in the list */
     bool unregistered;
@@ -66,6 +79,53 @@ typedef struct esp_event_loop_node {
 
 typedef SLIST_HEAD(esp_event_loop_nodes, esp_event_loop_node) esp_event_loop_nodes_t;
 
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+/// Handlers resolved for an event base and id pair
+typedef struct esp_event_dispatch_entry {
+    esp_event_base_t base;                                          /**< base identifier of the event, NULL for a free slot */
+    int32_t id;                                                     /**< id number of the event */
+    uint32_t generation;                                            /**< value of the loop generation the handlers were resolved for */
+    size_t handlers_count;                                          /**< number of handlers to be executed */
+    esp_event_handler_node_t** handlers;                            /**< handlers to be executed, in the same order as
+                                                                            the walk of the loop node lists */
+} esp_event_dispatch_entry_t;
+
+/// Dispatch table of an event loop, open addressing with linear probing
+typedef struct esp_event_dispatch_table {
+    esp_event_dispatch_entry_t* entries;                            /**< slots of the table, allocated on first use */
+    size_t capacity;                                                /**< number of slots, a power of two */
+    size_t count;                                                   /**< number of used slots */
+    uint32_t generation;                                            /**< incremented whenever handlers are added or removed */
+} esp_event_dispatch_table_t;
+#endif
+
+/// Buffers reserved for event data at loop creation
+typedef struct esp_event_payload_pool {
+    uint8_t* buffers;                                               /**< memory of all buffers */
+    size_t buffer_size;                                             /**< size of the data a buffer can hold */
+    size_t buffer_stride;                                           /**< distance between two buffers */
+    uint32_t buffers_count;                                         /**< number of buffers, at most 32 */
+    atomic_uint_least32_t free_mask;                                /**< bit n is set when buffer n is free */
+    atomic_uint_least32_t free_min;                                 /**< lowest number of free buffers */
+    atomic_uint_least32_t data_pooled;                              /**< number of event data copied to a buffer */
+    atomic_uint_least32_t data_allocated;                           /**< number of event data copied to allocated memory */
+} esp_event_payload_pool_t;
+
+#define ESP_EVENT_PAYLOAD_POOL_MAX_BUFFERS 32
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+/// Profiling data of the events with the same base and id posted to a loop
+typedef struct esp_event_stats {
+    esp_event_base_t base;                                          /**< base identifier of the event, NULL for a free slot */
+    int32_t id;                                                     /**< id number of the event */
+    uint32_t dispatched;                                            /**< number of events dispatched */
+    uint32_t queue_depth_max;                                       /**< highest number of events in the queue once
+                                                                            one of these events was posted */
+    esp_event_time_histogram_t queue_delay;                         /**< time from post to start of dispatch */
+    esp_event_time_histogram_t exec_time;                           /**< time to execute all handlers of an event */
+} esp_event_stats_t;
+#endif
+
 /// Event loop
 typedef struct esp_event_loop_instance {
     const char* name;                                               /**< name of this event loop */
@@ -76,9 +136,21 @@ typedef struct esp_event_loop_instance {
     SemaphoreHandle_t mutex;                                        /**< mutex for updating the events linked list */
     esp_event_loop_nodes_t loop_nodes;                              /**< set of linked lists containing the
                                                                             registered handlers for the loop */
+    esp_event_payload_pool_t payload_pool;                          /**< buffers for the data of posted events */
+#ifdef CONFIG_ESP_EVENT_LOOP_DISPATCH_TABLE
+    esp_event_dispatch_table_t dispatch_table;                      /**< handlers resolved for the posted events */
+    uint32_t dispatch_depth;                                        /**< number of nested esp_event_loop_run calls
+                                                                            currently executing handlers */
+#endif
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_uint_least32_t events_received;                          /**< number of events successfully posted to the loop */
     atomic_uint_least32_t events_dropped;                           /**< number of events dropped due to queue being full */
+    atomic_uint_least32_t queue_depth_max;                          /**< highest number of events in the queue once
+                                                                            an event was posted */
+    uint32_t events_untracked;                                      /**< number of events dispatched while event_stats
+                                                                            had no slot left for them */
+    esp_event_stats_t* event_stats;                                 /**< profiling data of the posted events,
+                                                                            CONFIG_ESP_EVENT_LOOP_PROFILING_EVENTS slots */
     SLIST_ENTRY(esp_event_loop_instance) next;                      /**< next event loop in the list */
 #endif
 } esp_event_loop_instance_t;
@@ -105,6 +177,14 @@ typedef struct esp_event_post_instance {
     esp_event_base_t base;                                           /**< the event base */
     int32_t id;                                                      /**< the event id */
     esp_event_post_data_t data;                                      /**< data associated with the event */
+    esp_event_data_release_t release;                                /**< function releasing the data once the event has
+                                                                            been dispatched, NULL if the data is freed */
+    void* release_arg;                                               /**< argument passed to release */
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    int64_t time_posted;                                             /**< time the event was posted, in microseconds */
+    uint32_t queue_depth;                                            /**< number of events in the queue once this one
+                                                                            was posted */
+#endif
 } esp_event_post_instance_t;
 
 #ifdef __cplusplus
@@ -12,6 +12,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_event.h"
+#include "esp_rom_sys.h"
 #include "unity.h"
 
 ESP_EVENT_DECLARE_BASE(s_test_base1);
@@ -1651,6 +1652,80 @@ TEST_CASE("profiling reports valid values", "[event][default]")
     TEST_ESP_OK(esp_event_loop_delete_default());
 }
 
+static void handler_busy(void* arg, esp_event_base_t event_base, int32_t event_id, void* data)
+{
+    esp_rom_delay_us(100);
+}
+
+TEST_CASE("profiling reports per handler and per event statistics", "[event][default]")
+{
+    EV_LoopFix loop_fix;
+    esp_event_loop_profile_t loop_profile;
+    esp_event_handler_profile_t handler_profiles[4];
+    esp_event_event_profile_t event_profiles[4];
+    size_t count;
+
+    TEST_ESP_OK(esp_event_handler_register_with(loop_fix.loop, s_test_base1, TEST_EVENT_BASE1_EV1, handler_busy, NULL));
+    TEST_ESP_OK(esp_event_handler_register_with(loop_fix.loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, handler_all, NULL));
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ESP_OK(esp_event_post_to(loop_fix.loop, s_test_base1, TEST_EVENT_BASE1_EV1, NULL, 0, portMAX_DELAY));
+    }
+    TEST_ESP_OK(esp_event_post_to(loop_fix.loop, s_test_base2, TEST_EVENT_BASE1_EV2, NULL, 0, portMAX_DELAY));
+    TEST_ESP_OK(esp_event_loop_run(loop_fix.loop, ZERO_DELAY));
+
+    TEST_ESP_OK(esp_event_loop_get_profile(loop_fix.loop, &loop_profile));
+    TEST_ASSERT_EQUAL_UINT32(4, loop_profile.events_received);
+    TEST_ASSERT_EQUAL_UINT32(0, loop_profile.events_dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, loop_profile.events_untracked);
+    TEST_ASSERT_EQUAL_UINT32(4, loop_profile.queue_depth_max);
+    TEST_ASSERT_EQUAL(2, loop_profile.handlers);
+    TEST_ASSERT_EQUAL(2, loop_profile.events);
+
+    /* the number of handlers is returned if no array is given */
+    count = 0;
+    TEST_ESP_OK(esp_event_loop_get_handler_profiles(loop_fix.loop, NULL, &count));
+    TEST_ASSERT_EQUAL(2, count);
+
+    count = sizeof(handler_profiles) / sizeof(handler_profiles[0]);
+    TEST_ESP_OK(esp_event_loop_get_handler_profiles(loop_fix.loop, handler_profiles, &count));
+    TEST_ASSERT_EQUAL(2, count);
+    for (size_t i = 0; i < count; i++) {
+        if (handler_profiles[i].handler == handler_busy) {
+            TEST_ASSERT_EQUAL_STRING(s_test_base1, handler_profiles[i].event_base);
+            TEST_ASSERT_EQUAL_INT32(TEST_EVENT_BASE1_EV1, handler_profiles[i].event_id);
+            TEST_ASSERT_EQUAL_UINT32(3, handler_profiles[i].invoked);
+            TEST_ASSERT_GREATER_OR_EQUAL_UINT32(100, handler_profiles[i].exec_time.p50);
+        } else {
+            TEST_ASSERT_EQUAL_PTR(handler_all, handler_profiles[i].handler);
+            TEST_ASSERT_NULL(handler_profiles[i].event_base);
+            TEST_ASSERT_EQUAL_UINT32(4, handler_profiles[i].invoked);
+        }
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(handler_profiles[i].exec_time.p99, handler_profiles[i].exec_time.p50);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(handler_profiles[i].exec_time.max, handler_profiles[i].exec_time.p99);
+    }
+
+    count = sizeof(event_profiles) / sizeof(event_profiles[0]);
+    TEST_ESP_OK(esp_event_loop_get_event_profiles(loop_fix.loop, event_profiles, &count));
+    TEST_ASSERT_EQUAL(2, count);
+    for (size_t i = 0; i < count; i++) {
+        if (event_profiles[i].event_base == s_test_base1) {
+            TEST_ASSERT_EQUAL_UINT32(3, event_profiles[i].dispatched);
+            TEST_ASSERT_EQUAL_UINT32(3, event_profiles[i].queue_depth_max);
+            TEST_ASSERT_GREATER_OR_EQUAL_UINT32(100, event_profiles[i].exec_time.p50);
+        } else {
+            TEST_ASSERT_EQUAL_PTR(s_test_base2, event_profiles[i].event_base);
+            TEST_ASSERT_EQUAL_UINT32(1, event_profiles[i].dispatched);
+            TEST_ASSERT_EQUAL_UINT32(4, event_profiles[i].queue_depth_max);
+        }
+    }
+
+    /* a smaller array is filled up to its size */
+    count = 1;
+    TEST_ESP_OK(esp_event_loop_get_event_profiles(loop_fix.loop, event_profiles, &count));
+    TEST_ASSERT_EQUAL(1, count);
+}
+
 static void handler_id2(void* arg, esp_event_base_t event_base, int32_t event_id, void* data)
 {
     printf("event received: base=%s, id=%" PRId32 ", data=%p\n", event_base, event_id, data);
@@ -0,0 +1,163 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "esp_httpd_priv.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+extern "C" {
+#include "Mocktask.h"
+#include "Mockesp_event.h"
+}
+
+/* What the transport functions of the session received */
+struct Transport {
+    std::string out;
+    bool keep = true;               // keep the output, else only copy it like a socket would
+    size_t out_len = 0;
+    std::vector<char> sink = std::vector<char>(16 * 1024);
+    int send_calls = 0;
+    int sendv_calls = 0;
+    size_t max_send = SIZE_MAX;     // bytes accepted per call, to exercise partial sends
+
+    void append(const void *buf, size_t len)
+    {
+        if (keep) {
+            out.append((const char *) buf, len);
+        } else {
+            for (size_t pos = 0; pos < len; pos += sink.size()) {
+                memcpy(sink.data(), (const char *) buf + pos, std::min(sink.size(), len - pos));
+            }
+        }
+        out_len += len;
+    }
+
+    void clear()
+    {
+        out.clear();
+        out_len = 0;
+    }
+};
+
+inline Transport *s_transport;
+
+inline int capture_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    size_t len = std::min(buf_len, s_transport->max_send);
+    s_transport->send_calls++;
+    s_transport->append(buf, len);
+    return len;
+}
+
+inline int capture_sendv(httpd_handle_t hd, int sockfd, const struct iovec *iov, int iovcnt, int flags)
+{
+    size_t sent = 0;
+    s_transport->sendv_calls++;
+    for (int i = 0; i < iovcnt && sent < s_transport->max_send; i++) {
+        size_t len = std::min(iov[i].iov_len, s_transport->max_send - sent);
+        s_transport->append(iov[i].iov_base, len);
+        sent += len;
+    }
+    return sent;
+}
+
+/* A server with one session, in the middle of processing a request */
+class RequestFixture {
+public:
+    RequestFixture()
+    {
+        xTaskGetCurrentTaskHandle_IgnoreAndReturn(TASK);
+        esp_event_post_IgnoreAndReturn(ESP_OK);
+
+        /* Not default constructible in C++, because of the const members of httpd_req_t */
+        hd = (struct httpd_data *) calloc(1, sizeof(struct httpd_data));
+        REQUIRE(hd);
+        memset(&sd, 0, sizeof(sd));
+        hd->config.max_resp_headers = MAX_RESP_HEADERS;
+        hd->config.max_uri_handlers = MAX_URI_HANDLERS;
+        hd->config.uri_match_fn = httpd_uri_match_wildcard;
+        hd->hd_calls = calls;
+        hd->hd_td.handle = TASK;
+#if CONFIG_HTTPD_URI_INDEX
+        uri_index_init(&hd->hd_uri_index, true);
+        httpd_uri_index_rebuild(hd);
+#endif
+        sd.fd = 3;
+        sd.handle = hd;
+        sd.send_fn = capture_send;
+        sd.sendv_fn = capture_sendv;
+
+        struct httpd_req_aux *ra = &hd->hd_req_aux;
+        ra->sd = &sd;
+        ra->resp_hdrs = resp_hdrs;
+        ra->status = (char *) HTTPD_200;
+        ra->content_type = (char *) HTTPD_TYPE_TEXT;
+        ra->max_req_hdr_len = 512;
+        hd->hd_req.handle = hd;
+        hd->hd_req.aux = ra;
+        req = &hd->hd_req;
+        s_transport = &transport;
+    }
+
+    ~RequestFixture()
+    {
+        s_transport = nullptr;
+        httpd_unregister_all_uri_handlers(hd);
+        free(hd);
+    }
+
+    /* Starts the next request on the session, as after parsing its headers */
+    void request(const char *uri, const std::vector<std::string> &headers = {})
+    {
+        struct httpd_req_aux *ra = &hd->hd_req_aux;
+        snprintf((char *) req->uri, sizeof(req->uri), "%s", uri);
+        scratch.clear();
+        for (auto &header : headers) {
+            scratch.insert(scratch.end(), header.begin(), header.end());
+            scratch.push_back('\0');
+        }
+        scratch.push_back('\0');
+        ra->scratch = scratch.data();
+        ra->req_hdrs_count = headers.size();
+        ra->resp_hdrs_count = 0;
+        ra->first_chunk_sent = false;
+        ra->status = (char *) HTTPD_200;
+        ra->content_type = (char *) HTTPD_TYPE_TEXT;
+        transport.clear();
+    }
+
+    /* Processes the current request with the handler registered for its URI */
+    esp_err_t handle()
+    {
+        for (httpd_uri_t *uri : calls) {
+            if (uri && httpd_uri_match_wildcard(uri->uri, req->uri, strcspn(req->uri, "?"))) {
+                req->user_ctx = uri->user_ctx;
+                return uri->handler(req);
+            }
+        }
+        FAIL("no handler for " << req->uri);
+        return ESP_FAIL;
+    }
+
+    static const size_t MAX_RESP_HEADERS = 8;
+    static const size_t MAX_URI_HANDLERS = 8;
+    TaskHandle_t const TASK = (TaskHandle_t) 0x1234;
+
+    struct httpd_data *hd;
+    struct sock_db sd;
+    httpd_req_aux::resp_hdr resp_hdrs[MAX_RESP_HEADERS];
+    httpd_uri_t *calls[MAX_URI_HANDLERS] = {};
+    std::vector<char> scratch;
+    httpd_req_t *req;
+    Transport transport;
+};
@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "request_fixture.hpp"
+
+/* Heap allocations are counted by wrapping the allocator of glibc,
+ * which conflicts with the allocator of the address sanitizer */
+#if defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCS 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define COUNT_ALLOCS 0
+#endif
+#endif
+#ifndef COUNT_ALLOCS
+#define COUNT_ALLOCS 1
+#endif
+
+namespace {
+
+bool s_counting;
+size_t s_allocs;
+
+/* Data the client sent, received by the session */
+struct Input {
+    std::string data;
+    size_t pos = 0;
+    int recv_calls = 0;
+};
+
+Input *s_input;
+
+int input_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len, int flags)
+{
+    s_input->recv_calls++;
+    size_t len = std::min(buf_len, s_input->data.size() - s_input->pos);
+    memcpy(buf, s_input->data.data() + s_input->pos, len);
+    s_input->pos += len;
+    return len;
+}
+
+/* Answers with the URI and the first bytes of the body */
+esp_err_t echo_handler(httpd_req_t *req)
+{
+    char body[16];
+    int len = (req->content_len > 0) ? httpd_req_recv(req, body, std::min(sizeof(body), req->content_len)) : 0;
+    if (len < 0) {
+        return ESP_FAIL;
+    }
+    char resp[64 + sizeof(body)];
+    snprintf(resp, sizeof(resp), "%s:%.*s", req->uri, len, body);
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
+/* A session of a server, receiving the requests of a client */
+class PipelineFixture : public RequestFixture {
+public:
+    PipelineFixture()
+    {
+        sd.recv_fn = input_recv;
+        hd->hd_sd = &sd;
+        hd->config.max_open_sockets = 1;
+        hd->hd_td.status = thread_data::THREAD_RUNNING;
+        s_input = &input;
+        httpd_uri_t echo = {};
+        echo.uri = "/*";
+        echo.method = HTTP_GET;
+        echo.handler = echo_handler;
+        REQUIRE(httpd_register_uri_handler(hd, &echo) == ESP_OK);
+        echo.method = HTTP_POST;
+        REQUIRE(httpd_register_uri_handler(hd, &echo) == ESP_OK);
+    }
+
+    ~PipelineFixture()
+    {
+        s_input = nullptr;
+#if CONFIG_HTTPD_SESS_ARENA
+        sess_arena_free(&sd.arena);
+#endif
+    }
+
+    /* Processes the requests sent at once, like the server does while
+     * data is pending or the socket is readable */
+    esp_err_t process(const std::string &data)
+    {
+        input.data = data;
+        input.pos = 0;
+        esp_err_t ret;
+        do {
+            ret = httpd_sess_process(hd, &sd);
+        } while (ret == ESP_OK && (httpd_sess_pending(hd, &sd) || input.pos < input.data.size()));
+        return ret;
+    }
+
+    Input input;
+};
+
+std::string response(const std::string &body)
+{
+    return "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+
+} // namespace
+
+#if COUNT_ALLOCS
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    s_allocs += s_counting;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    s_allocs += s_counting;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    s_allocs += s_counting;
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+TEST_CASE("pipelined requests are answered in order", "[pipeline]")
+{
+    PipelineFixture f;
+    std::string body(300, 'b');
+    CHECK(f.process("GET /one HTTP/1.1\r\nHost: esp\r\n\r\n"
+                    "POST /two HTTP/1.1\r\nContent-Length: 300\r\n\r\n" + body +
+                    "GET /three?x=1 HTTP/1.1\r\n\r\n") == ESP_OK);
+    CHECK(f.transport.out == response("/one:") + response("/two:bbbbbbbbbbbbbbbb") + response("/three?x=1:"));
+    CHECK(f.input.pos == f.input.data.size());
+#if CONFIG_HTTPD_SESS_ARENA
+    /* All requests came with the first read */
+    CHECK(f.input.recv_calls == 1);
+#endif
+}
+
+TEST_CASE("request headers larger than the first read", "[pipeline]")
+{
+    PipelineFixture f;
+    std::string cookie(700, 'c');
+    CHECK(f.process("GET /big HTTP/1.1\r\nCookie: id=" + cookie + "\r\n\r\nGET /next HTTP/1.1\r\n\r\n") == ESP_OK);
+    CHECK(f.transport.out == response("/big:") + response("/next:"));
+
+    /* The session stays usable for the next requests */
+    f.transport.clear();
+    CHECK(f.process("GET /again HTTP/1.1\r\n\r\n") == ESP_OK);
+    CHECK(f.transport.out == response("/again:"));
+}
+
+TEST_CASE("pipelining benchmark", "[pipeline][bench]")
+{
+    const int ROUNDS = 2000;
+    const int BATCH = 8;
+    std::string batch;
+    for (int i = 0; i < BATCH; i++) {
+        batch += "GET /item/" + std::to_string(i) + " HTTP/1.1\r\nHost: esp\r\nAccept: */*\r\n\r\n";
+    }
+
+    for (bool vectored : {true, false}) {
+        PipelineFixture f;
+        f.transport.keep = false;
+        if (!vectored) {
+            f.sd.sendv_fn = NULL;
+        }
+        /* The first requests of a session set up its buffers */
+        REQUIRE(f.process(batch) == ESP_OK);
+        f.input.recv_calls = 0;
+
+        s_allocs = 0;
+        s_counting = true;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            f.process(batch);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        s_counting = false;
+
+        printf("%d pipelined requests, %s: %.2f allocations, %.2f reads, %lld ns per request\n", BATCH,
+               vectored ? "vectored send" : "copied to one send", (double) s_allocs / (ROUNDS * BATCH),
+               (double) f.input.recv_calls / (ROUNDS * BATCH), (long long) (elapsed / (ROUNDS * BATCH)));
+#if CONFIG_HTTPD_SESS_ARENA && COUNT_ALLOCS
+        CHECK(s_allocs == 0);
+#endif
+    }
+}
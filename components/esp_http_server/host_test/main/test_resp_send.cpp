@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "request_fixture.hpp"
+
+namespace {
+
+const char RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Content-Length: 5\r\n"
+    "Cache-Control: no-store\r\n"
+    "X-Request: test\r\n"
+    "\r\n"
+    "hello";
+
+const char CHUNKED_RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Cache-Control: no-store\r\n"
+    "\r\n"
+    "5\r\nhello\r\n"
+    "6\r\n world\r\n"
+    "0\r\n\r\n";
+
+} // namespace
+
+TEST_CASE("response goes out with a single vectored send", "[resp_send]")
+{
+    RequestFixture f;
+    CHECK(httpd_resp_set_hdr(f.req, "Cache-Control", "no-store") == ESP_OK);
+    CHECK(httpd_resp_set_hdr(f.req, "X-Request", "test") == ESP_OK);
+    CHECK(httpd_resp_send(f.req, "hello", HTTPD_RESP_USE_STRLEN) == ESP_OK);
+    CHECK(f.transport.out == RESPONSE);
+    CHECK(f.transport.sendv_calls == 1);
+    CHECK(f.transport.send_calls == 0);
+}
+
+TEST_CASE("response is copied for a session without vectored send", "[resp_send]")
+{
+    RequestFixture f;
+    f.sd.sendv_fn = NULL;
+    CHECK(httpd_resp_set_hdr(f.req, "Cache-Control", "no-store") == ESP_OK);
+    CHECK(httpd_resp_set_hdr(f.req, "X-Request", "test") == ESP_OK);
+    CHECK(httpd_resp_send(f.req, "hello", HTTPD_RESP_USE_STRLEN) == ESP_OK);
+    CHECK(f.transport.out == RESPONSE);
+    CHECK(f.transport.send_calls == 1);
+}
+
+TEST_CASE("headers are copied together and a large body is sent on its own without vectored send", "[resp_send]")
+{
+    RequestFixture f;
+    f.sd.sendv_fn = NULL;
+    std::string body(4000, 'b');
+    CHECK(httpd_resp_set_hdr(f.req, "Cache-Control", "no-store") == ESP_OK);
+    CHECK(httpd_resp_set_hdr(f.req, "X-Request", "test") == ESP_OK);
+    CHECK(httpd_resp_send(f.req, body.data(), body.size()) == ESP_OK);
+    std::string expected = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 4000\r\n"
+                           "Cache-Control: no-store\r\nX-Request: test\r\n\r\n" + body;
+    CHECK(f.transport.out == expected);
+    CHECK(f.transport.send_calls == 2);
+}
+
+TEST_CASE("partial sends are continued", "[resp_send]")
+{
+    for (bool vectored : {true, false}) {
+        RequestFixture f;
+        f.transport.max_send = 3;
+        if (!vectored) {
+            f.sd.sendv_fn = NULL;
+        }
+        CHECK(httpd_resp_set_hdr(f.req, "Cache-Control", "no-store") == ESP_OK);
+        CHECK(httpd_resp_set_hdr(f.req, "X-Request", "test") == ESP_OK);
+        CHECK(httpd_resp_send(f.req, "hello", HTTPD_RESP_USE_STRLEN) == ESP_OK);
+        CHECK(f.transport.out == RESPONSE);
+    }
+}
+
+TEST_CASE("headers more than fit in one batch", "[resp_send]")
+{
+    RequestFixture f;
+    std::string expected = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 2\r\n";
+    const char *names[] = {"A", "B", "C", "D", "E", "F", "G", "H"};
+    for (const char *name : names) {
+        CHECK(httpd_resp_set_hdr(f.req, name, "value") == ESP_OK);
+        expected += std::string(name) + ": value\r\n";
+    }
+    expected += "\r\nok";
+    CHECK(httpd_resp_send(f.req, "ok", 2) == ESP_OK);
+    CHECK(f.transport.out == expected);
+    CHECK(f.transport.sendv_calls == 2);
+}
+
+TEST_CASE("chunks go out with one send each, the first one along with the headers", "[resp_send]")
+{
+    RequestFixture f;
+    CHECK(httpd_resp_set_hdr(f.req, "Cache-Control", "no-store") == ESP_OK);
+    CHECK(httpd_resp_send_chunk(f.req, "hello", HTTPD_RESP_USE_STRLEN) == ESP_OK);
+    CHECK(httpd_resp_send_chunk(f.req, " world", HTTPD_RESP_USE_STRLEN) == ESP_OK);
+    CHECK(httpd_resp_send_chunk(f.req, NULL, 0) == ESP_OK);
+    CHECK(f.transport.out == CHUNKED_RESPONSE);
+    CHECK(f.transport.sendv_calls == 3);
+}
+
+TEST_CASE("failing transport fails the response", "[resp_send]")
+{
+    RequestFixture f;
+    f.sd.sendv_fn = [](httpd_handle_t, int, const struct iovec *, int, int) {
+        return HTTPD_SOCK_ERR_FAIL;
+    };
+    CHECK(httpd_resp_send(f.req, "hello", HTTPD_RESP_USE_STRLEN) == ESP_ERR_HTTPD_RESP_SEND);
+}
+
+TEST_CASE("response assembly benchmark", "[resp_send][bench]")
+{
+    const int ROUNDS = 20000;
+    char body[100];
+    memset(body, 'x', sizeof(body));
+
+    for (bool vectored : {true, false}) {
+        RequestFixture f;
+        if (!vectored) {
+            f.sd.sendv_fn = NULL;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            f.hd->hd_req_aux.resp_hdrs_count = 0;
+            httpd_resp_set_hdr(f.req, "Cache-Control", "no-store");
+            httpd_resp_set_hdr(f.req, "Access-Control-Allow-Origin", "*");
+            httpd_resp_set_hdr(f.req, "X-Request", "bench");
+            CHECK(httpd_resp_send(f.req, body, sizeof(body)) == ESP_OK);
+            f.transport.out.clear();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        printf("Response with 3 headers and 100 bytes, %s: %.2f transport calls, %lld ns per response\n",
+               vectored ? "vectored send" : "copied to one send",
+               (double) (f.transport.send_calls + f.transport.sendv_calls) / ROUNDS, (long long) (elapsed / ROUNDS));
+    }
+}
@@ -0,0 +1,336 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "request_fixture.hpp"
+
+namespace {
+
+/* Writes asset images like httpd_static_gen.py */
+class ImageBuilder {
+public:
+    void add(const std::string &path, const std::string &type, const std::string &data,
+             const std::string &gz_data = "", bool gzip_only = false)
+    {
+        files[path] = File{type, data, gz_data, gzip_only};
+    }
+
+    std::vector<uint8_t> build()
+    {
+        std::vector<uint8_t> strings, data;
+        uint32_t strings_start = 16 + 36 * files.size();
+        auto add_string = [&](const std::string &s) {
+            uint32_t offset = strings_start + strings.size();
+            strings.insert(strings.end(), s.begin(), s.end());
+            strings.push_back(0);
+            return offset;
+        };
+        auto add_data = [&](const std::string &d) {
+            uint32_t offset = data.size();
+            data.insert(data.end(), d.begin(), d.end());
+            data.resize((data.size() + 3) & ~3);
+            return offset;
+        };
+
+        std::vector<std::vector<uint32_t>> entries;
+        for (auto &[path, file] : files) {
+            bool gzip = !file.gz_data.empty();
+            entries.push_back({add_string(path), add_string(file.type), add_string(etag(file.data)),
+                               gzip ? add_string(etag(file.gz_data)) : 0, add_data(file.data), (uint32_t) file.data.size(),
+                               gzip ? add_data(file.gz_data) : 0, (uint32_t) file.gz_data.size(),
+                               (gzip ? 1u : 0u) | (file.gzip_only ? 2u : 0u)
+                              });
+        }
+        strings.resize(((strings_start + strings.size() + 3) & ~3) - strings_start);
+        uint32_t data_start = strings_start + strings.size();
+
+        std::vector<uint8_t> image;
+        auto put = [&](uint32_t value, int size) {
+            for (int i = 0; i < size; i++) {
+                image.push_back(value >> (8 * i));
+            }
+        };
+        put(0x53415448, 4);
+        put(1, 2);
+        put(files.size(), 2);
+        put(data_start + data.size(), 4);
+        put(0, 4);
+        for (auto &entry : entries) {
+            entry[4] += data_start;
+            if (entry[8] & 1) {
+                entry[6] += data_start;
+            }
+            for (uint32_t value : entry) {
+                put(value, 4);
+            }
+        }
+        image.insert(image.end(), strings.begin(), strings.end());
+        image.insert(image.end(), data.begin(), data.end());
+        return image;
+    }
+
+    static std::string etag(const std::string &data)
+    {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "\"%016zx\"", std::hash<std::string>()(data));
+        return buf;
+    }
+
+private:
+    struct File {
+        std::string type, data, gz_data;
+        bool gzip_only;
+    };
+    std::map<std::string, File> files;
+};
+
+/* Status line, headers and body of a response */
+struct Response {
+    Response(const std::string &raw)
+    {
+        size_t end = raw.find("\r\n\r\n");
+        REQUIRE(end != std::string::npos);
+        body = raw.substr(end + 4);
+        size_t pos = raw.find("\r\n");
+        status = raw.substr(9, pos - 9);
+        while (pos < end) {
+            size_t next = raw.find("\r\n", pos + 2);
+            std::string line = raw.substr(pos + 2, next - pos - 2);
+            size_t colon = line.find(": ");
+            headers[line.substr(0, colon)] = line.substr(colon + 2);
+            pos = next;
+        }
+    }
+
+    std::string status;
+    std::map<std::string, std::string> headers;
+    std::string body;
+};
+
+const std::string APP_JS = std::string(3000, 'a') + std::string(3000, 'b');
+const std::string APP_JS_GZ = "compressed app.js";
+
+class StaticFixture : public RequestFixture {
+public:
+    StaticFixture(const char *prefix = "/")
+    {
+        ImageBuilder builder;
+        builder.add("index.html", "text/html", "<html>home</html>");
+        builder.add("js/app.js", "application/javascript", APP_JS, APP_JS_GZ);
+        builder.add("img/logo.svg", "image/svg+xml", "", "compressed logo", true);
+        builder.add("docs/index.html", "text/html", "<html>docs</html>");
+        builder.add("empty.txt", "text/plain", "");
+        image = builder.build();
+
+        httpd_static_config_t config = HTTPD_STATIC_CONFIG_DEFAULT();
+        config.uri_prefix = prefix;
+        config.image = image.data();
+        config.image_len = image.size();
+        REQUIRE(httpd_static_register(hd, &config, &stat) == ESP_OK);
+    }
+
+    ~StaticFixture()
+    {
+        if (stat) {
+            CHECK(httpd_static_unregister(hd, stat) == ESP_OK);
+        }
+    }
+
+    Response get(const char *uri, const std::vector<std::string> &headers = {})
+    {
+        request(uri, headers);
+        CHECK(handle() == ESP_OK);
+        return Response(transport.out);
+    }
+
+    std::vector<uint8_t> image;
+    httpd_static_handle_t stat;
+};
+
+} // namespace
+
+TEST_CASE("files are served from the image", "[static]")
+{
+    StaticFixture f;
+    Response r = f.get("/js/app.js");
+    CHECK(r.status == "200 OK");
+    CHECK(r.body == APP_JS);
+    CHECK(r.headers["Content-Type"] == "application/javascript");
+    CHECK(r.headers["Content-Length"] == std::to_string(APP_JS.size()));
+    CHECK(r.headers["ETag"] == ImageBuilder::etag(APP_JS));
+    CHECK(r.headers["Cache-Control"] == "no-cache");
+    CHECK(r.headers["Vary"] == "Accept-Encoding");
+    CHECK(r.headers.count("Content-Encoding") == 0);
+    // the body is sent from the image, along with the headers
+    CHECK(f.transport.sendv_calls == 1);
+
+    CHECK(f.get("/").body == "<html>home</html>");
+    CHECK(f.get("/?lang=en").body == "<html>home</html>");
+    CHECK(f.get("/docs/").body == "<html>docs</html>");
+    CHECK(f.get("/empty.txt").headers["Content-Length"] == "0");
+    CHECK(f.get("/missing.html").status == "404 Not Found");
+    CHECK(f.get("/docs").status == "404 Not Found");
+    CHECK(f.get("/js/app.jsx").status == "404 Not Found");
+    CHECK(f.get("/js/app.j").status == "404 Not Found");
+}
+
+TEST_CASE("files are served below a prefix", "[static]")
+{
+    StaticFixture f("/ui/");
+    CHECK(f.get("/ui/js/app.js").body == APP_JS);
+    CHECK(f.get("/ui/").body == "<html>home</html>");
+    CHECK(f.get("/ui/index.html").body == "<html>home</html>");
+
+    CHECK(httpd_static_unregister(f.hd, f.stat) == ESP_OK);
+    CHECK(f.calls[0] == NULL);
+    f.stat = NULL;
+}
+
+TEST_CASE("compressed variants are sent to clients accepting them", "[static]")
+{
+    StaticFixture f;
+    Response r = f.get("/js/app.js", {"Accept-Encoding: gzip, deflate, br"});
+    CHECK(r.body == APP_JS_GZ);
+    CHECK(r.headers["Content-Encoding"] == "gzip");
+    CHECK(r.headers["ETag"] == ImageBuilder::etag(APP_JS_GZ));
+    CHECK(r.headers["Vary"] == "Accept-Encoding");
+
+    CHECK(f.get("/js/app.js", {"Accept-Encoding: deflate, GZIP;q=0.5"}).body == APP_JS_GZ);
+    CHECK(f.get("/js/app.js", {"Accept-Encoding: *"}).body == APP_JS_GZ);
+    CHECK(f.get("/js/app.js", {"Accept-Encoding: gzip;q=0"}).body == APP_JS);
+    CHECK(f.get("/js/app.js", {"Accept-Encoding: br"}).body == APP_JS);
+    CHECK(f.get("/js/app.js", {"Accept-Encoding: gzipx"}).body == APP_JS);
+
+    // without an uncompressed variant, the compressed one is sent to every client
+    r = f.get("/img/logo.svg");
+    CHECK(r.body == "compressed logo");
+    CHECK(r.headers["Content-Encoding"] == "gzip");
+    CHECK(r.headers.count("Vary") == 0);
+}
+
+TEST_CASE("requests with a known ETag are answered with 304", "[static]")
+{
+    StaticFixture f;
+    std::string etag = ImageBuilder::etag(APP_JS);
+    Response r = f.get("/js/app.js", {"If-None-Match: " + etag});
+    CHECK(r.status == "304 Not Modified");
+    CHECK(r.body.empty());
+    CHECK(r.headers["ETag"] == etag);
+    // the headers describe the file the client has, not an empty body
+    CHECK(r.headers.count("Content-Length") == 0);
+    CHECK(r.headers.count("Content-Type") == 0);
+
+    CHECK(f.get("/js/app.js", {"If-None-Match: \"1234\", W/" + etag}).status == "304 Not Modified");
+    CHECK(f.get("/js/app.js", {"If-None-Match: *"}).status == "304 Not Modified");
+    CHECK(f.get("/js/app.js", {"If-None-Match: \"1234\""}).status == "200 OK");
+    // the ETag of the compressed variant differs
+    CHECK(f.get("/js/app.js", {"If-None-Match: " + etag, "Accept-Encoding: gzip"}).status == "200 OK");
+    CHECK(f.get("/js/app.js", {"If-None-Match: " + ImageBuilder::etag(APP_JS_GZ), "Accept-Encoding: gzip"}).status == "304 Not Modified");
+}
+
+TEST_CASE("byte ranges are served", "[static]")
+{
+    StaticFixture f;
+    const size_t size = APP_JS.size();
+    Response r = f.get("/js/app.js", {"Range: bytes=2990-3009"});
+    CHECK(r.status == "206 Partial Content");
+    CHECK(r.body == APP_JS.substr(2990, 20));
+    CHECK(r.headers["Content-Range"] == "bytes 2990-3009/" + std::to_string(size));
+    CHECK(r.headers["Content-Length"] == "20");
+    CHECK(r.headers["Accept-Ranges"] == "bytes");
+
+    CHECK(f.get("/js/app.js", {"Range: bytes=5990-"}).body == APP_JS.substr(5990));
+    CHECK(f.get("/js/app.js", {"Range: bytes=5990-100000"}).body == APP_JS.substr(5990));
+    CHECK(f.get("/js/app.js", {"Range: bytes=-10"}).body == APP_JS.substr(size - 10));
+    CHECK(f.get("/js/app.js", {"Range: bytes=-100000"}).body == APP_JS);
+
+    r = f.get("/js/app.js", {"Range: bytes=6000-"});
+    CHECK(r.status == "416 Range Not Satisfiable");
+    CHECK(r.headers["Content-Range"] == "bytes */" + std::to_string(size));
+    CHECK(r.body.empty());
+    CHECK(f.get("/js/app.js", {"Range: bytes=-0"}).status == "416 Range Not Satisfiable");
+
+    // invalid or multiple ranges, and stale If-Range, get the whole file
+    for (const char *range : {"bytes=10-5", "bytes=1-2,5-6", "bytes=x-", "lines=1-2", "bytes=-"}) {
+        r = f.get("/js/app.js", {std::string("Range: ") + range});
+        CHECK(r.status == "200 OK");
+        CHECK(r.body == APP_JS);
+    }
+    CHECK(f.get("/js/app.js", {"Range: bytes=0-0", "If-Range: \"1234\""}).body == APP_JS);
+    CHECK(f.get("/js/app.js", {"Range: bytes=0-0", "If-Range: " + ImageBuilder::etag(APP_JS)}).body == "a");
+}
+
+TEST_CASE("damaged images are refused", "[static]")
+{
+    RequestFixture f;
+    ImageBuilder builder;
+    builder.add("b.html", "text/html", "b");
+    builder.add("a.html", "text/html", "a");
+    std::vector<uint8_t> image = builder.build();
+
+    httpd_static_config_t config = HTTPD_STATIC_CONFIG_DEFAULT();
+    httpd_static_handle_t stat;
+    config.image = image.data();
+    config.image_len = image.size() - 1;
+    CHECK(httpd_static_register(f.hd, &config, &stat) == ESP_ERR_INVALID_SIZE);
+    config.image_len = image.size();
+    image[0] ^= 1;
+    CHECK(httpd_static_register(f.hd, &config, &stat) == ESP_ERR_INVALID_VERSION);
+    image[0] ^= 1;
+    image[16 + 4 * 4] = 0xff;   // data of the first entry out of the image
+    CHECK(httpd_static_register(f.hd, &config, &stat) == ESP_ERR_INVALID_SIZE);
+    CHECK(f.calls[0] == NULL);
+}
+
+TEST_CASE("static file benchmark", "[static][bench]")
+{
+    /* A web UI bundle, served either from the image, or copied in chunks
+     * into a buffer and sent with httpd_resp_send_chunk(), as read from a file */
+    const size_t SIZE = 600 * 1024;
+    const size_t CHUNK = 1024;
+    std::string bundle(SIZE, 'x');
+    ImageBuilder builder;
+    builder.add("bundle.js", "application/javascript", bundle);
+    std::vector<uint8_t> image = builder.build();
+
+    RequestFixture f;
+    f.transport.keep = false;
+    httpd_static_config_t config = HTTPD_STATIC_CONFIG_DEFAULT();
+    httpd_static_handle_t stat;
+    config.image = image.data();
+    config.image_len = image.size();
+    REQUIRE(httpd_static_register(f.hd, &config, &stat) == ESP_OK);
+
+    const int ROUNDS = 200;
+    for (bool from_image : {false, true}) {
+        int calls = f.transport.sendv_calls;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            f.request("/bundle.js");
+            if (from_image) {
+                CHECK(f.handle() == ESP_OK);
+            } else {
+                std::vector<char> buf(CHUNK);
+                for (size_t pos = 0; pos < SIZE; pos += CHUNK) {
+                    memcpy(buf.data(), bundle.data() + pos, CHUNK);
+                    httpd_resp_send_chunk(f.req, buf.data(), CHUNK);
+                }
+                httpd_resp_send_chunk(f.req, NULL, 0);
+            }
+            CHECK(f.transport.out_len > SIZE);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printf("Sending a %zu KB file, %s: %.0f MB/s, %.1f transport calls, %zu bytes of buffer\n", SIZE / 1024,
+               from_image ? "from the image" : "copied in 1 KB chunks", ROUNDS * SIZE / seconds / 1e6,
+               (double) (f.transport.sendv_calls - calls) / ROUNDS, from_image ? 0 : CHUNK);
+    }
+    CHECK(httpd_static_unregister(f.hd, stat) == ESP_OK);
+}
@@ -0,0 +1,225 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "uri_index.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+
+/* The handlers of a server, in the order of registration */
+class Handlers {
+public:
+    Handlers(bool wildcard) : wildcard(wildcard)
+    {
+        uri_index_init(&index, wildcard);
+    }
+
+    ~Handlers()
+    {
+        uri_index_clear(&index);
+    }
+
+    void add(const char *uri, httpd_method_t method)
+    {
+        templates.push_back(uri);
+        calls.push_back(httpd_uri_t{});
+        calls.back().method = method;
+    }
+
+    /* Done once all handlers are added, the vectors don't move anymore */
+    void build()
+    {
+        for (size_t i = 0; i < calls.size(); i++) {
+            calls[i].uri = templates[i].c_str();
+            REQUIRE(uri_index_add(&index, &calls[i]) == ESP_OK);
+        }
+    }
+
+    /* Same search as httpd_find_uri_handler() without the index */
+    httpd_uri_t *find_linear(const char *uri, size_t len, httpd_method_t method, httpd_err_code_t *err)
+    {
+        *err = HTTPD_404_NOT_FOUND;
+        for (auto &call : calls) {
+            bool match = wildcard ? httpd_uri_match_wildcard(call.uri, uri, len) :
+                         (strlen(call.uri) == len && strncmp(call.uri, uri, len) == 0);
+            if (match) {
+                if (call.method == method || call.method == HTTP_ANY) {
+                    *err = (httpd_err_code_t) 0;
+                    return &call;
+                }
+                *err = HTTPD_405_METHOD_NOT_ALLOWED;
+            }
+        }
+        return NULL;
+    }
+
+    httpd_uri_t *find_indexed(const char *uri, size_t len, httpd_method_t method, httpd_err_code_t *err)
+    {
+        return uri_index_find(&index, uri, len, method, err);
+    }
+
+    void check(const std::string &uri, httpd_method_t method)
+    {
+        httpd_err_code_t err_linear, err_indexed;
+        httpd_uri_t *linear = find_linear(uri.c_str(), uri.size(), method, &err_linear);
+        httpd_uri_t *indexed = find_indexed(uri.c_str(), uri.size(), method, &err_indexed);
+        INFO("uri '" << uri << "' method " << method);
+        CHECK(indexed == linear);
+        CHECK(err_indexed == err_linear);
+    }
+
+    bool wildcard;
+    uri_index_t index;
+    std::vector<std::string> templates;
+    std::vector<httpd_uri_t> calls;
+};
+
+const httpd_method_t METHODS[] = {HTTP_GET, HTTP_POST, HTTP_PUT};
+
+} // namespace
+
+TEST_CASE("index matches literal URIs", "[uri_index]")
+{
+    Handlers handlers(false);
+    handlers.add("/", HTTP_GET);
+    handlers.add("/api", HTTP_GET);
+    handlers.add("/api/status", HTTP_GET);
+    handlers.add("/api/status", HTTP_POST);
+    handlers.add("/api/stat", (httpd_method_t) HTTP_ANY);
+    handlers.add("/api*", HTTP_GET);
+    handlers.add("/api?", HTTP_GET);
+    handlers.build();
+
+    httpd_err_code_t err;
+    CHECK(handlers.find_indexed("/api/status", 11, HTTP_POST, &err) == &handlers.calls[3]);
+    CHECK(err == 0);
+    CHECK(handlers.find_indexed("/api/status", 11, HTTP_PUT, &err) == NULL);
+    CHECK(err == HTTPD_405_METHOD_NOT_ALLOWED);
+    CHECK(handlers.find_indexed("/api/statu", 10, HTTP_GET, &err) == NULL);
+    CHECK(err == HTTPD_404_NOT_FOUND);
+    // without wildcard matching, special characters are literal
+    CHECK(handlers.find_indexed("/api*", 5, HTTP_GET, &err) == &handlers.calls[5]);
+    CHECK(handlers.find_indexed("/apix", 5, HTTP_GET, &err) == NULL);
+
+    for (const char *uri : {"", "/", "/a", "/api", "/api/", "/api/stat", "/api/status", "/api/status/", "/api*", "/api?", "/ap"}) {
+        for (httpd_method_t method : METHODS) {
+            handlers.check(uri, method);
+        }
+    }
+}
+
+TEST_CASE("index matches wildcard templates", "[uri_index]")
+{
+    Handlers handlers(true);
+    handlers.add("/api/status", HTTP_GET);
+    handlers.add("/api/*", HTTP_POST);
+    handlers.add("/api/status", HTTP_POST);     // shadowed by "/api/*" for POST
+    handlers.add("/files?", HTTP_GET);          // "/file" and "/files"
+    handlers.add("/img?*", HTTP_GET);           // "/im" and "/img..."
+    handlers.add("/doc*?", HTTP_GET);           // same as "/doc?*"
+    handlers.add("/a*b", HTTP_GET);             // '*' inside the template is literal
+    handlers.add("?", HTTP_GET);                // invalid, never matches
+    handlers.add("*", HTTP_DELETE);
+    handlers.build();
+
+    httpd_err_code_t err;
+    CHECK(handlers.find_indexed("/api/status", 11, HTTP_POST, &err) == &handlers.calls[1]);
+    CHECK(handlers.find_indexed("/file", 5, HTTP_GET, &err) == &handlers.calls[3]);
+    CHECK(handlers.find_indexed("/filex", 6, HTTP_GET, &err) == NULL);
+    CHECK(handlers.find_indexed("/filex", 6, HTTP_POST, &err) == NULL);
+    CHECK(err == HTTPD_405_METHOD_NOT_ALLOWED);     // "*" matches with DELETE only
+
+    const char *uris[] = {
+        "", "/", "/api", "/api/", "/api/status", "/api/statusx", "/file", "/files", "/filesx", "/fil",
+        "/im", "/img", "/imgs/logo.png", "/imx", "/do", "/doc", "/documents", "/dox", "/a*b", "/axb", "?", "*",
+    };
+    for (const char *uri : uris) {
+        for (httpd_method_t method : {HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE}) {
+            handlers.check(uri, method);
+        }
+    }
+}
+
+TEST_CASE("index matches random templates like the linear search", "[uri_index]")
+{
+    std::mt19937 gen(42);
+    // a small alphabet makes templates share prefixes, which exercises splitting of nodes
+    const char alphabet[] = "ab/?*";
+    auto random_string = [&](size_t max_len) {
+        std::string s(std::uniform_int_distribution<size_t>(0, max_len)(gen), 'a');
+        for (auto &c : s) {
+            c = alphabet[std::uniform_int_distribution<size_t>(0, sizeof(alphabet) - 2)(gen)];
+        }
+        return s;
+    };
+
+    for (bool wildcard : {false, true}) {
+        for (int round = 0; round < 50; round++) {
+            Handlers handlers(wildcard);
+            for (int i = 0; i < 20; i++) {
+                handlers.add(random_string(6).c_str(), METHODS[gen() % 3]);
+            }
+            handlers.build();
+            for (int i = 0; i < 200; i++) {
+                handlers.check(random_string(8), METHODS[gen() % 3]);
+            }
+            for (auto &uri : handlers.templates) {
+                handlers.check(uri, HTTP_GET);
+            }
+        }
+    }
+}
+
+TEST_CASE("routing benchmark", "[uri_index][bench]")
+{
+    // handlers of a typical device UI: a REST API, pages and catch-alls for static files
+    const char *groups[] = {"wifi", "system", "ota", "log", "sensor", "schedule"};
+    const char *actions[] = {"status", "config", "scan", "list", "start", "stop", "reset", "info"};
+    Handlers handlers(true);
+    std::vector<std::string> requests;
+    for (const char *group : groups) {
+        for (const char *action : actions) {
+            std::string uri = std::string("/api/v1/") + group + "/" + action;
+            handlers.add(uri.c_str(), HTTP_GET);
+            requests.push_back(uri);
+        }
+    }
+    for (const char *page : {"/", "/index.html", "/settings.html", "/update.html", "/ws", "/favicon.ico"}) {
+        handlers.add(page, HTTP_GET);
+        requests.push_back(page);
+    }
+    handlers.add("/api/v1/*", HTTP_POST);
+    handlers.add("/static/*", HTTP_GET);
+    handlers.add("/img?*", HTTP_GET);
+    requests.push_back("/static/js/app.js");
+    requests.push_back("/img/logo.png");
+    requests.push_back("/missing");
+    handlers.build();
+
+    const int ROUNDS = 2000;
+    for (bool use_index : {false, true}) {
+        size_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            for (auto &uri : requests) {
+                httpd_err_code_t err;
+                found += (use_index ? handlers.find_indexed(uri.c_str(), uri.size(), HTTP_GET, &err) :
+                          handlers.find_linear(uri.c_str(), uri.size(), HTTP_GET, &err)) != NULL;
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        CHECK(found == ROUNDS * (requests.size() - 1));
+
+        printf("Lookup among %zu handlers, %s: %lld ns per request\n", handlers.calls.size(),
+               use_index ? "radix tree" : "linear search", (long long) (elapsed / (ROUNDS * (int64_t) requests.size())));
+    }
+}
@@ -0,0 +1,208 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "request_fixture.hpp"
+
+namespace {
+
+const uint8_t MASK_KEY[4] = {0x12, 0x34, 0x56, 0x78};
+
+void unmask_bytewise(uint8_t *payload, size_t len, const uint8_t *mask_key)
+{
+    for (size_t idx = 0; idx < len; idx++) {
+        payload[idx] ^= mask_key[idx % 4];
+    }
+}
+
+std::vector<uint8_t> pattern(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t) (i * 7 + 3);
+    }
+    return data;
+}
+
+int failing_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    return HTTPD_SOCK_ERR_FAIL;
+}
+
+/* A server with WebSocket clients, besides the session of the current request */
+class WsFixture : public RequestFixture {
+public:
+    WsFixture()
+    {
+        for (size_t i = 0; i < CLIENTS; i++) {
+            struct sock_db *client = &clients[i];
+            memset(client, 0, sizeof(*client));
+            client->fd = 10 + i;
+            client->handle = hd;
+            client->send_fn = capture_send;
+            client->sendv_fn = capture_sendv;
+            client->ws_handshake_done = true;
+        }
+        hd->hd_sd = clients;
+        hd->config.max_open_sockets = CLIENTS;
+    }
+
+    static const size_t CLIENTS = 4;
+    struct sock_db clients[CLIENTS];
+};
+
+std::string frame_bytes(uint8_t first, const std::string &payload)
+{
+    std::string frame(1, (char) first);
+    size_t len = payload.size();
+    if (len <= 125) {
+        frame += (char) len;
+    } else if (len <= UINT16_MAX) {
+        frame += (char) 126;
+        frame += (char) (len >> 8);
+        frame += (char) len;
+    } else {
+        frame += (char) 127;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame += (char) ((uint64_t) len >> shift);
+        }
+    }
+    return frame + payload;
+}
+
+} // namespace
+
+TEST_CASE("payload is unmasked like byte by byte", "[ws]")
+{
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len : {1, 3, 4, 7, 8, 9, 15, 16, 17, 63, 64, 100, 1000}) {
+            std::vector<uint8_t> expected = pattern(offset + len);
+            std::vector<uint8_t> data = expected;
+            unmask_bytewise(expected.data() + offset, len, MASK_KEY);
+            CHECK(httpd_ws_unmask_payload(data.data() + offset, len, MASK_KEY) == ESP_OK);
+            CHECK(data == expected);
+        }
+    }
+    uint8_t byte = 0;
+    CHECK(httpd_ws_unmask_payload(&byte, 0, MASK_KEY) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("frame goes out with a single send", "[ws]")
+{
+    for (size_t len : {0, 1, 125, 126, 65535, 65536}) {
+        WsFixture f;
+        std::string payload(len, 'p');
+        httpd_ws_frame_t frame = {};
+        frame.type = HTTPD_WS_TYPE_BINARY;
+        frame.payload = (uint8_t *) payload.data();
+        frame.len = len;
+
+        CHECK(httpd_ws_send_frame_async(f.hd, f.clients[0].fd, &frame) == ESP_OK);
+        CHECK(f.transport.out == frame_bytes(0x82, payload));
+        CHECK(f.transport.sendv_calls == 1);
+        CHECK(f.transport.send_calls == 0);
+    }
+}
+
+TEST_CASE("frame is sent completely without vectored send", "[ws]")
+{
+    for (size_t max_send : {(size_t) 3, SIZE_MAX}) {
+        WsFixture f;
+        f.clients[0].sendv_fn = NULL;
+        f.transport.max_send = max_send;
+        std::string payload = "hello";
+        httpd_ws_frame_t frame = {};
+        frame.type = HTTPD_WS_TYPE_TEXT;
+        frame.payload = (uint8_t *) payload.data();
+        frame.len = payload.size();
+
+        CHECK(httpd_ws_send_frame_async(f.hd, f.clients[0].fd, &frame) == ESP_OK);
+        CHECK(f.transport.out == frame_bytes(0x81, payload));
+        CHECK(f.transport.sendv_calls == 0);
+        if (max_send == SIZE_MAX) {
+            CHECK(f.transport.send_calls == 1);
+        }
+    }
+}
+
+TEST_CASE("broadcast reaches the other clients if one fails", "[ws]")
+{
+    WsFixture f;
+    f.clients[1].sendv_fn = NULL;
+    f.clients[2].send_fn = failing_send;
+    f.clients[2].sendv_fn = NULL;
+    f.clients[3].ws_handshake_done = false;
+
+    std::string payload = "news";
+    httpd_ws_frame_t frame = {};
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *) payload.data();
+    frame.len = payload.size();
+
+    size_t sent = 0;
+    CHECK(httpd_ws_broadcast_frame(f.hd, NULL, 0, &frame, &sent) == ESP_FAIL);
+    CHECK(sent == 2);
+    CHECK(f.transport.out == frame_bytes(0x81, payload) + frame_bytes(0x81, payload));
+
+    /* Given clients only, unknown ones fail */
+    f.transport.clear();
+    const int fds[] = {f.clients[0].fd, f.clients[3].fd, 99};
+    CHECK(httpd_ws_broadcast_frame(f.hd, fds, 3, &frame, &sent) == ESP_FAIL);
+    CHECK(sent == 2);
+    CHECK(f.transport.out == frame_bytes(0x81, payload) + frame_bytes(0x81, payload));
+
+    CHECK(httpd_ws_broadcast_frame(f.hd, fds, 2, &frame, &sent) == ESP_OK);
+    CHECK(httpd_ws_broadcast_frame(f.hd, NULL, 1, &frame, &sent) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("WebSocket benchmark", "[ws][bench]")
+{
+    const size_t LEN = 64 * 1024;
+    const int ROUNDS = 2000;
+    std::vector<uint8_t> data = pattern(LEN);
+
+    for (bool wordwise : {false, true}) {
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            if (wordwise) {
+                httpd_ws_unmask_payload(data.data(), LEN, MASK_KEY);
+            } else {
+                unmask_bytewise(data.data(), LEN, MASK_KEY);
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        printf("Unmask %zu bytes, %s: %.0f MB/s\n", LEN, wordwise ? "word at a time" : "byte by byte",
+               (double) LEN * ROUNDS * 1000 / elapsed);
+    }
+
+    const int FRAMES = 20000;
+    std::string payload(100, 'b');
+    httpd_ws_frame_t frame = {};
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *) payload.data();
+    frame.len = payload.size();
+
+    for (bool broadcast : {false, true}) {
+        WsFixture f;
+        f.transport.keep = false;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < FRAMES; round++) {
+            if (broadcast) {
+                httpd_ws_broadcast_frame(f.hd, NULL, 0, &frame, NULL);
+            } else {
+                for (auto &client : f.clients) {
+                    httpd_ws_send_frame_async(f.hd, client.fd, &frame);
+                }
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        printf("Frame of 100 bytes to %zu clients, %s: %.0f frames/s\n", WsFixture::CLIENTS,
+               broadcast ? "broadcast" : "sent to each", (double) FRAMES * WsFixture::CLIENTS * 1e9 / elapsed);
+    }
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python
+#
+# httpd_static_gen is a tool used to generate the asset images served by
+# httpd_static_register() of esp_http_server
+#
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+import argparse
+import gzip
+import hashlib
+import mimetypes
+import os
+import struct
+import sys
+
+MAGIC = 0x53415448  # "HTAS"
+VERSION = 1
+
+HEADER = struct.Struct('<IHHII')
+ENTRY = struct.Struct('<IIIIIIIII')
+
+HAS_GZIP = 1 << 0
+GZIP_ONLY = 1 << 1
+
+# Compressed variants are only kept if they save at least this fraction of the size
+GZIP_MIN_SAVING = 0.1
+
+
+class Asset(object):
+    def __init__(self, path):  # type: (str) -> None
+        self.path = path
+        self.data = None  # type: bytes | None
+        self.gz_data = None  # type: bytes | None
+
+
+def etag(data):  # type: (bytes) -> str
+    return '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+
+
+def content_type(path):  # type: (str) -> str
+    mime, _ = mimetypes.guess_type(path)
+    if mime is None:
+        return 'application/octet-stream'
+    if mime.startswith('text/') or mime in ('application/javascript', 'application/json'):
+        return mime + '; charset=utf-8'
+    return mime
+
+
+def collect(base_dir, compress):  # type: (str, bool) -> list[Asset]
+    assets = {}  # type: dict[str, Asset]
+    for root, dirs, files in os.walk(base_dir):
+        dirs.sort()
+        for name in sorted(files):
+            full_path = os.path.join(root, name)
+            path = os.path.relpath(full_path, base_dir).replace(os.sep, '/')
+            with open(full_path, 'rb') as f:
+                data = f.read()
+            if path.endswith('.gz'):
+                # Precompressed variant of the file without the suffix
+                asset = assets.setdefault(path[:-3], Asset(path[:-3]))
+                asset.gz_data = data
+            else:
+                asset = assets.setdefault(path, Asset(path))
+                asset.data = data
+
+    if compress:
+        for asset in assets.values():
+            if asset.data is not None and asset.gz_data is None:
+                gz_data = gzip.compress(asset.data, compresslevel=9, mtime=0)
+                if len(gz_data) <= len(asset.data) * (1 - GZIP_MIN_SAVING):
+                    asset.gz_data = gz_data
+    return sorted(assets.values(), key=lambda a: a.path.encode('utf-8'))
+
+
+def build_image(assets):  # type: (list[Asset]) -> bytes
+    if len(assets) > 0xFFFF:
+        raise RuntimeError('Too many files: %d' % len(assets))
+
+    strings = bytearray()
+    string_offsets = {}  # type: dict[str, int]
+    data = bytearray()
+    strings_start = HEADER.size + ENTRY.size * len(assets)
+
+    def add_string(s):  # type: (str) -> int
+        if s not in string_offsets:
+            string_offsets[s] = strings_start + len(strings)
+            strings.extend(s.encode('utf-8') + b'\0')
+        return string_offsets[s]
+
+    def add_data(blob):  # type: (bytes) -> int
+        offset = len(data)
+        data.extend(blob)
+        data.extend(b'\0' * (-len(data) % 4))
+        return offset
+
+    records = []
+    for asset in assets:
+        flags = 0
+        gz_etag = gz_data = gz_len = 0
+        if asset.gz_data is not None:
+            flags |= HAS_GZIP
+            gz_etag = add_string(etag(asset.gz_data))
+            gz_data = add_data(asset.gz_data)
+            gz_len = len(asset.gz_data)
+        if asset.data is None:
+            # Only a precompressed file was given
+            flags |= GZIP_ONLY
+        identity = asset.data if asset.data is not None else b''
+        records.append([add_string(asset.path), add_string(content_type(asset.path)), add_string(etag(identity)),
+                        gz_etag, add_data(identity), len(identity), gz_data, gz_len, flags])
+
+    # File data follows the strings, 4 byte aligned
+    strings.extend(b'\0' * (-(strings_start + len(strings)) % 4))
+    data_start = strings_start + len(strings)
+    entries = bytearray()
+    for r in records:
+        r[4] += data_start
+        if r[8] & HAS_GZIP:
+            r[6] += data_start
+        entries.extend(ENTRY.pack(*r))
+
+    size = data_start + len(data)
+    return HEADER.pack(MAGIC, VERSION, len(assets), size, 0) + bytes(entries) + bytes(strings) + bytes(data)
+
+
+def main():  # type: () -> None
+    parser = argparse.ArgumentParser(description='Asset image generator for the static file handler of esp_http_server')
+
+    parser.add_argument('image_size',
+                        help='Size of the created image, the unused part is filled with 0xFF. '
+                             'Use 0 for an image of the size of its contents.',
+                        type=lambda x: int(x, 0))
+
+    parser.add_argument('base_dir',
+                        help='Path to directory from which the image will be created')
+
+    parser.add_argument('output_file',
+                        help='Created image output file path')
+
+    parser.add_argument('--gzip',
+                        help='Add a gzip compressed variant of the files where it saves space. '
+                             'Files ending with .gz are always taken as compressed variant '
+                             'of the file without the suffix.',
+                        action='store_true',
+                        default=False)
+
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.base_dir):
+        raise RuntimeError('Given base directory %s does not exist' % args.base_dir)
+
+    assets = collect(args.base_dir, args.gzip)
+    image = build_image(assets)
+    if args.image_size:
+        if len(image) > args.image_size:
+            raise RuntimeError('Asset image of %d bytes does not fit into %d bytes' % (len(image), args.image_size))
+        image += b'\xff' * (args.image_size - len(image))
+
+    with open(args.output_file, 'wb') as f:
+        f.write(image)
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except RuntimeError as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <http_parser.h>
@@ -33,7 +34,8 @@ typedef enum {
     HTTP_SERVER_EVENT_START,           /*!< This event occurs when HTTP Server is started */
     HTTP_SERVER_EVENT_ON_CONNECTED,    /*!< Once the HTTP Server has been connected to the client, no data exchange has been performed */
     HTTP_SERVER_EVENT_ON_HEADER,       /*!< Occurs when receiving each header sent from the client */
-    HTTP_SERVER_EVENT_HEADERS_SENT,     /*!< After sending all the headers to the client */
+    HTTP_SERVER_EVENT_HEADERS_SENT,     /*!< After sending all the headers to the client. httpd_resp_send() sends the headers
+                                             together with the content, the event follows the content then */
     HTTP_SERVER_EVENT_ON_DATA,         /*!< Occurs when receiving data from the client */
     HTTP_SERVER_EVENT_SENT_DATA,       /*!< Occurs when an ESP HTTP server session is finished */
     HTTP_SERVER_EVENT_DISCONNECTED,    /*!< The connection has been disconnected */
@@ -78,7 +80,8 @@ initializer that should be kept in sync
         .keep_alive_count = 0,                          \
         .open_fn = NULL,                                \
         .close_fn = NULL,                               \
-        .uri_match_fn = NULL                            \
+        .uri_match_fn = NULL,                           \
+        .worker_count = 0                               \
 }
 
 #define ESP_ERR_HTTPD_BASE              (0xb000)                    /*!< Starting number of HTTPD error codes */
@@ -286,6 +289,20 @@ typedef struct httpd_config {
      * of the `httpd_uri_match_func_t` function prototype)
      */
     httpd_uri_match_func_t uri_match_fn;
+
+    /**
+     * Number of worker tasks processing the requests, requires CONFIG_HTTPD_WORKERS.
+     *
+     * With 0 the server task receives and processes all requests itself, one session after the other.
+     * Otherwise the server task only accepts connections and polls the sockets, and hands every session
+     * with incoming data to one of the worker tasks. The requests of a session are still processed in order,
+     * by one worker at a time.
+     *
+     * The workers are created with the task_priority, stack_size, core_id and task_caps settings of the
+     * server task. Note that work queued with httpd_queue_work() is executed by the server task and may
+     * therefore run at the same time as URI handlers.
+     */
+    uint8_t worker_count;
 } httpd_config_t;
 
 /**
@@ -710,6 +727,29 @@ esp_err_t httpd_register_err_handler(httpd_handle_t handle,
  */
 typedef int (*httpd_send_func_t)(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags);
 
+/**
+ * @brief  Prototype for HTTPDs low-level vectored send function
+ *
+ * Sends the buffers described by iov one after the other, like sendmsg().
+ * The responses are assembled as such a list of buffers, so that the status
+ * line, the headers and the content go out with a single call.
+ *
+ * @note   Same as for httpd_send_func_t, errors must be handled internally
+ *         and returned as HTTPD_SOCK_ERR_ codes
+ *
+ * @param[in] hd        server instance
+ * @param[in] sockfd    session socket file descriptor
+ * @param[in] iov       buffers with bytes to send
+ * @param[in] iovcnt    number of buffers
+ * @param[in] flags     flags for the sendmsg() function
+ * @return
+ *  - Bytes : The number of bytes sent successfully, possibly less than the total size of the buffers
+ *  - HTTPD_SOCK_ERR_INVALID  : Invalid arguments
+ *  - HTTPD_SOCK_ERR_TIMEOUT  : Timeout/interrupted while calling socket sendmsg()
+ *  - HTTPD_SOCK_ERR_FAIL     : Unrecoverable error while calling socket sendmsg()
+ */
+typedef int (*httpd_sendv_func_t)(httpd_handle_t hd, int sockfd, const struct iovec *iov, int iovcnt, int flags);
+
 /**
  * @brief  Prototype for HTTPDs low-level recv function
  *
@@ -802,6 +842,31 @@ esp_err_t httpd_sess_set_recv_override(httpd_handle_t hd, int sockfd, httpd_recv
  */
 esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func);
 
+/**
+ * @brief   Override web server's vectored send function (by session FD)
+ *
+ * This function overrides the function used to send a response made of
+ * several buffers at once. Without it, these buffers are copied into one
+ * and passed to the send function of the session.
+ *
+ * @note    Overriding the send function with httpd_sess_set_send_override()
+ *          unsets the vectored send function, as it would bypass the new send
+ *          function. So, if both are overridden, this has to be called last.
+ *
+ * @note    This API is supposed to be called either from the context of
+ *          - an http session APIs where sockfd is a valid parameter
+ *          - a URI handler where sockfd is obtained using httpd_req_to_sockfd()
+ *
+ * @param[in] hd         HTTPD instance handle
+ * @param[in] sockfd     Session socket FD
+ * @param[in] sendv_func The vectored send function to be set for this session, NULL to not use one
+ *
+ * @return
+ *  - ESP_OK : On successfully registering override
+ *  - ESP_ERR_INVALID_ARG : Null arguments
+ */
+esp_err_t httpd_sess_set_sendv_override(httpd_handle_t hd, int sockfd, httpd_sendv_func_t sendv_func);
+
 /**
  * @brief   Override web server's pending function (by session FD)
  *
@@ -1095,6 +1160,8 @@ bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match
  *  - Once this API is called, all request headers are purged, so
  *    request headers need be copied into separate buffers if
  *    they are required later.
+ *  - With status HTTPD_304, the Content-Type and Content-Length
+ *    headers are not sent and buf_len should be 0.
  *
  * @param[in] r         The request being responded to
  * @param[in] buf       Buffer from where the content is to be fetched
@@ -1193,10 +1260,13 @@ static inline esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *r, const char *str
 /* Some commonly used status codes */
 #define HTTPD_200      "200 OK"                     /*!< HTTP Response 200 */
 #define HTTPD_204      "204 No Content"             /*!< HTTP Response 204 */
+#define HTTPD_206      "206 Partial Content"        /*!< HTTP Response 206 */
 #define HTTPD_207      "207 Multi-Status"           /*!< HTTP Response 207 */
+#define HTTPD_304      "304 Not Modified"           /*!< HTTP Response 304 */
 #define HTTPD_400      "400 Bad Request"            /*!< HTTP Response 400 */
 #define HTTPD_404      "404 Not Found"              /*!< HTTP Response 404 */
 #define HTTPD_408      "408 Request Timeout"        /*!< HTTP Response 408 */
+#define HTTPD_416      "416 Range Not Satisfiable"  /*!< HTTP Response 416 */
 #define HTTPD_500      "500 Internal Server Error"  /*!< HTTP Response 500 */
 
 /**
@@ -1766,6 +1836,37 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *pkt);
  */
 esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame);
 
+/**
+ * @brief Send the same WebSocket frame to several clients
+ *
+ * The frame header is encoded once and the payload is sent from the given
+ * buffer to every client, which is cheaper than calling
+ * httpd_ws_send_frame_async() for each of them. A failure to send to one
+ * client doesn't stop the frame from being sent to the others.
+ *
+ * @note Like httpd_ws_send_frame_async(), this must be called from the server
+ *       task, to not interleave with other frames sent to the same clients:
+ *        - Without worker tasks (worker_count 0), from a URI handler or from
+ *          a work item queued with httpd_queue_work().
+ *        - With worker tasks (CONFIG_HTTPD_WORKERS), URI handlers run in the
+ *          workers, so only from a work item queued with httpd_queue_work().
+ *          Handlers which send frames to the same clients have to queue their
+ *          frames with httpd_queue_work() as well.
+ *
+ * @param[in]  hd        Server instance data
+ * @param[in]  fds       Socket descriptors of the clients, or NULL for all
+ *                       clients which completed the WebSocket handshake
+ * @param[in]  fd_count  Number of socket descriptors in fds
+ * @param[in]  frame     WebSocket frame
+ * @param[out] sent      Number of clients the frame was sent to (optional)
+ * @return
+ *  - ESP_OK                : Frame sent to every client
+ *  - ESP_FAIL              : Frame not sent to some of the clients
+ *  - ESP_ERR_INVALID_ARG   : Null arguments
+ */
+esp_err_t httpd_ws_broadcast_frame(httpd_handle_t hd, const int *fds, size_t fd_count,
+                                   httpd_ws_frame_t *frame, size_t *sent);
+
 /**
  * @brief Checks the supplied socket descriptor if it belongs to any active client
  * of this server instance and if the websoket protocol is active
@@ -1813,6 +1914,98 @@ esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_f
  * @}
  */
 
+/* ************** Group: Static Files ************** */
+/** @name Static Files
+ * Serving files from an asset image in flash or memory
+ * @{
+ */
+
+/**
+ * @brief Configuration of a static file handler
+ *
+ * The files are taken from an asset image created with httpd_static_gen.py,
+ * either found at image / image_len, or in the data partition named
+ * partition_label, which is then memory mapped.
+ */
+typedef struct httpd_static_config {
+    const char *uri_prefix;         /*!< URI under which the files are served, ending with '/' */
+    const void *image;              /*!< Asset image in memory, or NULL to use partition_label */
+    size_t      image_len;          /*!< Length of the memory at image */
+    const char *partition_label;    /*!< Label of the data partition holding the asset image */
+    const char *index_file;         /*!< File served for URIs ending with '/', may be NULL */
+    const char *cache_control;      /*!< Value of the Cache-Control header of the responses, may be NULL */
+} httpd_static_config_t;
+
+#define HTTPD_STATIC_CONFIG_DEFAULT() {         \
+        .uri_prefix      = "/",                 \
+        .image           = NULL,                \
+        .image_len       = 0,                   \
+        .partition_label = NULL,                \
+        .index_file      = "index.html",        \
+        .cache_control   = "no-cache",          \
+}
+
+/**
+ * @brief Handle of a registered static file handler
+ */
+typedef struct httpd_static *httpd_static_handle_t;
+
+/**
+ * @brief   Register a handler serving the files of an asset image
+ *
+ * The handler answers GET requests for uri_prefix followed by the path of
+ * a file in the image. The body of a response is sent straight from the
+ * image, which is either in memory or memory mapped flash, without being
+ * copied into an intermediate buffer.
+ *
+ * The responses carry the ETag of the file, a request with a matching
+ * If-None-Match header is answered with 304 Not Modified. Single byte
+ * ranges are served with 206 Partial Content. If the image holds a gzip
+ * compressed variant of a file, it is sent to clients accepting the gzip
+ * encoding.
+ *
+ * @note
+ *  - The handler is registered for the URI uri_prefix followed by '*',
+ *    so the server has to be configured with httpd_uri_match_wildcard()
+ *    as uri_match_fn.
+ *  - The handler has to be unregistered with httpd_static_unregister()
+ *    before the server is stopped, to release its memory and mapping.
+ *
+ * @param[in]  handle   Handle to server returned by httpd_start
+ * @param[in]  config   Configuration of the handler, the image in memory has
+ *                      to stay valid until the handler is unregistered
+ * @param[out] out      Handle of the registered handler
+ *
+ * @return
+ *  - ESP_OK                        : On success
+ *  - ESP_ERR_INVALID_ARG           : Null arguments or no image given
+ *  - ESP_ERR_NOT_FOUND             : Partition not found
+ *  - ESP_ERR_INVALID_VERSION       : Not an asset image, or of an unsupported version
+ *  - ESP_ERR_INVALID_SIZE          : Asset image corrupted or truncated
+ *  - ESP_ERR_HTTPD_ALLOC_MEM       : Failed to allocate memory for the handler
+ *  - ESP_ERR_HTTPD_HANDLER_EXISTS  : A handler for the URI is already registered
+ *  - ESP_ERR_HTTPD_HANDLERS_FULL   : No slot left for the handler
+ */
+esp_err_t httpd_static_register(httpd_handle_t handle, const httpd_static_config_t *config,
+                                httpd_static_handle_t *out);
+
+/**
+ * @brief   Unregister a static file handler and release its image
+ *
+ * @param[in] handle    Handle to server returned by httpd_start
+ * @param[in] stat      Handle of the static file handler
+ *
+ * @return
+ *  - ESP_OK                : On success
+ *  - ESP_ERR_INVALID_ARG   : Null arguments
+ *  - ESP_ERR_NOT_FOUND     : The handler isn't registered with the server
+ */
+esp_err_t httpd_static_unregister(httpd_handle_t handle, httpd_static_handle_t stat);
+
+/** End of Group Static Files
+ * @}
+ */
+
 #ifdef __cplusplus
 }
 #endif
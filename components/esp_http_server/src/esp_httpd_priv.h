@@ -17,6 +17,17 @@
 
 #include <esp_http_server.h>
 #include "osal.h"
+#if CONFIG_HTTPD_WORKERS
+#include <sys/poll.h>
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#endif
+#if CONFIG_HTTPD_URI_INDEX
+#include "uri_index.h"
+#endif
+#if CONFIG_HTTPD_SESS_ARENA
+#include "sess_arena.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,11 +73,17 @@ struct sock_db {
     httpd_free_ctx_fn_t free_ctx;      /*!< Function for freeing the context */
     httpd_free_ctx_fn_t free_transport_ctx; /*!< Function for freeing the 'transport' context */
     httpd_send_func_t send_fn;              /*!< Send function for this socket */
+    httpd_sendv_func_t sendv_fn;            /*!< Vectored send function for this socket, NULL to go through send_fn */
     httpd_recv_func_t recv_fn;              /*!< Receive function for this socket */
     httpd_pending_func_t pending_fn;        /*!< Pending function for this socket */
     uint64_t lru_counter;                   /*!< LRU Counter indicating when the socket was last used */
     bool lru_socket;                        /*!< Flag indicating LRU socket */
+#if CONFIG_HTTPD_SESS_ARENA
+    sess_arena_t arena;                     /*!< Memory of the requests, reset between them */
+    size_t pending_off;                     /*!< Offset of pending data to be received in the arena */
+#else
     char pending_data[PARSER_BLOCK_SIZE];   /*!< Buffer for pending data to be received */
+#endif
     size_t pending_len;                     /*!< Length of pending data to be received */
     bool for_async_req;                     /*!< If true, the socket will not be LRU purged */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
@@ -76,6 +93,11 @@ struct sock_db {
     bool ws_control_frames;                         /*!< WebSocket flag indicating that control frames should be passed to user handlers */
     void *ws_user_ctx;                         /*!< Pointer to user context data which will be available to handler for websocket*/
 #endif
+#if CONFIG_HTTPD_WORKERS
+    bool worker_busy;                       /*!< Set while the session is handed to a worker, only changed by the HTTPD thread */
+    bool worker_failed;                     /*!< Set by the worker if processing failed and the session has to be closed */
+    bool worker_close;                      /*!< Set if the session was to be closed while a worker processed it */
+#endif
 };
 
 /**
@@ -108,6 +130,19 @@ struct httpd_req_aux {
 #endif
 };
 
+#if CONFIG_HTTPD_WORKERS
+/**
+ * @brief   Worker task data. Every worker receives and processes its
+ *          requests in its own request structures.
+ */
+struct httpd_worker {
+    struct httpd_data *hd;                  /*!< Server instance */
+    struct thread_data td;                  /*!< Information for the worker thread */
+    struct httpd_req req;                   /*!< The request currently processed by this worker */
+    struct httpd_req_aux req_aux;           /*!< Additional data about the request */
+};
+#endif
+
 /**
  * @brief   Server data for each instance. This is exposed publicly as
  *          httpd_handle_t but internal structure/members are kept private.
@@ -124,9 +159,21 @@ struct httpd_data {
     struct sock_db *hd_sd;                  /*!< The socket database */
     int hd_sd_active_count;                 /*!< The number of the active sockets */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
+#if CONFIG_HTTPD_URI_INDEX
+    uri_index_t hd_uri_index;               /*!< Registered URI handlers by URI */
+    bool hd_uri_indexed;                    /*!< The index holds all handlers, otherwise they are searched one by one */
+#endif
     struct httpd_req hd_req;                /*!< The current HTTPD request */
     struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
     uint64_t lru_counter;                   /*!< LRU counter */
+#if CONFIG_HTTPD_WORKERS
+    struct httpd_worker *hd_workers;        /*!< Worker tasks, NULL if the HTTPD thread processes the requests */
+    QueueHandle_t hd_work_queue;            /*!< Sessions ready to be processed by a worker */
+    SemaphoreHandle_t hd_sd_lock;           /*!< Recursive mutex held while the socket database is changed by the HTTPD
+                                                 thread or searched by another task */
+    struct pollfd *hd_pfds;                 /*!< Descriptors polled by the HTTPD thread, the control and the listening
+                                                 socket followed by one entry per session of the socket database */
+#endif
 
     /* Array of registered error handler functions */
     httpd_err_handler_func_t *err_handler_fns;
@@ -141,9 +188,45 @@ struct httpd_data {
 // Enum function, which will be called for each session
 typedef int (*httpd_session_enum_function)(struct sock_db *session, void *context);
 
+/**
+ * @brief  Locks the socket database
+ *
+ * With worker tasks, request handlers look up and enumerate sessions while
+ * the HTTPD thread opens and closes them. The HTTPD thread holds the lock
+ * while it changes a session slot, any other task while it searches the
+ * database or accesses a session it doesn't process. The lock is recursive.
+ * Without workers, this does nothing.
+ *
+ * @param[in] hd    Server instance data
+ */
+static inline void httpd_sess_lock(struct httpd_data *hd)
+{
+#if CONFIG_HTTPD_WORKERS
+    if (hd && hd->hd_sd_lock) {
+        xSemaphoreTakeRecursive(hd->hd_sd_lock, portMAX_DELAY);
+    }
+#endif
+}
+
+/**
+ * @brief  Unlocks the socket database locked by httpd_sess_lock
+ *
+ * @param[in] hd    Server instance data
+ */
+static inline void httpd_sess_unlock(struct httpd_data *hd)
+{
+#if CONFIG_HTTPD_WORKERS
+    if (hd && hd->hd_sd_lock) {
+        xSemaphoreGiveRecursive(hd->hd_sd_lock);
+    }
+#endif
+}
+
 /**
  * @brief  Enumerates all sessions
  *
+ * The socket database is locked while the sessions are enumerated.
+ *
  * @param[in] hd            Server instance data
  * @param[in] enum_function Enumeration function, which will be called for each session
  * @param[in] context       Context, which will be passed to the enumeration function
@@ -269,6 +352,28 @@ bool httpd_is_sess_available(struct httpd_data *hd);
  */
 bool httpd_sess_pending(struct httpd_data *hd, struct sock_db *session);
 
+/**
+ * @brief   Allocates a temporary buffer while processing a request of a session
+ *
+ * With CONFIG_HTTPD_SESS_ARENA, the buffer is taken from the arena of the
+ * session if called by the task processing its request, else from the heap.
+ * Buffers must be freed in the reverse order of their allocation.
+ *
+ * @param[in] session  Session
+ * @param[in] len      Length of the buffer
+ *
+ * @return  The buffer, or NULL if out of memory
+ */
+void *httpd_sess_tmp_alloc(struct sock_db *session, size_t len);
+
+/**
+ * @brief   Frees a buffer allocated with httpd_sess_tmp_alloc()
+ *
+ * @param[in] session  Session
+ * @param[in] buf      The buffer
+ */
+void httpd_sess_tmp_free(struct sock_db *session, void *buf);
+
 /**
  * @brief   Removes the least recently used client from the session
  *
@@ -321,6 +426,18 @@ esp_err_t httpd_uri(struct httpd_data *hd);
  */
 void httpd_unregister_all_uri_handlers(struct httpd_data *hd);
 
+#if CONFIG_HTTPD_URI_INDEX
+/**
+ * @brief   (Re)builds the URI index from the registered handlers
+ *
+ * If the match function configured isn't supported by the index or
+ * memory runs out, the handlers are searched one by one instead.
+ *
+ * @param[in] hd   Server instance data
+ */
+void httpd_uri_index_rebuild(struct httpd_data *hd);
+#endif
+
 /**
  * @brief   Validates the request to prevent users from calling APIs, that are to
  *          be called only inside a URI handler, outside the handler context
@@ -352,6 +469,18 @@ bool httpd_validate_req_ptr(httpd_req_t *r);
  * @{
  */
 
+/**
+ * @brief   Returns the request structures used by the calling task, those
+ *          of its worker if the server runs worker tasks, otherwise the
+ *          ones of the server instance
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return Request, respectively additional request data of the calling task
+ */
+struct httpd_req *httpd_req_current(struct httpd_data *hd);
+struct httpd_req_aux *httpd_req_aux_current(struct httpd_data *hd);
+
 /**
  * @brief   Initiates the processing of HTTP request
  *
@@ -446,6 +575,10 @@ int httpd_recv_with_opt(httpd_req_t *r, char *buf, size_t buf_len, bool halt_aft
  * when httpd_recv is called, it first fetches this pending data and
  * then only starts receiving from the socket
  *
+ * With CONFIG_HTTPD_SESS_ARENA, the data must be in the scratch buffer
+ * of the request. It isn't copied then, but kept in place, and there is
+ * no limit on its length.
+ *
  * @note    If data is too large for the internal buffer then only
  *          part of the data is unreceived, reflected in the returned
  *          length. Make sure that such truncation is checked for and
@@ -476,6 +609,54 @@ size_t httpd_unrecv(struct httpd_req *r, const char *buf, size_t buf_len);
  */
 int httpd_default_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags);
 
+/**
+ * @brief   This is the low level default vectored send function of the HTTPD.
+ *          This should NEVER be called directly. The semantics of this is
+ *          exactly similar to sendmsg() of the BSD socket API.
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] sockfd  Socket descriptor for sending data
+ * @param[in] iov     Buffers to send
+ * @param[in] iovcnt  Number of buffers
+ * @param[in] flags   Flags for mode selection
+ *
+ * @return
+ *  - Length of data : if successful
+ *  - -1             : if failed (appropriate errno is set)
+ */
+int httpd_default_sendv(httpd_handle_t hd, int sockfd, const struct iovec *iov, int iovcnt, int flags);
+
+/**
+ * @brief   Sends a buffer on a session with its send function, until all
+ *          of it is sent or an error occurs
+ *
+ * @param[in] sd       Session
+ * @param[in] buf      Data to send
+ * @param[in] buf_len  Length of the data
+ *
+ * @return
+ *  - ESP_OK   : All of the data was sent
+ *  - ESP_FAIL : Error in the send function
+ */
+esp_err_t httpd_sess_send_all(struct sock_db *sd, const char *buf, size_t buf_len);
+
+/**
+ * @brief   Sends buffers on a session, with a single call of its vectored
+ *          send function if possible
+ *
+ * Without vectored send function, e.g. after a send override was set,
+ * small batches are copied into one buffer for the send function.
+ *
+ * @param[in] sd      Session
+ * @param[in] iov     Buffers to send, modified while sending
+ * @param[in] iovcnt  Number of buffers
+ *
+ * @return
+ *  - ESP_OK   : All of the data was sent
+ *  - ESP_FAIL : Error in the send function
+ */
+esp_err_t httpd_sess_sendv_all(struct sock_db *sd, struct iovec *iov, int iovcnt);
+
 /**
  * @brief   This is the low level default recv function of the HTTPD. This should
  *          NEVER be called directly. The semantics of this is exactly similar to
@@ -532,6 +713,20 @@ esp_err_t httpd_ws_respond_server_handshake(httpd_req_t *req, const char *suppor
  */
 esp_err_t httpd_ws_get_frame_type(httpd_req_t *req);
 
+/**
+ * @brief   Unmasks the payload of a frame received from a client, a word
+ *          at a time
+ *
+ * @param[in,out] payload   Payload, unmasked in place
+ * @param[in]     len       Length of the payload
+ * @param[in]     mask_key  Masking key of the frame, 4 bytes
+ *
+ * @return
+ *  - ESP_OK                : On success
+ *  - ESP_ERR_INVALID_ARG   : Empty payload
+ */
+esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key);
+
 /**
  * @brief   Trigger an httpd session close externally
  *
@@ -181,17 +181,21 @@ esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_
         return ESP_ERR_INVALID_ARG;
     }
     size_t max_fds = *fds;
+    esp_err_t ret = ESP_OK;
     *fds = 0;
+    httpd_sess_lock(hd);
     for (int i = 0; i < hd->config.max_open_sockets; ++i) {
         if (hd->hd_sd[i].fd != -1) {
             if (*fds < max_fds) {
                 client_fds[(*fds)++] = hd->hd_sd[i].fd;
             } else {
-                return ESP_ERR_INVALID_ARG;
+                ret = ESP_ERR_INVALID_ARG;
+                break;
             }
         }
     }
-    return ESP_OK;
+    httpd_sess_unlock(hd);
+    return ret;
 }
 
 void *httpd_get_global_user_ctx(httpd_handle_t handle)
@@ -243,6 +247,21 @@ static void httpd_process_ctrl_msg(struct httpd_data *hd)
 #endif
 }
 
+/* Data already received, e.g. requests pipelined behind the one processed or
+ * data buffered by the transport, doesn't make the socket readable, so the
+ * session is processed again right away */
+static bool httpd_sess_process_again(struct httpd_data *hd, struct sock_db *session)
+{
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    /* Whatever follows a Close frame isn't processed */
+    if (session->ws_close) {
+        return false;
+    }
+#endif
+    return !session->for_async_req && httpd_sess_pending(hd, session) &&
+           hd->hd_td.status == THREAD_RUNNING;
+}
+
 // Called for each session from httpd_server
 static int httpd_process_session(struct sock_db *session, void *context)
 {
@@ -264,7 +283,11 @@ static int httpd_process_session(struct sock_db *session, void *context)
 
     if (FD_ISSET(fd, ctx->fdset) || httpd_sess_pending(ctx->hd, session)) {
         ESP_LOGD(TAG, LOG_FMT("processing socket %d"), fd);
-        if (httpd_sess_process(ctx->hd, session) != ESP_OK) {
+        esp_err_t ret;
+        do {
+            ret = httpd_sess_process(ctx->hd, session);
+        } while (ret == ESP_OK && httpd_sess_process_again(ctx->hd, session));
+        if (ret != ESP_OK) {
             httpd_sess_delete(ctx->hd, session); // Delete session
         }
     }
@@ -327,6 +350,190 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     return ESP_OK;
 }
 
+#if CONFIG_HTTPD_WORKERS
+/* Entries of hd_pfds in front of the sessions */
+#define HTTPD_PFD_CTRL      0
+#define HTTPD_PFD_LISTEN    1
+#define HTTPD_PFD_SESSIONS  2
+
+static struct httpd_worker *httpd_worker_self(struct httpd_data *hd)
+{
+    if (hd->hd_workers) {
+        othread_t self = httpd_os_thread_handle();
+        for (int i = 0; i < hd->config.worker_count; i++) {
+            if (hd->hd_workers[i].td.handle == self) {
+                return &hd->hd_workers[i];
+            }
+        }
+    }
+    return NULL;
+}
+#endif
+
+struct httpd_req *httpd_req_current(struct httpd_data *hd)
+{
+#if CONFIG_HTTPD_WORKERS
+    struct httpd_worker *worker = httpd_worker_self(hd);
+    if (worker) {
+        return &worker->req;
+    }
+#endif
+    return &hd->hd_req;
+}
+
+struct httpd_req_aux *httpd_req_aux_current(struct httpd_data *hd)
+{
+#if CONFIG_HTTPD_WORKERS
+    struct httpd_worker *worker = httpd_worker_self(hd);
+    if (worker) {
+        return &worker->req_aux;
+    }
+#endif
+    return &hd->hd_req_aux;
+}
+
+#if CONFIG_HTTPD_WORKERS
+/* Executed by the HTTPD thread once a worker is done with a session */
+static void httpd_worker_done(void *arg)
+{
+    struct sock_db *session = (struct sock_db *) arg;
+    struct httpd_data *hd = (struct httpd_data *) session->handle;
+
+    session->worker_busy = false;
+    if (session->worker_failed || session->worker_close) {
+        session->worker_failed = false;
+        session->worker_close = false;
+        httpd_sess_delete(hd, session);
+    }
+}
+
+static void httpd_worker_thread(void *arg)
+{
+    struct httpd_worker *worker = (struct httpd_worker *) arg;
+    struct httpd_data *hd = worker->hd;
+    struct sock_db *session;
+
+    /* A NULL session asks the worker to stop */
+    while (xQueueReceive(hd->hd_work_queue, &session, portMAX_DELAY) == pdTRUE && session) {
+        ESP_LOGD(TAG, LOG_FMT("processing socket %d"), session->fd);
+        esp_err_t ret;
+        do {
+            ret = httpd_sess_process(hd, session);
+        } while (ret == ESP_OK && httpd_sess_process_again(hd, session));
+
+        /* Hand the session back to the HTTPD thread, which polls or closes it */
+        session->worker_failed = (ret != ESP_OK);
+        while (hd->hd_td.status == THREAD_RUNNING && httpd_queue_work(hd, httpd_worker_done, session) != ESP_OK) {
+            httpd_os_thread_sleep(10);
+        }
+    }
+
+    ESP_LOGD(TAG, LOG_FMT("worker exiting"));
+    worker->td.status = THREAD_STOPPED;
+    httpd_os_thread_delete();
+}
+
+static void httpd_workers_stop(struct httpd_data *hd)
+{
+    struct sock_db *stop = NULL;
+    /* Any worker may take any stop request, so send one per started
+     * worker, even if it is already gone after taking an earlier one */
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        if (hd->hd_workers[i].td.status != THREAD_IDLE) {
+            xQueueSend(hd->hd_work_queue, &stop, portMAX_DELAY);
+        }
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        while (hd->hd_workers[i].td.status == THREAD_RUNNING) {
+            httpd_os_thread_sleep(10);
+        }
+    }
+}
+
+static esp_err_t httpd_workers_start(struct httpd_data *hd)
+{
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *worker = &hd->hd_workers[i];
+        worker->td.status = THREAD_RUNNING;
+        if (httpd_os_thread_create(&worker->td.handle, "httpd_worker",
+                                   hd->config.stack_size,
+                                   hd->config.task_priority,
+                                   httpd_worker_thread, worker,
+                                   hd->config.core_id,
+                                   hd->config.task_caps) != ESP_OK) {
+            worker->td.status = THREAD_IDLE;
+            httpd_workers_stop(hd);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Manage in-coming connection or data requests, handing the sessions to the workers */
+static esp_err_t httpd_server_poll(struct httpd_data *hd)
+{
+    struct pollfd *pfds = hd->hd_pfds;
+    bool purgeable = false;
+    /* Sessions processed by a worker or an asynchronous handler are not polled, negative descriptors are ignored */
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *session = &hd->hd_sd[i];
+        bool idle = (session->fd != -1) && !session->for_async_req && !session->worker_busy;
+        pfds[HTTPD_PFD_SESSIONS + i].fd = idle ? session->fd : -1;
+        purgeable |= (session->fd != -1) && !session->worker_busy;
+    }
+    /* Only listen for new connections if server has capacity to
+     * handle more (or when LRU purge is enabled and a session isn't
+     * held by a worker, in which case it will be closed) */
+    bool can_accept = httpd_is_sess_available(hd) || (hd->config.lru_purge_enable && purgeable);
+    pfds[HTTPD_PFD_LISTEN].fd = can_accept ? hd->listen_fd : -1;
+
+    ESP_LOGD(TAG, LOG_FMT("doing poll"));
+    int active_cnt = poll(pfds, HTTPD_PFD_SESSIONS + hd->config.max_open_sockets, -1);
+    if (active_cnt < 0) {
+        ESP_LOGE(TAG, LOG_FMT("error in poll (%d)"), errno);
+        httpd_sess_delete_invalid(hd);
+        return ESP_OK;
+    }
+
+    /* Case0: Do we have control messages? The workers hand back
+     * their sessions this way, so process all that are queued. */
+    if (pfds[HTTPD_PFD_CTRL].revents) {
+        do {
+            ESP_LOGD(TAG, LOG_FMT("processing ctrl message"));
+            httpd_process_ctrl_msg(hd);
+            if (hd->hd_td.status == THREAD_STOPPING) {
+                ESP_LOGD(TAG, LOG_FMT("stopping thread"));
+                return ESP_FAIL;
+            }
+        } while (poll(&pfds[HTTPD_PFD_CTRL], 1, 0) > 0);
+    }
+
+    /* Case1: Hand the sessions with activity to the workers. A session
+     * may have been closed by the control message in the meantime. */
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *session = &hd->hd_sd[i];
+        struct pollfd *pfd = &pfds[HTTPD_PFD_SESSIONS + i];
+        if (pfd->fd == -1 || !pfd->revents || session->fd != pfd->fd || session->worker_busy) {
+            continue;
+        }
+        ESP_LOGD(TAG, LOG_FMT("queueing socket %d"), session->fd);
+        session->worker_busy = true;
+        /* The queue holds every session, this doesn't block */
+        xQueueSend(hd->hd_work_queue, &session, portMAX_DELAY);
+    }
+
+    /* Case2: Do we have any incoming connection requests to
+     * process? */
+    if (pfds[HTTPD_PFD_LISTEN].fd != -1 && pfds[HTTPD_PFD_LISTEN].revents) {
+        ESP_LOGD(TAG, LOG_FMT("processing listen socket %d"), hd->listen_fd);
+        if (httpd_accept_conn(hd, hd->listen_fd) != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("error accepting new connection"));
+        }
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_HTTPD_WORKERS
+
 /* The main HTTPD thread */
 static void httpd_thread(void *arg)
 {
@@ -336,13 +543,23 @@ static void httpd_thread(void *arg)
 
     ESP_LOGD(TAG, LOG_FMT("web server started"));
     while (1) {
+#if CONFIG_HTTPD_WORKERS
+        ret = hd->hd_workers ? httpd_server_poll(hd) : httpd_server(hd);
+#else
         ret = httpd_server(hd);
+#endif
         if (ret != ESP_OK) {
             break;
         }
     }
 
     ESP_LOGD(TAG, LOG_FMT("web server exiting"));
+#if CONFIG_HTTPD_WORKERS
+    if (hd->hd_workers) {
+        /* Let the workers finish their sessions before closing them */
+        httpd_workers_stop(hd);
+    }
+#endif
     close(hd->msg_fd);
     cs_free_ctrl_sock(hd->ctrl_fd);
     httpd_sess_close_all(hd);
@@ -419,8 +636,64 @@ static esp_err_t httpd_server_init(struct httpd_data *hd)
     hd->listen_fd = fd;
     hd->ctrl_fd = ctrl_fd;
     hd->msg_fd  = msg_fd;
+#if CONFIG_HTTPD_WORKERS
+    if (hd->hd_pfds) {
+        hd->hd_pfds[HTTPD_PFD_CTRL].fd = ctrl_fd;
+        hd->hd_pfds[HTTPD_PFD_LISTEN].fd = fd;
+        for (int i = 0; i < HTTPD_PFD_SESSIONS + hd->config.max_open_sockets; i++) {
+            hd->hd_pfds[i].events = POLLIN;
+        }
+    }
+#endif
+    return ESP_OK;
+}
+
+#if CONFIG_HTTPD_WORKERS
+static void httpd_workers_delete(struct httpd_data *hd)
+{
+    if (hd->hd_workers) {
+        for (int i = 0; i < hd->config.worker_count; i++) {
+            free(hd->hd_workers[i].req_aux.resp_hdrs);
+        }
+        free(hd->hd_workers);
+        hd->hd_workers = NULL;
+    }
+    if (hd->hd_work_queue) {
+        vQueueDelete(hd->hd_work_queue);
+        hd->hd_work_queue = NULL;
+    }
+    if (hd->hd_sd_lock) {
+        vSemaphoreDelete(hd->hd_sd_lock);
+        hd->hd_sd_lock = NULL;
+    }
+    free(hd->hd_pfds);
+    hd->hd_pfds = NULL;
+}
+
+static esp_err_t httpd_workers_create(struct httpd_data *hd)
+{
+    hd->hd_workers = calloc(hd->config.worker_count, sizeof(struct httpd_worker));
+    hd->hd_pfds = calloc(HTTPD_PFD_SESSIONS + hd->config.max_open_sockets, sizeof(struct pollfd));
+    /* A session is queued once at most, plus one stop request per worker */
+    hd->hd_work_queue = xQueueCreate(hd->config.max_open_sockets + hd->config.worker_count, sizeof(struct sock_db *));
+    /* Nested, the handlers may look up sessions while a session is being closed */
+    hd->hd_sd_lock = xSemaphoreCreateRecursiveMutex();
+    if (!hd->hd_workers || !hd->hd_pfds || !hd->hd_work_queue || !hd->hd_sd_lock) {
+        httpd_workers_delete(hd);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *worker = &hd->hd_workers[i];
+        worker->hd = hd;
+        worker->req_aux.resp_hdrs = calloc(hd->config.max_resp_headers, sizeof(struct resp_hdr));
+        if (!worker->req_aux.resp_hdrs) {
+            httpd_workers_delete(hd);
+            return ESP_ERR_NO_MEM;
+        }
+    }
     return ESP_OK;
 }
+#endif
 
 static struct httpd_data *httpd_create(const httpd_config_t *config)
 {
@@ -463,6 +736,21 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
     }
     /* Save the configuration for this instance */
     hd->config = *config;
+#if CONFIG_HTTPD_URI_INDEX
+    uri_index_init(&hd->hd_uri_index, config->uri_match_fn == httpd_uri_match_wildcard);
+    httpd_uri_index_rebuild(hd);
+#endif
+#if CONFIG_HTTPD_WORKERS
+    if (config->worker_count && httpd_workers_create(hd) != ESP_OK) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP workers"));
+        free(hd->err_handler_fns);
+        free(ra->resp_hdrs);
+        free(hd->hd_sd);
+        free(hd->hd_calls);
+        free(hd);
+        return NULL;
+    }
+#endif
     return hd;
 }
 
@@ -473,6 +761,9 @@ static void httpd_delete(struct httpd_data *hd)
     free(hd->err_handler_fns);
     free(ra->resp_hdrs);
     free(hd->hd_sd);
+#if CONFIG_HTTPD_WORKERS
+    httpd_workers_delete(hd);
+#endif
 
     /* Free registered URI handlers */
     httpd_unregister_all_uri_handlers(hd);
@@ -503,6 +794,13 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
         return ESP_ERR_INVALID_ARG;
     }
 
+#if !CONFIG_HTTPD_WORKERS
+    if (config->worker_count) {
+        ESP_LOGE(TAG, "Config option worker_count requires CONFIG_HTTPD_WORKERS to be enabled");
+        return ESP_ERR_INVALID_ARG;
+    }
+#endif
+
     struct httpd_data *hd = httpd_create(config);
     if (hd == NULL) {
         /* Failed to allocate memory */
@@ -527,6 +825,13 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
     }
 
     httpd_sess_init(hd);
+#if CONFIG_HTTPD_WORKERS
+    if (hd->hd_workers && httpd_workers_start(hd) != ESP_OK) {
+        /* Failed to launch worker tasks */
+        httpd_delete(hd);
+        return ESP_ERR_HTTPD_TASK;
+    }
+#endif
     if (httpd_os_thread_create(&hd->hd_td.handle, "httpd",
                                hd->config.stack_size,
                                hd->config.task_priority,
@@ -534,6 +839,11 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
                                hd->config.core_id,
                                hd->config.task_caps) != ESP_OK) {
         /* Failed to launch task */
+#if CONFIG_HTTPD_WORKERS
+        if (hd->hd_workers) {
+            httpd_workers_stop(hd);
+        }
+#endif
         httpd_delete(hd);
         return ESP_ERR_HTTPD_TASK;
     }
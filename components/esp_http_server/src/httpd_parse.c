@@ -19,6 +19,15 @@
 
 static const char *TAG = "httpd_parse";
 
+#if CONFIG_HTTPD_SESS_ARENA
+/* Pending data isn't limited to the size of a buffer, so receive as much as
+ * fits in the scratch buffer at once. Requests pipelined behind the current
+ * one then come along, and are parsed later without receiving them again. */
+#define RECV_BLOCK_SIZE     SIZE_MAX
+#else
+#define RECV_BLOCK_SIZE     PARSER_BLOCK_SIZE
+#endif
+
 typedef struct {
     /* Parser settings for http_parser_execute() */
     http_parser_settings settings;
@@ -317,6 +326,25 @@ static esp_err_t cb_headers_complete(http_parser *parser)
             parser_data->status = PARSING_FAILED;
             return ESP_FAIL;
         }
+
+        /* Place the parser ptr right after the request line and the
+         * empty line ending the request, else the data following the
+         * URL would be taken as the start of the next request */
+        const char *at = parser_data->last.at + parser_data->last.length;
+        const char *end = ra->scratch + parser_data->raw_datalen;
+        unsigned short remaining_terminators = 2;
+        while (at < end && remaining_terminators) {
+            if (*(at++) == '\n') {
+                remaining_terminators--;
+            }
+        }
+        if (remaining_terminators) {
+            ESP_LOGE(TAG, LOG_FMT("incomplete termination of request line"));
+            parser_data->error = HTTPD_400_BAD_REQUEST;
+            parser_data->status = PARSING_FAILED;
+            return ESP_FAIL;
+        }
+        parser_data->last.at = at;
     } else if (parser_data->status == PARSING_HDR_VALUE) {
         /* Locate end of last header */
         char *at = (char *)parser_data->last.at + parser_data->last.length;
@@ -503,7 +531,11 @@ static int read_block(httpd_req_t *req, http_parser *parser, size_t offset, size
        from where the reading will start and buf_len is till what length
        the buffer will be read.
     */
+#if CONFIG_HTTPD_SESS_ARENA
+    raux->scratch = sess_arena_grow(&raux->sd->arena, offset + buf_len);
+#else
     raux->scratch = (char*) realloc(raux->scratch, offset + buf_len);
+#endif
     if (raux->scratch == NULL) {
         ESP_LOGE(TAG, "Unable to allocate the scratch buffer");
         return 0;
@@ -642,7 +674,7 @@ static void parse_init(httpd_req_t *r, http_parser *parser, parser_data_t *data)
  */
 static esp_err_t httpd_parse_req(struct httpd_data *hd)
 {
-    httpd_req_t *r = &hd->hd_req;
+    httpd_req_t *r = httpd_req_current(hd);
     int blk_len,  offset;
     http_parser   parser = {};
     parser_data_t parser_data = {};
@@ -654,7 +686,7 @@ static esp_err_t httpd_parse_req(struct httpd_data *hd)
     offset = 0;
     do {
         /* Read block into scratch buffer */
-        if ((blk_len = read_block(r, &parser, offset, PARSER_BLOCK_SIZE)) < 0) {
+        if ((blk_len = read_block(r, &parser, offset, RECV_BLOCK_SIZE)) < 0) {
             if (blk_len == HTTPD_SOCK_ERR_TIMEOUT) {
                 /* Retry read in case of non-fatal timeout error.
                  * read_block() ensures that the timeout error is
@@ -740,9 +772,17 @@ static void httpd_req_cleanup(httpd_req_t *r)
     ra->sd->free_ctx = r->free_ctx;
     ra->sd->ignore_sess_ctx_changes = r->ignore_sess_ctx_changes;
 
+#if CONFIG_HTTPD_SESS_ARENA
+    /* Keep the data received for the next request, which may have
+     * been pipelined behind this one, and reuse the memory */
+    sess_arena_reset(&ra->sd->arena, ra->sd->pending_off, ra->sd->pending_len);
+    ra->sd->pending_off = 0;
+#else
+    free(ra->scratch);
+#endif
+
     /* Clear out the request and request_aux structures */
     ra->sd = NULL;
-    free(ra->scratch);
     ra->scratch = NULL;
     ra->scratch_size_limit = 0;
     ra->scratch_cur_size = 0;
@@ -756,11 +796,12 @@ static void httpd_req_cleanup(httpd_req_t *r)
  */
 esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
 {
-    httpd_req_t *r = &hd->hd_req;
+    httpd_req_t *r = httpd_req_current(hd);
+    struct httpd_req_aux *aux = httpd_req_aux_current(hd);
     init_req(r, &hd->config);
-    init_req_aux(&hd->hd_req_aux, &hd->config);
+    init_req_aux(aux, &hd->config);
     r->handle = hd;
-    r->aux = &hd->hd_req_aux;
+    r->aux = aux;
 
     /* Associate the request to the socket */
     struct httpd_req_aux *ra = r->aux;
@@ -829,7 +870,7 @@ esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
  */
 esp_err_t httpd_req_delete(struct httpd_data *hd)
 {
-    httpd_req_t *r = &hd->hd_req;
+    httpd_req_t *r = httpd_req_current(hd);
     struct httpd_req_aux *ra = r->aux;
 
     /* Finish off reading any pending/leftover data */
@@ -868,6 +909,13 @@ bool httpd_validate_req_ptr(httpd_req_t *r)
     if (r) {
         struct httpd_data *hd = (struct httpd_data *) r->handle;
         if (hd) {
+#if CONFIG_HTTPD_WORKERS
+            /* Check if this function is running in the context of
+             * the worker processing this request */
+            if (hd->hd_workers) {
+                return httpd_req_current(hd) == r;
+            }
+#endif
             /* Check if this function is running in the context of
              * the correct httpd server thread */
             if (httpd_os_thread_handle() == hd->hd_td.handle) {
@@ -1191,7 +1239,8 @@ esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, ch
     if (hdr_len_cookie <= 0) {
         return ESP_ERR_NOT_FOUND;
     }
-    cookie_str = malloc(hdr_len_cookie + 1);
+    struct sock_db *sd = ((struct httpd_req_aux *) req->aux)->sd;
+    cookie_str = httpd_sess_tmp_alloc(sd, hdr_len_cookie + 1);
     if (cookie_str == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for cookie string");
         return ESP_ERR_NO_MEM;
@@ -1199,12 +1248,12 @@ esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, ch
 
     if (httpd_req_get_hdr_value_str(req, "Cookie", cookie_str, hdr_len_cookie + 1) != ESP_OK) {
         ESP_LOGW(TAG, "Cookie not found in header uri:[%s]", req->uri);
-        free(cookie_str);
+        httpd_sess_tmp_free(sd, cookie_str);
         return ESP_ERR_NOT_FOUND;
     }
 
     ret = httpd_cookie_key_value(cookie_str, cookie_name, val, val_size);
-    free(cookie_str);
+    httpd_sess_tmp_free(sd, cookie_str);
     return ret;
 
 }
@@ -46,12 +46,14 @@ void httpd_sess_enum(struct httpd_data *hd, httpd_session_enum_function enum_fun
     struct sock_db *current = hd->hd_sd;
     struct sock_db *end = hd->hd_sd + hd->config.max_open_sockets - 1;
 
+    httpd_sess_lock(hd);
     while (current <= end) {
         if (enum_function && (!enum_function(current, context))) {
             break;
         }
         current++;
     }
+    httpd_sess_unlock(hd);
 }
 
 // Check if a FD is valid
@@ -97,6 +99,12 @@ static int enum_function(struct sock_db *session, void *context)
         break;
     // Delete invalid session
     case HTTPD_TASK_DELETE_INVALID:
+#if CONFIG_HTTPD_WORKERS
+        // Sessions processed by a worker are checked once handed back
+        if (session->worker_busy) {
+            break;
+        }
+#endif
         if (!fd_is_valid(session->fd)) {
             ESP_LOGW(TAG, LOG_FMT("Closing invalid socket %d"), session->fd);
             httpd_sess_delete(ctx->hd, session);
@@ -109,7 +117,11 @@ static int enum_function(struct sock_db *session, void *context)
             return 0;
         }
         // Only close sockets that are not in use
+#if CONFIG_HTTPD_WORKERS
+        if (session->for_async_req == false && session->worker_busy == false) {
+#else
         if (session->for_async_req == false) {
+#endif
             // Check/update lowest lru
             if (session->lru_counter < ctx->lru_counter) {
                 ctx->lru_counter = session->lru_counter;
@@ -145,6 +157,13 @@ static void httpd_sess_close(void *arg)
         return;
     }
     sock_db->lru_socket = false;
+#if CONFIG_HTTPD_WORKERS
+    if (sock_db->worker_busy) {
+        // The session is closed once the worker hands it back
+        sock_db->worker_close = true;
+        return;
+    }
+#endif
     struct httpd_data *hd = (struct httpd_data *) sock_db->handle;
     httpd_sess_delete(hd, sock_db);
 }
@@ -174,8 +193,9 @@ struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
 
     // Check if called inside a request handler, and the session sockfd in use is same as the parameter
     // => Just return the pointer to the sock_db corresponding to the request
-    if ((hd->hd_req_aux.sd) && (hd->hd_req_aux.sd->fd == sockfd)) {
-        return hd->hd_req_aux.sd;
+    struct httpd_req_aux *ra = httpd_req_aux_current(hd);
+    if ((ra->sd) && (ra->sd->fd == sockfd)) {
+        return ra->sd;
     }
 
     enum_context_t context = {
@@ -195,8 +215,10 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
         return ESP_FAIL;
     }
 
+    httpd_sess_lock(hd);
     struct sock_db *session = httpd_sess_get_free(hd);
     if (!session) {
+        httpd_sess_unlock(hd);
         ESP_LOGD(TAG, LOG_FMT("unable to launch session for fd = %d"), newfd);
         return ESP_FAIL;
     }
@@ -206,10 +228,12 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
     session->fd = newfd;
     session->handle = (httpd_handle_t) hd;
     session->send_fn = httpd_default_send;
+    session->sendv_fn = httpd_default_sendv;
     session->recv_fn = httpd_default_recv;
 
     // increment number of sessions
     hd->hd_sd_active_count++;
+    httpd_sess_unlock(hd);
 
     // Call user-defined session opening function
     if (hd->config.open_fn) {
@@ -260,22 +284,25 @@ void httpd_sess_clear_ctx(struct sock_db *session)
 
 void *httpd_sess_get_ctx(httpd_handle_t handle, int sockfd)
 {
-    struct sock_db *session = httpd_sess_get(handle, sockfd);
-    if (!session) {
-        return NULL;
-    }
-
-    // Check if the function has been called from inside a
-    // request handler, in which case fetch the context from
-    // the httpd_req_t structure
     struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        return hd->hd_req.sess_ctx;
+    void *ctx = NULL;
+    httpd_sess_lock(hd);
+    struct sock_db *session = httpd_sess_get(handle, sockfd);
+    if (session) {
+        // Check if the function has been called from inside a
+        // request handler, in which case fetch the context from
+        // the httpd_req_t structure
+        if (httpd_req_aux_current(hd)->sd == session) {
+            ctx = httpd_req_current(hd)->sess_ctx;
+        } else {
+            ctx = session->ctx;
+        }
     }
-    return session->ctx;
+    httpd_sess_unlock(hd);
+    return ctx;
 }
 
-void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
+static void httpd_sess_set_ctx_locked(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
 {
     struct sock_db *session = httpd_sess_get(handle, sockfd);
     if (!session) {
@@ -286,16 +313,17 @@ void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free
     // request handler, in which case set the context inside
     // the httpd_req_t structure
     struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        if (hd->hd_req.sess_ctx != ctx) {
+    if (httpd_req_aux_current(hd)->sd == session) {
+        struct httpd_req *r = httpd_req_current(hd);
+        if (r->sess_ctx != ctx) {
             // Don't free previous context if it is in sockdb
             // as it will be freed inside httpd_req_cleanup()
-            if (session->ctx != hd->hd_req.sess_ctx) {
-                httpd_sess_free_ctx(&hd->hd_req.sess_ctx, hd->hd_req.free_ctx); // Free previous context
+            if (session->ctx != r->sess_ctx) {
+                httpd_sess_free_ctx(&r->sess_ctx, r->free_ctx); // Free previous context
             }
-            hd->hd_req.sess_ctx = ctx;
+            r->sess_ctx = ctx;
         }
-        hd->hd_req.free_ctx = free_fn;
+        r->free_ctx = free_fn;
         return;
     }
 
@@ -308,13 +336,23 @@ void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free
     session->free_ctx = free_fn;
 }
 
+void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
+{
+    httpd_sess_lock(handle);
+    httpd_sess_set_ctx_locked(handle, sockfd, ctx, free_fn);
+    httpd_sess_unlock(handle);
+}
+
 void *httpd_sess_get_transport_ctx(httpd_handle_t handle, int sockfd)
 {
+    httpd_sess_lock(handle);
     struct sock_db *session = httpd_sess_get(handle, sockfd);
-    return session ? session->transport_ctx : NULL;
+    void *ctx = session ? session->transport_ctx : NULL;
+    httpd_sess_unlock(handle);
+    return ctx;
 }
 
-void httpd_sess_set_transport_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
+static void httpd_sess_set_transport_ctx_locked(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
 {
     struct sock_db *session = httpd_sess_get(handle, sockfd);
     if (!session) {
@@ -329,6 +367,13 @@ void httpd_sess_set_transport_ctx(httpd_handle_t handle, int sockfd, void *ctx,
     session->free_transport_ctx = free_fn;
 }
 
+void httpd_sess_set_transport_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
+{
+    httpd_sess_lock(handle);
+    httpd_sess_set_transport_ctx_locked(handle, sockfd, ctx, free_fn);
+    httpd_sess_unlock(handle);
+}
+
 void httpd_sess_set_descriptors(struct httpd_data *hd, fd_set *fdset, int *maxfd)
 {
     enum_context_t context = {
@@ -358,6 +403,7 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     }
 
     ESP_LOGD(TAG, LOG_FMT("fd = %d"), session->fd);
+    httpd_sess_lock(hd);
     if (hd->config.enable_so_linger) {
         struct linger so_linger = {
             .l_onoff = true,
@@ -379,6 +425,11 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     // clear all contexts
     httpd_sess_clear_ctx(session);
 
+#if CONFIG_HTTPD_SESS_ARENA
+    sess_arena_free(&session->arena);
+    session->pending_len = 0;
+#endif
+
     // mark session slot as available
     session->fd = -1;
 
@@ -388,6 +439,7 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     if (!hd->hd_sd_active_count) {
         hd->lru_counter = 0;
     }
+    httpd_sess_unlock(hd);
 }
 
 void httpd_sess_init(struct httpd_data *hd)
@@ -413,6 +465,32 @@ bool httpd_sess_pending(struct httpd_data *hd, struct sock_db *session)
     return (session->pending_len != 0);
 }
 
+void *httpd_sess_tmp_alloc(struct sock_db *session, size_t len)
+{
+#if CONFIG_HTTPD_SESS_ARENA
+    /* Only the task processing a request of the session may use its arena */
+    if (httpd_req_aux_current(session->handle)->sd == session) {
+        void *buf = sess_arena_alloc(&session->arena, len);
+        if (buf) {
+            return buf;
+        }
+    }
+#endif
+    return malloc(len);
+}
+
+void httpd_sess_tmp_free(struct sock_db *session, void *buf)
+{
+#if CONFIG_HTTPD_SESS_ARENA
+    sess_arena_t *arena = &session->arena;
+    if ((char *) buf >= arena->buf && (char *) buf < arena->buf + arena->size) {
+        sess_arena_release(arena, buf);
+        return;
+    }
+#endif
+    free(buf);
+}
+
 /* This MUST return ESP_OK on successful execution. If any other
  * value is returned, everything related to this socket will be
  * cleaned up and the socket will be closed.
@@ -432,7 +510,8 @@ esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session)
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("success"));
-    session->lru_counter = ++hd->lru_counter;
+    // Sessions may be processed by several workers at once
+    session->lru_counter = __atomic_add_fetch(&hd->lru_counter, 1, __ATOMIC_RELAXED);
     return ESP_OK;
 }
 
@@ -448,12 +527,15 @@ esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
         .task = HTTPD_TASK_FIND_FD,
         .fd = sockfd
     };
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    httpd_sess_lock(hd);
     httpd_sess_enum(hd, enum_function, &context);
     if (context.session) {
-        context.session->lru_counter = ++hd->lru_counter;
-        return ESP_OK;
+        context.session->lru_counter = __atomic_add_fetch(&hd->lru_counter, 1, __ATOMIC_RELAXED);
+        ret = ESP_OK;
     }
-    return ESP_ERR_NOT_FOUND;
+    httpd_sess_unlock(hd);
+    return ret;
 }
 
 esp_err_t httpd_sess_close_lru(struct httpd_data *hd)
@@ -0,0 +1,454 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_partition.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+
+static const char *TAG = "httpd_static";
+
+/* Layout of an asset image, as written by httpd_static_gen.py. Integers
+ * are little endian, offsets count from the start of the image and point
+ * at null terminated strings or at file data. */
+#define HTTPD_STATIC_MAGIC      0x53415448      /* "HTAS" */
+#define HTTPD_STATIC_VERSION    1
+
+#define HTTPD_STATIC_HAS_GZIP   (1 << 0)        /* The file has a gzip compressed variant */
+#define HTTPD_STATIC_GZIP_ONLY  (1 << 1)        /* The compressed variant is the only one */
+
+struct httpd_static_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;             /* Number of entries, following the header */
+    uint32_t size;              /* Size of the whole image */
+    uint32_t reserved;
+};
+
+struct httpd_static_entry {
+    uint32_t path;              /* Path below the root directory, the entries are sorted by it */
+    uint32_t type;              /* Content type */
+    uint32_t etag;              /* Quoted ETag of the data */
+    uint32_t gz_etag;           /* Quoted ETag of the compressed data */
+    uint32_t data;
+    uint32_t data_len;
+    uint32_t gz_data;
+    uint32_t gz_len;
+    uint32_t flags;
+};
+
+struct httpd_static {
+    const uint8_t *image;
+    uint32_t count;
+    bool mapped;                /* The image is a memory mapped partition */
+    esp_partition_mmap_handle_t mmap;
+    char *index_file;
+    char *cache_control;
+    size_t prefix_len;
+    char uri[];                 /* URI prefix followed by '*' */
+};
+
+/* Size limit of the request headers looked at, longer values are ignored */
+#define HTTPD_STATIC_HDR_MAX    128
+
+typedef enum {
+    HTTPD_STATIC_RANGE_NONE,            /* Serve the whole file */
+    HTTPD_STATIC_RANGE_OK,
+    HTTPD_STATIC_RANGE_UNSATISFIABLE,
+} httpd_static_range_t;
+
+/* The image isn't necessarily aligned, e.g. when embedded in the application */
+static void httpd_static_entry_get(const struct httpd_static *stat, uint32_t i, struct httpd_static_entry *entry)
+{
+    memcpy(entry, stat->image + sizeof(struct httpd_static_header) + i * sizeof(struct httpd_static_entry),
+           sizeof(struct httpd_static_entry));
+}
+
+static bool httpd_static_str_valid(const uint8_t *image, uint32_t size, uint32_t offset)
+{
+    return offset < size && memchr(image + offset, '\0', size - offset) != NULL;
+}
+
+static bool httpd_static_data_valid(uint32_t size, uint32_t offset, uint32_t len)
+{
+    return offset <= size && len <= size - offset;
+}
+
+/* Checks that the image is complete and that nothing in it points outside of it,
+ * so that requests can be served without further checks */
+static esp_err_t httpd_static_check(struct httpd_static *stat, const uint8_t *image, size_t len)
+{
+    struct httpd_static_header header;
+    if (len < sizeof(header)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&header, image, sizeof(header));
+    if (header.magic != HTTPD_STATIC_MAGIC || header.version != HTTPD_STATIC_VERSION) {
+        ESP_LOGE(TAG, LOG_FMT("not an asset image"));
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header.size > len ||
+        header.size < sizeof(header) + header.count * sizeof(struct httpd_static_entry)) {
+        ESP_LOGE(TAG, LOG_FMT("asset image truncated"));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    stat->image = image;
+    stat->count = header.count;
+    const char *prev = NULL;
+    for (uint32_t i = 0; i < header.count; i++) {
+        struct httpd_static_entry entry;
+        httpd_static_entry_get(stat, i, &entry);
+        bool gzip = entry.flags & HTTPD_STATIC_HAS_GZIP;
+        if (!httpd_static_str_valid(image, header.size, entry.path) ||
+            !httpd_static_str_valid(image, header.size, entry.type) ||
+            !httpd_static_str_valid(image, header.size, entry.etag) ||
+            !httpd_static_data_valid(header.size, entry.data, entry.data_len) ||
+            (gzip && !httpd_static_str_valid(image, header.size, entry.gz_etag)) ||
+            (gzip && !httpd_static_data_valid(header.size, entry.gz_data, entry.gz_len)) ||
+            (!gzip && (entry.flags & HTTPD_STATIC_GZIP_ONLY))) {
+            ESP_LOGE(TAG, LOG_FMT("asset image entry %"PRIu32" corrupted"), i);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        const char *path = (const char *) image + entry.path;
+        if (prev && strcmp(prev, path) >= 0) {
+            ESP_LOGE(TAG, LOG_FMT("asset image entries not sorted at %s"), path);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        prev = path;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t httpd_static_map(struct httpd_static *stat, const char *label)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        ESP_LOGE(TAG, LOG_FMT("partition %s not found"), label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* Map only as much of the partition as the image takes */
+    struct httpd_static_header header;
+    esp_err_t ret = esp_partition_read(part, 0, &header, sizeof(header));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (header.magic != HTTPD_STATIC_MAGIC || header.version != HTTPD_STATIC_VERSION) {
+        ESP_LOGE(TAG, LOG_FMT("no asset image in partition %s"), label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header.size > part->size) {
+        ESP_LOGE(TAG, LOG_FMT("asset image larger than partition %s"), label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *image;
+    ret = esp_partition_mmap(part, 0, header.size, ESP_PARTITION_MMAP_DATA, &image, &stat->mmap);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, LOG_FMT("failed to map partition %s: %s"), label, esp_err_to_name(ret));
+        return ret;
+    }
+    stat->mapped = true;
+    return httpd_static_check(stat, image, header.size);
+}
+
+static void httpd_static_free(struct httpd_static *stat)
+{
+    if (stat->mapped) {
+        esp_partition_munmap(stat->mmap);
+    }
+    free(stat->index_file);
+    free(stat->cache_control);
+    free(stat);
+}
+
+/* Compares the null terminated name with dir followed by file, like strcmp() */
+static int httpd_static_cmp(const char *name, const char *dir, size_t dir_len, const char *file)
+{
+    int cmp = strncmp(name, dir, dir_len);
+    return cmp ? cmp : strcmp(name + dir_len, file);
+}
+
+static bool httpd_static_find(const struct httpd_static *stat, const char *dir, size_t dir_len,
+                              const char *file, struct httpd_static_entry *entry)
+{
+    uint32_t low = 0, high = stat->count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        httpd_static_entry_get(stat, mid, entry);
+        int cmp = httpd_static_cmp((const char *) stat->image + entry->path, dir, dir_len, file);
+        if (cmp == 0) {
+            return true;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return false;
+}
+
+static bool httpd_static_get_hdr(httpd_req_t *req, const char *field, char *buf)
+{
+    return httpd_req_get_hdr_value_str(req, field, buf, HTTPD_STATIC_HDR_MAX) == ESP_OK;
+}
+
+static bool httpd_static_accepts_gzip(httpd_req_t *req, char *buf)
+{
+    if (!httpd_static_get_hdr(req, "Accept-Encoding", buf)) {
+        return false;
+    }
+    char *save = NULL;
+    for (char *coding = strtok_r(buf, ",", &save); coding; coding = strtok_r(NULL, ",", &save)) {
+        coding += strspn(coding, " \t");
+        size_t len = strcspn(coding, " \t;");
+        if ((len == 4 && strncasecmp(coding, "gzip", len) == 0) || (len == 1 && coding[0] == '*')) {
+            /* Refused with a quality value of 0 */
+            const char *q = strstr(coding + len, "q=");
+            return !q || strtod(q + 2, NULL) > 0;
+        }
+    }
+    return false;
+}
+
+/* Looks for the ETag in the value of an If-None-Match header, using the weak comparison */
+static bool httpd_static_etag_listed(const char *list, const char *etag)
+{
+    size_t etag_len = strlen(etag);
+    while (true) {
+        list += strspn(list, " \t,");
+        if (!*list) {
+            return false;
+        }
+        if (*list == '*') {
+            return true;
+        }
+        if (strncmp(list, "W/", 2) == 0) {
+            list += 2;
+        }
+        size_t len = strcspn(list, " \t,");
+        if (len == etag_len && memcmp(list, etag, len) == 0) {
+            return true;
+        }
+        list += len;
+    }
+}
+
+static bool httpd_static_parse_pos(const char **str, size_t *pos)
+{
+    if (!isdigit((unsigned char) **str)) {
+        return false;
+    }
+    char *end;
+    unsigned long long value = strtoull(*str, &end, 10);
+    *pos = value > SIZE_MAX ? SIZE_MAX : value;
+    *str = end;
+    return true;
+}
+
+/* Only a single range is supported, requests for more get the whole file */
+static httpd_static_range_t httpd_static_parse_range(const char *spec, size_t size, size_t *first, size_t *last)
+{
+    if (strncasecmp(spec, "bytes=", 6) != 0) {
+        return HTTPD_STATIC_RANGE_NONE;
+    }
+    spec += 6;
+    spec += strspn(spec, " \t");
+    if (*spec == '-') {
+        /* The last bytes of the file */
+        spec++;
+        size_t suffix;
+        if (!httpd_static_parse_pos(&spec, &suffix)) {
+            return HTTPD_STATIC_RANGE_NONE;
+        }
+        if (spec[strspn(spec, " \t")]) {
+            return HTTPD_STATIC_RANGE_NONE;
+        }
+        if (suffix == 0 || size == 0) {
+            return HTTPD_STATIC_RANGE_UNSATISFIABLE;
+        }
+        *first = size > suffix ? size - suffix : 0;
+        *last = size - 1;
+        return HTTPD_STATIC_RANGE_OK;
+    }
+
+    if (!httpd_static_parse_pos(&spec, first) || *spec++ != '-') {
+        return HTTPD_STATIC_RANGE_NONE;
+    }
+    *last = SIZE_MAX;
+    if (isdigit((unsigned char) *spec)) {
+        httpd_static_parse_pos(&spec, last);
+        if (*last < *first) {
+            return HTTPD_STATIC_RANGE_NONE;
+        }
+    }
+    if (spec[strspn(spec, " \t")]) {
+        return HTTPD_STATIC_RANGE_NONE;
+    }
+    if (*first >= size) {
+        return HTTPD_STATIC_RANGE_UNSATISFIABLE;
+    }
+    if (*last >= size) {
+        *last = size - 1;
+    }
+    return HTTPD_STATIC_RANGE_OK;
+}
+
+static esp_err_t httpd_static_handler(httpd_req_t *req)
+{
+    struct httpd_static *stat = req->user_ctx;
+    char buf[HTTPD_STATIC_HDR_MAX];
+
+    /* Path of the file below the prefix, without query */
+    if (strncmp(req->uri, stat->uri, stat->prefix_len) != 0) {
+        return httpd_resp_send_404(req);
+    }
+    const char *dir = req->uri + stat->prefix_len;
+    size_t dir_len = strcspn(dir, "?#");
+    const char *file = "";
+    if ((dir_len == 0 || dir[dir_len - 1] == '/') && stat->index_file) {
+        file = stat->index_file;
+    }
+    struct httpd_static_entry entry;
+    if (!httpd_static_find(stat, dir, dir_len, file, &entry)) {
+        ESP_LOGD(TAG, LOG_FMT("no file for %s"), req->uri);
+        return httpd_resp_send_404(req);
+    }
+
+    bool gzip = (entry.flags & HTTPD_STATIC_GZIP_ONLY) ||
+                ((entry.flags & HTTPD_STATIC_HAS_GZIP) && httpd_static_accepts_gzip(req, buf));
+    const char *image = (const char *) stat->image;
+    const char *etag = image + (gzip ? entry.gz_etag : entry.etag);
+    const char *data = image + (gzip ? entry.gz_data : entry.data);
+    size_t len = gzip ? entry.gz_len : entry.data_len;
+
+    esp_err_t ret = httpd_resp_set_type(req, image + entry.type);
+    if (ret == ESP_OK) {
+        ret = httpd_resp_set_hdr(req, "ETag", etag);
+    }
+    if (ret == ESP_OK && stat->cache_control) {
+        ret = httpd_resp_set_hdr(req, "Cache-Control", stat->cache_control);
+    }
+    if (ret == ESP_OK && (entry.flags & HTTPD_STATIC_HAS_GZIP) && !(entry.flags & HTTPD_STATIC_GZIP_ONLY)) {
+        ret = httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (httpd_static_get_hdr(req, "If-None-Match", buf) && httpd_static_etag_listed(buf, etag)) {
+        httpd_resp_set_status(req, HTTPD_304);
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    if (gzip) {
+        ret = httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+    if (ret == ESP_OK) {
+        ret = httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* Without matching If-Range the whole file is sent, as it may have changed */
+    char content_range[48];
+    size_t first, last;
+    if (httpd_static_get_hdr(req, "Range", buf) &&
+        !(httpd_static_get_hdr(req, "If-Range", content_range) && strcmp(content_range, etag) != 0)) {
+        switch (httpd_static_parse_range(buf, len, &first, &last)) {
+        case HTTPD_STATIC_RANGE_OK:
+            snprintf(content_range, sizeof(content_range), "bytes %zu-%zu/%zu", first, last, len);
+            httpd_resp_set_status(req, HTTPD_206);
+            data += first;
+            len = last - first + 1;
+            break;
+        case HTTPD_STATIC_RANGE_UNSATISFIABLE:
+            snprintf(content_range, sizeof(content_range), "bytes */%zu", len);
+            httpd_resp_set_status(req, HTTPD_416);
+            len = 0;
+            break;
+        default:
+            content_range[0] = '\0';
+            break;
+        }
+        if (content_range[0] && (ret = httpd_resp_set_hdr(req, "Content-Range", content_range)) != ESP_OK) {
+            return ret;
+        }
+    }
+
+    /* The body goes out straight from the image */
+    return httpd_resp_send(req, data, len);
+}
+
+esp_err_t httpd_static_register(httpd_handle_t handle, const httpd_static_config_t *config,
+                                httpd_static_handle_t *out)
+{
+    if (handle == NULL || config == NULL || out == NULL || config->uri_prefix == NULL ||
+        (config->image == NULL && config->partition_label == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t prefix_len = strlen(config->uri_prefix);
+    struct httpd_static *stat = calloc(1, sizeof(struct httpd_static) + prefix_len + 2);
+    if (stat == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    memcpy(stat->uri, config->uri_prefix, prefix_len);
+    stat->uri[prefix_len] = '*';
+    stat->prefix_len = prefix_len;
+
+    esp_err_t ret = ESP_OK;
+    if ((config->index_file && (stat->index_file = strdup(config->index_file)) == NULL) ||
+        (config->cache_control && (stat->cache_control = strdup(config->cache_control)) == NULL)) {
+        ret = ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    if (ret == ESP_OK) {
+        ret = config->image ? httpd_static_check(stat, config->image, config->image_len) :
+              httpd_static_map(stat, config->partition_label);
+    }
+    if (ret == ESP_OK) {
+        httpd_uri_t uri = {
+            .uri      = stat->uri,
+            .method   = HTTP_GET,
+            .handler  = httpd_static_handler,
+            .user_ctx = stat,
+        };
+        ret = httpd_register_uri_handler(handle, &uri);
+    }
+    if (ret != ESP_OK) {
+        httpd_static_free(stat);
+        return ret;
+    }
+    ESP_LOGD(TAG, LOG_FMT("serving %"PRIu32" files at %s"), stat->count, stat->uri);
+    *out = stat;
+    return ESP_OK;
+}
+
+esp_err_t httpd_static_unregister(httpd_handle_t handle, httpd_static_handle_t stat)
+{
+    if (handle == NULL || stat == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = httpd_unregister_uri_handler(handle, stat->uri, HTTP_GET);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    httpd_static_free(stat);
+    return ESP_OK;
+}
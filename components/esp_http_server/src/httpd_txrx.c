@@ -15,6 +15,23 @@
 
 static const char *TAG = "httpd_txrx";
 
+/* Number of buffers a response is assembled from before they are sent.
+ * Enough for the status line, four custom headers and the content, while
+ * keeping the stack usage of the send APIs in the URI handlers small. */
+#define HTTPD_RESP_IOV_MAX          24
+
+/* Without vectored send function, buffers of up to this size in total are
+ * copied and passed to the send function at once, larger ones one by one */
+#define HTTPD_SEND_COALESCE_MAX     1024
+
+/* Buffers of a response not sent yet */
+struct httpd_resp_iov {
+    httpd_req_t *r;
+    struct iovec iov[HTTPD_RESP_IOV_MAX];
+    int cnt;
+    esp_err_t err;                      /* First error, later buffers are dropped */
+};
+
 esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func)
 {
     struct sock_db *sess = httpd_sess_get(hd, sockfd);
@@ -22,6 +39,18 @@ esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send
         return ESP_ERR_INVALID_ARG;
     }
     sess->send_fn = send_func;
+    /* Everything has to go through the new send function now */
+    sess->sendv_fn = NULL;
+    return ESP_OK;
+}
+
+esp_err_t httpd_sess_set_sendv_override(httpd_handle_t hd, int sockfd, httpd_sendv_func_t sendv_func)
+{
+    struct sock_db *sess = httpd_sess_get(hd, sockfd);
+    if (!sess) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sess->sendv_fn = sendv_func;
     return ESP_OK;
 }
 
@@ -64,13 +93,12 @@ int httpd_send(httpd_req_t *r, const char *buf, size_t buf_len)
     return ret;
 }
 
-static esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
+esp_err_t httpd_sess_send_all(struct sock_db *sd, const char *buf, size_t buf_len)
 {
-    struct httpd_req_aux *ra = r->aux;
     int ret;
 
     while (buf_len > 0) {
-        ret = ra->sd->send_fn(ra->sd->handle, ra->sd->fd, buf, buf_len, 0);
+        ret = sd->send_fn(sd->handle, sd->fd, buf, buf_len, 0);
         if (ret < 0) {
             ESP_LOGD(TAG, LOG_FMT("error in send_fn"));
             return ESP_FAIL;
@@ -82,14 +110,130 @@ static esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
     return ESP_OK;
 }
 
+esp_err_t httpd_sess_sendv_all(struct sock_db *sd, struct iovec *iov, int iovcnt)
+{
+    if (sd->sendv_fn) {
+        while (iovcnt > 0) {
+            int ret = sd->sendv_fn(sd->handle, sd->fd, iov, iovcnt, 0);
+            if (ret < 0) {
+                ESP_LOGD(TAG, LOG_FMT("error in sendv_fn"));
+                return ESP_FAIL;
+            }
+            ESP_LOGD(TAG, LOG_FMT("sent = %d"), ret);
+            /* Skip the buffers sent, the first remaining one may be sent partially */
+            size_t sent = ret;
+            while (iovcnt > 0 && sent >= iov->iov_len) {
+                sent -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+            if (iovcnt > 0) {
+                iov->iov_base = (char *) iov->iov_base + sent;
+                iov->iov_len -= sent;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /* Copy the small buffers together, a transport like TLS would
+     * otherwise send every buffer on its own. Buffers which don't fit
+     * into the copy, like a large body, are sent without copying. */
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    size_t size = (len < HTTPD_SEND_COALESCE_MAX) ? len : HTTPD_SEND_COALESCE_MAX;
+    char *buf = size ? httpd_sess_tmp_alloc(sd, size) : NULL;
+    size_t used = 0;
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < iovcnt && ret == ESP_OK; i++) {
+        bool copy = buf && iov[i].iov_len <= size;
+        if (used && (!copy || used + iov[i].iov_len > size)) {
+            ret = httpd_sess_send_all(sd, buf, used);
+            used = 0;
+        }
+        if (ret != ESP_OK) {
+            break;
+        }
+        if (copy) {
+            memcpy(buf + used, iov[i].iov_base, iov[i].iov_len);
+            used += iov[i].iov_len;
+        } else {
+            ret = httpd_sess_send_all(sd, iov[i].iov_base, iov[i].iov_len);
+        }
+    }
+    if (ret == ESP_OK && used) {
+        ret = httpd_sess_send_all(sd, buf, used);
+    }
+    if (buf) {
+        httpd_sess_tmp_free(sd, buf);
+    }
+    return ret;
+}
+
+/* Sends the buffers collected so far */
+static esp_err_t httpd_resp_iov_flush(struct httpd_resp_iov *v)
+{
+    struct httpd_req_aux *ra = v->r->aux;
+    int cnt = v->cnt;
+
+    v->cnt = 0;
+    if (v->err != ESP_OK || !cnt) {
+        return v->err;
+    }
+    v->err = httpd_sess_sendv_all(ra->sd, v->iov, cnt);
+    return v->err;
+}
+
+/* Appends a buffer to the response, which has to stay valid until flushed */
+static void httpd_resp_iov_add(struct httpd_resp_iov *v, const char *buf, size_t buf_len)
+{
+    if (!buf_len) {
+        return;
+    }
+    if (v->cnt == HTTPD_RESP_IOV_MAX) {
+        httpd_resp_iov_flush(v);
+    }
+    v->iov[v->cnt].iov_base = (void *) buf;
+    v->iov[v->cnt].iov_len = buf_len;
+    v->cnt++;
+}
+
+static void httpd_resp_iov_add_str(struct httpd_resp_iov *v, const char *str)
+{
+    httpd_resp_iov_add(v, str, strlen(str));
+}
+
+/* Appends the additional headers set with httpd_resp_set_hdr() and the
+ * end of the header section. The line with the last essential header
+ * isn't terminated yet. */
+static void httpd_resp_iov_add_hdrs(struct httpd_resp_iov *v)
+{
+    struct httpd_req_aux *ra = v->r->aux;
+
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        httpd_resp_iov_add_str(v, "\r\n");
+        httpd_resp_iov_add_str(v, ra->resp_hdrs[i].field);
+        httpd_resp_iov_add_str(v, ": ");
+        httpd_resp_iov_add_str(v, ra->resp_hdrs[i].value);
+    }
+    httpd_resp_iov_add_str(v, "\r\n\r\n");
+}
+
 static size_t httpd_recv_pending(httpd_req_t *r, char *buf, size_t buf_len)
 {
     struct httpd_req_aux *ra = r->aux;
-    size_t offset = sizeof(ra->sd->pending_data) - ra->sd->pending_len;
 
     /* buf_len must not be greater than remaining_len */
     buf_len = MIN(ra->sd->pending_len, buf_len);
+#if CONFIG_HTTPD_SESS_ARENA
+    /* The pending data may be received into the scratch buffer, in front of it */
+    memmove(buf, ra->sd->arena.buf + ra->sd->pending_off, buf_len);
+    ra->sd->pending_off += buf_len;
+#else
+    size_t offset = sizeof(ra->sd->pending_data) - ra->sd->pending_len;
     memcpy(buf, ra->sd->pending_data + offset, buf_len);
+#endif
 
     ra->sd->pending_len -= buf_len;
     return buf_len;
@@ -145,6 +289,13 @@ int httpd_recv(httpd_req_t *r, char *buf, size_t buf_len)
 size_t httpd_unrecv(struct httpd_req *r, const char *buf, size_t buf_len)
 {
     struct httpd_req_aux *ra = r->aux;
+#if CONFIG_HTTPD_SESS_ARENA
+    /* Keep the data in place, the scratch buffer is in the arena */
+    ra->sd->pending_off = buf - ra->sd->arena.buf;
+    ra->sd->pending_len = buf_len;
+    ESP_LOGD(TAG, LOG_FMT("length = %"NEWLIB_NANO_COMPAT_FORMAT), NEWLIB_NANO_COMPAT_CAST(ra->sd->pending_len));
+    return ra->sd->pending_len;
+#else
     /* Truncate if external buf_len is greater than pending_data buffer size */
     ra->sd->pending_len = MIN(sizeof(ra->sd->pending_data), buf_len);
 
@@ -154,6 +305,7 @@ size_t httpd_unrecv(struct httpd_req *r, const char *buf, size_t buf_len)
     memcpy(ra->sd->pending_data + offset, buf, ra->sd->pending_len);
     ESP_LOGD(TAG, LOG_FMT("length = %"NEWLIB_NANO_COMPAT_FORMAT), NEWLIB_NANO_COMPAT_CAST(ra->sd->pending_len));
     return ra->sd->pending_len;
+#endif
 }
 
 /**
@@ -236,9 +388,6 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
     }
 
     struct httpd_req_aux *ra = r->aux;
-    const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     if (buf_len == HTTPD_RESP_USE_STRLEN) {
         buf_len = strlen(buf);
@@ -247,61 +396,36 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
-    /* Calculate the size of the headers. +1 for the null terminator */
-    size_t required_size = snprintf(NULL, 0, httpd_hdr_str, ra->status, ra->content_type, buf_len) + 1;
-    if (required_size > ra->max_req_hdr_len) {
-        return ESP_ERR_HTTPD_RESP_HDR;
-    }
-    char *res_buf = malloc(required_size); /* Temporary buffer to store the headers */
-    if (res_buf == NULL) {
-        ESP_LOGE(TAG, "Unable to allocate httpd send buffer");
-        return ESP_ERR_HTTPD_ALLOC_MEM;
-    }
+    char len_str[12];
+    snprintf(len_str, sizeof(len_str), "%ld", (long)buf_len);
 
-    esp_err_t ret = snprintf(res_buf, required_size, httpd_hdr_str, ra->status, ra->content_type, buf_len);
-    if (ret < 0 || ret >= required_size) {
-        free(res_buf);
+    /* Size of essential headers is limited by scratch buffer size */
+    if (sizeof("HTTP/1.1 \r\nContent-Type: \r\nContent-Length: \r\n") + strlen(ra->status) +
+            strlen(ra->content_type) + strlen(len_str) > ra->max_req_hdr_len) {
         return ESP_ERR_HTTPD_RESP_HDR;
     }
-    ESP_LOGD(TAG, "httpd send buffer size = %d", strlen(res_buf));
-    ret = httpd_send_all(r, res_buf, strlen(res_buf));
-    free(res_buf);
-    if (ret != ESP_OK) {
-        return ESP_ERR_HTTPD_RESP_SEND;
-    }
 
-    /* Sending additional headers based on set_header */
-    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-        /* Send header field */
-        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send ': ' */
-        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send header value */
-        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send CR + LF */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
+    /* Status line, headers and content go out together */
+    struct httpd_resp_iov v = { .r = r };
+    httpd_resp_iov_add_str(&v, "HTTP/1.1 ");
+    httpd_resp_iov_add_str(&v, ra->status);
+    /* A 304 describes content the client already has, Content-Type and Content-Length: 0 would not match it */
+    if (strncmp(ra->status, "304", 3) != 0) {
+        httpd_resp_iov_add_str(&v, "\r\nContent-Type: ");
+        httpd_resp_iov_add_str(&v, ra->content_type);
+        httpd_resp_iov_add_str(&v, "\r\nContent-Length: ");
+        httpd_resp_iov_add_str(&v, len_str);
     }
-
-    /* End header section */
-    if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    httpd_resp_iov_add_hdrs(&v);
+    if (buf && buf_len) {
+        httpd_resp_iov_add(&v, buf, buf_len);
+    }
+    if (httpd_resp_iov_flush(&v) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
+    /* The headers went out along with the content */
     esp_http_server_dispatch_event(HTTP_SERVER_EVENT_HEADERS_SENT, &(ra->sd->fd), sizeof(int));
 
-    /* Sending content */
-    if (buf && buf_len) {
-        if (httpd_send_all(r, buf, buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-    }
     esp_http_server_event_data evt_data = {
         .fd = ra->sd->fd,
         .data_len = buf_len,
@@ -325,81 +449,40 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
     }
 
     struct httpd_req_aux *ra = r->aux;
-    const char *httpd_chunked_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
+    struct httpd_resp_iov v = { .r = r };
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
     if (!ra->first_chunk_sent) {
-        /* Calculate the size of the headers. +1 for the null terminator */
-        size_t required_size = snprintf(NULL, 0, httpd_chunked_hdr_str, ra->status, ra->content_type) + 1;
-        if (required_size > ra->max_req_hdr_len) {
-            return ESP_ERR_HTTPD_RESP_HDR;
-        }
-        char *res_buf = malloc(required_size); /* Temporary buffer to store the headers */
-        if (res_buf == NULL) {
-            ESP_LOGE(TAG, "Unable to allocate httpd send chunk buffer");
-            return ESP_ERR_HTTPD_ALLOC_MEM;
-        }
-        esp_err_t ret = snprintf(res_buf, required_size, httpd_chunked_hdr_str, ra->status, ra->content_type);
-        if (ret < 0 || ret >= required_size) {
-            free(res_buf);
-            return ESP_ERR_HTTPD_RESP_HDR;
-        }
-        ESP_LOGD(TAG, "httpd send chunk buffer size = %d", strlen(res_buf));
         /* Size of essential headers is limited by scratch buffer size */
-        ret = httpd_send_all(r, res_buf, strlen(res_buf));
-        free(res_buf);
-        if (ret != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-
-        /* Sending additional headers based on set_header */
-        for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-            /* Send header field */
-            if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send ': ' */
-            if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send header value */
-            if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send CR + LF */
-            if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
+        if (sizeof("HTTP/1.1 \r\nContent-Type: \r\nTransfer-Encoding: chunked\r\n") + strlen(ra->status) +
+                strlen(ra->content_type) > ra->max_req_hdr_len) {
+            return ESP_ERR_HTTPD_RESP_HDR;
         }
 
-        /* End header section */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        ra->first_chunk_sent = true;
+        /* The headers go out along with the first chunk */
+        httpd_resp_iov_add_str(&v, "HTTP/1.1 ");
+        httpd_resp_iov_add_str(&v, ra->status);
+        httpd_resp_iov_add_str(&v, "\r\nContent-Type: ");
+        httpd_resp_iov_add_str(&v, ra->content_type);
+        httpd_resp_iov_add_str(&v, "\r\nTransfer-Encoding: chunked");
+        httpd_resp_iov_add_hdrs(&v);
     }
 
-    /* Sending chunked content */
-    char len_str[10];
+    /* Chunk size, content and end of chunk */
+    char len_str[12];
     snprintf(len_str, sizeof(len_str), "%lx\r\n", (long)buf_len);
-    if (httpd_send_all(r, len_str, strlen(len_str)) != ESP_OK) {
-        return ESP_ERR_HTTPD_RESP_SEND;
-    }
-
+    httpd_resp_iov_add_str(&v, len_str);
     if (buf) {
-        if (httpd_send_all(r, buf, (size_t) buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
+        httpd_resp_iov_add(&v, buf, (size_t) buf_len);
     }
-
-    /* Indicate end of chunk */
-    if (httpd_send_all(r, "\r\n", strlen("\r\n")) != ESP_OK) {
+    httpd_resp_iov_add_str(&v, "\r\n");
+    if (httpd_resp_iov_flush(&v) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
+    ra->first_chunk_sent = true;
+
     esp_http_server_event_data evt_data = {
         .fd = ra->sd->fd,
         .data_len = buf_len,
@@ -748,6 +831,24 @@ int httpd_default_send(httpd_handle_t hd, int sockfd, const char *buf, size_t bu
     return ret;
 }
 
+int httpd_default_sendv(httpd_handle_t hd, int sockfd, const struct iovec *iov, int iovcnt, int flags)
+{
+    (void)hd;
+    if (iov == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    struct msghdr msg = {
+        .msg_iov = (struct iovec *) iov,
+        .msg_iovlen = iovcnt,
+    };
+    int ret = sendmsg(sockfd, &msg, flags);
+    if (ret < 0) {
+        return httpd_sock_err("sendmsg", sockfd);
+    }
+    return ret;
+}
+
 int httpd_default_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len, int flags)
 {
     (void)hd;
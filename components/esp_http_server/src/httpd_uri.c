@@ -87,6 +87,12 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
                                            httpd_method_t method,
                                            httpd_err_code_t *err)
 {
+#if CONFIG_HTTPD_URI_INDEX
+    if (hd->hd_uri_indexed) {
+        return uri_index_find(&hd->hd_uri_index, uri, uri_len, method, err);
+    }
+#endif
+
     if (err) {
         *err = HTTPD_404_NOT_FOUND;
     }
@@ -123,6 +129,26 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
     return NULL;
 }
 
+#if CONFIG_HTTPD_URI_INDEX
+void httpd_uri_index_rebuild(struct httpd_data *hd)
+{
+    uri_index_clear(&hd->hd_uri_index);
+    hd->hd_uri_indexed = (!hd->config.uri_match_fn ||
+                          hd->config.uri_match_fn == httpd_uri_match_wildcard);
+
+    for (int i = 0; hd->hd_uri_indexed && i < hd->config.max_uri_handlers; i++) {
+        if (!hd->hd_calls[i]) {
+            break;
+        }
+        if (uri_index_add(&hd->hd_uri_index, hd->hd_calls[i]) != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("no memory for URI index, searching handlers one by one"));
+            uri_index_clear(&hd->hd_uri_index);
+            hd->hd_uri_indexed = false;
+        }
+    }
+}
+#endif
+
 esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
                                      const httpd_uri_t *uri_handler)
 {
@@ -180,6 +206,14 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
             } else {
                 hd->hd_calls[i]->supported_subprotocol = NULL;
             }
+#endif
+#if CONFIG_HTTPD_URI_INDEX
+            if (hd->hd_uri_indexed && uri_index_add(&hd->hd_uri_index, hd->hd_calls[i]) != ESP_OK) {
+                /* The handler stays registered, just not indexed */
+                ESP_LOGW(TAG, LOG_FMT("no memory for URI index, searching handlers one by one"));
+                uri_index_clear(&hd->hd_uri_index);
+                hd->hd_uri_indexed = false;
+            }
 #endif
             ESP_LOGD(TAG, LOG_FMT("[%d] installed %s"), i, uri_handler->uri);
             return ESP_OK;
@@ -220,6 +254,9 @@ esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
             }
             /* Nullify the following non null entry */
             hd->hd_calls[i-1] = NULL;
+#if CONFIG_HTTPD_URI_INDEX
+            httpd_uri_index_rebuild(hd);
+#endif
             return ESP_OK;
         }
     }
@@ -260,6 +297,11 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
     for (int k = (i - j); k < i; k++) {
         hd->hd_calls[k] = NULL;
     }
+#if CONFIG_HTTPD_URI_INDEX
+    if (found) {
+        httpd_uri_index_rebuild(hd);
+    }
+#endif
 
     if (!found) {
         ESP_LOGW(TAG, LOG_FMT("no handler found for URI %s"), uri);
@@ -279,13 +321,16 @@ void httpd_unregister_all_uri_handlers(struct httpd_data *hd)
         free(hd->hd_calls[i]);
         hd->hd_calls[i] = NULL;
     }
+#if CONFIG_HTTPD_URI_INDEX
+    uri_index_clear(&hd->hd_uri_index);
+#endif
 }
 
 esp_err_t httpd_uri(struct httpd_data *hd)
 {
     httpd_uri_t            *uri = NULL;
-    httpd_req_t            *req = &hd->hd_req;
-    struct http_parser_url *res = &hd->hd_req_aux.url_parse_res;
+    httpd_req_t            *req = httpd_req_current(hd);
+    struct http_parser_url *res = &((struct httpd_req_aux *) req->aux)->url_parse_res;
 
     /* For conveying URI not found/method not allowed */
     httpd_err_code_t err = 0;
@@ -321,7 +366,7 @@ esp_err_t httpd_uri(struct httpd_data *hd)
     struct httpd_req_aux   *aux = req->aux;
     if (uri->is_websocket && aux->ws_handshake_detect && uri->method == HTTP_GET) {
         ESP_LOGD(TAG, LOG_FMT("Responding WS handshake to sock %d"), aux->sd->fd);
-        esp_err_t ret = httpd_ws_respond_server_handshake(&hd->hd_req, uri->supported_subprotocol);
+        esp_err_t ret = httpd_ws_respond_server_handshake(req, uri->supported_subprotocol);
         if (ret != ESP_OK) {
             return ret;
         }
@@ -47,6 +47,13 @@ static const char *TAG="httpd_ws";
 #define HTTPD_WS_MASK_BIT       0x80U
 #define HTTPD_WS_LENGTH_BITS    0x7fU
 
+/* Maximum length of the header of a frame sent by the server */
+#define HTTPD_WS_HEADER_MAX     10
+
+/* Frames broadcast to sessions without vectored send function are copied
+ * into one buffer for all of them, if not larger than this */
+#define HTTPD_WS_BROADCAST_COPY_MAX     4096
+
 /*
  * The magic GUID string used for handshake
  * Please refer to RFC6455 Section 1.3 for more details.
@@ -257,15 +264,40 @@ static esp_err_t httpd_ws_check_req(httpd_req_t *req)
     return ESP_OK;
 }
 
-static esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key)
+esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key)
 {
     if (len < 1 || !payload) {
         ESP_LOGW(TAG, LOG_FMT("Invalid payload provided"));
         return ESP_ERR_INVALID_ARG;
     }
 
-    for (size_t idx = 0; idx < len; idx++) {
-        payload[idx] = (payload[idx] ^ mask_key[idx % 4]);
+    /* Bytes up to the first aligned word */
+    size_t idx = 0;
+    for (; idx < len && ((uintptr_t) (payload + idx) % sizeof(uintptr_t)); idx++) {
+        payload[idx] ^= mask_key[idx % 4];
+    }
+
+    if (len - idx >= sizeof(uintptr_t)) {
+        /* The key repeats every 4 bytes, so every following word is
+         * masked with the key bytes in the order starting at idx */
+        uint8_t mask_bytes[sizeof(uintptr_t)];
+        for (size_t i = 0; i < sizeof(mask_bytes); i++) {
+            mask_bytes[i] = mask_key[(idx + i) % 4];
+        }
+        uintptr_t mask;
+        memcpy(&mask, mask_bytes, sizeof(mask));
+
+        for (; len - idx >= sizeof(uintptr_t); idx += sizeof(uintptr_t)) {
+            uint8_t *word_ptr = __builtin_assume_aligned(payload + idx, sizeof(uintptr_t));
+            uintptr_t word;
+            memcpy(&word, word_ptr, sizeof(word));
+            word ^= mask;
+            memcpy(word_ptr, &word, sizeof(word));
+        }
+    }
+
+    for (; idx < len; idx++) {
+        payload[idx] ^= mask_key[idx % 4];
     }
 
     return ESP_OK;
@@ -401,24 +433,19 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
     return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
 }
 
-esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+/* Writes the header of a frame sent by the server, returns its length */
+static size_t httpd_ws_encode_header(const httpd_ws_frame_t *frame, uint8_t *header_buf)
 {
-    if (!frame) {
-        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
-    uint8_t tx_len = 0;
-    uint8_t header_buf[10] = {0 };
+    /* Maximum length is 10, which includes 2 bytes header and 8 bytes length. The server doesn't mask its frames. */
+    size_t tx_len;
     /* Set the `FIN` bit by default if message is not fragmented. Else, set it as per the `final` field */
-    header_buf[0] |= (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
+    header_buf[0] = (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
     header_buf[0] |= frame->type; /* Type (opcode): 4 bits */
 
     if (frame->len <= 125) {
         header_buf[1] = frame->len & 0x7fU; /* Length for 7 bits */
         tx_len = 2;
-    } else if (frame->len > 125 && frame->len < UINT16_MAX) {
+    } else if (frame->len <= UINT16_MAX) {
         header_buf[1] = 126;                /* Length for 16 bits */
         header_buf[2] = (frame->len >> 8U) & 0xffU;
         header_buf[3] = frame->len & 0xffU;
@@ -435,30 +462,117 @@ esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t
         }
         tx_len = 10;
     }
+    return tx_len;
+}
 
-    /* WebSocket server does not required to mask response payload, so leave the MASK bit as 0. */
-    header_buf[1] &= (~HTTPD_WS_MASK_BIT);
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (!frame) {
+        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
 
     struct sock_db *sess = httpd_sess_get(hd, fd);
     if (!sess) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Send off header */
-    if (sess->send_fn(hd, fd, (const char *)header_buf, tx_len, 0) < 0) {
-        ESP_LOGW(TAG, LOG_FMT("Failed to send WS header"));
+    /* Send off header and payload together */
+    uint8_t header_buf[HTTPD_WS_HEADER_MAX];
+    struct iovec iov[2] = {
+        { .iov_base = header_buf, .iov_len = httpd_ws_encode_header(frame, header_buf) },
+        { .iov_base = frame->payload, .iov_len = frame->payload ? frame->len : 0 },
+    };
+    if (httpd_sess_sendv_all(sess, iov, iov[1].iov_len ? 2 : 1) != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("Failed to send WS frame"));
         return ESP_FAIL;
     }
 
-    /* Send off payload */
-    if(frame->len > 0 && frame->payload != NULL) {
-        if (sess->send_fn(hd, fd, (const char *)frame->payload, frame->len, 0) < 0) {
-            ESP_LOGW(TAG, LOG_FMT("Failed to send WS payload"));
-            return ESP_FAIL;
+    return ESP_OK;
+}
+
+typedef struct {
+    struct iovec iov[2];
+    char *flat;                 /* Header and payload copied together, for sessions without vectored send */
+    bool flat_failed;
+    size_t sent;
+    esp_err_t err;
+} ws_broadcast_t;
+
+static esp_err_t httpd_ws_broadcast_one(struct sock_db *sess, ws_broadcast_t *b)
+{
+    size_t len = b->iov[0].iov_len + b->iov[1].iov_len;
+    esp_err_t err;
+
+    if (!sess->sendv_fn && len <= HTTPD_WS_BROADCAST_COPY_MAX && !b->flat_failed) {
+        /* Copied once for all such sessions */
+        if (!b->flat && (b->flat = malloc(len)) != NULL) {
+            memcpy(b->flat, b->iov[0].iov_base, b->iov[0].iov_len);
+            memcpy(b->flat + b->iov[0].iov_len, b->iov[1].iov_base, b->iov[1].iov_len);
         }
+        b->flat_failed = !b->flat;
+    }
+    if (!sess->sendv_fn && b->flat) {
+        err = httpd_sess_send_all(sess, b->flat, len);
+    } else {
+        struct iovec iov[2] = { b->iov[0], b->iov[1] };
+        err = httpd_sess_sendv_all(sess, iov, iov[1].iov_len ? 2 : 1);
     }
 
-    return ESP_OK;
+    if (err == ESP_OK) {
+        b->sent++;
+    } else {
+        ESP_LOGW(TAG, LOG_FMT("Failed to send WS frame to fd %d"), sess->fd);
+        b->err = ESP_FAIL;
+    }
+    return err;
+}
+
+static int httpd_ws_broadcast_enum(struct sock_db *session, void *context)
+{
+    if (session->fd != -1 && session->ws_handshake_done && !session->ws_close) {
+        httpd_ws_broadcast_one(session, context);
+    }
+    return 1;
+}
+
+esp_err_t httpd_ws_broadcast_frame(httpd_handle_t hd, const int *fds, size_t fd_count,
+                                   httpd_ws_frame_t *frame, size_t *sent)
+{
+    if (!hd || !frame || (fd_count && !fds)) {
+        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* The frame is encoded only once */
+    uint8_t header_buf[HTTPD_WS_HEADER_MAX];
+    ws_broadcast_t b = {
+        .iov = {
+            { .iov_base = header_buf, .iov_len = httpd_ws_encode_header(frame, header_buf) },
+            { .iov_base = frame->payload, .iov_len = frame->payload ? frame->len : 0 },
+        },
+        .err = ESP_OK,
+    };
+
+    if (fds) {
+        for (size_t i = 0; i < fd_count; i++) {
+            struct sock_db *sess = httpd_sess_get(hd, fds[i]);
+            if (!sess) {
+                ESP_LOGW(TAG, LOG_FMT("No session for fd %d"), fds[i]);
+                b.err = ESP_FAIL;
+                continue;
+            }
+            httpd_ws_broadcast_one(sess, &b);
+        }
+    } else {
+        httpd_sess_enum(hd, httpd_ws_broadcast_enum, &b);
+    }
+
+    free(b.flat);
+    if (sent) {
+        *sent = b.sent;
+    }
+    return b.err;
 }
 
 esp_err_t httpd_ws_get_frame_type(httpd_req_t *req)
@@ -547,13 +661,15 @@ esp_err_t httpd_ws_get_frame_type(httpd_req_t *req)
 
 httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd)
 {
+    httpd_ws_client_info_t info = HTTPD_WS_CLIENT_INVALID;
+    httpd_sess_lock(hd);
     struct sock_db *sess = httpd_sess_get(hd, fd);
-
-    if (sess == NULL) {
-        return HTTPD_WS_CLIENT_INVALID;
+    if (sess) {
+        bool is_active_ws = sess->ws_handshake_done && (!sess->ws_close);
+        info = is_active_ws ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
     }
-    bool is_active_ws = sess->ws_handshake_done && (!sess->ws_close);
-    return is_active_ws ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+    httpd_sess_unlock(hd);
+    return info;
 }
 
 static void httpd_ws_send_cb(void *arg)
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "sess_arena.h"
+
+#define SESS_ARENA_ALIGN    _Alignof(max_align_t)
+
+static size_t sess_arena_align(size_t offset)
+{
+    return (offset + SESS_ARENA_ALIGN - 1) & ~(SESS_ARENA_ALIGN - 1);
+}
+
+static char *sess_arena_resize(sess_arena_t *arena, size_t size)
+{
+    char *buf = realloc(arena->buf, size);
+    if (buf) {
+        arena->buf = buf;
+        arena->size = size;
+    }
+    return buf;
+}
+
+char *sess_arena_grow(sess_arena_t *arena, size_t size)
+{
+    if (size > arena->size && !sess_arena_resize(arena, MAX(size, arena->want))) {
+        return NULL;
+    }
+    arena->used = MAX(arena->used, size);
+    arena->want = MAX(arena->want, arena->used);
+    return arena->buf;
+}
+
+void *sess_arena_alloc(sess_arena_t *arena, size_t len)
+{
+    size_t offset = sess_arena_align(arena->used);
+    if (offset + len > arena->size) {
+        arena->want = MAX(arena->want, offset + len);
+        return NULL;
+    }
+    arena->used = offset + len;
+    arena->want = MAX(arena->want, arena->used);
+    return arena->buf + offset;
+}
+
+void sess_arena_release(sess_arena_t *arena, void *ptr)
+{
+    char *p = ptr;
+    if (p >= arena->buf && p < arena->buf + arena->used) {
+        arena->used = p - arena->buf;
+    }
+}
+
+void sess_arena_reset(sess_arena_t *arena, size_t keep_off, size_t keep_len)
+{
+    if (keep_len && keep_off) {
+        memmove(arena->buf, arena->buf + keep_off, keep_len);
+    }
+    arena->used = keep_len;
+    if (arena->want > arena->size) {
+        /* Not enlarged if there is no memory, the allocations
+         * which don't fit then keep going to the heap */
+        sess_arena_resize(arena, arena->want);
+    }
+    arena->want = keep_len;
+}
+
+void sess_arena_free(sess_arena_t *arena)
+{
+    free(arena->buf);
+    memset(arena, 0, sizeof(*arena));
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * \file sess_arena.h
+ * \brief Memory of the requests of a session
+ *
+ * Allocating and freeing the buffers of every request, piece by piece,
+ * costs a number of heap operations per request. The arena is one block
+ * a session keeps while it is open instead: the request buffer grows at
+ * its start, other buffers of the request are taken from behind it, and
+ * the whole block is reset rather than freed once the request is done.
+ *
+ * An allocation which doesn't fit fails, so that the caller falls back
+ * to the heap, and the block is enlarged to fit it on the next reset.
+ * Once a session has seen its typical requests, these need no heap
+ * operations anymore.
+ */
+#ifndef _SESS_ARENA_H_
+#define _SESS_ARENA_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Block of memory reset between the requests of a session
+ *
+ * A zeroed structure is an empty arena.
+ */
+typedef struct sess_arena {
+    char *buf;          /*!< The block, NULL until first needed */
+    size_t size;        /*!< Size of the block */
+    size_t used;        /*!< Bytes at the start of the block in use */
+    size_t want;        /*!< Size the block should have to fit the allocations since the last reset */
+} sess_arena_t;
+
+/**
+ * @brief Make the start of the block at least the given size, keeping its contents
+ *
+ *      This is for the buffer at the start of the block, which grows while
+ *      data is received into it. The block may move, so pointers into it have
+ *      to be updated. It must not be called while other allocations are in use.
+ *
+ * @param[in] arena  the arena
+ * @param[in] size   size of the buffer at the start of the block
+ *
+ * @return - the start of the block
+ *         - NULL if the block couldn't be enlarged, its contents are kept
+ */
+char *sess_arena_grow(sess_arena_t *arena, size_t size);
+
+/**
+ * @brief Allocate a buffer behind the ones in use
+ *
+ * @param[in] arena  the arena
+ * @param[in] len    length of the buffer
+ *
+ * @return - the buffer, aligned for any type
+ *         - NULL if it doesn't fit in the block, the block is enlarged on the next reset
+ */
+void *sess_arena_alloc(sess_arena_t *arena, size_t len);
+
+/**
+ * @brief Release a buffer and all allocated after it
+ *
+ * @param[in] arena  the arena
+ * @param[in] ptr    buffer returned by sess_arena_alloc()
+ */
+void sess_arena_release(sess_arena_t *arena, void *ptr);
+
+/**
+ * @brief Release all buffers, keeping part of the block
+ *
+ *      The kept part is moved to the start of the block and stays in use.
+ *      This is where the block is enlarged, if allocations didn't fit.
+ *
+ * @param[in] arena     the arena
+ * @param[in] keep_off  offset of the part to keep
+ * @param[in] keep_len  length of the part to keep, 0 to keep nothing
+ */
+void sess_arena_reset(sess_arena_t *arena, size_t keep_off, size_t keep_len);
+
+/**
+ * @brief Free the block
+ *
+ * @param[in] arena  the arena, empty afterwards
+ */
+void sess_arena_free(sess_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ! _SESS_ARENA_H_ */
@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "uri_index.h"
+
+/* A handler matching the URI of a node, either exactly or as prefix */
+struct uri_index_entry {
+    httpd_uri_t *call;
+    uint32_t seq;                       /* Position among the handlers, entries are kept in ascending order */
+    struct uri_index_entry *next;
+};
+
+/* Node of the tree. The URI of a node is the concatenation of the labels
+ * from the root down to it, the root has an empty label. */
+struct uri_index_node {
+    struct uri_index_node *child;       /* First child, the labels of siblings start with different characters */
+    struct uri_index_node *sibling;
+    struct uri_index_entry *exact;      /* Handlers matching only the URI of this node */
+    struct uri_index_entry *prefix;     /* Handlers matching every URI starting with the one of this node */
+    size_t len;
+    char label[];
+};
+
+static struct uri_index_node *uri_index_node_new(const char *label, size_t len)
+{
+    struct uri_index_node *node = calloc(1, sizeof(struct uri_index_node) + len);
+    if (node) {
+        memcpy(node->label, label, len);
+        node->len = len;
+    }
+    return node;
+}
+
+static void uri_index_node_free(struct uri_index_node *node)
+{
+    while (node) {
+        struct uri_index_node *sibling = node->sibling;
+        uri_index_node_free(node->child);
+        for (int i = 0; i < 2; i++) {
+            struct uri_index_entry *entry = i ? node->prefix : node->exact;
+            while (entry) {
+                struct uri_index_entry *next = entry->next;
+                free(entry);
+                entry = next;
+            }
+        }
+        free(node);
+        node = sibling;
+    }
+}
+
+static struct uri_index_node *uri_index_child(const struct uri_index_node *node, char c)
+{
+    struct uri_index_node *child = node->child;
+    while (child && child->label[0] != c) {
+        child = child->sibling;
+    }
+    return child;
+}
+
+/* Returns the node of the URI of `node` followed by `key`, creating it if needed */
+static struct uri_index_node *uri_index_node_get(struct uri_index_node *node, const char *key, size_t len)
+{
+    while (len) {
+        struct uri_index_node *child = uri_index_child(node, key[0]);
+        if (!child) {
+            child = uri_index_node_new(key, len);
+            if (!child) {
+                return NULL;
+            }
+            child->sibling = node->child;
+            node->child = child;
+            return child;
+        }
+
+        size_t common = 1;
+        while (common < child->len && common < len && child->label[common] == key[common]) {
+            common++;
+        }
+        if (common < child->len) {
+            /* Split the child, the new node takes its place among the siblings */
+            struct uri_index_node *parent = uri_index_node_new(child->label, common);
+            if (!parent) {
+                return NULL;
+            }
+            struct uri_index_node **link = &node->child;
+            while (*link != child) {
+                link = &(*link)->sibling;
+            }
+            *link = parent;
+            parent->sibling = child->sibling;
+            parent->child = child;
+            child->sibling = NULL;
+            child->len -= common;
+            memmove(child->label, child->label + common, child->len);
+            child = parent;
+        }
+        node = child;
+        key += common;
+        len -= common;
+    }
+    return node;
+}
+
+static esp_err_t uri_index_entry_add(struct uri_index_entry **list, httpd_uri_t *call, uint32_t seq)
+{
+    struct uri_index_entry *entry = calloc(1, sizeof(struct uri_index_entry));
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->call = call;
+    entry->seq = seq;
+    while (*list) {
+        list = &(*list)->next;
+    }
+    *list = entry;
+    return ESP_OK;
+}
+
+void uri_index_init(uri_index_t *index, bool wildcard)
+{
+    index->root = NULL;
+    index->next_seq = 0;
+    index->wildcard = wildcard;
+}
+
+esp_err_t uri_index_add(uri_index_t *index, httpd_uri_t *call)
+{
+    const char *template = call->uri;
+    const size_t tpl_len = strlen(template);
+    size_t exact_match_chars = tpl_len;
+    bool asterisk = false;
+    bool quest = false;
+
+    if (index->wildcard) {
+        /* Same interpretation of the trailing characters as in httpd_uri_match_wildcard() */
+        const char last = (const char) (tpl_len > 0 ? template[tpl_len - 1] : 0);
+        const char prevlast = (const char) (tpl_len > 1 ? template[tpl_len - 2] : 0);
+        asterisk = last == '*' || (prevlast == '*' && last == '?');
+        quest = last == '?' || (prevlast == '?' && last == '*');
+        if (exact_match_chars < asterisk + quest * 2) {
+            /* Invalid template, never matches */
+            return ESP_OK;
+        }
+        exact_match_chars -= asterisk + quest * 2;
+    }
+
+    if (!index->root) {
+        index->root = uri_index_node_new("", 0);
+        if (!index->root) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* The template is turned into at most two entries:
+     *      "abc"   : exact "abc"
+     *      "abc*"  : prefix "abc"
+     *      "abc?"  : exact "ab", exact "abc"
+     *      "abc?*" : exact "ab", prefix "abc"
+     */
+    uint32_t seq = index->next_seq++;
+    struct uri_index_node *node = uri_index_node_get(index->root, template, exact_match_chars);
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (quest) {
+        if (uri_index_entry_add(&node->exact, call, seq) != ESP_OK) {
+            return ESP_ERR_NO_MEM;
+        }
+        node = uri_index_node_get(node, &template[exact_match_chars], 1);
+        if (!node) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return uri_index_entry_add(asterisk ? &node->prefix : &node->exact, call, seq);
+}
+
+/* Looks for a handler in `list` that comes before `*best` and accepts `method` */
+static void uri_index_consider(const struct uri_index_entry *list, httpd_method_t method,
+                               const struct uri_index_entry **best, bool *uri_found)
+{
+    if (list) {
+        *uri_found = true;
+    }
+    for (; list && (!*best || list->seq < (*best)->seq); list = list->next) {
+        if (list->call->method == method || list->call->method == HTTP_ANY) {
+            *best = list;
+            return;
+        }
+    }
+}
+
+httpd_uri_t *uri_index_find(const uri_index_t *index, const char *uri, size_t len,
+                            httpd_method_t method, httpd_err_code_t *err)
+{
+    const struct uri_index_entry *best = NULL;
+    bool uri_found = false;
+    const struct uri_index_node *node = index->root;
+
+    /* Every node on the path of the URI contributes its prefix handlers,
+     * the node of the whole URI its exact handlers as well */
+    while (node) {
+        uri_index_consider(node->prefix, method, &best, &uri_found);
+        if (!len) {
+            uri_index_consider(node->exact, method, &best, &uri_found);
+            break;
+        }
+        node = uri_index_child(node, uri[0]);
+        if (!node || node->len > len || memcmp(node->label, uri, node->len) != 0) {
+            break;
+        }
+        uri += node->len;
+        len -= node->len;
+    }
+
+    if (err) {
+        *err = best ? 0 : (uri_found ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND);
+    }
+    return best ? best->call : NULL;
+}
+
+void uri_index_clear(uri_index_t *index)
+{
+    uri_index_node_free(index->root);
+    index->root = NULL;
+    index->next_seq = 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * \file uri_index.h
+ * \brief Radix tree of URI handlers
+ *
+ * Finding the handler of a request by running the match function on
+ * every registered URI gets slow with many handlers. This index keeps
+ * the URI templates in a radix tree on their characters instead, so
+ * that a lookup only walks the characters of the requested URI.
+ *
+ * Templates are compiled when the handler is added. Besides literal
+ * URIs, the templates understood by httpd_uri_match_wildcard() are
+ * supported: a trailing '*' matches any suffix, a trailing '?' makes
+ * the preceding character optional. A lookup yields the same handler
+ * and the same 404 / 405 error as the linear search over the handlers
+ * in the order they were added.
+ */
+#ifndef _URI_INDEX_H_
+#define _URI_INDEX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uri_index_node;
+
+/**
+ * @brief Radix tree of URI handlers
+ */
+typedef struct uri_index {
+    struct uri_index_node *root;    /*!< Node of the empty URI, NULL if no handler was added */
+    uint32_t next_seq;              /*!< Position of the next handler added, lower ones take precedence */
+    bool wildcard;                  /*!< Templates are compiled as for httpd_uri_match_wildcard() */
+} uri_index_t;
+
+/**
+ * @brief Initialize an empty index
+ *
+ * @param[out] index     the index to initialize
+ * @param[in]  wildcard  true to interpret the templates like httpd_uri_match_wildcard(),
+ *                       false to match them literally
+ */
+void uri_index_init(uri_index_t *index, bool wildcard);
+
+/**
+ * @brief Add a handler to the index
+ *
+ *      The handler takes precedence over the ones added after it. The URI
+ *      template and the method are read from the handler, which has to
+ *      stay valid as long as it is part of the index.
+ *
+ *      If this fails, the index may hold part of the template. It has to be
+ *      cleared and can't be used until it is filled again.
+ *
+ * @param[in] index  the index
+ * @param[in] call   the handler
+ *
+ * @return - ESP_OK on success
+ *         - ESP_ERR_NO_MEM if a node couldn't be allocated
+ */
+esp_err_t uri_index_add(uri_index_t *index, httpd_uri_t *call);
+
+/**
+ * @brief Find the handler of a request
+ *
+ * @param[in]  index   the index
+ * @param[in]  uri     the path of the request, not necessarily null terminated
+ * @param[in]  len     length of the path
+ * @param[in]  method  method of the request
+ * @param[out] err     set to 0 if a handler is found, otherwise to HTTPD_405_METHOD_NOT_ALLOWED
+ *                     if a handler matches the path but not the method, else HTTPD_404_NOT_FOUND.
+ *                     May be NULL.
+ *
+ * @return - the first handler added that matches both path and method
+ *         - NULL if there is none
+ */
+httpd_uri_t *uri_index_find(const uri_index_t *index, const char *uri, size_t len,
+                            httpd_method_t method, httpd_err_code_t *err);
+
+/**
+ * @brief Remove all handlers and free the memory of the index
+ *
+ * @param[in] index  the index
+ */
+void uri_index_clear(uri_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ! _URI_INDEX_H_ */
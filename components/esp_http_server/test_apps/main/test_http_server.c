@@ -6,8 +6,13 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include <esp_system.h>
 #include <esp_http_server.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
 
 #include "unity.h"
 #include "test_utils.h"
@@ -244,6 +249,237 @@ TEST_CASE("Max Allowed Sockets Test", "[HTTP SERVER]")
     TEST_ASSERT(httpd_start(&hd, &config) != ESP_OK);
 }
 
+#if CONFIG_HTTPD_WORKERS
+
+#define IDF_LOG_PERFORMANCE(item, value_fmt, value, ...) \
+    printf("[Performance][%s]: " value_fmt "\n", item, value, ##__VA_ARGS__)
+
+#define WORKER_TEST_PIPELINED   5
+#define WORKER_TEST_SLOW_MS     500
+#define WORKER_TEST_BENCH_REQS  200
+
+/* Sleeps the longer the earlier the request was sent, then echoes its number */
+static esp_err_t seq_handler(httpd_req_t *req)
+{
+    char query[16], n[4] = "";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "n", n, sizeof(n));
+    }
+    vTaskDelay(pdMS_TO_TICKS((WORKER_TEST_PIPELINED - atoi(n)) * 20));
+    return httpd_resp_sendstr(req, n);
+}
+
+static esp_err_t slow_handler(httpd_req_t *req)
+{
+    vTaskDelay(pdMS_TO_TICKS(*(int *) req->user_ctx));
+    return httpd_resp_sendstr(req, "slow");
+}
+
+static esp_err_t fast_handler(httpd_req_t *req)
+{
+    return httpd_resp_sendstr(req, "fast");
+}
+
+static httpd_handle_t worker_test_start(uint8_t worker_count, int *slow_ms)
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    /* Leave enough of the LWIP sockets for the clients */
+    config.max_open_sockets = 3;
+    config.worker_count = worker_count;
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+
+    httpd_uri_t uris[] = {
+        { .uri = "/seq", .method = HTTP_GET, .handler = seq_handler },
+        { .uri = "/slow", .method = HTTP_GET, .handler = slow_handler, .user_ctx = slow_ms },
+        { .uri = "/fast", .method = HTTP_GET, .handler = fast_handler },
+    };
+    for (int i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
+        TEST_ASSERT(httpd_register_uri_handler(hd, &uris[i]) == ESP_OK);
+    }
+    return hd;
+}
+
+static int worker_test_connect(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(80),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct timeval timeout = { .tv_sec = 5 };
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    TEST_ASSERT(sock >= 0);
+    TEST_ASSERT(setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0);
+    TEST_ASSERT(connect(sock, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+    return sock;
+}
+
+static void worker_test_send(int sock, const char *uri)
+{
+    char request[64];
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", uri);
+    TEST_ASSERT(send(sock, request, len, 0) == len);
+}
+
+/* Reads a single response, byte by byte so that the next pipelined one is left in the socket */
+static void worker_test_recv(int sock, char *body, size_t body_size)
+{
+    char head[256];
+    size_t len = 0;
+    while (len < 4 || memcmp(&head[len - 4], "\r\n\r\n", 4) != 0) {
+        TEST_ASSERT(len < sizeof(head) - 1);
+        TEST_ASSERT(recv(sock, &head[len++], 1, 0) == 1);
+    }
+    head[len] = '\0';
+    TEST_ASSERT(strncmp(head, "HTTP/1.1 200", 12) == 0);
+    const char *content_length = strstr(head, "Content-Length: ");
+    TEST_ASSERT_NOT_NULL(content_length);
+    size_t body_len = atoi(content_length + strlen("Content-Length: "));
+    TEST_ASSERT(body_len < body_size);
+    for (size_t read = 0; read < body_len; ) {
+        int ret = recv(sock, body + read, body_len - read, 0);
+        TEST_ASSERT(ret > 0);
+        read += ret;
+    }
+    body[body_len] = '\0';
+}
+
+TEST_CASE("Worker Tasks keep the responses of a session in order", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    int slow_ms = 0;
+    httpd_handle_t hd = worker_test_start(2, &slow_ms);
+    int sock = worker_test_connect();
+
+    /* The earlier requests take longer, still their responses come first */
+    char uri[16], body[8];
+    for (int i = 0; i < WORKER_TEST_PIPELINED; i++) {
+        snprintf(uri, sizeof(uri), "/seq?n=%d", i);
+        worker_test_send(sock, uri);
+    }
+    for (int i = 0; i < WORKER_TEST_PIPELINED; i++) {
+        worker_test_recv(sock, body, sizeof(body));
+        TEST_ASSERT_EQUAL(i, atoi(body));
+    }
+
+    close(sock);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+TEST_CASE("Worker Tasks don't block other clients on a slow handler", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    int slow_ms = WORKER_TEST_SLOW_MS;
+    httpd_handle_t hd = worker_test_start(2, &slow_ms);
+    int slow_sock = worker_test_connect();
+    int fast_sock = worker_test_connect();
+    char body[8];
+
+    worker_test_send(slow_sock, "/slow");
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    /* Answered by the other worker while the slow handler still runs */
+    int64_t start = esp_timer_get_time();
+    worker_test_send(fast_sock, "/fast");
+    worker_test_recv(fast_sock, body, sizeof(body));
+    TEST_ASSERT_EQUAL_STRING("fast", body);
+    TEST_ASSERT_LESS_THAN(WORKER_TEST_SLOW_MS / 2 * 1000, esp_timer_get_time() - start);
+
+    worker_test_recv(slow_sock, body, sizeof(body));
+    TEST_ASSERT_EQUAL_STRING("slow", body);
+
+    close(fast_sock);
+    close(slow_sock);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+static volatile bool s_slow_client_run;
+
+/* Keeps a request to the slow handler pending until told to stop */
+static void slow_client_task(void *arg)
+{
+    SemaphoreHandle_t done = (SemaphoreHandle_t) arg;
+    int sock = worker_test_connect();
+    char body[8];
+    while (s_slow_client_run) {
+        worker_test_send(sock, "/slow");
+        worker_test_recv(sock, body, sizeof(body));
+    }
+    close(sock);
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+    int64_t diff = *(const int64_t *) a - *(const int64_t *) b;
+    return diff < 0 ? -1 : diff > 0;
+}
+
+/* Request rate and latency of a client on a fast handler, while another one waits on a slow handler */
+static void worker_test_bench(uint8_t worker_count)
+{
+    int slow_ms = 20;
+    httpd_handle_t hd = worker_test_start(worker_count, &slow_ms);
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(done);
+    s_slow_client_run = true;
+    TEST_ASSERT(xTaskCreate(slow_client_task, "slow_client", 4096, done, uxTaskPriorityGet(NULL), NULL) == pdPASS);
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    int64_t *latency = calloc(WORKER_TEST_BENCH_REQS, sizeof(int64_t));
+    TEST_ASSERT_NOT_NULL(latency);
+    int sock = worker_test_connect();
+    char body[8];
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < WORKER_TEST_BENCH_REQS; i++) {
+        int64_t sent = esp_timer_get_time();
+        worker_test_send(sock, "/fast");
+        worker_test_recv(sock, body, sizeof(body));
+        latency[i] = esp_timer_get_time() - sent;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    close(sock);
+
+    s_slow_client_run = false;
+    TEST_ASSERT(xSemaphoreTake(done, pdMS_TO_TICKS(5000)) == pdTRUE);
+    vSemaphoreDelete(done);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+
+    qsort(latency, WORKER_TEST_BENCH_REQS, sizeof(int64_t), compare_latency);
+    IDF_LOG_PERFORMANCE("HTTPD_REQ_PER_SEC", "%.1f, workers: %d", WORKER_TEST_BENCH_REQS * 1e6 / elapsed, worker_count);
+    IDF_LOG_PERFORMANCE("HTTPD_LATENCY_P50", "%" PRId64 " us, workers: %d", latency[WORKER_TEST_BENCH_REQS / 2], worker_count);
+    IDF_LOG_PERFORMANCE("HTTPD_LATENCY_P99", "%" PRId64 " us, workers: %d", latency[WORKER_TEST_BENCH_REQS * 99 / 100], worker_count);
+    free(latency);
+}
+
+TEST_CASE("Worker Tasks request rate and latency", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    worker_test_bench(0);
+    worker_test_bench(2);
+}
+
+#else
+
+TEST_CASE("Worker Tasks Test", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.worker_count = 3;
+
+    /* Workers aren't available unless enabled in the configuration */
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_ERR_INVALID_ARG);
+}
+
+#endif
+
 void app_main(void)
 {
     unity_run_menu();
@@ -6,6 +6,10 @@ from pytest_embedded_idf.utils import idf_parametrize
 
 
 @pytest.mark.generic
-@idf_parametrize('target', ['supported_targets'], indirect=['target'])
+@idf_parametrize(
+    'config,target',
+    [('default', 'supported_targets'), ('workers', 'supported_targets')],
+    indirect=['config', 'target'],
+)
 def test_esp_http_server(dut: Dut) -> None:
     dut.run_all_single_board_cases()
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -17,6 +17,9 @@
 #include "esp_heap_task_info_internal.h"
 #include "multi_heap_internal.h"
 #endif
+#if CONFIG_HEAP_SMALL_CACHE
+#include "heap_small_cache.h"
+#endif
 
 #ifdef CONFIG_HEAP_USE_HOOKS
 #define CALL_HOOK(hook, ...) {      \
@@ -34,6 +37,59 @@ extern void esp_heap_adjust_alignment_to_hw(size_t *p_alignment, size_t *p_size,
 //Default alignment the multiheap allocator / tlsf will align 'unaligned' memory to, in bytes
 #define UNALIGNED_MEM_ALIGNMENT_BYTES 4
 
+#if CONFIG_HEAP_SMALL_CACHE
+/* Blocks of the heaps having all these caps are cached when freed, and served to the
+   allocations requesting some of these caps only. Other allocations (DMA, EXEC, SPIRAM...)
+   always go to the heaps, they need memory the cache may not hold.
+*/
+#define SMALL_CACHE_CAPS (MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT | MALLOC_CAP_32BIT)
+
+/* One cache per core. A cache is only accessed by its core, with interrupts disabled, so a task cannot be
+   moved to another core while using it and no lock is needed. Since the caches do not belong to tasks,
+   nothing is left behind when a task is deleted.
+*/
+static heap_small_cache_t s_small_cache[portNUM_PROCESSORS];
+
+HEAP_IRAM_ATTR static void *small_cache_alloc(size_t size)
+{
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    void *ret = heap_small_cache_pop(&s_small_cache[xPortGetCoreID()], size);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    return ret;
+}
+
+HEAP_IRAM_ATTR static bool small_cache_free(heap_t *heap, void *ptr)
+{
+    if ((get_all_caps(heap) & SMALL_CACHE_CAPS) != SMALL_CACHE_CAPS) {
+        return false;
+    }
+    // Reads the header of an allocated block, which does not need the heap lock
+    size_t size = multi_heap_get_allocated_size(heap->heap, ptr);
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    bool cached = heap_small_cache_push(&s_small_cache[xPortGetCoreID()], ptr, size, CONFIG_HEAP_SMALL_CACHE_DEPTH);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    return cached;
+}
+
+HEAP_IRAM_ATTR size_t heap_caps_small_cache_flush(void)
+{
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    void *block = heap_small_cache_take_all(&s_small_cache[xPortGetCoreID()]);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+
+    size_t count = 0;
+    while (block != NULL) {
+        void *next = *(void **)block;
+        heap_t *heap = find_containing_heap(block);
+        assert(heap != NULL);
+        multi_heap_free(heap->heap, block);
+        block = next;
+        count++;
+    }
+    return count;
+}
+#endif // CONFIG_HEAP_SMALL_CACHE
+
 /*
   This takes a memory chunk in a region that can be addressed as both DRAM as well as IRAM. It will convert it to
   IRAM in such a way that it can be later freed. It assumes both the address as well as the length to be word-aligned.
@@ -83,6 +139,13 @@ HEAP_IRAM_ATTR void heap_caps_free( void *ptr)
     heap_caps_update_per_task_info_free(heap, ptr);
 #endif
 
+#if CONFIG_HEAP_SMALL_CACHE
+    if (small_cache_free(heap, ptr)) {
+        CALL_HOOK(esp_heap_trace_free_hook, ptr);
+        return;
+    }
+#endif
+
     multi_heap_free(heap->heap, block_owner_ptr);
 
     CALL_HOOK(esp_heap_trace_free_hook, ptr);
@@ -134,6 +197,16 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
         size = (size + 3) & (~3); // int overflow checked above
     }
 
+#if CONFIG_HEAP_SMALL_CACHE
+    if (caps != 0 && (caps & ~SMALL_CACHE_CAPS) == 0 && alignment <= UNALIGNED_MEM_ALIGNMENT_BYTES) {
+        ret = small_cache_alloc(size);
+        if (ret != NULL) {
+            CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
+            return ret;
+        }
+    }
+#endif
+
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
         heap_t *heap;
@@ -193,6 +266,14 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
         }
     }
 
+#if CONFIG_HEAP_SMALL_CACHE
+    //The memory may be held by the cache of this core. Parameters are already adjusted, adjusting them again
+    //does not change them.
+    if (heap_caps_small_cache_flush() != 0) {
+        return heap_caps_aligned_alloc_base(alignment, size, caps);
+    }
+#endif
+
     //Nothing usable found.
     return NULL;
 }
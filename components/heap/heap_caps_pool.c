@@ -0,0 +1,235 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <assert.h>
+#include <sys/param.h>
+#include "sys/queue.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_caps_pool.h"
+#include "heap_pool_slab.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <pthread.h>
+
+typedef pthread_mutex_t pool_lock_t;
+
+#define POOL_LOCK_STATIC_INITIALIZER    PTHREAD_MUTEX_INITIALIZER
+#define POOL_LOCK_INIT(PLOCK)           pthread_mutex_init((PLOCK), NULL)
+#define POOL_LOCK_DELETE(PLOCK)         pthread_mutex_destroy((PLOCK))
+#define POOL_LOCK(PLOCK)                pthread_mutex_lock((PLOCK))
+#define POOL_UNLOCK(PLOCK)              pthread_mutex_unlock((PLOCK))
+#else
+#include "freertos/FreeRTOS.h"
+#include "esp_rom_sys.h"
+#include "heap_private.h"
+
+/* Objects may be allocated and freed in an ISR, like heap memory,
+   so the pools use portmux spinlocks like the heaps */
+typedef portMUX_TYPE pool_lock_t;
+
+#define POOL_LOCK_STATIC_INITIALIZER    portMUX_INITIALIZER_UNLOCKED
+#define POOL_LOCK_INIT(PLOCK)           portMUX_INITIALIZE((PLOCK))
+#define POOL_LOCK_DELETE(PLOCK)         (void)(PLOCK)
+#define POOL_LOCK(PLOCK)                portENTER_CRITICAL_SAFE((PLOCK))
+#define POOL_UNLOCK(PLOCK)              portEXIT_CRITICAL_SAFE((PLOCK))
+#endif
+
+#if CONFIG_HEAP_TRACING && !CONFIG_IDF_TARGET_LINUX
+/* Heap tracing records the objects (heap_caps_pool_alloc() and heap_caps_pool_free() are wrapped),
+   not the slab holding them, which would have the address of the first object */
+void *__real_heap_caps_malloc_base(size_t size, uint32_t caps);
+void __real_heap_caps_free(void *p);
+
+static void *pool_slab_malloc(size_t size, uint32_t caps)
+{
+    void *memory = __real_heap_caps_malloc_base(size, caps);
+    if (memory == NULL) {
+        // done by heap_caps_malloc() otherwise
+        heap_caps_alloc_failed(size, caps, "heap_caps_pool_create");
+    }
+    return memory;
+}
+
+#define SLAB_MALLOC(SIZE, CAPS)     pool_slab_malloc((SIZE), (CAPS))
+#define SLAB_FREE(PTR)              __real_heap_caps_free((PTR))
+#else
+#define SLAB_MALLOC(SIZE, CAPS)     heap_caps_malloc((SIZE), (CAPS))
+#define SLAB_FREE(PTR)              heap_caps_free((PTR))
+#endif
+
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+/* Free objects kept by a core, only accessed by this core with interrupts disabled */
+typedef struct {
+    void *head;
+    size_t count;
+} pool_core_cache_t;
+#endif
+
+struct heap_caps_pool {
+    heap_pool_slab_t slab;
+    pool_lock_t lock;
+    size_t obj_size;
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+    pool_core_cache_t core_cache[portNUM_PROCESSORS];
+#endif
+    SLIST_ENTRY(heap_caps_pool) next;
+};
+
+/* All the pools, for heap_caps_print_heap_info() */
+static SLIST_HEAD(pool_ll, heap_caps_pool) s_pools = SLIST_HEAD_INITIALIZER(s_pools);
+static pool_lock_t s_pools_lock = POOL_LOCK_STATIC_INITIALIZER;
+
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+HEAP_IRAM_ATTR static void *core_cache_pop(heap_caps_pool_t *pool)
+{
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    pool_core_cache_t *cache = &pool->core_cache[xPortGetCoreID()];
+    void *obj = cache->head;
+    if (obj != NULL) {
+        cache->head = *(void **)obj;
+        cache->count--;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    return obj;
+}
+
+HEAP_IRAM_ATTR static bool core_cache_push(heap_caps_pool_t *pool, void *obj)
+{
+    bool cached = false;
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    pool_core_cache_t *cache = &pool->core_cache[xPortGetCoreID()];
+    if (cache->count < CONFIG_HEAP_POOL_PER_CORE_CACHE) {
+        *(void **)obj = cache->head;
+        cache->head = obj;
+        cache->count++;
+        cached = true;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    return cached;
+}
+#endif // CONFIG_HEAP_POOL_PER_CORE_CACHE
+
+heap_caps_pool_t *heap_caps_pool_create(size_t obj_size, size_t count, uint32_t caps)
+{
+    size_t stride = heap_pool_slab_stride(obj_size);
+    size_t slab_size;
+    if (obj_size == 0 || count == 0 || stride < obj_size || __builtin_mul_overflow(stride, count, &slab_size)) {
+        return NULL;
+    }
+
+    // The pool itself is accessed with its lock held, maybe in an ISR: internal RAM
+    heap_caps_pool_t *pool = heap_caps_calloc(1, sizeof(heap_caps_pool_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool == NULL) {
+        return NULL;
+    }
+    void *memory = SLAB_MALLOC(slab_size, caps);
+    if (memory == NULL) {
+        heap_caps_free(pool);
+        return NULL;
+    }
+    heap_pool_slab_init(&pool->slab, memory, stride, count);
+    POOL_LOCK_INIT(&pool->lock);
+    pool->obj_size = obj_size;
+
+    POOL_LOCK(&s_pools_lock);
+    SLIST_INSERT_HEAD(&s_pools, pool, next);
+    POOL_UNLOCK(&s_pools_lock);
+    return pool;
+}
+
+void heap_caps_pool_delete(heap_caps_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    POOL_LOCK(&s_pools_lock);
+    SLIST_REMOVE(&s_pools, pool, heap_caps_pool, next);
+    POOL_UNLOCK(&s_pools_lock);
+
+    POOL_LOCK_DELETE(&pool->lock);
+    SLAB_FREE(pool->slab.start);
+    heap_caps_free(pool);
+}
+
+HEAP_IRAM_ATTR void *heap_caps_pool_alloc(heap_caps_pool_t *pool)
+{
+    assert(pool != NULL);
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+    void *cached = core_cache_pop(pool);
+    if (cached != NULL) {
+        return cached;
+    }
+#endif
+    POOL_LOCK(&pool->lock);
+    void *obj = heap_pool_slab_alloc(&pool->slab);
+    POOL_UNLOCK(&pool->lock);
+    return obj;
+}
+
+HEAP_IRAM_ATTR void heap_caps_pool_free(heap_caps_pool_t *pool, void *ptr)
+{
+    assert(pool != NULL);
+    if (ptr == NULL) {
+        return;
+    }
+    // Objects are only added to the allocated part of the slab, which can be checked without the lock
+    assert(heap_pool_slab_contains(&pool->slab, ptr) && "heap_caps_pool_free() target pointer is not an object of the pool");
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+    if (core_cache_push(pool, ptr)) {
+        return;
+    }
+#endif
+    POOL_LOCK(&pool->lock);
+    heap_pool_slab_free(&pool->slab, ptr);
+    POOL_UNLOCK(&pool->lock);
+}
+
+HEAP_IRAM_ATTR size_t heap_caps_pool_get_obj_size(const heap_caps_pool_t *pool)
+{
+    return pool->obj_size;
+}
+
+void heap_caps_pool_get_info(heap_caps_pool_t *pool, heap_caps_pool_info_t *info)
+{
+    assert(pool != NULL && info != NULL);
+    POOL_LOCK(&pool->lock);
+    info->obj_size = pool->obj_size;
+    info->capacity = (pool->slab.end - pool->slab.start) / pool->slab.stride;
+    info->allocated = pool->slab.used;
+    info->peak_allocated = pool->slab.peak;
+    info->total_bytes = pool->slab.end - pool->slab.start;
+    POOL_UNLOCK(&pool->lock);
+    info->cached = 0;
+#if CONFIG_HEAP_POOL_PER_CORE_CACHE
+    // Read without disabling the interrupts of the other cores, may be slightly outdated
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        info->cached += pool->core_cache[core].count;
+    }
+    info->allocated -= MIN(info->allocated, info->cached);
+#endif
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+void heap_caps_pool_print_info(uint32_t caps)
+{
+    // Not safe to use std i/o while in a portmux critical section, use the ROM function like multi_heap
+    POOL_LOCK(&s_pools_lock);
+    heap_caps_pool_t *pool;
+    SLIST_FOREACH(pool, &s_pools, next) {
+        heap_t *heap = find_containing_heap(pool->slab.start);
+        if (heap == NULL || !heap_caps_match(heap, caps)) {
+            continue;
+        }
+        heap_caps_pool_info_t info;
+        heap_caps_pool_get_info(pool, &info);
+        esp_rom_printf("  Pool at 0x%08x len %d obj_size %d allocated %d/%d peak %d\n",
+               (intptr_t)pool->slab.start, info.total_bytes, info.obj_size,
+               info.allocated, info.capacity, info.peak_allocated);
+    }
+    POOL_UNLOCK(&s_pools_lock);
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed-size objects in one contiguous slab, the storage of heap_caps_pool_t.
+
+   Freed objects are linked through their first word. Objects which were never
+   allocated are taken from the end of the slab instead of being linked at
+   initialization, so that all the operations are O(1).
+
+   These functions do no locking. They are platform independent, so that the
+   host tests of multi_heap can use them, and always inlined, so that they are
+   placed in IRAM together with the callers.
+*/
+
+typedef struct {
+    void *free;         ///< Freed objects
+    uint8_t *unused;    ///< First object never allocated
+    uint8_t *start;
+    uint8_t *end;
+    size_t stride;      ///< Distance between two objects
+    size_t used;        ///< Number of allocated objects
+    size_t peak;        ///< Maximum number of allocated objects
+} heap_pool_slab_t;
+
+/* Distance between the objects of obj_size bytes: they hold a pointer when free and are pointer aligned */
+static inline __attribute__((always_inline)) size_t heap_pool_slab_stride(size_t obj_size)
+{
+    if (obj_size < sizeof(void *)) {
+        obj_size = sizeof(void *);
+    }
+    return (obj_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+}
+
+static inline __attribute__((always_inline)) void heap_pool_slab_init(heap_pool_slab_t *slab, void *memory, size_t stride, size_t count)
+{
+    slab->free = NULL;
+    slab->start = (uint8_t *)memory;
+    slab->unused = slab->start;
+    slab->end = slab->start + stride * count;
+    slab->stride = stride;
+    slab->used = 0;
+    slab->peak = 0;
+}
+
+/* Returns NULL if all the objects are allocated */
+static inline __attribute__((always_inline)) void *heap_pool_slab_alloc(heap_pool_slab_t *slab)
+{
+    void *obj = slab->free;
+    if (obj != NULL) {
+        slab->free = *(void **)obj;
+    } else if (slab->unused < slab->end) {
+        obj = slab->unused;
+        slab->unused += slab->stride;
+    } else {
+        return NULL;
+    }
+    if (++slab->used > slab->peak) {
+        slab->peak = slab->used;
+    }
+    return obj;
+}
+
+static inline __attribute__((always_inline)) void heap_pool_slab_free(heap_pool_slab_t *slab, void *obj)
+{
+    *(void **)obj = slab->free;
+    slab->free = obj;
+    slab->used--;
+}
+
+/* True if obj is the address of an object of the slab */
+static inline __attribute__((always_inline)) bool heap_pool_slab_contains(const heap_pool_slab_t *slab, const void *obj)
+{
+    const uint8_t *p = (const uint8_t *)obj;
+    return p >= slab->start && p < slab->unused && (size_t)(p - slab->start) % slab->stride == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -95,6 +95,13 @@ void *heap_caps_calloc_base(size_t n, size_t size, uint32_t caps);
 void *heap_caps_malloc_base(size_t size, uint32_t caps);
 void *heap_caps_aligned_alloc_base(size_t alignment, size_t size, uint32_t caps);
 
+/* Calls the failed allocation callback and aborts if CONFIG_HEAP_ABORT_WHEN_ALLOCATION_FAILS is set,
+   for allocations made with the _base functions above */
+void heap_caps_alloc_failed(size_t requested_size, uint32_t caps, const char *function_name);
+
+/* Print the pools (esp_heap_caps_pool.h) whose memory is in heaps matching caps */
+void heap_caps_pool_print_info(uint32_t caps);
+
 #ifdef __cplusplus
 }
 #endif
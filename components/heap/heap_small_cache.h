@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size-class free-lists of small blocks, kept in front of a multi_heap.
+
+   Freed blocks of up to HEAP_SMALL_CACHE_MAX_SIZE usable bytes stay allocated
+   in the heap and are linked into the list of their size class (through
+   their first word), to be returned by a later allocation without taking the
+   heap lock. Each list holds at most `depth` blocks, the others are freed to
+   the heap.
+
+   These functions do no locking: the caller makes sure that only one context
+   accesses a cache at a time (e.g. one cache per core, with interrupts
+   disabled). They are platform independent, so that the host tests of
+   multi_heap can use them, and always inlined, so that they are placed in
+   IRAM together with the callers.
+*/
+
+#define HEAP_SMALL_CACHE_MAX_SIZE   64  ///< Largest usable size of a cached block
+#define HEAP_SMALL_CACHE_GRANULE    4   ///< Usable sizes of the blocks are multiples of the heap alignment
+#define HEAP_SMALL_CACHE_CLASSES    (HEAP_SMALL_CACHE_MAX_SIZE / HEAP_SMALL_CACHE_GRANULE)
+#define HEAP_SMALL_CACHE_SEARCH     3   ///< Number of size classes tried by an allocation, from the smallest fitting one
+
+typedef struct {
+    void *head[HEAP_SMALL_CACHE_CLASSES];
+    uint8_t count[HEAP_SMALL_CACHE_CLASSES];
+} heap_small_cache_t;
+
+/* Takes a cached block of at least `size` bytes, or returns NULL.
+   A block of the smallest fitting class may not exist (the heap has a minimum block size,
+   and it may return blocks larger than requested), so the next classes are tried too. */
+static inline __attribute__((always_inline)) void *heap_small_cache_pop(heap_small_cache_t *cache, size_t size)
+{
+    if (size == 0 || size > HEAP_SMALL_CACHE_MAX_SIZE) {
+        return NULL;
+    }
+    size_t first = (size + HEAP_SMALL_CACHE_GRANULE - 1) / HEAP_SMALL_CACHE_GRANULE - 1;
+    size_t last = first + HEAP_SMALL_CACHE_SEARCH;
+    for (size_t cls = first; cls < last && cls < HEAP_SMALL_CACHE_CLASSES; cls++) {
+        void *block = cache->head[cls];
+        if (block != NULL) {
+            cache->head[cls] = *(void **)block;
+            cache->count[cls]--;
+            return block;
+        }
+    }
+    return NULL;
+}
+
+/* Keeps a freed block of `block_size` usable bytes in the cache.
+   Returns false if the block is not small enough or its list is full, it must be freed to the heap then. */
+static inline __attribute__((always_inline)) bool heap_small_cache_push(heap_small_cache_t *cache, void *block, size_t block_size, size_t depth)
+{
+    if (block_size < sizeof(void *) || block_size > HEAP_SMALL_CACHE_MAX_SIZE) {
+        return false;
+    }
+    // A block serves the requests up to its size, rounded down to the granule
+    size_t cls = block_size / HEAP_SMALL_CACHE_GRANULE - 1;
+    if (cache->count[cls] >= depth) {
+        return false;
+    }
+    *(void **)block = cache->head[cls];
+    cache->head[cls] = block;
+    cache->count[cls]++;
+    return true;
+}
+
+/* Removes all blocks from the cache, returns the list of them (linked through their first word) */
+static inline __attribute__((always_inline)) void *heap_small_cache_take_all(heap_small_cache_t *cache)
+{
+    void *all = NULL;
+    for (size_t cls = 0; cls < HEAP_SMALL_CACHE_CLASSES; cls++) {
+        while (cache->head[cls] != NULL) {
+            void *block = cache->head[cls];
+            cache->head[cls] = *(void **)block;
+            *(void **)block = all;
+            all = block;
+        }
+        cache->count[cls] = 0;
+    }
+    return all;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -461,6 +461,20 @@ size_t heap_caps_get_allocated_size(void *ptr);
  */
 size_t heap_caps_get_containing_block_size(void *ptr);
 
+#if CONFIG_HEAP_SMALL_CACHE
+/**
+ * @brief Free the small blocks cached by the current CPU core.
+ *
+ * With CONFIG_HEAP_SMALL_CACHE, small blocks freed on a core are kept for later allocations
+ * on the same core and still count as allocated memory. This returns the blocks of the calling
+ * core to their heaps, e.g. before measuring the free heap size. To flush the caches of all cores,
+ * call it on each core.
+ *
+ * @return Number of blocks returned to the heaps
+ */
+size_t heap_caps_small_cache_flush(void);
+#endif
+
 /**
  * @brief Structure used to store heap related data passed to
  * the walker callback function
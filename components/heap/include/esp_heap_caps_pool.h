@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pool of fixed-size objects, allocated from memory with given capabilities.
+ *
+ * The memory of all the objects is allocated at once when the pool is created,
+ * so that objects allocated and freed repeatedly do not fragment the heap.
+ * Allocating and freeing an object take constant time.
+ */
+typedef struct heap_caps_pool heap_caps_pool_t;
+
+/**
+ * @brief Structure to return information about a pool, see heap_caps_pool_get_info()
+ */
+typedef struct {
+    size_t obj_size;          ///< Size of an object, as given to heap_caps_pool_create()
+    size_t capacity;          ///< Number of objects in the pool
+    size_t allocated;         ///< Number of objects currently allocated
+    size_t cached;            ///< Number of free objects kept by the per-core caches (CONFIG_HEAP_POOL_PER_CORE_CACHE)
+    size_t peak_allocated;    ///< Maximum number of objects allocated at once since the pool was created
+    size_t total_bytes;       ///< Memory taken from the heap by the objects of the pool
+} heap_caps_pool_info_t;
+
+/**
+ * @brief Create a pool of objects
+ *
+ * The memory of the objects is one block allocated with heap_caps_malloc() with the given capabilities.
+ * It is accounted as allocated memory by heap_caps_get_info() and heap_caps_get_free_size(), whether
+ * the objects are allocated or not. heap_caps_print_heap_info() prints the usage of the pools.
+ *
+ * The objects are aligned to the size of a pointer.
+ *
+ * @param obj_size Size of an object, in bytes
+ * @param count    Number of objects in the pool
+ * @param caps     Bitwise OR of MALLOC_CAP_* flags indicating the type of memory of the objects
+ *
+ * @return The pool, or NULL if the arguments are invalid or there is not enough memory
+ */
+heap_caps_pool_t *heap_caps_pool_create(size_t obj_size, size_t count, uint32_t caps);
+
+/**
+ * @brief Delete a pool and free its memory
+ *
+ * @note Objects still allocated from the pool must not be used anymore.
+ *
+ * @param pool Pool to delete, can be NULL
+ */
+void heap_caps_pool_delete(heap_caps_pool_t *pool);
+
+/**
+ * @brief Allocate an object from a pool
+ *
+ * Can be called from an ISR, like heap_caps_malloc(). With heap tracing enabled,
+ * the allocation is recorded like a heap allocation of the size of an object.
+ *
+ * @param pool Pool to allocate from
+ *
+ * @return The object (its content is undefined), or NULL if all the objects of the pool are allocated
+ */
+void *heap_caps_pool_alloc(heap_caps_pool_t *pool);
+
+/**
+ * @brief Return an object to its pool
+ *
+ * @param pool Pool the object was allocated from
+ * @param ptr  Object returned by heap_caps_pool_alloc(), can be NULL
+ */
+void heap_caps_pool_free(heap_caps_pool_t *pool, void *ptr);
+
+/**
+ * @brief Get the size of the objects of a pool
+ *
+ * @param pool Pool
+ *
+ * @return Size of an object, as given to heap_caps_pool_create()
+ */
+size_t heap_caps_pool_get_obj_size(const heap_caps_pool_t *pool);
+
+/**
+ * @brief Get information about a pool
+ *
+ * @param pool Pool
+ * @param[out] info Information about the pool
+ */
+void heap_caps_pool_get_info(heap_caps_pool_t *pool, heap_caps_pool_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
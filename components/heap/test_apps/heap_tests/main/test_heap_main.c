@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,6 +7,7 @@
 #include "unity.h"
 #include "unity_test_runner.h"
 #include "esp_heap_caps.h"
+#include "esp_ipc.h"
 
 #define TEST_MEMORY_LEAK_THRESHOLD_DEFAULT -300
 static int leak_threshold = TEST_MEMORY_LEAK_THRESHOLD_DEFAULT;
@@ -18,6 +19,25 @@ void set_leak_threshold(int threshold)
 static size_t before_free_8bit;
 static size_t before_free_32bit;
 
+#if CONFIG_HEAP_SMALL_CACHE
+static void small_cache_flush(void *arg)
+{
+    heap_caps_small_cache_flush();
+}
+
+/* Each core has its own cache and heap_caps_small_cache_flush() only empties the caller's one */
+static void small_cache_flush_all_cores(void)
+{
+#if !CONFIG_FREERTOS_UNICORE
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        esp_ipc_call_blocking(core, small_cache_flush, NULL);
+    }
+#else
+    small_cache_flush(NULL);
+#endif
+}
+#endif
+
 static void check_leak(size_t before_free, size_t after_free, const char *type)
 {
     ssize_t delta = after_free - before_free;
@@ -27,12 +47,19 @@ static void check_leak(size_t before_free, size_t after_free, const char *type)
 
 void setUp(void)
 {
+#if CONFIG_HEAP_SMALL_CACHE
+    // Cached blocks are not free memory
+    small_cache_flush_all_cores();
+#endif
     before_free_8bit = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     before_free_32bit = heap_caps_get_free_size(MALLOC_CAP_32BIT);
 }
 
 void tearDown(void)
 {
+#if CONFIG_HEAP_SMALL_CACHE
+    small_cache_flush_all_cores();
+#endif
     size_t after_free_8bit = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     size_t after_free_32bit = heap_caps_get_free_size(MALLOC_CAP_32BIT);
     check_leak(before_free_8bit, after_free_8bit, "8BIT");
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -20,6 +20,7 @@
 #include "freertos/task.h"
 
 #include "esp_heap_caps.h"
+#include "esp_heap_caps_pool.h"
 
 #ifdef CONFIG_HEAP_TRACING
 // only compile in heap tracing tests if tracing is enabled
@@ -71,6 +72,35 @@ TEST_CASE("heap trace leak check", "[heap-trace]")
     heap_trace_stop();
 }
 
+TEST_CASE("heap trace records pool objects", "[heap-trace]")
+{
+    heap_trace_record_t recs[8];
+    heap_trace_init_standalone(recs, 8);
+
+    // The slab is allocated before the trace starts, it is never recorded anyway
+    heap_caps_pool_t *pool = heap_caps_pool_create(20, 4, MALLOC_CAP_DEFAULT);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    heap_trace_start(HEAP_TRACE_LEAKS);
+
+    void *a = heap_caps_pool_alloc(pool);
+    void *b = heap_caps_pool_alloc(pool);
+    TEST_ASSERT_EQUAL(2, heap_trace_get_count());
+
+    heap_trace_record_t trace_a;
+    heap_trace_get(0, &trace_a);
+    TEST_ASSERT_EQUAL_PTR(a, trace_a.address);
+    TEST_ASSERT_EQUAL(20, trace_a.size);
+
+    heap_caps_pool_free(pool, a);
+    TEST_ASSERT_EQUAL(1, heap_trace_get_count());
+    heap_caps_pool_free(pool, b);
+    TEST_ASSERT_EQUAL(0, heap_trace_get_count());
+
+    heap_trace_stop();
+    heap_caps_pool_delete(pool);
+}
+
 TEST_CASE("heap trace wrapped buffer check", "[heap-trace]")
 {
     const size_t N = 8;
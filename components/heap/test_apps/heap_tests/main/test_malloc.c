@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -290,3 +290,44 @@ TEST_CASE("test allocation and free function hooks", "[heap]")
     TEST_ASSERT_TRUE(test_success);
 }
 #endif
+
+#if CONFIG_HEAP_SMALL_CACHE
+TEST_CASE("small blocks freed on a core are reused by the next allocations", "[heap][small_cache]")
+{
+    heap_caps_small_cache_flush();
+    const size_t free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    void *ptr = heap_caps_malloc(40, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(ptr);
+    heap_caps_free(ptr);
+    // The block is kept by the cache, still allocated in the heap
+    TEST_ASSERT_LESS_THAN(free_before, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    TEST_ASSERT_EQUAL_PTR(ptr, malloc(37));
+    free(ptr);
+
+    // Capabilities the cache cannot guarantee always go to the heaps
+    void *dma = heap_caps_malloc(37, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(dma);
+    TEST_ASSERT_NOT_EQUAL(ptr, dma);
+    heap_caps_free(dma);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(1, heap_caps_small_cache_flush());
+    TEST_ASSERT_EQUAL(0, heap_caps_small_cache_flush());
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+}
+
+TEST_CASE("cached small blocks are freed when an allocation fails", "[heap][small_cache]")
+{
+    void *ptrs[CONFIG_HEAP_SMALL_CACHE_DEPTH];
+    for (int i = 0; i < CONFIG_HEAP_SMALL_CACHE_DEPTH; i++) {
+        ptrs[i] = malloc(16);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    for (int i = 0; i < CONFIG_HEAP_SMALL_CACHE_DEPTH; i++) {
+        free(ptrs[i]);
+    }
+    // Does not fit in the heaps, fails after the cache is flushed
+    TEST_ASSERT_NULL(heap_caps_malloc(heap_caps_get_total_size(MALLOC_CAP_INTERNAL), MALLOC_CAP_INTERNAL));
+    TEST_ASSERT_EQUAL(0, heap_caps_small_cache_flush());
+}
+#endif
@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for the pools of fixed-size objects (esp_heap_caps_pool.h)
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_caps_pool.h"
+#include "esp_memory_utils.h"
+
+#include "sdkconfig.h"
+
+#define POOL_OBJ_SIZE   36
+#define POOL_COUNT      16
+
+TEST_CASE("pool objects are allocated until the pool is exhausted", "[heap][pool]")
+{
+    const size_t free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    heap_caps_pool_t *pool = heap_caps_pool_create(POOL_OBJ_SIZE, POOL_COUNT, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL(POOL_OBJ_SIZE, heap_caps_pool_get_obj_size(pool));
+    // The whole slab is allocated from the heap
+    TEST_ASSERT_LESS_OR_EQUAL(free_before - POOL_OBJ_SIZE * POOL_COUNT, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    const size_t free_with_pool = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    void *objs[POOL_COUNT];
+    for (int i = 0; i < POOL_COUNT; i++) {
+        objs[i] = heap_caps_pool_alloc(pool);
+        TEST_ASSERT_NOT_NULL(objs[i]);
+        TEST_ASSERT_EQUAL(0, (intptr_t)objs[i] % sizeof(void *));
+        memset(objs[i], i, POOL_OBJ_SIZE);
+    }
+    TEST_ASSERT_NULL(heap_caps_pool_alloc(pool));
+    // Allocating objects does not change the heap
+    TEST_ASSERT_EQUAL(free_with_pool, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+
+    heap_caps_pool_info_t info;
+    heap_caps_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(POOL_OBJ_SIZE, info.obj_size);
+    TEST_ASSERT_EQUAL(POOL_COUNT, info.capacity);
+    TEST_ASSERT_EQUAL(POOL_COUNT, info.allocated);
+    TEST_ASSERT_EQUAL(POOL_COUNT, info.peak_allocated);
+    TEST_ASSERT_GREATER_OR_EQUAL(POOL_OBJ_SIZE * POOL_COUNT, info.total_bytes);
+
+    for (int i = 0; i < POOL_COUNT; i++) {
+        TEST_ASSERT_EACH_EQUAL_UINT8(i, objs[i], POOL_OBJ_SIZE);
+        heap_caps_pool_free(pool, objs[i]);
+    }
+    heap_caps_pool_free(pool, NULL);
+    heap_caps_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(0, info.allocated);
+    TEST_ASSERT_EQUAL(POOL_COUNT, info.peak_allocated);
+
+    // Freed objects are allocated again
+    void *obj = heap_caps_pool_alloc(pool);
+    bool reused = false;
+    for (int i = 0; i < POOL_COUNT; i++) {
+        reused |= (obj == objs[i]);
+    }
+    TEST_ASSERT_TRUE(reused);
+    heap_caps_pool_free(pool, obj);
+
+    heap_caps_pool_delete(pool);
+#if CONFIG_HEAP_SMALL_CACHE
+    // The pool structure is small enough to be kept by the cache
+    heap_caps_small_cache_flush();
+#endif
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+}
+
+TEST_CASE("pool creation fails with invalid arguments", "[heap][pool]")
+{
+    TEST_ASSERT_NULL(heap_caps_pool_create(0, POOL_COUNT, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_caps_pool_create(POOL_OBJ_SIZE, 0, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_caps_pool_create(SIZE_MAX, 2, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_caps_pool_create(SIZE_MAX / 2, 4, MALLOC_CAP_8BIT));
+    // More memory than available
+    TEST_ASSERT_NULL(heap_caps_pool_create(1024, heap_caps_get_total_size(MALLOC_CAP_INTERNAL) / 1024 + 1,
+                                           MALLOC_CAP_INTERNAL));
+    heap_caps_pool_delete(NULL);
+}
+
+TEST_CASE("pool objects have the capabilities of the pool", "[heap][pool]")
+{
+    heap_caps_pool_t *pool = heap_caps_pool_create(POOL_OBJ_SIZE, POOL_COUNT, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(pool);
+    void *obj = heap_caps_pool_alloc(pool);
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_TRUE(esp_ptr_dma_capable(obj));
+    heap_caps_pool_free(pool, obj);
+    heap_caps_pool_delete(pool);
+}
+
+#define POOL_STRESS_ITERATIONS  10000
+
+typedef struct {
+    heap_caps_pool_t *pool;
+    SemaphoreHandle_t done;
+    bool failed;
+} pool_stress_arg_t;
+
+static void pool_stress_task(void *arg)
+{
+    pool_stress_arg_t *stress = (pool_stress_arg_t *)arg;
+    void *objs[4];
+    for (int i = 0; i < POOL_STRESS_ITERATIONS; i++) {
+        for (int j = 0; j < 4; j++) {
+            objs[j] = heap_caps_pool_alloc(stress->pool);
+            if (objs[j] == NULL) {
+                stress->failed = true;
+                continue;
+            }
+            memset(objs[j], j, POOL_OBJ_SIZE);
+        }
+        for (int j = 0; j < 4; j++) {
+            heap_caps_pool_free(stress->pool, objs[j]);
+        }
+    }
+    xSemaphoreGive(stress->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("pool objects are allocated and freed from all the cores", "[heap][pool]")
+{
+    // Enough objects for the tasks, and for the per-core caches of the other cores
+    const size_t count = portNUM_PROCESSORS * (4 + CONFIG_HEAP_POOL_PER_CORE_CACHE);
+    pool_stress_arg_t stress[portNUM_PROCESSORS] = { 0 };
+    heap_caps_pool_t *pool = heap_caps_pool_create(POOL_OBJ_SIZE, count, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stress[core].pool = pool;
+        stress[core].done = xSemaphoreCreateBinary();
+        TEST_ASSERT_NOT_NULL(stress[core].done);
+        xTaskCreatePinnedToCore(pool_stress_task, "pool_stress", 2048, &stress[core], uxTaskPriorityGet(NULL) + 1, NULL, core);
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        xSemaphoreTake(stress[core].done, portMAX_DELAY);
+        vSemaphoreDelete(stress[core].done);
+        TEST_ASSERT_FALSE(stress[core].failed);
+    }
+
+    heap_caps_pool_info_t info;
+    heap_caps_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(0, info.allocated);
+    TEST_ASSERT_LESS_OR_EQUAL(portNUM_PROCESSORS * CONFIG_HEAP_POOL_PER_CORE_CACHE, info.cached);
+    heap_caps_pool_delete(pool);
+}
@@ -94,3 +94,17 @@ def test_heap_trace_dump(dut: Dut) -> None:
 @idf_parametrize('target', ['supported_targets'], indirect=['target'])
 def test_memory_protection(dut: Dut) -> None:
     dut.run_all_single_board_cases(group='heap&mem_prot', timeout=300)
+
+
+@pytest.mark.generic
+@pytest.mark.parametrize('config', ['small_cache'])
+@idf_parametrize('target', ['supported_targets'], indirect=['target'])
+def test_heap_small_cache(dut: Dut) -> None:
+    dut.run_all_single_board_cases(group='small_cache')
+
+
+@pytest.mark.generic
+@pytest.mark.parametrize('config', ['pool_cache'])
+@idf_parametrize('target', ['supported_targets'], indirect=['target'])
+def test_heap_pool_cache(dut: Dut) -> None:
+    dut.run_all_single_board_cases(group='pool')
@@ -0,0 +1,248 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "catch.hpp"
+#include "multi_heap.h"
+
+#include "../heap_pool_slab.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+/* The object storage of heap_caps_pool_t (heap_caps_pool.c), with the slabs allocated from a multi_heap. */
+
+namespace {
+
+struct Slab {
+    multi_heap_handle_t heap;
+    heap_pool_slab_t slab;
+
+    Slab(multi_heap_handle_t heap, size_t obj_size, size_t count) : heap(heap)
+    {
+        size_t stride = heap_pool_slab_stride(obj_size);
+        void *memory = multi_heap_malloc(heap, stride * count);
+        REQUIRE(memory != NULL);
+        heap_pool_slab_init(&slab, memory, stride, count);
+    }
+
+    ~Slab()
+    {
+        multi_heap_free(heap, slab.start);
+    }
+};
+
+uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+} // namespace
+
+TEST_CASE("pool slab stride holds a pointer and keeps it aligned", "[multi_heap][pool]")
+{
+    REQUIRE(heap_pool_slab_stride(1) == sizeof(void *));
+    REQUIRE(heap_pool_slab_stride(sizeof(void *)) == sizeof(void *));
+    REQUIRE(heap_pool_slab_stride(sizeof(void *) + 1) == 2 * sizeof(void *));
+    REQUIRE(heap_pool_slab_stride(40) == 40);
+}
+
+TEST_CASE("pool slab allocates every object once, then reuses freed objects", "[multi_heap][pool]")
+{
+    uint8_t memory[4096];
+    multi_heap_handle_t heap = multi_heap_register(memory, sizeof(memory));
+    REQUIRE(heap != NULL);
+    const size_t initial_free = multi_heap_free_size(heap);
+    {
+        Slab s(heap, 20, 10);
+        const size_t stride = heap_pool_slab_stride(20);
+
+        // Objects never allocated are taken in order from the start of the slab
+        void *p[10];
+        for (int i = 0; i < 10; i++) {
+            p[i] = heap_pool_slab_alloc(&s.slab);
+            REQUIRE(p[i] == s.slab.start + i * stride);
+            memset(p[i], 0xA5, 20);
+        }
+        REQUIRE(heap_pool_slab_alloc(&s.slab) == NULL);
+        REQUIRE(s.slab.used == 10);
+
+        // Most recently freed first
+        heap_pool_slab_free(&s.slab, p[3]);
+        heap_pool_slab_free(&s.slab, p[7]);
+        REQUIRE(s.slab.used == 8);
+        REQUIRE(heap_pool_slab_alloc(&s.slab) == p[7]);
+        REQUIRE(heap_pool_slab_alloc(&s.slab) == p[3]);
+        REQUIRE(heap_pool_slab_alloc(&s.slab) == NULL);
+
+        for (int i = 0; i < 10; i++) {
+            heap_pool_slab_free(&s.slab, p[i]);
+        }
+        REQUIRE(s.slab.used == 0);
+        REQUIRE(s.slab.peak == 10);
+        REQUIRE(multi_heap_check(heap, true));
+    }
+    REQUIRE(multi_heap_free_size(heap) == initial_free);
+}
+
+TEST_CASE("pool slab only contains the objects it allocated", "[multi_heap][pool]")
+{
+    uint8_t memory[4096];
+    multi_heap_handle_t heap = multi_heap_register(memory, sizeof(memory));
+    REQUIRE(heap != NULL);
+    Slab s(heap, 24, 8);
+
+    void *a = heap_pool_slab_alloc(&s.slab);
+    void *b = heap_pool_slab_alloc(&s.slab);
+    REQUIRE(heap_pool_slab_contains(&s.slab, a));
+    REQUIRE(heap_pool_slab_contains(&s.slab, b));
+    REQUIRE_FALSE(heap_pool_slab_contains(&s.slab, (uint8_t *)a + 1));
+    REQUIRE_FALSE(heap_pool_slab_contains(&s.slab, (uint8_t *)b + s.slab.stride));
+    REQUIRE_FALSE(heap_pool_slab_contains(&s.slab, s.slab.start - s.slab.stride));
+    REQUIRE_FALSE(heap_pool_slab_contains(&s.slab, memory));
+
+    // Freed objects stay part of the slab
+    heap_pool_slab_free(&s.slab, b);
+    REQUIRE(heap_pool_slab_contains(&s.slab, b));
+    REQUIRE(s.slab.peak == 2);
+}
+
+/* Fragmentation benchmark, hidden from the default run: ./test_multi_heap "[bench]" (or make bench).
+
+   Long running workload of a device: fixed-size objects (like outbox items, socket contexts and
+   posted events) allocated and freed continuously, interleaved with buffers of 64 to 2048 bytes.
+   Each step frees or allocates a random one of them, so that their lifetimes are random.
+
+   The fixed-size objects are either allocated from the heap, or from pools whose slabs are
+   allocated from the heap at the start. The buffers are always allocated from the heap.
+   Fragmentation is 1 - largest free block / free size, sampled every 1000 steps: the reported
+   values are the average fragmentation and the smallest largest free block since the start.
+*/
+namespace {
+
+struct ObjectType {
+    size_t size;
+    size_t count;
+};
+
+const ObjectType object_types[] = {
+    { 24, 256 },
+    { 40, 128 },
+    { 72, 96 },
+};
+const int object_type_count = sizeof(object_types) / sizeof(object_types[0]);
+const int buffer_slots = 96;
+const int sample_every = 1000;
+
+struct FragmentationStats {
+    double fragmentation;       // average
+    size_t min_largest_free_block;
+    size_t failed;
+};
+
+FragmentationStats run_fragmentation(multi_heap_handle_t heap, bool pools, int steps, int report_every)
+{
+    Slab *slabs[object_type_count] = {};
+    void **objects[object_type_count];
+    int object_slots = 0;
+    for (int t = 0; t < object_type_count; t++) {
+        if (pools) {
+            slabs[t] = new Slab(heap, object_types[t].size, object_types[t].count);
+        }
+        objects[t] = new void *[object_types[t].count]();
+        object_slots += object_types[t].count;
+    }
+    void *buffers[buffer_slots] = {};
+
+    FragmentationStats stats = {};
+    stats.min_largest_free_block = SIZE_MAX;
+    double fragmentation_sum = 0;
+    uint32_t rnd = 0x2545F491;
+    for (int i = 1; i <= steps; i++) {
+        uint32_t r = xorshift(&rnd);
+        uint32_t slot = r % (object_slots + buffer_slots * 4);
+        if (slot >= (uint32_t)object_slots) {
+            void **b = &buffers[(slot - object_slots) % buffer_slots];
+            if (*b != NULL) {
+                multi_heap_free(heap, *b);
+                *b = NULL;
+            } else {
+                *b = multi_heap_malloc(heap, 64 + (xorshift(&rnd) % (2048 - 64)));
+                stats.failed += (*b == NULL);
+            }
+        } else {
+            int t = 0;
+            while (slot >= object_types[t].count) {
+                slot -= object_types[t].count;
+                t++;
+            }
+            void **o = &objects[t][slot];
+            if (*o != NULL) {
+                if (pools) {
+                    heap_pool_slab_free(&slabs[t]->slab, *o);
+                } else {
+                    multi_heap_free(heap, *o);
+                }
+                *o = NULL;
+            } else {
+                *o = pools ? heap_pool_slab_alloc(&slabs[t]->slab) : multi_heap_malloc(heap, object_types[t].size);
+                stats.failed += (*o == NULL);
+            }
+        }
+
+        if (i % sample_every == 0) {
+            multi_heap_info_t info;
+            multi_heap_get_info(heap, &info);
+            fragmentation_sum += 1.0 - (double)info.largest_free_block / info.total_free_bytes;
+            stats.fragmentation = fragmentation_sum / (i / sample_every);
+            stats.min_largest_free_block = std::min(stats.min_largest_free_block, info.largest_free_block);
+        }
+        if (i % report_every == 0) {
+            printf("%-11s %10d %14.1f%% %18zu %8zu\n", pools ? "pools" : "multi_heap", i,
+                   100.0 * stats.fragmentation, stats.min_largest_free_block, stats.failed);
+        }
+    }
+
+    for (int b = 0; b < buffer_slots; b++) {
+        multi_heap_free(heap, buffers[b]);
+    }
+    for (int t = 0; t < object_type_count; t++) {
+        if (!pools) {
+            for (size_t o = 0; o < object_types[t].count; o++) {
+                multi_heap_free(heap, objects[t][o]);
+            }
+        }
+        delete slabs[t];
+        delete[] objects[t];
+    }
+    return stats;
+}
+
+} // namespace
+
+TEST_CASE("pool fragmentation benchmark", "[.][bench]")
+{
+    const int steps = 4000000;
+    const size_t heap_size = 128 * 1024;
+    uint8_t *memory = new uint8_t[heap_size];
+    FragmentationStats stats[2];
+
+    printf("%-11s %10s %15s %18s %8s\n", "objects", "step", "fragmentation", "min largest free", "failed");
+    for (int pools = 0; pools < 2; pools++) {
+        multi_heap_handle_t heap = multi_heap_register(memory, heap_size);
+        REQUIRE(heap != NULL);
+        const size_t initial_free = multi_heap_free_size(heap);
+        stats[pools] = run_fragmentation(heap, pools, steps, steps / 8);
+        REQUIRE(multi_heap_free_size(heap) == initial_free);
+    }
+    CHECK(stats[1].fragmentation < stats[0].fragmentation);
+    delete[] memory;
+}
@@ -0,0 +1,241 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "catch.hpp"
+#include "multi_heap.h"
+
+#include "../multi_heap_config.h"
+#include "../heap_small_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+/* The small block cache of heap_caps_base.c (CONFIG_HEAP_SMALL_CACHE), in front of a single multi_heap.
+   Every call into multi_heap counts as a lock acquisition: on the target each of them takes the heap
+   lock (a critical section), on the host the lock is a no-op.
+
+   Like CONFIG_HEAP_SMALL_CACHE, only without poisoning: a cached block may serve a larger request
+   than the one it was allocated for, over the tail canary.
+*/
+#ifndef MULTI_HEAP_POISONING
+
+namespace {
+
+struct CachedHeap {
+    multi_heap_handle_t heap;
+    heap_small_cache_t cache;
+    size_t depth;
+    bool enabled;
+    size_t heap_calls = 0;
+    size_t hits = 0;
+
+    CachedHeap(void *memory, size_t size, size_t depth, bool enabled)
+        : heap(multi_heap_register(memory, size)), depth(depth), enabled(enabled)
+    {
+        memset(&cache, 0, sizeof(cache));
+        REQUIRE(heap != NULL);
+    }
+
+    void *alloc(size_t size)
+    {
+        if (enabled) {
+            void *p = heap_small_cache_pop(&cache, size);
+            if (p != NULL) {
+                hits++;
+                return p;
+            }
+        }
+        heap_calls++;
+        void *p = multi_heap_malloc(heap, size);
+        if (p == NULL && enabled) {
+            flush();
+            heap_calls++;
+            p = multi_heap_malloc(heap, size);
+        }
+        return p;
+    }
+
+    void free(void *p)
+    {
+        // Reading the size of an allocated block does not take the lock
+        if (enabled && heap_small_cache_push(&cache, p, multi_heap_get_allocated_size(heap, p), depth)) {
+            return;
+        }
+        heap_calls++;
+        multi_heap_free(heap, p);
+    }
+
+    size_t flush()
+    {
+        size_t count = 0;
+        void *block = heap_small_cache_take_all(&cache);
+        while (block != NULL) {
+            void *next = *(void **)block;
+            heap_calls++;
+            multi_heap_free(heap, block);
+            block = next;
+            count++;
+        }
+        return count;
+    }
+};
+
+uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+} // namespace
+
+TEST_CASE("small cache reuses freed blocks of the same size class", "[multi_heap][small_cache]")
+{
+    uint8_t memory[4096];
+    CachedHeap h(memory, sizeof(memory), 4, true);
+    const size_t initial_free = multi_heap_free_size(h.heap);
+
+    void *p[10];
+    for (int i = 0; i < 10; i++) {
+        p[i] = h.alloc(24);
+        REQUIRE(p[i] != NULL);
+    }
+    REQUIRE(h.heap_calls == 10);
+    for (int i = 0; i < 10; i++) {
+        h.free(p[i]);
+    }
+    // Only `depth` blocks of a size class are kept, the other ones are freed
+    REQUIRE(h.heap_calls == 16);
+    REQUIRE(h.cache.count[24 / HEAP_SMALL_CACHE_GRANULE - 1] == 4);
+    REQUIRE(multi_heap_free_size(h.heap) < initial_free);
+
+    // Most recently freed first, smaller requests are served by the next classes
+    REQUIRE(h.alloc(24) == p[3]);
+    REQUIRE(h.alloc(21) == p[2]);
+    REQUIRE(h.alloc(17) == p[1]);
+    REQUIRE(h.heap_calls == 16);
+    REQUIRE(h.hits == 3);
+    // A larger request is not served from a smaller class
+    void *larger = h.alloc(32);
+    REQUIRE(larger != NULL);
+    REQUIRE(larger != p[0]);
+    REQUIRE(h.heap_calls == 17);
+
+    h.free(larger);
+    h.free(p[1]);
+    h.free(p[2]);
+    h.free(p[3]);
+    REQUIRE(h.flush() == 5);
+    REQUIRE(multi_heap_free_size(h.heap) == initial_free);
+    REQUIRE(heap_small_cache_pop(&h.cache, 24) == NULL);
+    REQUIRE(multi_heap_check(h.heap, true));
+}
+
+TEST_CASE("small cache ignores blocks and requests above the maximum size", "[multi_heap][small_cache]")
+{
+    uint8_t memory[4096];
+    CachedHeap h(memory, sizeof(memory), 8, true);
+
+    void *big = h.alloc(HEAP_SMALL_CACHE_MAX_SIZE + 1);
+    REQUIRE(big != NULL);
+    REQUIRE(multi_heap_get_allocated_size(h.heap, big) > HEAP_SMALL_CACHE_MAX_SIZE);
+    REQUIRE_FALSE(heap_small_cache_push(&h.cache, big, multi_heap_get_allocated_size(h.heap, big), 8));
+    multi_heap_free(h.heap, big);
+
+    REQUIRE(heap_small_cache_pop(&h.cache, 0) == NULL);
+    REQUIRE(heap_small_cache_pop(&h.cache, HEAP_SMALL_CACHE_MAX_SIZE + 1) == NULL);
+
+    void *largest = h.alloc(HEAP_SMALL_CACHE_MAX_SIZE);
+    h.free(largest);
+    REQUIRE(h.cache.count[HEAP_SMALL_CACHE_CLASSES - 1] == 1);
+    REQUIRE(h.alloc(HEAP_SMALL_CACHE_MAX_SIZE) == largest);
+    h.free(largest);
+    REQUIRE(h.flush() == 1);
+}
+
+TEST_CASE("small cache is flushed when the heap is exhausted", "[multi_heap][small_cache]")
+{
+    uint8_t memory[2048];
+    CachedHeap h(memory, sizeof(memory), 32, true);
+    const size_t initial_free = multi_heap_free_size(h.heap);
+
+    void *p[256];
+    size_t n = 0;
+    while (n < 256 && (p[n] = h.alloc(16)) != NULL) {
+        n++;
+    }
+    REQUIRE(n > 32);
+    // The heap has a minimum block size
+    const size_t cls = multi_heap_get_allocated_size(h.heap, p[0]) / HEAP_SMALL_CACHE_GRANULE - 1;
+    for (size_t i = 0; i < n; i++) {
+        h.free(p[i]);
+    }
+    REQUIRE(h.cache.count[cls] == 32);
+
+    // Only available once the cached blocks are back in the heap
+    void *large = h.alloc(multi_heap_free_size(h.heap) + 64);
+    REQUIRE(large != NULL);
+    REQUIRE(h.cache.count[cls] == 0);
+    h.free(large);
+    REQUIRE(multi_heap_free_size(h.heap) == initial_free);
+}
+
+/* Benchmark, hidden from the default run: ./test_multi_heap "[bench]" (or make bench).
+
+   Keeps a set of live blocks and replaces a random one at every step: mostly small
+   blocks (1 to 64 bytes), some larger ones which always go to the heap.
+*/
+static void run_workload(CachedHeap &h, int steps)
+{
+    const int slots = 256;
+    void *live[slots] = {};
+    uint32_t rnd = 0x12345678;
+    for (int i = 0; i < steps; i++) {
+        int slot = xorshift(&rnd) % slots;
+        if (live[slot] != NULL) {
+            h.free(live[slot]);
+        }
+        uint32_t r = xorshift(&rnd);
+        size_t size = (r % 10 == 0) ? 65 + (r >> 8) % 448 : 1 + (r >> 8) % HEAP_SMALL_CACHE_MAX_SIZE;
+        live[slot] = h.alloc(size);
+        REQUIRE(live[slot] != NULL);
+    }
+    for (int slot = 0; slot < slots; slot++) {
+        if (live[slot] != NULL) {
+            h.free(live[slot]);
+        }
+    }
+    h.flush();
+}
+
+TEST_CASE("small cache benchmark", "[.][bench]")
+{
+    const int steps = 2000000;
+    const size_t heap_size = 128 * 1024;
+    uint8_t *memory = new uint8_t[heap_size];
+    size_t calls[2];
+
+    printf("%-14s %12s %14s %16s %10s\n", "path", "allocs/s", "heap calls", "calls per alloc", "hit rate");
+    for (int cached = 0; cached < 2; cached++) {
+        CachedHeap h(memory, heap_size, 8, cached);
+        const size_t initial_free = multi_heap_free_size(h.heap);
+        auto start = std::chrono::steady_clock::now();
+        run_workload(h, steps);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(multi_heap_free_size(h.heap) == initial_free);
+
+        calls[cached] = h.heap_calls;
+        printf("%-14s %12.0f %14zu %16.2f %9.1f%%\n", cached ? "small cache" : "multi_heap",
+               steps / elapsed.count(), h.heap_calls, (double) h.heap_calls / steps, 100.0 * h.hits / steps);
+    }
+    CHECK(calls[1] < calls[0]);
+    delete[] memory;
+}
+
+#endif // MULTI_HEAP_POISONING
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Decoding throughput of binlog.hpp.
+ *
+ * The records are encoded here the way log_format_binary.c encodes them on a
+ * chip (4-byte pointers to format strings and tags in flash), packed into
+ * frames of the binary log sink, then decoded from memory. The format strings
+ * live in a synthetic section, so no ELF file is needed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "binlog.hpp"
+
+namespace {
+
+constexpr uint64_t RODATA = 0x3F400000;
+constexpr size_t FRAME_SIZE = 512;
+
+struct Encoder {
+    std::vector<uint8_t> frames;
+    std::vector<uint8_t> payload;
+    uint16_t first = binlog::FRAME_NO_START;
+    uint32_t seq = 0;
+
+    void put_be(std::vector<uint8_t> &pkt, uint64_t v, unsigned size)
+    {
+        for (unsigned i = size; i-- > 0;) {
+            pkt.push_back(uint8_t(v >> (i * 8)));
+        }
+    }
+
+    void record(uint8_t level, uint32_t format, uint32_t tag, uint32_t timestamp, const std::vector<uint32_t> &args)
+    {
+        std::vector<uint8_t> pkt(3);
+        put_be(pkt, format, 4);
+        put_be(pkt, tag, 4);
+        put_be(pkt, timestamp, 4);
+        for (uint32_t a : args) {
+            put_be(pkt, a, 4);
+        }
+        size_t len = pkt.size() + 1;
+        pkt[0] = 2;
+        uint16_t control = uint16_t(len | (level << 10) | (2 << 14));
+        pkt[1] = uint8_t(control >> 8);
+        pkt[2] = uint8_t(control);
+        pkt.push_back(binlog::Crc8::update(0, pkt.data(), pkt.size()));
+        if (first == binlog::FRAME_NO_START) {
+            first = uint16_t(payload.size());
+        }
+        for (uint8_t b : pkt) {
+            payload.push_back(b);
+            if (payload.size() == FRAME_SIZE - binlog::FRAME_HEADER_SIZE) {
+                close();
+            }
+        }
+    }
+
+    void close()
+    {
+        uint8_t header[binlog::FRAME_HEADER_SIZE];
+        uint16_t len = uint16_t(payload.size());
+        std::memcpy(header, &binlog::FRAME_MAGIC, 4);
+        std::memcpy(header + 4, &seq, 4);
+        std::memcpy(header + 8, &len, 2);
+        std::memcpy(header + 10, &first, 2);
+        uint32_t crc = binlog::Crc32::update(binlog::Crc32::update(0, header, 12), payload.data(), payload.size());
+        std::memcpy(header + 12, &crc, 4);
+        frames.insert(frames.end(), header, header + sizeof(header));
+        frames.insert(frames.end(), payload.begin(), payload.end());
+        frames.resize(frames.size() + FRAME_SIZE - binlog::FRAME_HEADER_SIZE - payload.size(), 0);
+        payload.clear();
+        first = binlog::FRAME_NO_START;
+        seq++;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2000000;
+    const char *strings[] = {
+        "wifi", "main", "mqtt",
+        "connected to %s, channel %d, rssi %d",
+        "heap free %u, largest block %u",
+        "task %s started",
+        "state changed",
+        "value 0x%08x, count %d",
+    };
+    std::vector<uint8_t> rodata;
+    std::vector<uint32_t> addr;
+    for (const char *s : strings) {
+        addr.push_back(uint32_t(RODATA + rodata.size()));
+        rodata.insert(rodata.end(), s, s + std::strlen(s) + 1);
+    }
+    binlog::Elf elf;
+    elf.add_section(RODATA, rodata);
+
+    Encoder enc;
+    for (size_t i = 0; i < records; i++) {
+        uint32_t ts = uint32_t(i);
+        switch (i % 5) {
+        case 0:
+            enc.record(3, addr[3], addr[0], ts, {addr[2], uint32_t(i % 13), uint32_t(-40 - int(i % 50))});
+            break;
+        case 1:
+            enc.record(4, addr[4], addr[1], ts, {uint32_t(200000 - i % 1000), 65536});
+            break;
+        case 2:
+            enc.record(3, addr[5], addr[1], ts, {addr[0]});
+            break;
+        case 3:
+            enc.record(2, addr[6], addr[2], ts, {});
+            break;
+        default:
+            enc.record(5, addr[7], addr[2], ts, {uint32_t(i * 2654435761u), uint32_t(i)});
+            break;
+        }
+    }
+    enc.close();
+
+    binlog::Decoder decoder(4);
+    decoder.set_elf(2, &elf);
+    size_t bytes_out = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < enc.frames.size(); offset += FRAME_SIZE) {
+        decoder.feed_frame(enc.frames.data() + offset, FRAME_SIZE);
+        if (decoder.output().size() > (1 << 20)) {
+            bytes_out += decoder.output().size();
+            decoder.output().clear();
+        }
+    }
+    bytes_out += decoder.output().size();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const binlog::Decoder::Stats &s = decoder.stats();
+    std::printf("records: %llu of %zu, frames: %llu, bad packets: %llu\n",
+                (unsigned long long) s.records, records, (unsigned long long) s.frames, (unsigned long long) s.bad_packets);
+    std::printf("decoded in %.3f s: %.2f M records/s, %.1f MB/s of frames, %.1f MB/s of text\n",
+                seconds, s.records / seconds / 1e6, enc.frames.size() / seconds / 1e6, bytes_out / seconds / 1e6);
+    return s.records == records ? 0 : 1;
+}
@@ -0,0 +1,827 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host-side decoder of the ESP-IDF binary log (CONFIG_LOG_MODE_BINARY).
+ *
+ * Packets are read either as a raw stream (console output) or from the frames
+ * of the binary log sink (CONFIG_LOG_BINARY_SINK). Format strings, tags and
+ * buffers passed by address are resolved from the ELF files, one per
+ * application type (1 - bootloader, 2 - application). Parsed format strings
+ * are cached by address, so decoding a record does not search the ELF again.
+ *
+ * Packet layout, all fields big-endian:
+ *   [0]       application type
+ *   [1, 2]    pkg_len:10 (whole packet), level:3, time_64bits:1, version:2
+ *   pointer   format, then tag: address, or an embedded string
+ *   [4 | 8]   timestamp
+ *   args      32-bit, 64-bit or pointer, by the conversions of the format
+ *   [1]       CRC8 (poly 0x07) of all bytes before it
+ *
+ * An embedded string starts with int16 (1 - len), then max(len, 2) bytes.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace binlog {
+
+constexpr uint32_t FRAME_MAGIC = 0x46424C45;   // "ELBF", esp_log_binary_sink.h
+constexpr uint16_t FRAME_NO_START = 0xFFFF;
+constexpr size_t FRAME_HEADER_SIZE = 16;
+
+/* CRC32 as computed by esp_rom_crc32_le(0, ...), slicing by 8 */
+class Crc32 {
+public:
+    static uint32_t update(uint32_t crc, const uint8_t *data, size_t len)
+    {
+        static const Tables t;
+        crc = ~crc;
+        while (len >= 8) {
+            uint32_t lo = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24);
+            uint32_t hi = uint32_t(data[4]) | uint32_t(data[5]) << 8 | uint32_t(data[6]) << 16 | uint32_t(data[7]) << 24;
+            crc = t.t[7][lo & 0xFF] ^ t.t[6][(lo >> 8) & 0xFF] ^ t.t[5][(lo >> 16) & 0xFF] ^ t.t[4][lo >> 24] ^
+                  t.t[3][hi & 0xFF] ^ t.t[2][(hi >> 8) & 0xFF] ^ t.t[1][(hi >> 16) & 0xFF] ^ t.t[0][hi >> 24];
+            data += 8;
+            len -= 8;
+        }
+        while (len--) {
+            crc = t.t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+private:
+    struct Tables {
+        uint32_t t[8][256];
+        Tables()
+        {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+                }
+                t[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; i++) {
+                for (int s = 1; s < 8; s++) {
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+};
+
+/* CRC8 of a packet, as computed by log_format_binary.c */
+class Crc8 {
+public:
+    static uint8_t update(uint8_t crc, const uint8_t *data, size_t len)
+    {
+        static const Table t;
+        while (len--) {
+            crc = t.t[crc ^ *data++];
+        }
+        return crc;
+    }
+
+private:
+    struct Table {
+        uint8_t t[256];
+        Table()
+        {
+            for (int i = 0; i < 256; i++) {
+                uint8_t c = uint8_t(i);
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 0x80) ? uint8_t((c << 1) ^ 0x07) : uint8_t(c << 1);
+                }
+                t[i] = c;
+            }
+        }
+    };
+};
+
+/* Loaded sections of an ELF file, by address */
+class Elf {
+public:
+    bool load(const std::string &path, std::string &error)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        image_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        const uint8_t *p = image_.data();
+        if (image_.size() < 52 || std::memcmp(p, "\x7f" "ELF", 4) != 0 || p[5] != 1) {
+            error = path + " is not a little-endian ELF file";
+            return false;
+        }
+        bool elf64 = p[4] == 2;
+        pointer_size_ = elf64 ? 8 : 4;
+        uint64_t shoff = elf64 ? get<uint64_t>(0x28) : get<uint32_t>(0x20);
+        uint16_t shentsize = get<uint16_t>(elf64 ? 0x3A : 0x2E);
+        uint16_t shnum = get<uint16_t>(elf64 ? 0x3C : 0x30);
+        for (uint16_t i = 0; i < shnum; i++) {
+            uint64_t sh = shoff + uint64_t(i) * shentsize;
+            if (sh + shentsize > image_.size()) {
+                error = path + ": section header out of the file";
+                return false;
+            }
+            uint32_t type = get<uint32_t>(sh + 4);
+            uint64_t addr = elf64 ? get<uint64_t>(sh + 0x10) : get<uint32_t>(sh + 0x0C);
+            uint64_t offset = elf64 ? get<uint64_t>(sh + 0x18) : get<uint32_t>(sh + 0x10);
+            uint64_t size = elf64 ? get<uint64_t>(sh + 0x20) : get<uint32_t>(sh + 0x14);
+            const uint32_t SHT_NULL = 0, SHT_NOBITS = 8;
+            if (type == SHT_NULL || type == SHT_NOBITS || size == 0 || offset + size > image_.size()) {
+                continue;
+            }
+            // The NOLOAD section of binary log formats is linked at address 0
+            if (addr == 0 && !is_named(sh, ".flash.rodata_noload", elf64)) {
+                continue;
+            }
+            sections_.push_back({addr, size, image_.data() + offset});
+        }
+        sort_sections();
+        return true;
+    }
+
+    /* Adds a section from memory, for tests without an ELF file */
+    void add_section(uint64_t addr, std::vector<uint8_t> data)
+    {
+        owned_.push_back(std::make_unique<std::vector<uint8_t>>(std::move(data)));
+        sections_.push_back({addr, owned_.back()->size(), owned_.back()->data()});
+        sort_sections();
+    }
+
+    /* Returns `len` bytes at `addr`, or nullptr if they are not in one section */
+    const uint8_t *bytes_at(uint64_t addr, size_t len) const
+    {
+        size_t avail;
+        const uint8_t *p = find(addr, avail);
+        return (p != nullptr && avail >= len) ? p : nullptr;
+    }
+
+    /* Returns the zero-terminated string at `addr`, cut at the end of its section */
+    bool string_at(uint64_t addr, std::string_view &out) const
+    {
+        size_t avail;
+        const uint8_t *p = find(addr, avail);
+        if (p == nullptr) {
+            return false;
+        }
+        const void *nul = std::memchr(p, 0, avail);
+        out = std::string_view(reinterpret_cast<const char *>(p), nul ? size_t(static_cast<const uint8_t *>(nul) - p) : avail);
+        return true;
+    }
+
+    unsigned pointer_size() const
+    {
+        return pointer_size_;
+    }
+
+private:
+    struct Section {
+        uint64_t addr;
+        uint64_t size;
+        const uint8_t *data;
+    };
+
+    const uint8_t *find(uint64_t addr, size_t &avail) const
+    {
+        auto it = std::upper_bound(sections_.begin(), sections_.end(), addr, [](uint64_t a, const Section & s) {
+            return a < s.addr;
+        });
+        if (it == sections_.begin()) {
+            return nullptr;
+        }
+        --it;
+        if (addr - it->addr >= it->size) {
+            return nullptr;
+        }
+        avail = size_t(it->size - (addr - it->addr));
+        return it->data + (addr - it->addr);
+    }
+
+    template <typename T> T get(uint64_t offset) const
+    {
+        T v = 0;
+        if (offset + sizeof(T) <= image_.size()) {
+            std::memcpy(&v, image_.data() + offset, sizeof(T));
+        }
+        return v;
+    }
+
+    bool is_named(uint64_t sh, const char *name, bool elf64) const
+    {
+        uint16_t shstrndx = get<uint16_t>(elf64 ? 0x3E : 0x32);
+        uint64_t shoff = elf64 ? get<uint64_t>(0x28) : get<uint32_t>(0x20);
+        uint16_t shentsize = get<uint16_t>(elf64 ? 0x3A : 0x2E);
+        uint64_t strtab = shoff + uint64_t(shstrndx) * shentsize;
+        uint64_t strings = elf64 ? get<uint64_t>(strtab + 0x18) : get<uint32_t>(strtab + 0x10);
+        uint64_t at = strings + get<uint32_t>(sh);
+        size_t len = std::strlen(name);
+        return at + len < image_.size() && std::memcmp(image_.data() + at, name, len + 1) == 0;
+    }
+
+    void sort_sections()
+    {
+        std::sort(sections_.begin(), sections_.end(), [](const Section & a, const Section & b) {
+            return a.addr < b.addr;
+        });
+    }
+
+    std::vector<uint8_t> image_;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> owned_;
+    std::vector<Section> sections_;
+    unsigned pointer_size_ = 4;
+};
+
+/* A format string split into literal text and conversions */
+struct Format {
+    enum class Kind { TEXT, BUFFER_HEX, BUFFER_CHAR, BUFFER_HEXDUMP };
+    enum class Arg : uint8_t { NONE, U32, U64, POINTER };
+
+    struct Piece {
+        std::string literal;    // text before the conversion
+        Arg arg = Arg::NONE;    // NONE for the trailing text
+        char conv = 0;
+        bool plain = true;      // no flags, width or precision
+        std::string spec;       // printf spec without the length modifier, if not plain
+    };
+
+    Kind kind = Kind::TEXT;
+    std::vector<Piece> pieces;
+
+    explicit Format(std::string_view fmt)
+    {
+        if (fmt.rfind("__ESP_BUFFER_HEX_FORMAT__", 0) == 0) {
+            kind = Kind::BUFFER_HEX;
+        } else if (fmt.rfind("__ESP_BUFFER_CHAR_FORMAT__", 0) == 0) {
+            kind = Kind::BUFFER_CHAR;
+        } else if (fmt.rfind("__ESP_BUFFER_HEXDUMP_FORMAT__", 0) == 0) {
+            kind = Kind::BUFFER_HEXDUMP;
+        }
+        Piece piece;
+        size_t i = 0;
+        while (i < fmt.size()) {
+            char c = fmt[i++];
+            if (c != '%') {
+                piece.literal += c;
+                continue;
+            }
+            if (i < fmt.size() && fmt[i] == '%') {
+                piece.literal += '%';
+                i++;
+                continue;
+            }
+            size_t spec_start = i - 1;
+            while (i < fmt.size() && std::strchr("-+ #0123456789.", fmt[i]) != nullptr) {
+                i++;
+            }
+            std::string spec(fmt.substr(spec_start, i - spec_start));
+            int longs = 0;
+            while (i < fmt.size() && std::strchr("lhzjtL", fmt[i]) != nullptr) {
+                longs += fmt[i] == 'l';
+                i++;
+            }
+            if (i >= fmt.size()) {
+                piece.literal += std::string(fmt.substr(spec_start));
+                break;
+            }
+            piece.conv = fmt[i++];
+            switch (piece.conv) {
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                piece.arg = Arg::U64;
+                break;
+            case 's': case 'S':
+                piece.arg = Arg::POINTER;
+                break;
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+                piece.arg = longs >= 2 ? Arg::U64 : Arg::U32;
+                break;
+            default:
+                piece.arg = Arg::U32;
+                break;
+            }
+            piece.plain = spec.size() == 1;
+            piece.spec = spec;
+            pieces.push_back(std::move(piece));
+            piece = Piece();
+        }
+        pieces.push_back(std::move(piece));
+    }
+};
+
+/* Decodes packets into text lines */
+class Decoder {
+public:
+    struct Stats {
+        uint64_t records = 0;       // decoded packets
+        uint64_t bad_packets = 0;   // CRC8 or layout errors, skipped
+        uint64_t frames = 0;        // valid frames
+        uint64_t bad_frames = 0;    // frames with a wrong magic or CRC32
+        uint64_t lost_frames = 0;   // gaps in the sequence numbers
+    };
+
+    /* Pointer size of the target, 4 for the chips, 8 for the Linux target on a 64-bit host */
+    explicit Decoder(unsigned pointer_size = 4) : pointer_size_(pointer_size) {}
+
+    /* Sets the ELF file of an application type, used to resolve addresses */
+    void set_elf(uint8_t app_identifier, const Elf *elf)
+    {
+        elves_[app_identifier & 3] = elf;
+        formats_[app_identifier & 3].clear();
+    }
+
+    /* Decodes a raw stream of packets, a packet may continue in the next call */
+    void feed_packets(const uint8_t *data, size_t size)
+    {
+        stream_.insert(stream_.end(), data, data + size);
+        decode_stream();
+    }
+
+    /* Decodes one frame of the binary log sink, frames must be given in the order of their sequence numbers */
+    void feed_frame(const uint8_t *frame, size_t size)
+    {
+        uint32_t magic, seq, crc;
+        uint16_t len, first;
+        if (size < FRAME_HEADER_SIZE) {
+            stats_.bad_frames++;
+            return;
+        }
+        std::memcpy(&magic, frame, 4);
+        std::memcpy(&seq, frame + 4, 4);
+        std::memcpy(&len, frame + 8, 2);
+        std::memcpy(&first, frame + 10, 2);
+        std::memcpy(&crc, frame + 12, 4);
+        if (magic != FRAME_MAGIC || len > size - FRAME_HEADER_SIZE ||
+                Crc32::update(Crc32::update(0, frame, 12), frame + FRAME_HEADER_SIZE, len) != crc) {
+            stats_.bad_frames++;
+            return;
+        }
+        stats_.frames++;
+        const uint8_t *data = frame + FRAME_HEADER_SIZE;
+        if (!have_seq_ || seq != next_seq_) {
+            if (have_seq_) {
+                stats_.lost_frames += uint32_t(seq - next_seq_);
+            }
+            // The packet continuing from a lost frame cannot be decoded, start at the next one
+            stream_.clear();
+            stream_pos_ = 0;
+            if (first == FRAME_NO_START || first > len) {
+                len = 0;
+            } else {
+                data += first;
+                len -= first;
+            }
+        }
+        have_seq_ = true;
+        next_seq_ = seq + 1;
+        feed_packets(data, len);
+    }
+
+    /* Forgets the sequence number, e.g. before frames of another recording */
+    void reset_stream()
+    {
+        have_seq_ = false;
+        stream_.clear();
+        stream_pos_ = 0;
+    }
+
+    /* Decoded text, the caller may take it and clear it at any time */
+    std::string &output()
+    {
+        return out_;
+    }
+
+    const Stats &stats() const
+    {
+        return stats_;
+    }
+
+private:
+    /* Reads the fields of a packet, big-endian */
+    struct Reader {
+        const uint8_t *p;
+        const uint8_t *end;
+        bool ok = true;
+
+        uint64_t uint(unsigned size)
+        {
+            if (size_t(end - p) < size) {
+                ok = false;
+                return 0;
+            }
+            uint64_t v = 0;
+            for (unsigned i = 0; i < size; i++) {
+                v = (v << 8) | *p++;
+            }
+            return v;
+        }
+
+        /*
+         * Returns true and the bytes of an embedded string, false and the address otherwise.
+         * The length word of strings shorter than 2 bytes is 0x0001 or 0x0000, the high half of
+         * no address but NULL, which is told from a 1-byte string by the zero byte following it.
+         * A buffer of known length is embedded if the word matches the length.
+         */
+        bool pointer(unsigned pointer_size, std::string_view &str, uint64_t &addr, size_t buffer_len = 0)
+        {
+            bool embedded = false;
+            if (end - p >= 3) {
+                uint16_t word = uint16_t((p[0] << 8) | p[1]);
+                if (buffer_len > 0) {
+                    embedded = word == uint16_t(1 - buffer_len);
+                } else {
+                    embedded = (word & 0x8000) || word == 1 || (word == 0 && p[2] != 0);
+                }
+            }
+            if (embedded) {
+                int16_t neg_len = int16_t(uint(2));
+                size_t len = size_t(1 - neg_len);
+                size_t stored = std::max<size_t>(len, 2);
+                if (!ok || size_t(end - p) < stored) {
+                    ok = false;
+                    return true;
+                }
+                str = std::string_view(reinterpret_cast<const char *>(p), len);
+                p += stored;
+                return true;
+            }
+            addr = uint(pointer_size);
+            return false;
+        }
+    };
+
+    void decode_stream()
+    {
+        while (stream_.size() - stream_pos_ >= 3) {
+            const uint8_t *pkt = stream_.data() + stream_pos_;
+            size_t pkg_len = ((size_t(pkt[1]) << 8) | pkt[2]) & 0x3FF;
+            if (pkg_len < 3 + 2 + 2 + 4 + 1) {
+                resync();
+                continue;
+            }
+            if (stream_.size() - stream_pos_ < pkg_len) {
+                break;
+            }
+            if (Crc8::update(0, pkt, pkg_len - 1) != pkt[pkg_len - 1] || !decode_packet(pkt, pkg_len)) {
+                resync();
+                continue;
+            }
+            stats_.records++;
+            stream_pos_ += pkg_len;
+        }
+        if (stream_pos_ > 0 && stream_pos_ * 2 >= stream_.size()) {
+            stream_.erase(stream_.begin(), stream_.begin() + stream_pos_);
+            stream_pos_ = 0;
+        }
+    }
+
+    void resync()
+    {
+        stats_.bad_packets++;
+        stream_pos_++;
+    }
+
+    const Format *format_at(uint8_t app, uint64_t addr)
+    {
+        auto &cache = formats_[app & 3];
+        auto it = cache.find(addr);
+        if (it != cache.end()) {
+            return it->second.get();
+        }
+        const Elf *elf = elves_[app & 3];
+        std::string_view text;
+        if (elf == nullptr || !elf->string_at(addr, text)) {
+            return nullptr;
+        }
+        return cache.emplace(addr, std::make_unique<Format>(text)).first->second.get();
+    }
+
+    const Format *format_embedded(std::string_view text)
+    {
+        auto it = embedded_formats_.find(std::string(text));
+        if (it != embedded_formats_.end()) {
+            return it->second.get();
+        }
+        return embedded_formats_.emplace(std::string(text), std::make_unique<Format>(text)).first->second.get();
+    }
+
+    bool resolve_string(uint8_t app, Reader &r, std::string_view &out, size_t buffer_len = 0)
+    {
+        uint64_t addr = 0;
+        if (r.pointer(pointer_size_, out, addr, buffer_len)) {
+            return r.ok;
+        }
+        if (!r.ok) {
+            return false;
+        }
+        if (addr == 0) {
+            out = "(null)";
+            return true;
+        }
+        const Elf *elf = elves_[app & 3];
+        if (buffer_len > 0) {
+            const uint8_t *bytes = elf ? elf->bytes_at(addr, buffer_len) : nullptr;
+            if (bytes != nullptr) {
+                out = std::string_view(reinterpret_cast<const char *>(bytes), buffer_len);
+                return true;
+            }
+        } else if (elf != nullptr && elf->string_at(addr, out)) {
+            return true;
+        }
+        unresolved_ = "<0x" + hex(addr, 8) + ">";
+        out = unresolved_;
+        return true;
+    }
+
+    static std::string hex(uint64_t v, int width)
+    {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "%0*llx", width, (unsigned long long) v);
+        return buf;
+    }
+
+    static void append_unsigned(std::string &out, uint64_t v)
+    {
+        char buf[20];
+        char *p = buf + sizeof(buf);
+        do {
+            *--p = char('0' + v % 10);
+            v /= 10;
+        } while (v);
+        out.append(p, buf + sizeof(buf) - p);
+    }
+
+    static void append_hex(std::string &out, uint64_t v, bool upper)
+    {
+        const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+        char buf[16];
+        char *p = buf + sizeof(buf);
+        do {
+            *--p = digits[v & 0xF];
+            v >>= 4;
+        } while (v);
+        out.append(p, buf + sizeof(buf) - p);
+    }
+
+    void append_prefix(char level, uint64_t timestamp, std::string_view tag)
+    {
+        out_ += level;
+        out_ += " (";
+        append_unsigned(out_, timestamp);
+        out_ += ") ";
+        out_.append(tag);
+        out_ += ": ";
+    }
+
+    bool decode_packet(const uint8_t *pkt, size_t pkg_len)
+    {
+        static const char LEVELS[8] = {'N', 'E', 'W', 'I', 'D', 'V', '?', '?'};
+        uint8_t app = pkt[0];
+        unsigned control = (unsigned(pkt[1]) << 8) | pkt[2];
+        char level = LEVELS[(control >> 10) & 7];
+        bool time_64bits = (control >> 13) & 1;
+        Reader r{pkt + 3, pkt + pkg_len - 1};
+
+        const Format *format;
+        std::string_view text;
+        uint64_t addr = 0;
+        if (r.pointer(pointer_size_, text, addr)) {
+            format = r.ok ? format_embedded(text) : nullptr;
+        } else {
+            format = r.ok ? format_at(app, addr) : nullptr;
+            if (r.ok && format == nullptr) {
+                format = format_embedded("<unknown format 0x" + hex(addr, 8) + ">");
+            }
+        }
+        std::string_view tag;
+        if (format == nullptr || !resolve_string(app, r, tag)) {
+            return false;
+        }
+        std::string tag_copy(tag);
+        uint64_t timestamp = r.uint(time_64bits ? 8 : 4);
+        if (!r.ok) {
+            return false;
+        }
+
+        size_t line_start = out_.size();
+        if (format->kind != Format::Kind::TEXT) {
+            return decode_buffer(app, *format, r, level, timestamp, tag_copy) || (out_.resize(line_start), false);
+        }
+        append_prefix(level, timestamp, tag_copy);
+        for (const Format::Piece &piece : format->pieces) {
+            out_ += piece.literal;
+            if (piece.arg == Format::Arg::NONE) {
+                break;
+            }
+            if (!append_arg(app, piece, r)) {
+                out_.resize(line_start);
+                return false;
+            }
+        }
+        if (r.p != r.end) {
+            out_.resize(line_start);
+            return false;
+        }
+        out_ += '\n';
+        return true;
+    }
+
+    bool append_arg(uint8_t app, const Format::Piece &piece, Reader &r)
+    {
+        if (piece.arg == Format::Arg::POINTER) {
+            std::string_view str;
+            if (!resolve_string(app, r, str)) {
+                return false;
+            }
+            if (piece.plain) {
+                out_.append(str);
+            } else {
+                append_printf(piece.spec + 's', std::string(str).c_str());
+            }
+            return true;
+        }
+        uint64_t v = r.uint(piece.arg == Format::Arg::U64 ? 8 : 4);
+        if (!r.ok) {
+            return false;
+        }
+        bool wide = piece.arg == Format::Arg::U64;
+        switch (piece.conv) {
+        case 'd': case 'i': {
+            int64_t s = wide ? int64_t(v) : int64_t(int32_t(v));
+            if (piece.plain) {
+                if (s < 0) {
+                    out_ += '-';
+                    append_unsigned(out_, uint64_t(0) - uint64_t(s));
+                } else {
+                    append_unsigned(out_, uint64_t(s));
+                }
+            } else {
+                append_printf(piece.spec + "lld", (long long) s);
+            }
+            break;
+        }
+        case 'u': case 'x': case 'X': case 'o':
+            if (piece.plain && piece.conv == 'u') {
+                append_unsigned(out_, v);
+            } else if (piece.plain && piece.conv != 'o') {
+                append_hex(out_, v, piece.conv == 'X');
+            } else {
+                append_printf(piece.spec + "ll" + piece.conv, (unsigned long long) v);
+            }
+            break;
+        case 'c':
+            append_printf(piece.spec + 'c', int(v & 0xFF));
+            break;
+        case 'p':
+            out_ += "0x";
+            append_hex(out_, v, false);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            double d;
+            std::memcpy(&d, &v, sizeof(d));
+            append_printf(piece.spec + piece.conv, d);
+            break;
+        }
+        default:
+            out_ += piece.spec;
+            out_ += piece.conv;
+            break;
+        }
+        return true;
+    }
+
+    template <typename T> void append_printf(const std::string &spec, T value)
+    {
+        char buf[128];
+        int len = std::snprintf(buf, sizeof(buf), spec.c_str(), value);
+        if (len >= int(sizeof(buf))) {
+            std::vector<char> big(size_t(len) + 1);
+            std::snprintf(big.data(), big.size(), spec.c_str(), value);
+            out_.append(big.data(), size_t(len));
+        } else if (len > 0) {
+            out_.append(buf, size_t(len));
+        }
+    }
+
+    /* ESP_LOG_BUFFER_HEX/CHAR/HEXDUMP: len, array, address; printed 16 bytes per line like in text mode */
+    bool decode_buffer(uint8_t app, const Format &format, Reader &r, char level, uint64_t timestamp, const std::string &tag)
+    {
+        const size_t BYTES_PER_LINE = 16;
+        size_t len = size_t(r.uint(4));
+        std::string_view data;
+        if (!r.ok || !resolve_string(app, r, data, len)) {
+            return false;
+        }
+        uint64_t address = r.uint(4);
+        if (!r.ok || r.p != r.end || data.size() != len) {
+            return false;
+        }
+        for (size_t offset = 0; offset < len; offset += BYTES_PER_LINE) {
+            size_t n = std::min(BYTES_PER_LINE, len - offset);
+            const uint8_t *line = reinterpret_cast<const uint8_t *>(data.data()) + offset;
+            append_prefix(level, timestamp, tag);
+            switch (format.kind) {
+            case Format::Kind::BUFFER_HEX:
+                for (size_t i = 0; i < n; i++) {
+                    out_ += hex(line[i], 2);
+                    if (i + 1 < n) {
+                        out_ += ' ';
+                    }
+                }
+                break;
+            case Format::Kind::BUFFER_CHAR:
+                out_.append(reinterpret_cast<const char *>(line), strnlen(reinterpret_cast<const char *>(line), n));
+                break;
+            default:
+                out_ += "0x" + hex(address + offset, 8) + " ";
+                for (size_t i = 0; i < BYTES_PER_LINE; i++) {
+                    out_ += (i % 8 == 0) ? "  " : " ";
+                    out_ += (i < n) ? hex(line[i], 2) : "  ";
+                }
+                out_ += "  |";
+                for (size_t i = 0; i < n; i++) {
+                    out_ += (line[i] >= 32 && line[i] <= 126) ? char(line[i]) : '.';
+                }
+                out_ += '|';
+                break;
+            }
+            out_ += '\n';
+        }
+        return true;
+    }
+
+    unsigned pointer_size_;
+    std::array<const Elf *, 4> elves_ {};
+    std::array<std::unordered_map<uint64_t, std::unique_ptr<Format>>, 4> formats_;
+    std::unordered_map<std::string, std::unique_ptr<Format>> embedded_formats_;
+    std::vector<uint8_t> stream_;
+    size_t stream_pos_ = 0;
+    bool have_seq_ = false;
+    uint32_t next_seq_ = 0;
+    std::string unresolved_;
+    std::string out_;
+    Stats stats_;
+};
+
+/*
+ * Returns the offsets of the valid frames of a recording (e.g. a flash partition read back),
+ * ordered by sequence number, starting with the oldest one.
+ */
+inline std::vector<size_t> order_frames(const uint8_t *data, size_t size, size_t frame_size)
+{
+    struct Entry {
+        uint32_t seq;
+        size_t offset;
+    };
+    std::vector<Entry> frames;
+    for (size_t offset = 0; offset + frame_size <= size; offset += frame_size) {
+        const uint8_t *frame = data + offset;
+        uint32_t magic, seq, crc;
+        uint16_t len;
+        std::memcpy(&magic, frame, 4);
+        std::memcpy(&seq, frame + 4, 4);
+        std::memcpy(&len, frame + 8, 2);
+        std::memcpy(&crc, frame + 12, 4);
+        if (magic == FRAME_MAGIC && len <= frame_size - FRAME_HEADER_SIZE &&
+                Crc32::update(Crc32::update(0, frame, 12), frame + FRAME_HEADER_SIZE, len) == crc) {
+            frames.push_back({seq, offset});
+        }
+    }
+    if (frames.empty()) {
+        return {};
+    }
+    // Sequence numbers may wrap around, order them relative to the newest frame
+    uint32_t newest = frames[0].seq;
+    for (const Entry &e : frames) {
+        if (int32_t(e.seq - newest) > 0) {
+            newest = e.seq;
+        }
+    }
+    std::sort(frames.begin(), frames.end(), [newest](const Entry & a, const Entry & b) {
+        return uint32_t(newest - a.seq) > uint32_t(newest - b.seq);
+    });
+    std::vector<size_t> offsets;
+    for (const Entry &e : frames) {
+        offsets.push_back(e.offset);
+    }
+    return offsets;
+}
+
+} // namespace binlog
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "binlog.hpp"
+
+static void usage(const char *prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options] [INPUT]\n"
+                 "Decodes the ESP-IDF binary log from INPUT, or from stdin.\n\n"
+                 "  --elf FILE             ELF file of the application\n"
+                 "  --bootloader-elf FILE  ELF file of the bootloader\n"
+                 "  --frames               INPUT is a stream of frames of the binary log sink\n"
+                 "  --flash                INPUT is a flash partition written by the binary log sink\n"
+                 "  --frame-size N         frame size, CONFIG_LOG_BINARY_SINK_FRAME_SIZE (default 512)\n"
+                 "  --ptr-size N           pointer size of the target (default: from the ELF, or 4)\n"
+                 "  --stats                print the decoding statistics to stderr\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    std::string app_elf_path, bootloader_elf_path, input_path;
+    enum { RAW, FRAMES, FLASH } mode = RAW;
+    size_t frame_size = 512;
+    unsigned ptr_size = 0;
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--elf" && has_value) {
+            app_elf_path = argv[++i];
+        } else if (arg == "--bootloader-elf" && has_value) {
+            bootloader_elf_path = argv[++i];
+        } else if (arg == "--frames") {
+            mode = FRAMES;
+        } else if (arg == "--flash") {
+            mode = FLASH;
+        } else if (arg == "--frame-size" && has_value) {
+            frame_size = std::strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--ptr-size" && has_value) {
+            ptr_size = unsigned(std::strtoul(argv[++i], nullptr, 0));
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg[0] != '-' && input_path.empty()) {
+            input_path = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (frame_size <= binlog::FRAME_HEADER_SIZE || (ptr_size != 0 && ptr_size != 4 && ptr_size != 8)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    binlog::Elf app_elf, bootloader_elf;
+    std::string error;
+    if (!app_elf_path.empty() && !app_elf.load(app_elf_path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (!bootloader_elf_path.empty() && !bootloader_elf.load(bootloader_elf_path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (ptr_size == 0) {
+        ptr_size = app_elf_path.empty() ? 4 : app_elf.pointer_size();
+    }
+
+    binlog::Decoder decoder(ptr_size);
+    if (!app_elf_path.empty()) {
+        decoder.set_elf(2, &app_elf);
+    }
+    if (!bootloader_elf_path.empty()) {
+        decoder.set_elf(1, &bootloader_elf);
+    }
+
+    std::FILE *in = input_path.empty() ? stdin : std::fopen(input_path.c_str(), "rb");
+    if (in == nullptr) {
+        std::fprintf(stderr, "cannot open %s\n", input_path.c_str());
+        return 1;
+    }
+
+    if (mode == FLASH) {
+        // Frames of a partition are in ring order, the oldest one may be anywhere
+        std::vector<uint8_t> image;
+        uint8_t chunk[65536];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), in)) > 0) {
+            image.insert(image.end(), chunk, chunk + n);
+        }
+        for (size_t offset : binlog::order_frames(image.data(), image.size(), frame_size)) {
+            decoder.feed_frame(image.data() + offset, frame_size);
+            std::fwrite(decoder.output().data(), 1, decoder.output().size(), stdout);
+            decoder.output().clear();
+        }
+    } else {
+        std::vector<uint8_t> buf(mode == FRAMES ? frame_size : 4096);
+        size_t have = 0, n;
+        while ((n = std::fread(buf.data() + have, 1, buf.size() - have, in)) > 0) {
+            if (mode == RAW) {
+                decoder.feed_packets(buf.data(), n);
+            } else if ((have += n) == frame_size) {
+                decoder.feed_frame(buf.data(), frame_size);
+                have = 0;
+            }
+            std::fwrite(decoder.output().data(), 1, decoder.output().size(), stdout);
+            decoder.output().clear();
+            std::fflush(stdout);
+        }
+    }
+    if (in != stdin) {
+        std::fclose(in);
+    }
+
+    if (stats) {
+        const binlog::Decoder::Stats &s = decoder.stats();
+        std::fprintf(stderr, "records: %llu, bad packets: %llu, frames: %llu, bad frames: %llu, lost frames: %llu\n",
+                     (unsigned long long) s.records, (unsigned long long) s.bad_packets, (unsigned long long) s.frames,
+                     (unsigned long long) s.bad_frames, (unsigned long long) s.lost_frames);
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "esp_log.h"
+#include "esp_log_binary_sink.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "binlog.hpp"
+#include "sdkconfig.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace std;
+
+static const char *TAG = "binlog";
+static const char *PARTITION = "binlog";
+
+namespace {
+
+struct FrameCapture {
+    vector<vector<uint8_t>> frames;
+    bool log_from_sink = false;
+
+    FrameCapture()
+    {
+        esp_log_binary_sink_config_t config = {
+            .write = write,
+            .arg = this,
+            .seq = 100,
+        };
+        esp_log_binary_sink_set(&config);
+    }
+
+    ~FrameCapture()
+    {
+        esp_log_binary_sink_set(nullptr);
+    }
+
+    static void write(const void *frame, size_t size, void *arg)
+    {
+        FrameCapture *self = static_cast<FrameCapture *>(arg);
+        REQUIRE(size == ESP_LOG_BINARY_FRAME_SIZE);
+        const uint8_t *data = static_cast<const uint8_t *>(frame);
+        self->frames.emplace_back(data, data + size);
+        if (self->log_from_sink) {
+            ESP_LOGI(TAG, "written frame %d", (int) self->frames.size());
+        }
+    }
+};
+
+esp_log_binary_frame_header_t header_of(const vector<uint8_t> &frame)
+{
+    esp_log_binary_frame_header_t header;
+    memcpy(&header, frame.data(), sizeof(header));
+    return header;
+}
+
+// Strings are embedded in the packets on Linux, the decoder does not need an ELF file
+string decode(const vector<vector<uint8_t>> &frames, binlog::Decoder &decoder)
+{
+    for (const vector<uint8_t> &frame : frames) {
+        decoder.feed_frame(frame.data(), frame.size());
+    }
+    return decoder.output();
+}
+
+vector<uint8_t> read_partition(const esp_partition_t *partition)
+{
+    vector<uint8_t> image(partition->size);
+    for (size_t offset = 0; offset < image.size(); offset += partition->erase_size) {
+        REQUIRE(esp_partition_read(partition, offset, image.data() + offset, partition->erase_size) == ESP_OK);
+    }
+    return image;
+}
+
+size_t count(const string &text, const string &what)
+{
+    size_t n = 0;
+    for (size_t pos = text.find(what); pos != string::npos; pos = text.find(what, pos + 1)) {
+        n++;
+    }
+    return n;
+}
+
+} // namespace
+
+TEST_CASE("binary log packets are collected into frames")
+{
+    FrameCapture capture;
+    for (int i = 0; i < 50; i++) {
+        ESP_LOGI(TAG, "message %d of %s, value 0x%x", i, "test", 0xC0FFEE);
+    }
+    ESP_LOGW(TAG, "warning %u", 7u);
+    uint8_t buffer[20];
+    for (int i = 0; i < (int) sizeof(buffer); i++) {
+        buffer[i] = i;
+    }
+    ESP_LOG_BUFFER_HEX(TAG, buffer, sizeof(buffer));
+    char line[] = "binary log sink!";
+    ESP_LOG_BUFFER_CHAR(TAG, line, strlen(line));
+    ESP_LOG_BUFFER_HEXDUMP(TAG, line, strlen(line), ESP_LOG_INFO);
+    esp_log_binary_sink_flush();
+
+    REQUIRE(capture.frames.size() > 2);
+    uint32_t seq = 100;
+    for (const vector<uint8_t> &frame : capture.frames) {
+        esp_log_binary_frame_header_t header = header_of(frame);
+        CHECK(header.magic == ESP_LOG_BINARY_FRAME_MAGIC);
+        CHECK(header.seq == seq++);
+        REQUIRE(header.len <= ESP_LOG_BINARY_FRAME_SIZE - sizeof(header));
+        uint32_t crc = esp_rom_crc32_le(0, frame.data(), offsetof(esp_log_binary_frame_header_t, crc));
+        CHECK(esp_rom_crc32_le(crc, frame.data() + sizeof(header), header.len) == header.crc);
+    }
+    CHECK(header_of(capture.frames[0]).first == 0);
+
+    binlog::Decoder decoder(sizeof(void *));
+    string text = decode(capture.frames, decoder);
+    CHECK(decoder.stats().records == 54);
+    CHECK(decoder.stats().bad_packets == 0);
+    CHECK(text.find("I (") == 0);
+    CHECK(text.find("binlog: message 0 of test, value 0xc0ffee\n") != string::npos);
+    CHECK(text.find("binlog: message 49 of test, value 0xc0ffee\n") != string::npos);
+    CHECK(text.find("binlog: warning 7\n") != string::npos);
+    CHECK(text.find("binlog: 00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f\n") != string::npos);
+    CHECK(text.find("binlog: 10 11 12 13\n") != string::npos);
+    CHECK(text.find("binlog: binary log sink!\n") != string::npos);
+    CHECK(text.find("  62 69 6e 61 72 79 20 6c  6f 67 20 73 69 6e 6b 21  |binary log sink!|\n") != string::npos);
+}
+
+TEST_CASE("decoder resynchronizes after a lost frame")
+{
+    FrameCapture capture;
+    for (int i = 0; i < 60; i++) {
+        ESP_LOGI(TAG, "record %d", i);
+    }
+    esp_log_binary_sink_flush();
+    REQUIRE(capture.frames.size() >= 4);
+
+    capture.frames.erase(capture.frames.begin() + 1);
+    binlog::Decoder decoder(sizeof(void *));
+    string text = decode(capture.frames, decoder);
+    CHECK(decoder.stats().lost_frames == 1);
+    CHECK(decoder.stats().bad_packets == 0);
+    CHECK(decoder.stats().records < 60);
+    CHECK(text.find("binlog: record 0\n") != string::npos);
+    CHECK(text.find("binlog: record 59\n") != string::npos);
+}
+
+TEST_CASE("sink may log without a deadlock")
+{
+    FrameCapture capture;
+    capture.log_from_sink = true;
+    for (int i = 0; i < 40; i++) {
+        ESP_LOGI(TAG, "record %d", i);
+    }
+    capture.log_from_sink = false;
+    esp_log_binary_sink_flush();
+
+    binlog::Decoder decoder(sizeof(void *));
+    string text = decode(capture.frames, decoder);
+    CHECK(decoder.stats().lost_frames == 0);
+    CHECK(count(text, "binlog: record ") == 40);
+    CHECK(count(text, "binlog: written frame ") > 0);
+}
+
+TEST_CASE("flash sink keeps the newest frames and continues the sequence after a restart")
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PARTITION);
+    REQUIRE(partition != nullptr);
+    REQUIRE(esp_partition_erase_range(partition, 0, partition->size) == ESP_OK);
+    // Every access to the emulated flash is logged, from the sink too
+    esp_log_level_set("linux_spiflash", ESP_LOG_WARN);
+
+    CHECK(esp_log_binary_sink_flash_start("no_such_partition") == ESP_ERR_NOT_FOUND);
+    REQUIRE(esp_log_binary_sink_flash_start(PARTITION) == ESP_OK);
+    CHECK(esp_log_binary_sink_flash_start(PARTITION) == ESP_ERR_INVALID_STATE);
+    // Several times the partition size, the ring wraps around
+    for (int i = 0; i < 2000; i++) {
+        ESP_LOGI(TAG, "first run %d", i);
+    }
+    esp_log_binary_sink_flash_stop();
+
+    vector<uint8_t> image = read_partition(partition);
+    vector<size_t> order = binlog::order_frames(image.data(), image.size(), ESP_LOG_BINARY_FRAME_SIZE);
+    REQUIRE(order.size() > partition->size / ESP_LOG_BINARY_FRAME_SIZE / 2);
+    uint32_t last_seq = 0;
+    binlog::Decoder decoder(sizeof(void *));
+    for (size_t offset : order) {
+        last_seq = header_of(vector<uint8_t>(image.begin() + offset, image.begin() + offset + sizeof(esp_log_binary_frame_header_t))).seq;
+        decoder.feed_frame(image.data() + offset, ESP_LOG_BINARY_FRAME_SIZE);
+    }
+    CHECK(decoder.stats().lost_frames == 0);
+    CHECK(decoder.output().find("binlog: first run 1999\n") != string::npos);
+    CHECK(decoder.output().find("binlog: first run 0\n") == string::npos);
+
+    REQUIRE(esp_log_binary_sink_flash_start(PARTITION) == ESP_OK);
+    ESP_LOGI(TAG, "second run");
+    esp_log_binary_sink_flash_stop();
+
+    image = read_partition(partition);
+    order = binlog::order_frames(image.data(), image.size(), ESP_LOG_BINARY_FRAME_SIZE);
+    REQUIRE(!order.empty());
+    esp_log_binary_frame_header_t newest;
+    memcpy(&newest, image.data() + order.back(), sizeof(newest));
+    CHECK(newest.seq == last_seq + 1);
+    binlog::Decoder second(sizeof(void *));
+    second.feed_frame(image.data() + order.back(), ESP_LOG_BINARY_FRAME_SIZE);
+    CHECK(second.output().find("binlog: second run\n") != string::npos);
+}
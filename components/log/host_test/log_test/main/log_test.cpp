@@ -9,9 +9,17 @@
 #include <cstdio>
 #include <regex>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "esp_rom_sys.h"
 #include "esp_log.h"
 #include "esp_private/log_util.h"
+#include "esp_private/log_level.h"
 #include "esp_private/log_timestamp.h"
 #include "sdkconfig.h"
 
@@ -60,11 +68,17 @@ public:
 
     string get_print_buffer_string() const
     {
+#if CONFIG_LOG_ASYNC
+        esp_log_async_flush();
+#endif
         return string(print_buffer);
     }
 
     void reset_buffer()
     {
+#if CONFIG_LOG_ASYNC
+        esp_log_async_flush();
+#endif
         std::memset(print_buffer, 0, BUFFER_SIZE);
         buffer_idx = 0;
         additional_reset();
@@ -91,6 +105,9 @@ struct PrintFixture : BasicLogFixture {
 
     virtual ~PrintFixture()
     {
+#if CONFIG_LOG_ASYNC
+        esp_log_async_flush();
+#endif
         esp_log_set_vprintf(old_vprintf);
         instance = nullptr;
     }
@@ -521,3 +538,320 @@ TEST_CASE("esp_log TAG can be NULL")
     fix.reset_buffer();
 }
 #endif // ESP_LOG_VERSION == 2
+
+#if CONFIG_LOG_ASYNC
+static string s_output;
+static std::mutex s_output_mutex;
+static std::atomic<bool> s_output_blocked;
+static std::atomic<bool> s_output_entered;
+
+static int output_to_string(const char *format, va_list args)
+{
+    s_output_entered = true;
+    while (s_output_blocked) {
+        std::this_thread::yield();
+    }
+    char line[256];
+    int len = vsnprintf(line, sizeof(line), format, args);
+    std::lock_guard<std::mutex> lock(s_output_mutex);
+    s_output.append(line, std::min(len, (int) sizeof(line) - 1));
+    return len;
+}
+
+static string get_output()
+{
+    std::lock_guard<std::mutex> lock(s_output_mutex);
+    return s_output;
+}
+
+static void clear_output()
+{
+    std::lock_guard<std::mutex> lock(s_output_mutex);
+    s_output.clear();
+}
+
+static size_t count_lines(const string &output, const string &text)
+{
+    size_t count = 0;
+    for (size_t pos = output.find(text); pos != string::npos; pos = output.find(text, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST_CASE("async log copies the arguments")
+{
+    PrintFixture fix(ESP_LOG_INFO);
+    char name[16] = "sensor";
+    ESP_LOGI(TEST_TAG, "%s: %d %5.2f %lld %zu %x %c %% [%-*d] [%.*s] %p", name, -42, 3.14159, -1234567890123LL,
+             (size_t) 77, 0xbeef, 'z', 4, 7, 3, "abcdef", (void *) 0x1234);
+    /* Printed later by the log task, with the string as it was */
+    strcpy(name, "changed");
+    const std::regex test_print("I " TIMESTAMP_FORMAT "test: sensor: -42  3.14 -1234567890123 77 beef z % \\[7   \\] \\[abc\\] 0x1234",
+                                std::regex::ECMAScript);
+    CHECK(regex_search(fix.get_print_buffer_string(), test_print) == true);
+}
+
+TEST_CASE("async log copies the tag, a format string not in rodata is printed synchronously")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    clear_output();
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(output_to_string);
+    esp_log_config_t config = ESP_LOG_CONFIG_INIT(ESP_LOG_INFO | ESP_LOG_CONFIGS_DEFAULT);
+
+    char tag[16] = "sensor";
+    esp_log(config, tag, "tag copied %d", 1);
+    strcpy(tag, "changed");
+
+    /* Printed before esp_log() returns */
+    std::string format = "format on the heap %d";
+    esp_log(config, TEST_TAG, format.c_str(), 2);
+    CHECK(count_lines(get_output(), "test: format on the heap 2") == 1);
+    format.assign(format.size(), 'x');
+
+    esp_log_async_flush();
+    esp_log_set_vprintf(old_vprintf);
+    CHECK(count_lines(get_output(), "sensor: tag copied 1") == 1);
+}
+
+TEST_CASE("async log keeps the order of messages of each thread")
+{
+    const int THREADS = 4;
+    const int MESSAGES = 500;
+    BasicLogFixture fix(ESP_LOG_INFO);
+    clear_output();
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(output_to_string);
+    uint32_t dropped = esp_log_async_get_dropped();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < MESSAGES; i++) {
+                ESP_LOGI(TEST_TAG, "thread %d message %d", t, i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    esp_log_async_flush();
+    esp_log_set_vprintf(old_vprintf);
+    dropped = esp_log_async_get_dropped() - dropped;
+    const string output = get_output();
+
+    size_t printed = 0;
+    for (int t = 0; t < THREADS; t++) {
+        const std::regex message("thread " + std::to_string(t) + " message ([0-9]+)", std::regex::ECMAScript);
+        int last = -1;
+        for (auto it = std::sregex_iterator(output.begin(), output.end(), message); it != std::sregex_iterator(); ++it) {
+            int i = std::stoi((*it)[1]);
+            CHECK(i > last);
+            last = i;
+            printed++;
+        }
+    }
+    CHECK(printed + dropped == THREADS * MESSAGES);
+}
+
+TEST_CASE("async log drops and reports messages while the buffer is full")
+{
+    const int MESSAGES = 5000;
+    BasicLogFixture fix(ESP_LOG_INFO);
+    clear_output();
+    s_output_blocked = true;
+    s_output_entered = false;
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(output_to_string);
+    uint32_t dropped = esp_log_async_get_dropped();
+
+    /* The log task waits in the middle of printing the first message */
+    ESP_LOGI(TEST_TAG, "first");
+    while (!s_output_entered) {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < MESSAGES; i++) {
+        ESP_LOGI(TEST_TAG, "message %d", i);
+    }
+    dropped = esp_log_async_get_dropped() - dropped;
+    CHECK(dropped > 0);
+    s_output_blocked = false;
+
+    /* Reported by the log task once it printed the messages, possibly along with messages dropped earlier */
+    const std::regex report("W " TIMESTAMP_FORMAT "log: ([0-9]+) messages dropped", std::regex::ECMAScript);
+    uint32_t reported = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reported < dropped && std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        std::this_thread::yield();
+        const string output = get_output();
+        reported = 0;
+        for (auto it = std::sregex_iterator(output.begin(), output.end(), report); it != std::sregex_iterator(); ++it) {
+            reported += std::stoul((*it)[1]);
+        }
+    }
+    esp_log_async_flush();
+    esp_log_set_vprintf(old_vprintf);
+    CHECK(count_lines(get_output(), "test: message ") + dropped == MESSAGES);
+    CHECK(reported >= dropped);
+}
+#endif // CONFIG_LOG_ASYNC
+
+#if CONFIG_LOG_TAG_LEVEL_INTERNED
+ESP_LOG_TAG_DEFINE(INTERNED_TAG, "interned");
+
+#define INTERNED_TAGS_10(n) \
+    ESP_LOG_TAG_DEFINE(bench_tag_##n##0, "bench_" #n "0"); ESP_LOG_TAG_DEFINE(bench_tag_##n##1, "bench_" #n "1"); \
+    ESP_LOG_TAG_DEFINE(bench_tag_##n##2, "bench_" #n "2"); ESP_LOG_TAG_DEFINE(bench_tag_##n##3, "bench_" #n "3"); \
+    ESP_LOG_TAG_DEFINE(bench_tag_##n##4, "bench_" #n "4"); ESP_LOG_TAG_DEFINE(bench_tag_##n##5, "bench_" #n "5"); \
+    ESP_LOG_TAG_DEFINE(bench_tag_##n##6, "bench_" #n "6"); ESP_LOG_TAG_DEFINE(bench_tag_##n##7, "bench_" #n "7"); \
+    ESP_LOG_TAG_DEFINE(bench_tag_##n##8, "bench_" #n "8"); ESP_LOG_TAG_DEFINE(bench_tag_##n##9, "bench_" #n "9")
+#define INTERNED_TAG_PTRS_10(n) \
+    bench_tag_##n##0, bench_tag_##n##1, bench_tag_##n##2, bench_tag_##n##3, bench_tag_##n##4, \
+    bench_tag_##n##5, bench_tag_##n##6, bench_tag_##n##7, bench_tag_##n##8, bench_tag_##n##9
+
+INTERNED_TAGS_10(0); INTERNED_TAGS_10(1); INTERNED_TAGS_10(2); INTERNED_TAGS_10(3); INTERNED_TAGS_10(4);
+INTERNED_TAGS_10(5); INTERNED_TAGS_10(6); INTERNED_TAGS_10(7); INTERNED_TAGS_10(8); INTERNED_TAGS_10(9);
+
+static const char *const s_interned_tags[] = {
+    INTERNED_TAG_PTRS_10(0), INTERNED_TAG_PTRS_10(1), INTERNED_TAG_PTRS_10(2), INTERNED_TAG_PTRS_10(3), INTERNED_TAG_PTRS_10(4),
+    INTERNED_TAG_PTRS_10(5), INTERNED_TAG_PTRS_10(6), INTERNED_TAG_PTRS_10(7), INTERNED_TAG_PTRS_10(8), INTERNED_TAG_PTRS_10(9),
+};
+
+TEST_CASE("interned tag level is set by name")
+{
+    PrintFixture fix(ESP_LOG_INFO);
+    const std::regex test_print("I " TIMESTAMP_FORMAT "interned: must indeed be printed", std::regex::ECMAScript);
+
+    ESP_LOGI(INTERNED_TAG, "must indeed be printed");
+    CHECK(regex_search(fix.get_print_buffer_string(), test_print) == true);
+
+    fix.reset_buffer();
+    // a different pointer to the same name sets the level of the interned tag
+    const string name = "interned";
+    esp_log_level_set(name.c_str(), ESP_LOG_WARN);
+    CHECK(esp_log_level_get(INTERNED_TAG) == ESP_LOG_WARN);
+    CHECK(esp_log_level_get(name.c_str()) == ESP_LOG_WARN);
+    CHECK(esp_log_level_get(bench_tag_00) == ESP_LOG_INFO);
+
+    ESP_LOGI(INTERNED_TAG, "must not be printed");
+    CHECK(fix.get_print_buffer_string().size() == 0);
+
+    fix.reset_buffer();
+    esp_log_level_set("*", ESP_LOG_INFO);
+    CHECK(esp_log_level_get(INTERNED_TAG) == ESP_LOG_INFO);
+
+    ESP_LOGI(INTERNED_TAG, "must indeed be printed");
+    CHECK(regex_search(fix.get_print_buffer_string(), test_print) == true);
+}
+
+TEST_CASE("interned tag without a level follows the default level")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    esp_log_level_set(bench_tag_01, ESP_LOG_WARN);
+
+    esp_log_set_default_level(ESP_LOG_DEBUG);
+    CHECK(esp_log_level_get(bench_tag_00) == ESP_LOG_DEBUG);
+    CHECK(esp_log_is_tag_loggable(ESP_LOG_DEBUG, bench_tag_00) == true);
+    CHECK(esp_log_level_get(bench_tag_01) == ESP_LOG_WARN);
+
+    // the wildcard tag makes all of them follow the default level again
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    esp_log_set_default_level(ESP_LOG_VERBOSE);
+    CHECK(esp_log_level_get(bench_tag_00) == ESP_LOG_VERBOSE);
+    CHECK(esp_log_level_get(bench_tag_01) == ESP_LOG_VERBOSE);
+}
+
+TEST_CASE("interned tags have their own levels")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    for (size_t i = 0; i < std::size(s_interned_tags); i++) {
+        esp_log_level_set(s_interned_tags[i], (esp_log_level_t) (i % ESP_LOG_MAX));
+    }
+    for (size_t i = 0; i < std::size(s_interned_tags); i++) {
+        CHECK(esp_log_level_get(s_interned_tags[i]) == (esp_log_level_t) (i % ESP_LOG_MAX));
+        CHECK(esp_log_is_tag_loggable(ESP_LOG_ERROR, s_interned_tags[i]) == (i % ESP_LOG_MAX >= ESP_LOG_ERROR));
+    }
+}
+
+TEST_CASE("tag level check of 100 tags", "[bench]")
+{
+    const int ROUNDS = 10000;
+    BasicLogFixture fix(ESP_LOG_INFO);
+    std::vector<string> names;
+    for (const char *tag : s_interned_tags) {
+        names.push_back(string("plain_") + tag);
+    }
+    std::vector<const char *> plain_tags;
+    for (const string &name : names) {
+        plain_tags.push_back(name.c_str());
+        esp_log_level_set(name.c_str(), ESP_LOG_WARN);
+    }
+    for (const char *tag : s_interned_tags) {
+        esp_log_level_set(tag, ESP_LOG_WARN);
+    }
+
+    auto measure = [&](const char *const * tags, size_t count) {
+        size_t loggable = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            for (size_t i = 0; i < count; i++) {
+                loggable += esp_log_is_tag_loggable(ESP_LOG_DEBUG, tags[i]);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        CHECK(loggable == 0);
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (ROUNDS * count);
+    };
+    double plain_ns = measure(plain_tags.data(), plain_tags.size());
+    double interned_ns = measure(s_interned_tags, std::size(s_interned_tags));
+#if CONFIG_LOG_TAG_LEVEL_CACHE_BINARY_MIN_HEAP
+    const char *method = "binary min-heap cache + linked list";
+#elif CONFIG_LOG_TAG_LEVEL_CACHE_ARRAY
+    const char *method = "array cache + linked list";
+#else
+    const char *method = "linked list";
+#endif
+    printf("tag level check of %zu tags: interned %.1f ns, %s %.1f ns\n", std::size(s_interned_tags), interned_ns, method, plain_ns);
+}
+#endif // CONFIG_LOG_TAG_LEVEL_INTERNED
+
+static int format_and_discard(const char *format, va_list args)
+{
+    char line[256];
+    return vsnprintf(line, sizeof(line), format, args);
+}
+
+TEST_CASE("log call latency", "[bench]")
+{
+    const int BURSTS = 100;
+    const int BURST_SIZE = 32;
+    BasicLogFixture fix(ESP_LOG_INFO);
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(format_and_discard);
+    std::vector<long long> latency;
+
+    for (int burst = 0; burst < BURSTS; burst++) {
+        for (int i = 0; i < BURST_SIZE; i++) {
+            auto start = std::chrono::steady_clock::now();
+            ESP_LOGI(TEST_TAG, "sample %d of burst %d: %s = 0x%08x, %.3f", i, burst, "value", burst * i, burst / 3.0);
+            auto end = std::chrono::steady_clock::now();
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+        /* Bursts fit into the buffer, the log task prints them in between */
+#if CONFIG_LOG_ASYNC
+        esp_log_async_flush();
+#endif
+    }
+    esp_log_set_vprintf(old_vprintf);
+
+#if CONFIG_LOG_ASYNC
+    const char *mode = "async";
+#else
+    const char *mode = "sync";
+#endif
+    std::sort(latency.begin(), latency.end());
+    long long total = 0;
+    for (long long ns : latency) {
+        total += ns;
+    }
+    printf("%s log: %zu calls, caller-side latency mean %lld ns, median %lld ns, 99th percentile %lld ns, max %lld ns\n",
+           mode, latency.size(), total / (long long) latency.size(),
+           latency[latency.size() / 2], latency[latency.size() * 99 / 100], latency.back());
+}
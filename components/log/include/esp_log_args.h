@@ -195,6 +195,17 @@ extern "C++" {
         constexpr static unsigned long long log_type = ESP_LOG_ARGS_TYPE_POINTER;
     };
 
+    // String literals and arrays are deduced as arrays by ESP_LOG_DETECT_TYPE, they are passed as pointers
+    template <size_t N>
+    struct EspLogArgType<char[N]> {
+        constexpr static unsigned long long log_type = ESP_LOG_ARGS_TYPE_POINTER;
+    };
+
+    template <size_t N>
+    struct EspLogArgType<uint8_t[N]> {
+        constexpr static unsigned long long log_type = ESP_LOG_ARGS_TYPE_POINTER;
+    };
+
     template <>
     struct EspLogArgType<long long int> {
         constexpr static unsigned long long log_type = ESP_LOG_ARGS_TYPE_64BITS;
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_LOG_ASYNC
+
+/*
+ * With CONFIG_LOG_ASYNC, the tag and the arguments of a message are copied when it is logged,
+ * the format string is not: the log task reads it later. Only messages whose format string is
+ * a constant in flash, such as a string literal, are left to the log task, the others are
+ * printed synchronously by the caller.
+ */
+
+/**
+ * @brief Print the log messages waiting to be printed by the log task
+ *
+ * With CONFIG_LOG_ASYNC, messages are formatted and printed by a low-priority task.
+ * This function prints the messages logged so far from the calling task, e.g. before
+ * a restart or entering deep sleep. If the log task is printing a message, it waits
+ * for it to finish, unless called from an ISR or while the scheduler is not running,
+ * nothing is printed then.
+ */
+void esp_log_async_flush(void);
+
+/**
+ * @brief Get the number of log messages dropped because the buffer of a core was full
+ *
+ * @return Number of messages dropped since startup.
+ */
+uint32_t esp_log_async_get_dropped(void);
+
+#endif // CONFIG_LOG_ASYNC
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_LOG_BINARY_SINK || __DOXYGEN__
+
+#define ESP_LOG_BINARY_FRAME_MAGIC      (0x46424C45)    /*!< "ELBF", first bytes of a frame */
+#define ESP_LOG_BINARY_FRAME_NO_START   (0xFFFF)        /*!< Value of esp_log_binary_frame_header_t::first if no packet starts in the frame */
+#define ESP_LOG_BINARY_FRAME_SIZE       (CONFIG_LOG_BINARY_SINK_FRAME_SIZE) /*!< Size of a frame, including the header */
+
+/**
+ * @brief Header of a binary log frame.
+ *
+ * A frame is ESP_LOG_BINARY_FRAME_SIZE bytes long: the header (little-endian) followed by `len` bytes of
+ * binary log packets, the rest is zero. Packets continue from one frame into the next one. After a lost
+ * frame, the host skips the data up to `first` and continues with the packet starting there.
+ */
+typedef struct {
+    uint32_t magic;     /*!< ESP_LOG_BINARY_FRAME_MAGIC */
+    uint32_t seq;       /*!< Sequence number, incremented by one for every frame */
+    uint16_t len;       /*!< Number of bytes of packet data in the frame */
+    uint16_t first;     /*!< Offset of the first packet starting in the frame, or ESP_LOG_BINARY_FRAME_NO_START */
+    uint32_t crc;       /*!< CRC32 (esp_rom_crc32_le) of the header up to this field and of the packet data */
+} esp_log_binary_frame_header_t;
+
+/**
+ * @brief Writes a frame to the sink.
+ *
+ * Called from the task which completed the frame, without the log lock held, one frame at a time
+ * and in the order of the sequence numbers. Logging from this callback is allowed.
+ *
+ * @param frame Frame of ESP_LOG_BINARY_FRAME_SIZE bytes, starting with esp_log_binary_frame_header_t.
+ * @param size  ESP_LOG_BINARY_FRAME_SIZE.
+ * @param arg   The argument given in esp_log_binary_sink_config_t.
+ */
+typedef void (*esp_log_binary_sink_write_t)(const void *frame, size_t size, void *arg);
+
+/**
+ * @brief Configuration of a binary log sink.
+ */
+typedef struct {
+    esp_log_binary_sink_write_t write;  /*!< Writes one frame */
+    void *arg;                          /*!< Argument passed to write */
+    uint32_t seq;                       /*!< Sequence number of the first frame */
+} esp_log_binary_sink_config_t;
+
+/**
+ * @brief Set the binary log sink.
+ *
+ * Frames waiting for the previous sink are written to it first (see esp_log_binary_sink_flush()).
+ *
+ * @param config Sink configuration, it is copied. NULL sends the packets to the console again.
+ */
+void esp_log_binary_sink_set(const esp_log_binary_sink_config_t *config);
+
+/**
+ * @brief Pass the frame being filled to the sink, even if it is not full.
+ *
+ * Frames waiting for the sink are written from the calling task. If another task is writing frames
+ * at the same time, it writes them instead and this function may return before they are written.
+ */
+void esp_log_binary_sink_flush(void);
+
+#endif // CONFIG_LOG_BINARY_SINK || __DOXYGEN__
+
+#if CONFIG_LOG_BINARY_SINK_FLASH || __DOXYGEN__
+
+/**
+ * @brief Start writing the binary log to a flash partition.
+ *
+ * The partition is used as a ring buffer of frames. Writing starts at the sector following the newest
+ * valid frame found in the partition, with the next sequence number. A sector is erased before the
+ * first frame is written into it.
+ *
+ * @param partition_label Label of a data partition.
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the partition does not exist
+ *      - ESP_ERR_INVALID_SIZE if the partition has less than two sectors
+ *        or its sector size is not a multiple of the frame size
+ *      - ESP_ERR_INVALID_STATE if the flash sink is already started
+ */
+esp_err_t esp_log_binary_sink_flash_start(const char *partition_label);
+
+/**
+ * @brief Write the frame being filled to the partition and send the packets to the console again.
+ */
+void esp_log_binary_sink_flash_stop(void);
+
+#endif // CONFIG_LOG_BINARY_SINK_FLASH || __DOXYGEN__
+
+#ifdef __cplusplus
+}
+#endif
@@ -179,6 +179,38 @@ void esp_log_level_set(const char* tag, esp_log_level_t level);
  */
 esp_log_level_t esp_log_level_get(const char* tag);
 
+/** @cond */
+#if CONFIG_LOG_TAG_LEVEL_INTERNED && !NON_OS_BUILD
+#if CONFIG_IDF_TARGET_LINUX
+#define ESP_LOG_TAG_SECTION "esp_log_tags"
+#else
+#define ESP_LOG_TAG_SECTION ".esp_log_tags"
+#endif
+ESP_STATIC_ASSERT((CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN & (CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN - 1)) == 0, "Slot size of an interned tag must be 2**n. [8, 16, 32, 64]");
+#endif
+/** @endcond */
+
+/**
+ * @brief Define a log tag at file scope.
+ *
+ * Expands to `static const char var[] = name;`. If CONFIG_LOG_TAG_LEVEL_INTERNED is enabled, the tag is also
+ * interned: it gets a dense ID at link time and the level check for it does not search for the tag.
+ * The tag is used by the ESP_LOGx macros and esp_log_level_set() in the same way as a plain string.
+ *
+ * Usage: `ESP_LOG_TAG_DEFINE(TAG, "wifi");`
+ *
+ * @param var  Name of the variable holding the tag.
+ * @param name Tag string literal. If interned, it must be shorter than CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN.
+ */
+#if (CONFIG_LOG_TAG_LEVEL_INTERNED && !NON_OS_BUILD) || __DOXYGEN__
+#define ESP_LOG_TAG_DEFINE(var, name) \
+    ESP_STATIC_ASSERT(sizeof(name) <= CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN, "Tag " name " is too long, see CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN"); \
+    static const char var[CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN] \
+        __attribute__((used, section(ESP_LOG_TAG_SECTION), aligned(CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN))) = name
+#else
+#define ESP_LOG_TAG_DEFINE(var, name) static const char var[] = name
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "log_message.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+#define ESP_LOG_ASYNC_BUFFERS (1)
+#else
+#define ESP_LOG_ASYNC_BUFFERS (CONFIG_FREERTOS_NUMBER_OF_CORES)
+#endif
+
+/**
+ * @brief Put a message into the buffer of the current core, to be printed by the log task
+ *
+ * The tag and the arguments of the message are copied, the arguments are consumed.
+ * The format string is not copied, a message whose format string is not a constant
+ * (see esp_log_async_impl_is_constant) is not queued.
+ *
+ * @param message Message to log, not from a constrained environment.
+ * @return true if the message was queued or dropped because the buffer is full,
+ *         false if the log task is not running or the format string is not a constant,
+ *         the message should be printed by the caller then.
+ */
+bool esp_log_async_write(esp_log_msg_t *message);
+
+/* Implemented for each system target */
+bool esp_log_async_impl_start(void (*task)(void));
+void esp_log_async_impl_wait(void);
+void esp_log_async_impl_notify(void);
+void esp_log_async_impl_yield(void);
+int esp_log_async_impl_core_id(void);
+bool esp_log_async_impl_is_constant(const void *ptr); /* Points to constant data of the application image */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Called by the binary log formatter with esp_log_impl_lock held,
+ * for messages not from a constrained environment.
+ */
+
+/**
+ * @brief Check if packets go to the sink instead of the console.
+ */
+bool esp_log_binary_sink_is_set(void);
+
+/**
+ * @brief Mark the start of a packet in the frame being filled.
+ */
+void esp_log_binary_sink_packet_start(void);
+
+/**
+ * @brief Append a byte of the packet to the frame being filled.
+ */
+void esp_log_binary_sink_put(uint8_t data);
+
+/**
+ * @brief End the packet.
+ *
+ * @return true if frames wait for the sink and nobody is writing them,
+ *         the caller should call esp_log_binary_sink_write_pending() after releasing the lock.
+ */
+bool esp_log_binary_sink_packet_end(void);
+
+/**
+ * @brief Write the frames waiting for the sink, called without the log lock.
+ */
+void esp_log_binary_sink_write_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include "esp_private/log_async.h"
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static bool s_notified;
+static void (*s_task)(void);
+
+static void *log_async_thread(void *arg)
+{
+    s_task();
+    return NULL;
+}
+
+bool esp_log_async_impl_start(void (*task)(void))
+{
+    pthread_t thread;
+    s_task = task;
+    if (pthread_create(&thread, NULL, log_async_thread, NULL) != 0) {
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+void esp_log_async_impl_wait(void)
+{
+    pthread_mutex_lock(&s_mutex);
+    while (!s_notified) {
+        pthread_cond_wait(&s_cond, &s_mutex);
+    }
+    s_notified = false;
+    pthread_mutex_unlock(&s_mutex);
+}
+
+void esp_log_async_impl_notify(void)
+{
+    pthread_mutex_lock(&s_mutex);
+    s_notified = true;
+    pthread_cond_signal(&s_cond);
+    pthread_mutex_unlock(&s_mutex);
+}
+
+void esp_log_async_impl_yield(void)
+{
+    sched_yield();
+}
+
+int esp_log_async_impl_core_id(void)
+{
+    return 0;
+}
+
+bool esp_log_async_impl_is_constant(const void *ptr)
+{
+    /* Provided by the linker, the read-only data lies between the text and the data of the executable */
+    extern const char __executable_start[], edata[];
+    return (const char *)ptr >= __executable_start && (const char *)ptr < edata;
+}
@@ -0,0 +1,612 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_log_async.h"
+#include "esp_private/log_async.h"
+#include "esp_private/log_format.h"
+#include "esp_private/log_message.h"
+#include "esp_private/log_util.h"
+#include "sdkconfig.h"
+
+/*
+ * Each core has a buffer of messages, several tasks of a core can put messages into it
+ * (a task preempted while writing a message, or moved to another core) and the log task
+ * takes them out. A caller reserves the space of a message by moving the head forward,
+ * copies the message and then sets its header. The log task prints the message once
+ * the header is set, clears the space and moves the tail forward. Bytes between the
+ * tail and the end of the buffer which are not reserved are always 0.
+ *
+ * The tag and the string arguments are copied into the message, the format string
+ * is not: it is printed later, after the caller has returned. A message whose format
+ * string is not a constant in flash is printed synchronously by the caller.
+ */
+
+#define LOG_ASYNC_BUFFER_SIZE   (CONFIG_LOG_ASYNC_BUFFER_SIZE)
+#define LOG_ASYNC_MESSAGE_SIZE  (256) /* Largest message in a buffer */
+#define LOG_ASYNC_LINE_SIZE     (512) /* Largest message printed by the log task */
+#define LOG_ASYNC_SPEC_SIZE     (32)  /* Largest conversion specification, with '*' replaced */
+
+#define ENTRY_COMMITTED         (1UL << 31)
+#define ENTRY_PADDING           (1UL << 30)
+#define ENTRY_NO_TAG            (1UL << 29)
+#define ENTRY_SIZE_MASK         (0xffffUL)
+
+ESP_STATIC_ASSERT((LOG_ASYNC_BUFFER_SIZE & (LOG_ASYNC_BUFFER_SIZE - 1)) == 0, "CONFIG_LOG_ASYNC_BUFFER_SIZE must be a power of two");
+
+typedef struct {
+    uint32_t header;            /* Size of the entry with ENTRY_ flags, 0 until the message is copied */
+    esp_log_config_t config;
+    const char *format;         /* Constant in flash */
+    uint64_t timestamp;
+    uint8_t args[];             /* The tag, then the arguments in the order of the format string, strings included */
+} log_entry_t;
+
+typedef struct {
+    uint32_t head;              /* Bytes reserved by callers */
+    uint32_t tail;              /* Bytes printed by the log task */
+    uint32_t dropped;           /* Messages which did not fit */
+    uint8_t buffer[LOG_ASYNC_BUFFER_SIZE] __attribute__((aligned(8)));
+} log_ring_t;
+
+typedef enum {
+    LOG_ASYNC_IDLE,
+    LOG_ASYNC_STARTING,
+    LOG_ASYNC_RUNNING,
+    LOG_ASYNC_FAILED,
+} log_async_state_t;
+
+typedef enum {
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_POINTER,
+    ARG_STRING,
+} arg_type_t;
+
+typedef struct {
+    arg_type_t type;
+    char conversion;
+    int stars;                  /* Width and precision passed as arguments */
+    bool star_precision;        /* The last of them is the precision */
+    int precision;              /* Precision in the format string, -1 if none */
+    size_t len;                 /* Length of the conversion specification */
+} conversion_t;
+
+static const char *TAG = "log";
+
+static log_ring_t s_rings[ESP_LOG_ASYNC_BUFFERS];
+static int s_state = LOG_ASYNC_IDLE;
+static bool s_waiting;          /* The log task waits for a notification */
+static bool s_busy;             /* Messages are printed, by the log task or esp_log_async_flush() */
+static uint32_t s_reported;     /* Dropped messages reported by the log task */
+
+/* Parses the conversion specification at format, which starts with '%' */
+static const char *parse_conversion(const char *format, conversion_t *conv)
+{
+    const char *p = format + 1;
+    int longs = 0;
+    char size = 0;
+
+    conv->type = ARG_NONE;
+    conv->stars = 0;
+    conv->star_precision = false;
+    conv->precision = -1;
+    p += strspn(p, "-+ #0");
+    if (*p == '*') {
+        conv->stars++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            conv->stars++;
+            conv->star_precision = true;
+            p++;
+        } else {
+            conv->precision = 0;
+            while (*p >= '0' && *p <= '9') {
+                conv->precision = conv->precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+    for (;; p++) {
+        if (*p == 'l') {
+            longs++;
+        } else if (*p == 'q' || *p == 'j' || *p == 'z' || *p == 't' || *p == 'L') {
+            size = *p;
+        } else if (*p != 'h') {
+            break;
+        }
+    }
+    conv->conversion = *p;
+    switch (*p) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        conv->type = (size == 'j') ? ARG_INTMAX :
+                     (size == 'z') ? ARG_SIZE :
+                     (size == 't') ? ARG_PTRDIFF :
+                     (longs > 1 || size == 'q') ? ARG_LLONG :
+                     (longs == 1) ? ARG_LONG : ARG_INT;
+        break;
+    case 'c':
+        conv->type = ARG_INT;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        conv->type = (size == 'L') ? ARG_LDOUBLE : ARG_DOUBLE;
+        break;
+    case 'p': case 'n':
+        conv->type = ARG_POINTER;
+        break;
+    case 's':
+        conv->type = ARG_STRING;
+        break;
+    default:
+        break;
+    }
+    if (*p != '\0') {
+        p++;
+    }
+    conv->len = p - format;
+    return p;
+}
+
+static uint8_t *put_arg(uint8_t *pos, uint8_t *end, const void *value, size_t size)
+{
+    if (pos == NULL || (size_t)(end - pos) < size) {
+        return NULL;
+    }
+    memcpy(pos, value, size);
+    return pos + size;
+}
+
+static uint8_t *put_string(uint8_t *pos, uint8_t *end, const char *str, int precision)
+{
+    if (pos == NULL || pos == end) {
+        return NULL;
+    }
+    size_t max_len = end - pos - 1;
+    if (precision >= 0 && (size_t)precision < max_len) {
+        max_len = precision;
+    }
+    size_t len = strnlen((str) ? str : "(null)", max_len);
+    memcpy(pos, (str) ? str : "(null)", len);
+    pos[len] = '\0';
+    return pos + len + 1;
+}
+
+/* Copies the arguments, as many of them as fit, returns their size */
+static size_t copy_args(uint8_t *buffer, size_t size, const char *format, va_list args)
+{
+    uint8_t *pos = buffer;
+    uint8_t *end = buffer + size;
+    uint8_t *last = buffer;
+    conversion_t conv;
+
+    for (const char *p = strchr(format, '%'); p != NULL && pos != NULL; p = strchr(p, '%')) {
+        p = parse_conversion(p, &conv);
+        int precision = conv.precision;
+        for (int i = 0; i < conv.stars; i++) {
+            int star = va_arg(args, int);
+            precision = star;
+            pos = put_arg(pos, end, &star, sizeof(star));
+        }
+        if (!conv.star_precision) {
+            precision = conv.precision;
+        }
+        switch (conv.type) {
+        case ARG_INT: {
+            int value = va_arg(args, int);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_LONG: {
+            long value = va_arg(args, long);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_LLONG: {
+            long long value = va_arg(args, long long);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_INTMAX: {
+            intmax_t value = va_arg(args, intmax_t);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_SIZE: {
+            size_t value = va_arg(args, size_t);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_PTRDIFF: {
+            ptrdiff_t value = va_arg(args, ptrdiff_t);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_DOUBLE: {
+            double value = va_arg(args, double);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_LDOUBLE: {
+            long double value = va_arg(args, long double);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_POINTER: {
+            void *value = va_arg(args, void *);
+            pos = put_arg(pos, end, &value, sizeof(value));
+            break;
+        }
+        case ARG_STRING:
+            pos = put_string(pos, end, va_arg(args, const char *), precision);
+            break;
+        case ARG_NONE:
+            break;
+        }
+        if (pos != NULL) {
+            last = pos;
+        }
+    }
+    return last - buffer;
+}
+
+static bool get_arg(const uint8_t **pos, const uint8_t *end, void *value, size_t size)
+{
+    if ((size_t)(end - *pos) < size) {
+        return false;
+    }
+    memcpy(value, *pos, size);
+    *pos += size;
+    return true;
+}
+
+/* Copies the conversion specification to spec, with the values of '*' */
+static bool make_spec(char *spec, const char *format, const conversion_t *conv, const uint8_t **pos, const uint8_t *end)
+{
+    size_t len = 0;
+    int star;
+
+    for (size_t i = 0; i < conv->len && len < LOG_ASYNC_SPEC_SIZE - 1; i++) {
+        if (format[i] != '*') {
+            spec[len++] = format[i];
+            continue;
+        }
+        if (!get_arg(pos, end, &star, sizeof(star))) {
+            return false;
+        }
+        if (i > 0 && format[i - 1] == '.' && star < 0) {
+            len--; /* A negative precision is taken as if it was omitted */
+            continue;
+        }
+        len += snprintf(&spec[len], LOG_ASYNC_SPEC_SIZE - len, "%d", star);
+    }
+    if (len >= LOG_ASYNC_SPEC_SIZE - 1) {
+        return false;
+    }
+    spec[len] = '\0';
+    return true;
+}
+
+/* Formats the message of an entry in line, as much of it as the copied arguments allow */
+static void format_entry(const log_entry_t *entry, char *line, size_t size)
+{
+    const uint8_t *pos = entry->args + strlen((const char *)entry->args) + 1;
+    const uint8_t *end = (const uint8_t *)entry + (entry->header & ENTRY_SIZE_MASK);
+    const char *format = entry->format;
+    char spec[LOG_ASYNC_SPEC_SIZE];
+    conversion_t conv;
+    size_t len = 0;
+    int n = 0;
+
+    while (len < size - 1) {
+        const char *percent = strchr(format, '%');
+        size_t literal = (percent) ? (size_t)(percent - format) : strlen(format);
+        if (literal > size - 1 - len) {
+            literal = size - 1 - len;
+        }
+        memcpy(&line[len], format, literal);
+        len += literal;
+        if (percent == NULL || len == size - 1) {
+            break;
+        }
+        format = parse_conversion(percent, &conv);
+        if (conv.type == ARG_NONE) {
+            if (conv.conversion == '%') {
+                line[len++] = '%';
+            }
+            continue;
+        }
+        if (!make_spec(spec, percent, &conv, &pos, end)) {
+            break;
+        }
+        char *out = &line[len];
+        size_t room = size - len;
+        switch (conv.type) {
+        case ARG_INT: {
+            int value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_LONG: {
+            long value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_LLONG: {
+            long long value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_INTMAX: {
+            intmax_t value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_SIZE: {
+            size_t value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_PTRDIFF: {
+            ptrdiff_t value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_DOUBLE: {
+            double value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_LDOUBLE: {
+            long double value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? snprintf(out, room, spec, value) : -1;
+            break;
+        }
+        case ARG_POINTER: {
+            void *value;
+            n = get_arg(&pos, end, &value, sizeof(value)) ? ((conv.conversion == 'p') ? snprintf(out, room, spec, value) : 0) : -1;
+            break;
+        }
+        case ARG_STRING: {
+            const char *value = (const char *)pos;
+            size_t str_len = strnlen(value, end - pos);
+            if (str_len == (size_t)(end - pos)) {
+                n = -1;
+                break;
+            }
+            pos += str_len + 1;
+            n = snprintf(out, room, spec, value);
+            break;
+        }
+        case ARG_NONE:
+            break;
+        }
+        if (n < 0) {
+            break;
+        }
+        len += ((size_t)n < room) ? (size_t)n : room - 1;
+    }
+    line[len] = '\0';
+}
+
+static log_entry_t *ring_reserve(log_ring_t *ring, uint32_t size)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t offset, padding;
+    do {
+        offset = head & (LOG_ASYNC_BUFFER_SIZE - 1);
+        padding = (offset + size > LOG_ASYNC_BUFFER_SIZE) ? LOG_ASYNC_BUFFER_SIZE - offset : 0;
+        if (head + padding + size - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > LOG_ASYNC_BUFFER_SIZE) {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + padding + size, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    if (padding) {
+        /* The message does not fit before the end of the buffer, the log task skips the rest */
+        __atomic_store_n((uint32_t *)&ring->buffer[offset], ENTRY_COMMITTED | ENTRY_PADDING | padding, __ATOMIC_RELEASE);
+        offset = 0;
+    }
+    return (log_entry_t *)&ring->buffer[offset];
+}
+
+/* The oldest message of a buffer, if it is written */
+static log_entry_t *ring_peek(log_ring_t *ring)
+{
+    for (;;) {
+        uint32_t offset = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED) & (LOG_ASYNC_BUFFER_SIZE - 1);
+        log_entry_t *entry = (log_entry_t *)&ring->buffer[offset];
+        uint32_t header = __atomic_load_n(&entry->header, __ATOMIC_ACQUIRE);
+        if (!(header & ENTRY_COMMITTED)) {
+            return NULL;
+        }
+        if (!(header & ENTRY_PADDING)) {
+            return entry;
+        }
+        __atomic_store_n(&entry->header, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ring->tail, header & ENTRY_SIZE_MASK, __ATOMIC_RELEASE);
+    }
+}
+
+static void ring_release(log_ring_t *ring, log_entry_t *entry)
+{
+    uint32_t size = entry->header & ENTRY_SIZE_MASK;
+    memset((uint8_t *)entry + sizeof(entry->header), 0, size - sizeof(entry->header));
+    __atomic_store_n(&entry->header, 0, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ring->tail, size, __ATOMIC_RELEASE);
+}
+
+static void print_message(esp_log_msg_t *message, ...)
+{
+    va_start(message->args, message);
+    esp_log_format(message);
+    va_end(message->args);
+}
+
+/* Prints the messages of all buffers, the oldest first */
+static void print_pending(bool constrained_env)
+{
+    static char line[LOG_ASYNC_LINE_SIZE];
+
+    for (;;) {
+        log_ring_t *ring = NULL;
+        log_entry_t *entry = NULL;
+        for (int i = 0; i < ESP_LOG_ASYNC_BUFFERS; i++) {
+            log_entry_t *oldest = ring_peek(&s_rings[i]);
+            if (oldest != NULL && (entry == NULL || oldest->timestamp < entry->timestamp)) {
+                ring = &s_rings[i];
+                entry = oldest;
+            }
+        }
+        if (entry == NULL) {
+            return;
+        }
+        format_entry(entry, line, sizeof(line));
+        esp_log_msg_t message = {
+            .config = entry->config,
+            .tag = (entry->header & ENTRY_NO_TAG) ? NULL : (const char *)entry->args,
+            .format = "%s",
+            .timestamp = entry->timestamp,
+            .arg_types = NULL,
+        };
+        message.config.opts.constrained_env = constrained_env;
+        print_message(&message, line);
+        ring_release(ring, entry);
+    }
+}
+
+static bool is_pending(void)
+{
+    for (int i = 0; i < ESP_LOG_ASYNC_BUFFERS; i++) {
+        if (ring_peek(&s_rings[i]) != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool print_lock(bool wait)
+{
+    while (__atomic_exchange_n(&s_busy, true, __ATOMIC_ACQUIRE)) {
+        if (!wait) {
+            return false;
+        }
+        esp_log_async_impl_yield();
+    }
+    return true;
+}
+
+static void print_unlock(void)
+{
+    __atomic_store_n(&s_busy, false, __ATOMIC_RELEASE);
+}
+
+static void log_async_task(void)
+{
+    for (;;) {
+        print_lock(true);
+        print_pending(false);
+        print_unlock();
+
+        uint32_t dropped = esp_log_async_get_dropped();
+        if (dropped != s_reported) {
+            ESP_LOGW(TAG, "%" PRIu32 " messages dropped, the log buffer was full", dropped - s_reported);
+            s_reported = dropped;
+            continue;
+        }
+
+        __atomic_store_n(&s_waiting, true, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!is_pending()) {
+            esp_log_async_impl_wait();
+        }
+        __atomic_store_n(&s_waiting, false, __ATOMIC_RELAXED);
+    }
+}
+
+static bool log_async_start(void)
+{
+    int state = LOG_ASYNC_IDLE;
+    if (__atomic_compare_exchange_n(&s_state, &state, LOG_ASYNC_STARTING, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        state = esp_log_async_impl_start(log_async_task) ? LOG_ASYNC_RUNNING : LOG_ASYNC_FAILED;
+        __atomic_store_n(&s_state, state, __ATOMIC_RELEASE);
+    }
+    return state == LOG_ASYNC_RUNNING;
+}
+
+bool esp_log_async_write(esp_log_msg_t *message)
+{
+    if (!esp_log_async_impl_is_constant(message->format)) {
+        /* It may be gone by the time the log task prints the message */
+        return false;
+    }
+    if (__atomic_load_n(&s_state, __ATOMIC_ACQUIRE) != LOG_ASYNC_RUNNING && !log_async_start()) {
+        return false;
+    }
+
+    union {
+        log_entry_t entry;
+        uint8_t bytes[LOG_ASYNC_MESSAGE_SIZE];
+    } buffer;
+    log_entry_t *entry = &buffer.entry;
+    entry->config = message->config;
+    entry->format = message->format;
+    entry->timestamp = message->timestamp;
+    uint8_t *args = put_string(entry->args, &buffer.bytes[sizeof(buffer)], (message->tag) ? message->tag : "", -1);
+    size_t size = args - buffer.bytes;
+    size += copy_args(args, sizeof(buffer) - size, message->format, message->args);
+    size = (size + 7) & ~7;
+    uint32_t flags = ENTRY_COMMITTED | ((message->tag) ? 0 : ENTRY_NO_TAG);
+
+    log_ring_t *ring = &s_rings[esp_log_async_impl_core_id()];
+    log_entry_t *reserved = ring_reserve(ring, size);
+    if (reserved == NULL) {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    memcpy((uint8_t *)reserved + sizeof(entry->header), (uint8_t *)entry + sizeof(entry->header), size - sizeof(entry->header));
+    __atomic_store_n(&reserved->header, flags | size, __ATOMIC_RELEASE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s_waiting, __ATOMIC_RELAXED) && __atomic_exchange_n(&s_waiting, false, __ATOMIC_RELAXED)) {
+        esp_log_async_impl_notify();
+    }
+    return true;
+}
+
+void esp_log_async_flush(void)
+{
+    bool constrained_env = esp_log_util_is_constrained();
+    if (print_lock(!constrained_env)) {
+        print_pending(constrained_env);
+        print_unlock();
+    }
+}
+
+uint32_t esp_log_async_get_dropped(void)
+{
+    uint32_t dropped = 0;
+    for (int i = 0; i < ESP_LOG_ASYNC_BUFFERS; i++) {
+        dropped += __atomic_load_n(&s_rings[i].dropped, __ATOMIC_RELAXED);
+    }
+    return dropped;
+}
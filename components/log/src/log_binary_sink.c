@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Frames of the binary log sink.
+ *
+ * The frame buffers form a ring: the frames from s_head on wait for the sink
+ * (the oldest one may be being written), the one after them is being filled.
+ * Filling and queueing happen under esp_log_impl_lock, called by the binary
+ * formatter. The sink is called without the lock, so that it can take its
+ * time and even log: the task which finds waiting frames and nobody writing
+ * them becomes the writer until no frame waits.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_log_binary_sink.h"
+#include "esp_private/log_binary_sink.h"
+#include "esp_private/log_lock.h"
+#include "esp_assert.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
+
+#define FRAME_SIZE      (CONFIG_LOG_BINARY_SINK_FRAME_SIZE)
+#define FRAMES          (CONFIG_LOG_BINARY_SINK_FRAMES)
+#define HEADER_SIZE     (sizeof(esp_log_binary_frame_header_t))
+#define PAYLOAD_SIZE    (FRAME_SIZE - HEADER_SIZE)
+
+ESP_STATIC_ASSERT((FRAME_SIZE & (FRAME_SIZE - 1)) == 0, "Frame size must be 2**n");
+ESP_STATIC_ASSERT(sizeof(esp_log_binary_frame_header_t) == 16, "Frame header must be 16 bytes");
+
+static uint8_t s_frames[FRAMES][FRAME_SIZE] __attribute__((aligned(4)));
+static esp_log_binary_sink_config_t s_sink;
+static unsigned s_head;             // Oldest frame waiting for the sink
+static unsigned s_waiting;          // Number of frames waiting for the sink
+static size_t s_fill;               // Bytes of packet data in the frame being filled
+static uint16_t s_first = ESP_LOG_BINARY_FRAME_NO_START;
+static bool s_writing;
+
+static inline uint8_t *frame_being_filled(void)
+{
+    return s_frames[(s_head + s_waiting) % FRAMES];
+}
+
+static void close_frame(void)
+{
+    uint8_t *frame = frame_being_filled();
+    esp_log_binary_frame_header_t header = {
+        .magic = ESP_LOG_BINARY_FRAME_MAGIC,
+        .seq = s_sink.seq++,
+        .len = (uint16_t) s_fill,
+        .first = s_first,
+    };
+    memset(frame + HEADER_SIZE + s_fill, 0, PAYLOAD_SIZE - s_fill);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *) &header, offsetof(esp_log_binary_frame_header_t, crc));
+    header.crc = esp_rom_crc32_le(crc, frame + HEADER_SIZE, s_fill);
+    memcpy(frame, &header, HEADER_SIZE);
+    // If all other buffers wait, this one is reused. Its sequence number is skipped, which marks the loss.
+    if (s_waiting < FRAMES - 1) {
+        s_waiting++;
+    }
+    s_fill = 0;
+    s_first = ESP_LOG_BINARY_FRAME_NO_START;
+}
+
+bool esp_log_binary_sink_is_set(void)
+{
+    return s_sink.write != NULL;
+}
+
+void esp_log_binary_sink_packet_start(void)
+{
+    if (s_first == ESP_LOG_BINARY_FRAME_NO_START) {
+        s_first = (uint16_t) s_fill;
+    }
+}
+
+void esp_log_binary_sink_put(uint8_t data)
+{
+    frame_being_filled()[HEADER_SIZE + s_fill++] = data;
+    if (s_fill == PAYLOAD_SIZE) {
+        close_frame();
+    }
+}
+
+bool esp_log_binary_sink_packet_end(void)
+{
+    return s_waiting > 0 && !s_writing;
+}
+
+void esp_log_binary_sink_write_pending(void)
+{
+    esp_log_impl_lock();
+    if (s_writing) {
+        esp_log_impl_unlock();
+        return;
+    }
+    s_writing = true;
+    while (s_waiting > 0) {
+        esp_log_binary_sink_write_t write = s_sink.write;
+        void *arg = s_sink.arg;
+        const uint8_t *frame = s_frames[s_head];
+        esp_log_impl_unlock();
+        if (write) {
+            write(frame, FRAME_SIZE, arg);
+        }
+        esp_log_impl_lock();
+        s_head = (s_head + 1) % FRAMES;
+        s_waiting--;
+    }
+    s_writing = false;
+    esp_log_impl_unlock();
+}
+
+void esp_log_binary_sink_flush(void)
+{
+    esp_log_impl_lock();
+    if (s_sink.write != NULL && s_fill > 0) {
+        close_frame();
+    }
+    esp_log_impl_unlock();
+    esp_log_binary_sink_write_pending();
+}
+
+void esp_log_binary_sink_set(const esp_log_binary_sink_config_t *config)
+{
+    esp_log_binary_sink_flush();
+    esp_log_impl_lock();
+    if (config != NULL) {
+        s_sink = *config;
+    } else {
+        memset(&s_sink, 0, sizeof(s_sink));
+    }
+    esp_log_impl_unlock();
+}
@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Binary log sink writing the frames to a data partition used as a ring
+ * buffer. The frame size divides the sector size, so frames never cross
+ * sectors: a sector is erased right before its first frame is written.
+ *
+ * At start, the partition is scanned for the newest valid frame (by sequence
+ * number, allowing for wrap-around). Writing continues at the next sector,
+ * so that a frame torn by a reset is never written over without an erase.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log_binary_sink.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+static const esp_partition_t *s_partition;
+static size_t s_pos;
+
+static bool frame_is_valid(const uint8_t *frame)
+{
+    esp_log_binary_frame_header_t header;
+    memcpy(&header, frame, sizeof(header));
+    if (header.magic != ESP_LOG_BINARY_FRAME_MAGIC || header.len > ESP_LOG_BINARY_FRAME_SIZE - sizeof(header)) {
+        return false;
+    }
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *) &header, offsetof(esp_log_binary_frame_header_t, crc));
+    crc = esp_rom_crc32_le(crc, frame + sizeof(header), header.len);
+    return crc == header.crc;
+}
+
+static void flash_sink_write(const void *frame, size_t size, void *arg)
+{
+    const esp_partition_t *partition = (const esp_partition_t *) arg;
+    if (s_pos % partition->erase_size == 0) {
+        if (esp_partition_erase_range(partition, s_pos, partition->erase_size) != ESP_OK) {
+            return;
+        }
+    }
+    esp_partition_write(partition, s_pos, frame, size);
+    s_pos = (s_pos + size) % partition->size;
+}
+
+static esp_err_t find_newest_frame(const esp_partition_t *partition, bool *found, size_t *pos, uint32_t *seq)
+{
+    uint8_t *frame = malloc(ESP_LOG_BINARY_FRAME_SIZE);
+    if (frame == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    *found = false;
+    for (size_t offset = 0; offset < partition->size; offset += ESP_LOG_BINARY_FRAME_SIZE) {
+        esp_err_t err = esp_partition_read(partition, offset, frame, ESP_LOG_BINARY_FRAME_SIZE);
+        if (err != ESP_OK) {
+            free(frame);
+            return err;
+        }
+        if (!frame_is_valid(frame)) {
+            continue;
+        }
+        esp_log_binary_frame_header_t header;
+        memcpy(&header, frame, sizeof(header));
+        if (!*found || (int32_t)(header.seq - *seq) > 0) {
+            *found = true;
+            *pos = offset;
+            *seq = header.seq;
+        }
+    }
+    free(frame);
+    return ESP_OK;
+}
+
+esp_err_t esp_log_binary_sink_flash_start(const char *partition_label)
+{
+    if (s_partition != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (partition->erase_size % ESP_LOG_BINARY_FRAME_SIZE != 0 || partition->size < 2 * partition->erase_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool found;
+    size_t newest = 0;
+    uint32_t seq = 0;
+    esp_err_t err = find_newest_frame(partition, &found, &newest, &seq);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (found) {
+        size_t next_sector = (newest / partition->erase_size + 1) * partition->erase_size;
+        s_pos = next_sector % partition->size;
+        seq++;
+    } else {
+        s_pos = 0;
+    }
+    s_partition = partition;
+
+    esp_log_binary_sink_config_t config = {
+        .write = flash_sink_write,
+        .arg = (void *) partition,
+        .seq = seq,
+    };
+    esp_log_binary_sink_set(&config);
+    return ESP_OK;
+}
+
+void esp_log_binary_sink_flash_stop(void)
+{
+    if (s_partition == NULL) {
+        return;
+    }
+    esp_log_binary_sink_set(NULL);
+    s_partition = NULL;
+}
@@ -14,6 +14,7 @@
 #include "esp_private/log_message.h"
 #include "esp_private/log_print.h"
 #include "esp_private/log_util.h"
+#include "esp_private/log_binary_sink.h"
 #include "soc/soc.h"
 #include "esp_rom_uart.h"
 
@@ -66,6 +67,7 @@ typedef struct {
     bool buffer_hexdump_log;
     int buffer_len;
     bool len_calculation_stage;
+    bool to_sink;
 } pkg_info_t;
 
 extern const char __ESP_BUFFER_HEX_FORMAT__[];
@@ -111,7 +113,14 @@ static unsigned output(const void *src, unsigned length, pkg_info_t *pkg_info)
     for (unsigned i = 0; i < length; i++) {
         uint8_t data = ((uint8_t *)src)[length - 1 - i];
         if (pkg_info->len_calculation_stage == false) {
-            esp_rom_output_tx_one_char(data);
+#if CONFIG_LOG_BINARY_SINK && !NON_OS_BUILD
+            if (pkg_info->to_sink) {
+                esp_log_binary_sink_put(data);
+            } else
+#endif
+            {
+                esp_rom_output_tx_one_char(data);
+            }
             update_crc8(data, pkg_info);
         }
     }
@@ -129,7 +138,9 @@ static unsigned output_pointer(const char *ptr, pkg_info_t *pkg_info)
         int16_t pkg_str_len = 1 - len;
         pkg_len = output(&pkg_str_len, sizeof(pkg_str_len), pkg_info);
         for (unsigned i = 0; i < MAX(len, 2); i++) {
-            pkg_len += output(&ptr[i], sizeof(uint8_t), pkg_info);
+            // Strings shorter than 2 bytes are padded with zeros, not read beyond their end
+            const char data = ((int) i < len) ? ptr[i] : 0;
+            pkg_len += output(&data, sizeof(uint8_t), pkg_info);
         }
     }
     return pkg_len;
@@ -240,6 +251,7 @@ static unsigned calc_pkg_len(esp_log_msg_t *message, pkg_info_t *pkg_info)
     va_end(args);
     pkg_len += sizeof(uint8_t); // crc8
     pkg_info->len_calculation_stage = false;
+    pkg_info->buffer_len = 0; // set by the arguments, the format and tag of the output stage are not buffers
     return pkg_len;
 }
 
@@ -271,7 +283,14 @@ void esp_log_format_binary(esp_log_msg_t *message)
         .buffer_hexdump_log = message->format == __ESP_BUFFER_HEXDUMP_FORMAT__,
         .buffer_len = 0,
         .len_calculation_stage = false,
+        .to_sink = false,
     };
+#if CONFIG_LOG_BINARY_SINK && !NON_OS_BUILD
+    if (!message->config.opts.constrained_env && esp_log_binary_sink_is_set()) {
+        pkg_info.to_sink = true;
+        esp_log_binary_sink_packet_start();
+    }
+#endif
 
     // Output control byte
     control_t control = {
@@ -290,7 +309,15 @@ void esp_log_format_binary(esp_log_msg_t *message)
     output_arguments(message, message->args, &pkg_info);
     output(&pkg_info.crc, sizeof(pkg_info.crc), &pkg_info);
 
+#if CONFIG_LOG_BINARY_SINK && !NON_OS_BUILD
+    bool write_frames = pkg_info.to_sink && esp_log_binary_sink_packet_end();
+#endif
     if (!message->config.opts.constrained_env) {
         esp_log_impl_unlock();
     }
+#if CONFIG_LOG_BINARY_SINK && !NON_OS_BUILD
+    if (write_frames) {
+        esp_log_binary_sink_write_pending();
+    }
+#endif
 }
@@ -9,6 +9,9 @@
 #include "esp_private/log_level.h"
 #include "esp_attr.h"
 #include "sdkconfig.h"
+#if CONFIG_LOG_TAG_LEVEL_INTERNED
+#include "tag_log_level/interned/log_interned.h"
+#endif
 
 #if CONFIG_LOG_DYNAMIC_LEVEL_CONTROL
 esp_log_level_t esp_log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
@@ -50,6 +53,12 @@ bool esp_log_is_tag_loggable(esp_log_level_t level, const char *tag)
     return true;
 #endif
 #else // !CONFIG_LOG_TAG_LEVEL_IMPL_NONE
+#if CONFIG_LOG_TAG_LEVEL_INTERNED
+    esp_log_level_t level_for_tag;
+    if (esp_log_interned_get_level(tag, &level_for_tag)) {
+        return level_for_tag >= level && level > ESP_LOG_NONE;
+    }
+#endif
     return esp_log_level_get_timeout(tag) >= level && level > ESP_LOG_NONE;
 #endif // !CONFIG_LOG_TAG_LEVEL_IMPL_NONE
 }
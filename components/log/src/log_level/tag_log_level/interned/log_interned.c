@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * This file keeps the log levels of interned tags, i.e. tags defined with
+ * ESP_LOG_TAG_DEFINE. Each such tag occupies a slot of a fixed size in a
+ * dedicated linker section, so the index of the slot is a dense ID assigned
+ * at link time. The levels are stored in a flat array indexed by this ID.
+ * A tag whose level was never set, or was reset by the wildcard tag, holds
+ * ESP_LOG_INTERNED_LEVEL_UNSET and follows the default level.
+ *
+ * The lookup (esp_log_interned_get_level in log_interned.h) does not compare
+ * strings and does not take the lock. Setting a level is the slow path, it
+ * compares the given tag with the name in every slot. Only the setters are
+ * called under esp_log_impl_lock by tag_log_level.c, the levels are read and
+ * written atomically because the lookup runs without the lock.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_log_level.h"
+#include "log_interned.h"
+#include "sdkconfig.h"
+
+uint8_t esp_log_interned_levels[ESP_LOG_INTERNED_MAX_TAGS] = {
+    [0 ... ESP_LOG_INTERNED_MAX_TAGS - 1] = ESP_LOG_INTERNED_LEVEL_UNSET
+};
+
+static uintptr_t interned_tags_first(void)
+{
+    // The first slot starts at the first aligned address of the section
+    return ((uintptr_t)ESP_LOG_INTERNED_TAGS_START + ESP_LOG_INTERNED_NAME_LEN - 1) & ~(uintptr_t)(ESP_LOG_INTERNED_NAME_LEN - 1);
+}
+
+static size_t interned_tags_count(void)
+{
+    uintptr_t first = interned_tags_first();
+    uintptr_t end = (uintptr_t)ESP_LOG_INTERNED_TAGS_END;
+    size_t count = (end > first) ? (end - first) / ESP_LOG_INTERNED_NAME_LEN : 0;
+    return (count < ESP_LOG_INTERNED_MAX_TAGS) ? count : ESP_LOG_INTERNED_MAX_TAGS;
+}
+
+void esp_log_interned_set_level(const char *tag, esp_log_level_t level)
+{
+    uintptr_t first = interned_tags_first();
+    size_t count = interned_tags_count();
+    for (size_t id = 0; id < count; ++id) {
+        const char *name = (const char *)(first + id * ESP_LOG_INTERNED_NAME_LEN);
+        if (strncmp(name, tag, ESP_LOG_INTERNED_NAME_LEN) == 0) {
+            __atomic_store_n(&esp_log_interned_levels[id], (uint8_t) level, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void esp_log_interned_reset_all(void)
+{
+    for (size_t id = 0; id < ESP_LOG_INTERNED_MAX_TAGS; ++id) {
+        __atomic_store_n(&esp_log_interned_levels[id], ESP_LOG_INTERNED_LEVEL_UNSET, __ATOMIC_RELAXED);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_log_level.h"
+#include "sdkconfig.h"
+
+#define ESP_LOG_INTERNED_NAME_LEN   (CONFIG_LOG_TAG_LEVEL_INTERNED_NAME_LEN)
+#define ESP_LOG_INTERNED_MAX_TAGS   (CONFIG_LOG_TAG_LEVEL_INTERNED_MAX_TAGS)
+
+#if CONFIG_IDF_TARGET_LINUX
+// Provided by the linker for sections named as C identifiers, weak in case no tag is interned.
+extern const char __start_esp_log_tags[] __attribute__((weak));
+extern const char __stop_esp_log_tags[] __attribute__((weak));
+#define ESP_LOG_INTERNED_TAGS_START __start_esp_log_tags
+#define ESP_LOG_INTERNED_TAGS_END   __stop_esp_log_tags
+#else
+// Provided by SURROUND(esp_log_tags) in linker.lf
+extern const char _esp_log_tags_start[];
+extern const char _esp_log_tags_end[];
+#define ESP_LOG_INTERNED_TAGS_START _esp_log_tags_start
+#define ESP_LOG_INTERNED_TAGS_END   _esp_log_tags_end
+#endif
+
+/** Level of an interned tag whose level was not set, it follows the default level */
+#define ESP_LOG_INTERNED_LEVEL_UNSET    (0xFF)
+
+/** Levels of interned tags, indexed by the ID of a tag */
+extern uint8_t esp_log_interned_levels[ESP_LOG_INTERNED_MAX_TAGS];
+
+/**
+ * @brief Get the log level for an interned tag.
+ *
+ * The tag is interned if it points to a slot of the interned tags section (see ESP_LOG_TAG_DEFINE).
+ * The ID of the tag is the index of its slot, the level is read from the flat level array
+ * without comparing strings and without taking the lock. If no level was set for the tag,
+ * the default level is retrieved (see esp_log_get_default_level()).
+ *
+ * @param tag   The log tag for which to retrieve the log level.
+ * @param level Pointer to a variable where the retrieved log level will be stored.
+ * @return `true`  if the tag is interned and the level was retrieved,
+ *         `false` if the tag is not interned, the `level` value remains unchanged.
+ */
+__attribute__((always_inline))
+static inline bool esp_log_interned_get_level(const char *tag, esp_log_level_t *level)
+{
+    uintptr_t offset = (uintptr_t)tag - (uintptr_t)ESP_LOG_INTERNED_TAGS_START;
+    if (offset >= (uintptr_t)ESP_LOG_INTERNED_TAGS_END - (uintptr_t)ESP_LOG_INTERNED_TAGS_START) {
+        return false;
+    }
+    // Slots are aligned to their size, so the division gives the index even if the section start is not aligned
+    uintptr_t id = offset / ESP_LOG_INTERNED_NAME_LEN;
+    if (id >= ESP_LOG_INTERNED_MAX_TAGS) {
+        return false;
+    }
+    uint8_t level_for_tag = __atomic_load_n(&esp_log_interned_levels[id], __ATOMIC_RELAXED);
+    *level = (level_for_tag == ESP_LOG_INTERNED_LEVEL_UNSET) ? esp_log_get_default_level() : (esp_log_level_t) level_for_tag;
+    return true;
+}
+
+/**
+ * @brief Set the log level for all interned tags with the given name.
+ *
+ * The tag is compared by string, so it does not need to be interned itself.
+ * The same name can be interned in several files, each of them has its own ID.
+ *
+ * @param tag   The log tag for which to set the log level.
+ * @param level The log level to be set.
+ */
+void esp_log_interned_set_level(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Reset the log level of all interned tags, they follow the default level again.
+ *
+ * Used for the wildcard tag "*".
+ */
+void esp_log_interned_reset_all(void);
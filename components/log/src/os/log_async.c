@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_memory_utils.h"
+#include "esp_private/log_async.h"
+#include "sdkconfig.h"
+
+static TaskHandle_t s_task_handle;
+static void (*s_task)(void);
+
+static void log_async_task(void *arg)
+{
+    s_task();
+}
+
+bool esp_log_async_impl_start(void (*task)(void))
+{
+    s_task = task;
+    return xTaskCreate(log_async_task, "log", CONFIG_LOG_ASYNC_TASK_STACK_SIZE, NULL,
+                       CONFIG_LOG_ASYNC_TASK_PRIORITY, &s_task_handle) == pdPASS;
+}
+
+void esp_log_async_impl_wait(void)
+{
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+void esp_log_async_impl_notify(void)
+{
+    xTaskNotifyGive(s_task_handle);
+}
+
+void esp_log_async_impl_yield(void)
+{
+    /* Lets the log task run even if it has a lower priority */
+    vTaskDelay(1);
+}
+
+int esp_log_async_impl_core_id(void)
+{
+    return esp_cpu_get_core_id();
+}
+
+bool esp_log_async_impl_is_constant(const void *ptr)
+{
+    return esp_ptr_in_drom(ptr);
+}
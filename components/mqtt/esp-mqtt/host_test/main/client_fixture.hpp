@@ -0,0 +1,189 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "mqtt_client.h"
+#include "mqtt_msg.h"
+extern "C" {
+#include "Mockesp_event.h"
+#include "Mockesp_mac.h"
+#include "Mockesp_transport.h"
+#include "Mockesp_transport_ssl.h"
+#include "Mockesp_transport_tcp.h"
+#include "Mockesp_transport_ws.h"
+#include "Mockevent_groups.h"
+#include "Mockhttp_parser.h"
+#include "Mockqueue.h"
+#include "Mocktask.h"
+#if __has_include ("Mockidf_additions.h")
+/* Some functions were moved from "task.h" to "idf_additions.h" */
+#include "Mockidf_additions.h"
+#endif
+#include "Mockesp_timer.h"
+}
+
+/* A named deleter rather than a lambda, the alias is used by several translation units */
+struct mqtt_client_deleter {
+    void operator()(esp_mqtt_client_handle_t client) const
+    {
+        esp_mqtt_client_destroy(client);
+    }
+};
+
+using unique_mqtt_client = std::unique_ptr<std::remove_pointer_t<esp_mqtt_client_handle_t>, mqtt_client_deleter>;
+
+/* Mocks of the functions called by esp_mqtt_client_init() and esp_mqtt_client_destroy() */
+inline void mock_client_init()
+{
+    static int mtx, transport_list, transport, event_group;
+    static uint8_t mac[] = {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55};
+    esp_timer_get_time_IgnoreAndReturn(0);
+    xQueueTakeMutexRecursive_IgnoreAndReturn(true);
+    xQueueGiveMutexRecursive_IgnoreAndReturn(true);
+    xQueueCreateMutex_ExpectAnyArgsAndReturn(reinterpret_cast<QueueHandle_t>(&mtx));
+    xEventGroupCreate_IgnoreAndReturn(reinterpret_cast<EventGroupHandle_t>(&event_group));
+    esp_transport_list_init_IgnoreAndReturn(reinterpret_cast<esp_transport_list_handle_t>(&transport_list));
+    esp_transport_tcp_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ssl_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ws_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ws_set_subprotocol_IgnoreAndReturn(ESP_OK);
+    esp_transport_list_add_IgnoreAndReturn(ESP_OK);
+    esp_transport_set_default_port_IgnoreAndReturn(ESP_OK);
+    http_parser_url_init_Ignore();
+    esp_event_loop_create_IgnoreAndReturn(ESP_OK);
+    esp_read_mac_IgnoreAndReturn(ESP_OK);
+    esp_read_mac_ReturnThruPtr_mac(mac);
+    esp_transport_list_destroy_IgnoreAndReturn(ESP_OK);
+    esp_transport_destroy_IgnoreAndReturn(ESP_OK);
+    vEventGroupDelete_Ignore();
+    vQueueDelete_Ignore();
+}
+
+/* Expects the minimal URI to be parsed, call before esp_mqtt_client_init() */
+inline void mock_parse_uri(esp_mqtt_client_config_t &config)
+{
+    config.broker.address.uri = "mqtt://1.1.1.1";
+    static struct http_parser_url ret_uri = {
+        .field_set = 1 | (1 << 1),
+        .port = 0,
+        .field_data = { { 0, 4 } /*mqtt*/, { 7, 1 } } // at least *scheme* and *host*
+    };
+    http_parser_parse_url_ExpectAnyArgsAndReturn(0);
+    http_parser_parse_url_ReturnThruPtr_u(&ret_uri);
+}
+
+/* Client initialized with the mocks, config gets the minimal URI */
+inline unique_mqtt_client init_client(esp_mqtt_client_config_t &config)
+{
+    mock_client_init();
+    mock_parse_uri(config);
+    auto client = unique_mqtt_client{esp_mqtt_client_init(&config)};
+    REQUIRE(client != nullptr);
+    return client;
+}
+
+/* Packet written by the client */
+struct mqtt_packet {
+    size_t size;
+    int type;
+    int qos;
+    int msg_id;
+    std::string topic;
+    std::string payload;
+};
+
+/* Broker parsing the packets written by the client, and sending its stream of packets to the client */
+struct mock_broker {
+    int writes = 0;
+    size_t bytes = 0;
+    bool fail = false;
+    std::string written;                // start of a packet not completely written yet
+    std::vector<mqtt_packet> publishes;
+    std::vector<mqtt_packet> others;    // other packets, with the message id of acknowledgements
+
+    esp_mqtt_client_handle_t client = nullptr;
+    std::string stream;
+    size_t read = 0;
+
+    void receive(const char *buffer, int len)
+    {
+        writes++;
+        bytes += len;
+        written.append(buffer, len);
+        while (written.size() >= 2) {
+            size_t remaining = 0, pos = 1;
+            for (int shift = 0; pos < written.size(); shift += 7) {
+                remaining |= (size_t)(written[pos] & 0x7f) << shift;
+                if ((written[pos++] & 0x80) == 0) {
+                    break;
+                }
+            }
+            if (written.size() < pos + remaining) {
+                return;
+            }
+            std::string body = written.substr(pos, remaining);
+            mqtt_packet packet{pos + remaining, (uint8_t) written[0] >> 4, (written[0] >> 1) & 3, 0, {}, {}};
+            written.erase(0, pos + remaining);
+            if (packet.type != MQTT_MSG_TYPE_PUBLISH) {
+                if (packet.type >= MQTT_MSG_TYPE_PUBACK && packet.type <= MQTT_MSG_TYPE_PUBCOMP) {
+                    packet.msg_id = ((uint8_t) body[0] << 8) | (uint8_t) body[1];
+                }
+                others.push_back(packet);
+                continue;
+            }
+            size_t topic_len = ((uint8_t) body[0] << 8) | (uint8_t) body[1];
+            packet.topic = body.substr(2, topic_len);
+            pos = 2 + topic_len;
+            if (packet.qos > 0) {
+                packet.msg_id = ((uint8_t) body[pos] << 8) | (uint8_t) body[pos + 1];
+                pos += 2;
+            }
+            packet.payload = body.substr(pos);
+            publishes.push_back(packet);
+        }
+    }
+};
+
+inline mock_broker *broker;
+
+inline int broker_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms, int cmock_num_calls)
+{
+    if (broker->fail) {
+        return -1;
+    }
+    broker->receive(buffer, len);
+    return len;
+}
+
+/* PUBLISH packet sent by the broker */
+inline std::string publish_packet(const std::string &topic, const std::string &data, int qos = 0, int msg_id = 0)
+{
+    std::string body;
+    body += (char)(topic.size() >> 8);
+    body += (char) topic.size();
+    body += topic;
+    if (qos > 0) {
+        body += (char)(msg_id >> 8);
+        body += (char) msg_id;
+    }
+    body += data;
+    std::string packet(1, (char)(0x30 | qos << 1));
+    size_t len = body.size();
+    do {
+        packet += (char)((len & 0x7f) | (len > 0x7f ? 0x80 : 0));
+        len >>= 7;
+    } while (len);
+    return packet + body;
+}
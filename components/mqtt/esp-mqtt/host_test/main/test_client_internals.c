@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Access to the internals of the client for the tests, the private header of the client is C only
+ */
+#include "mqtt_client_priv.h"
+
+void test_client_set_connected(esp_mqtt_client_handle_t client, esp_transport_handle_t transport)
+{
+    client->transport = transport;
+    client->state = MQTT_STATE_CONNECTED;
+}
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "client_fixture.hpp"
+
+namespace {
+
+struct received_message {
+    std::string topic;
+    std::string data;
+    int msg_id;
+    int qos;
+    int parts;
+};
+
+/* Broker sending its stream of packets to the client, with the messages received by the client */
+struct sending_broker : mock_broker {
+    std::vector<received_message> messages;
+    int posted_events = 0;
+
+    void receive_data(esp_mqtt_event_handle_t event)
+    {
+        REQUIRE(event->event_id == MQTT_EVENT_DATA);
+        if (event->current_data_offset == 0) {
+            messages.push_back({std::string(event->topic, event->topic_len), {}, event->msg_id, event->qos, 0});
+        }
+        auto &message = messages.back();
+        REQUIRE(event->current_data_offset == (int) message.data.size());
+        REQUIRE(event->total_data_len >= event->current_data_offset + event->data_len);
+        message.data.append(event->data ? event->data : "", event->data_len);
+        message.parts++;
+    }
+};
+
+sending_broker *sender;
+TaskFunction_t mqtt_task;
+
+BaseType_t create_task(TaskFunction_t task, const char *name, const uint32_t stack, void *params, UBaseType_t prio,
+                       TaskHandle_t *handle, const BaseType_t core, int cmock_num_calls)
+{
+    mqtt_task = task;
+    return pdTRUE;
+}
+
+int broker_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms, int cmock_num_calls)
+{
+    if (sender->read == sender->stream.size()) {
+        /* Everything sent, the task ends after this read */
+        esp_mqtt_client_stop(sender->client);
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    len = std::min((size_t) len, sender->stream.size() - sender->read);
+    memcpy(buffer, sender->stream.data() + sender->read, len);
+    sender->read += len;
+    return len;
+}
+
+/* Copies the event to the loop and runs the handler, as esp_event does */
+esp_err_t post_event(esp_event_loop_handle_t loop, esp_event_base_t base, int32_t id, const void *data, size_t size,
+                     TickType_t ticks, int cmock_num_calls)
+{
+    sender->posted_events++;
+    if (id != MQTT_EVENT_DATA) {
+        return ESP_OK;
+    }
+    void *copy = malloc(size);
+    REQUIRE(copy != nullptr);
+    memcpy(copy, data, size);
+    sender->receive_data((esp_mqtt_event_handle_t) copy);
+    free(copy);
+    return ESP_OK;
+}
+
+void sink(void *sink_arg, esp_mqtt_event_handle_t event)
+{
+    static_cast<sending_broker *>(sink_arg)->receive_data(event);
+}
+
+std::string blob(size_t len, int seed)
+{
+    std::mt19937 random(seed);
+    std::string data(len, 0);
+    for (char &c : data) {
+        c = (char) random();
+    }
+    return data;
+}
+
+/* Runs the MQTT task until the client received everything the broker sent */
+void receive(sending_broker &mock, bool use_sink)
+{
+    static int transport, task;
+    xEventGroupClearBits_IgnoreAndReturn(0);
+    xEventGroupSetBits_IgnoreAndReturn(0);
+    xEventGroupWaitBits_IgnoreAndReturn(0);
+    esp_transport_list_get_transport_IgnoreAndReturn(nullptr);
+    esp_transport_connect_IgnoreAndReturn(0);
+    esp_transport_poll_read_IgnoreAndReturn(1);
+    esp_transport_close_IgnoreAndReturn(0);
+    esp_event_loop_run_IgnoreAndReturn(ESP_OK);
+    xTaskGetCurrentTaskHandle_IgnoreAndReturn(reinterpret_cast<TaskHandle_t>(&task));
+    vTaskDelete_Ignore();
+
+    esp_mqtt_client_config_t config{};
+    config.network.transport = reinterpret_cast<esp_transport_handle_t>(&transport);
+    auto client = init_client(config);
+    if (use_sink) {
+        REQUIRE(esp_mqtt_client_register_data_sink(client.get(), sink, &mock) == ESP_OK);
+    }
+
+    broker = sender = &mock;
+    mock.client = client.get();
+    mock.stream.insert(0, "\x20\x02\x00\x00", 4); // CONNACK
+    esp_transport_read_Stub(broker_read);
+    esp_transport_write_Stub(broker_write);
+    esp_event_post_to_Stub(post_event);
+    xTaskCreatePinnedToCore_Stub(create_task);
+    REQUIRE(esp_mqtt_client_start(client.get()) == ESP_OK);
+    mqtt_task(client.get());
+    REQUIRE(mock.read == mock.stream.size());
+}
+
+} // namespace
+
+TEST_CASE("data sink receives the data of published messages", "[client][sink]")
+{
+    /* A message much longer than the receive buffer between short ones */
+    const std::string config = blob(200 * 1024, 1);
+    std::string stream = publish_packet("config/blob", config, 0) +
+                         publish_packet("sensors/sample", "short", 1, 7) +
+                         publish_packet("empty", "", 0);
+
+    sending_broker events;
+    events.stream = stream;
+    receive(events, false);
+    sending_broker sunk;
+    sunk.stream = stream;
+    receive(sunk, true);
+
+    REQUIRE(sunk.messages.size() == 3);
+    CHECK(sunk.messages[0].topic == "config/blob");
+    CHECK(sunk.messages[0].data == config);
+    CHECK(sunk.messages[0].parts > 1);
+    CHECK(sunk.messages[1].topic == "sensors/sample");
+    CHECK(sunk.messages[1].data == "short");
+    CHECK(sunk.messages[1].qos == 1);
+    CHECK(sunk.messages[1].msg_id == 7);
+    CHECK(sunk.messages[2].topic == "empty");
+    CHECK(sunk.messages[2].data.empty());
+    /* The same data as with MQTT_EVENT_DATA events, none of which was posted */
+    REQUIRE(events.messages.size() == 3);
+    for (int i = 0; i < 3; i++) {
+        CHECK(events.messages[i].data == sunk.messages[i].data);
+        CHECK(events.messages[i].parts == sunk.messages[i].parts);
+    }
+    CHECK(sunk.posted_events == events.posted_events - events.messages[0].parts - 2);
+    /* Acknowledged as usual */
+    CHECK(std::any_of(sunk.others.begin(), sunk.others.end(), [](const mqtt_packet & packet) {
+        return packet.type == MQTT_MSG_TYPE_PUBACK && packet.msg_id == 7;
+    }));
+}
+
+TEST_CASE("data sink benchmark", "[client][sink][bench]")
+{
+    const int MESSAGES = 20;
+    const std::string config = blob(200 * 1024, 1);
+    std::string stream;
+    for (int i = 0; i < MESSAGES; i++) {
+        stream += publish_packet("config/blob", config, 1, i + 1);
+    }
+
+    for (bool use_sink : {false, true}) {
+        sending_broker mock;
+        mock.stream = stream;
+        auto start = std::chrono::steady_clock::now();
+        receive(mock, use_sink);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(mock.messages.size() == MESSAGES);
+        printf("%-10s %d messages of %zu bytes in %d parts: %lld us, %.1f MB/s, %d events posted\n",
+               use_sink ? "data sink" : "events", MESSAGES, config.size(), mock.messages[0].parts, (long long) elapsed,
+               (double) stream.size() / (elapsed ? elapsed : 1), mock.posted_events);
+    }
+}
@@ -11,24 +11,8 @@
 #include "esp_transport.h"
 #include <catch2/catch_test_macros.hpp>
 
-#include "mqtt_client.h"
+#include "client_fixture.hpp"
 extern "C" {
-#include "Mockesp_event.h"
-#include "Mockesp_mac.h"
-#include "Mockesp_transport.h"
-#include "Mockesp_transport_ssl.h"
-#include "Mockesp_transport_tcp.h"
-#include "Mockesp_transport_ws.h"
-#include "Mockevent_groups.h"
-#include "Mockhttp_parser.h"
-#include "Mockqueue.h"
-#include "Mocktask.h"
-#if __has_include ("Mockidf_additions.h")
-/* Some functions were moved from "task.h" to "idf_additions.h" */
-#include "Mockidf_additions.h"
-#endif
-#include "Mockesp_timer.h"
-
     /*
      * The following functions are not directly called but the generation of them
      * from cmock is broken, so we need to define them here.
@@ -48,50 +32,13 @@ auto random_string(std::size_t n)
     return str;
 }
 
-using unique_mqtt_client = std::unique_ptr < std::remove_pointer_t<esp_mqtt_client_handle_t>, decltype([](esp_mqtt_client_handle_t client)
-{
-    esp_mqtt_client_destroy(client);
-}) >;
-
 SCENARIO("MQTT Client Operation")
 {
     // Set expectations for the mocked calls.
-    int mtx = 0;
-    int transport_list = 0;
-    int transport = 0;
-    int event_group = 0;
-    uint8_t mac[] = {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55};
-    esp_timer_get_time_IgnoreAndReturn(0);
-    xQueueTakeMutexRecursive_IgnoreAndReturn(true);
-    xQueueGiveMutexRecursive_IgnoreAndReturn(true);
-    xQueueCreateMutex_ExpectAnyArgsAndReturn(
-        reinterpret_cast<QueueHandle_t>(&mtx));
-    xEventGroupCreate_IgnoreAndReturn(reinterpret_cast<EventGroupHandle_t>(&event_group));
-    esp_transport_list_init_IgnoreAndReturn(reinterpret_cast<esp_transport_list_handle_t>(&transport_list));
-    esp_transport_tcp_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
-    esp_transport_ssl_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
-    esp_transport_ws_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
-    esp_transport_ws_set_subprotocol_IgnoreAndReturn(ESP_OK);
-    esp_transport_list_add_IgnoreAndReturn(ESP_OK);
-    esp_transport_set_default_port_IgnoreAndReturn(ESP_OK);
-    http_parser_url_init_Ignore();
-    esp_event_loop_create_IgnoreAndReturn(ESP_OK);
-    esp_read_mac_IgnoreAndReturn(ESP_OK);
-    esp_read_mac_ReturnThruPtr_mac(mac);
-    esp_transport_list_destroy_IgnoreAndReturn(ESP_OK);
-    esp_transport_destroy_IgnoreAndReturn(ESP_OK);
-    vEventGroupDelete_Ignore();
-    vQueueDelete_Ignore();
+    mock_client_init();
     GIVEN("An a minimal config") {
         esp_mqtt_client_config_t config{};
-        config.broker.address.uri = "mqtt://1.1.1.1";
-        struct http_parser_url ret_uri = {
-            .field_set = 1 | (1 << 1),
-            .port = 0,
-            .field_data = { { 0, 4 } /*mqtt*/, { 7, 1 } } // at least *scheme* and *host*
-        };
-        http_parser_parse_url_ExpectAnyArgsAndReturn(0);
-        http_parser_parse_url_ReturnThruPtr_u(&ret_uri);
+        mock_parse_uri(config);
         xTaskCreatePinnedToCore_ExpectAnyArgsAndReturn(pdTRUE);
         SECTION("Client with minimal config") {
             auto client = unique_mqtt_client{esp_mqtt_client_init(&config)};
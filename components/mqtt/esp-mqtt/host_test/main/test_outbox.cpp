@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "mqtt_config.h"
+#include "mqtt_msg.h"
+#include "mqtt_outbox.h"
+
+namespace {
+
+using unique_outbox = std::unique_ptr < std::remove_pointer_t<outbox_handle_t>, decltype([](outbox_handle_t outbox)
+{
+    outbox_destroy(outbox);
+}) >;
+
+outbox_item_handle_t enqueue(outbox_handle_t outbox, int msg_id, const std::string &data, outbox_tick_t tick = 0,
+                             int msg_type = MQTT_MSG_TYPE_PUBLISH)
+{
+    outbox_message_t message = {};
+    message.data = (uint8_t *) data.data();
+    message.len = data.size() / 2;
+    message.remaining_data = (uint8_t *) data.data() + message.len;
+    message.remaining_len = data.size() - message.len;
+    message.msg_id = msg_id;
+    message.msg_type = msg_type;
+    message.msg_qos = 1;
+    return outbox_enqueue(outbox, &message, tick);
+}
+
+std::string data_of(outbox_item_handle_t item)
+{
+    size_t len;
+    uint16_t msg_id;
+    int msg_type, qos;
+    uint8_t *data = outbox_item_get_data(item, &len, &msg_id, &msg_type, &qos);
+    return std::string((char *) data, len);
+}
+
+std::string message(int msg_id, size_t len)
+{
+    std::string data(len, 'a' + msg_id % 26);
+    data[0] = (char) msg_id;
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("outbox finds messages by id", "[outbox]")
+{
+    auto outbox = unique_outbox{outbox_init()};
+    REQUIRE(outbox != nullptr);
+    for (int msg_id = 1; msg_id <= 100; msg_id++) {
+        REQUIRE(enqueue(outbox.get(), msg_id, message(msg_id, 20)) != nullptr);
+    }
+    /* A reused id, and a PUBREL sharing the id of its PUBLISH */
+    auto reused = enqueue(outbox.get(), 7, "reused");
+    REQUIRE(enqueue(outbox.get(), 50, "pubrel", 0, MQTT_MSG_TYPE_PUBREL) != nullptr);
+    CHECK(outbox_get_size(outbox.get()) == 100 * 20 + 12);
+
+    for (int msg_id = 1; msg_id <= 100; msg_id++) {
+        CHECK(data_of(outbox_get(outbox.get(), msg_id)) == message(msg_id, 20));
+    }
+    CHECK(outbox_get(outbox.get(), 101) == nullptr);
+
+    CHECK(outbox_delete(outbox.get(), 7, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+    CHECK(outbox_get(outbox.get(), 7) == reused);
+    CHECK(outbox_delete(outbox.get(), 50, MQTT_MSG_TYPE_PUBREL) == ESP_OK);
+    CHECK(outbox_delete(outbox.get(), 50, MQTT_MSG_TYPE_PUBREL) == ESP_FAIL);
+    CHECK(data_of(outbox_get(outbox.get(), 50)) == message(50, 20));
+    CHECK(outbox_delete_item(outbox.get(), reused) == ESP_OK);
+    CHECK(outbox_get(outbox.get(), 7) == nullptr);
+
+    /* Dequeued in the order enqueued */
+    CHECK(outbox_set_pending(outbox.get(), 1, TRANSMITTED) == ESP_OK);
+    CHECK(outbox_set_pending(outbox.get(), 3, TRANSMITTED) == ESP_OK);
+    CHECK(outbox_set_pending(outbox.get(), 7, TRANSMITTED) == ESP_FAIL);
+    CHECK(outbox_dequeue(outbox.get(), QUEUED, nullptr) == outbox_get(outbox.get(), 2));
+    CHECK(outbox_dequeue(outbox.get(), TRANSMITTED, nullptr) == outbox_get(outbox.get(), 1));
+    CHECK(outbox_dequeue(outbox.get(), ACKNOWLEDGED, nullptr) == nullptr);
+    CHECK(outbox_item_get_pending(outbox_get(outbox.get(), 3)) == TRANSMITTED);
+
+    outbox_delete_all_items(outbox.get());
+    CHECK(outbox_get_size(outbox.get()) == 0);
+    CHECK(outbox_get(outbox.get(), 1) == nullptr);
+    CHECK(outbox_dequeue(outbox.get(), TRANSMITTED, nullptr) == nullptr);
+
+    /* Usable after being emptied */
+    REQUIRE(enqueue(outbox.get(), 1, "again") != nullptr);
+    CHECK(data_of(outbox_get(outbox.get(), 1)) == "again");
+}
+
+TEST_CASE("outbox expires messages by tick", "[outbox]")
+{
+    auto outbox = unique_outbox{outbox_init()};
+    REQUIRE(outbox != nullptr);
+    for (int msg_id = 1; msg_id <= 5; msg_id++) {
+        REQUIRE(enqueue(outbox.get(), msg_id, "data", msg_id * 100) != nullptr);
+    }
+    /* Message 1 was retransmitted, message 6 enqueued with an older tick */
+    CHECK(outbox_set_tick(outbox.get(), 1, 1000) == ESP_OK);
+    REQUIRE(enqueue(outbox.get(), 6, "data", 150) != nullptr);
+
+    CHECK(outbox_delete_single_expired(outbox.get(), 350, 100) == 6);
+    CHECK(outbox_delete_single_expired(outbox.get(), 350, 100) == 2);
+    CHECK(outbox_delete_single_expired(outbox.get(), 350, 100) == -1);
+    CHECK(outbox_delete_expired(outbox.get(), 700, 100) == 3);
+    CHECK(outbox_get(outbox.get(), 1) != nullptr);
+    CHECK(outbox_delete_expired(outbox.get(), 2000, 100) == 1);
+    CHECK(outbox_get_size(outbox.get()) == 0);
+}
+
+TEST_CASE("outbox keeps data of messages deleted out of order", "[outbox]")
+{
+    auto outbox = unique_outbox{outbox_init()};
+    REQUIRE(outbox != nullptr);
+    std::mt19937 random(1);
+    std::vector<int> queued;
+    int next_id = 1;
+    for (int round = 0; round < 2000; round++) {
+        /* Sizes around the size of the ring, if one is configured */
+        size_t len = 1 + random() % (OUTBOX_RING_SIZE / 4 + 300);
+        if (queued.size() < 20 && random() % 2) {
+            REQUIRE(enqueue(outbox.get(), next_id, message(next_id, len)) != nullptr);
+            queued.push_back(next_id);
+            next_id = next_id % 65535 + 1;
+        } else if (!queued.empty()) {
+            auto acked = queued.begin() + random() % queued.size();
+            CHECK(outbox_delete(outbox.get(), *acked, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+            queued.erase(acked);
+        }
+        uint64_t size = 0;
+        for (int msg_id : queued) {
+            auto item = outbox_get(outbox.get(), msg_id);
+            REQUIRE(item != nullptr);
+            std::string data = data_of(item);
+            CHECK(data == message(msg_id, data.size()));
+            size += data.size();
+        }
+        CHECK(outbox_get_size(outbox.get()) == size);
+    }
+}
+
+TEST_CASE("outbox benchmark", "[outbox][bench]")
+{
+    const int OPERATIONS = 200000;
+    const std::string data(40, 'd');
+
+    for (int in_flight : {10, 100, 1000}) {
+        auto outbox = unique_outbox{outbox_init()};
+        REQUIRE(outbox != nullptr);
+        std::mt19937 random(1);
+        int rounds = OPERATIONS / in_flight;
+        std::vector<int> ids(in_flight);
+        long long enqueue_ns = 0, ack_ns = 0, expire_ns = 0;
+
+        for (int round = 0; round < rounds; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < in_flight; i++) {
+                ids[i] = (round * in_flight + i) % 65535 + 1;
+                enqueue(outbox.get(), ids[i], data, round);
+                outbox_set_pending(outbox.get(), ids[i], TRANSMITTED);
+            }
+            auto enqueued = std::chrono::steady_clock::now();
+            /* Half of the messages acked out of order, the rest expires */
+            std::shuffle(ids.begin(), ids.end(), random);
+            for (int i = 0; i < in_flight / 2; i++) {
+                outbox_delete(outbox.get(), ids[i], MQTT_MSG_TYPE_PUBLISH);
+            }
+            auto acked = std::chrono::steady_clock::now();
+            while (outbox_delete_single_expired(outbox.get(), round + 2, 1) >= 0) {
+            }
+            auto expired = std::chrono::steady_clock::now();
+            enqueue_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(enqueued - start).count();
+            ack_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(acked - enqueued).count();
+            expire_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(expired - acked).count();
+        }
+        int acks = rounds * (in_flight / 2);
+        int expires = rounds * in_flight - acks;
+        printf("%4d messages in flight: enqueue %lld ns, ack %lld ns, expire %lld ns per message\n", in_flight,
+               enqueue_ns / (rounds * in_flight), ack_ns / acks, expire_ns / expires);
+        CHECK(outbox_get_size(outbox.get()) == 0);
+    }
+}
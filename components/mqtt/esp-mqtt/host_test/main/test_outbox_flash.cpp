@@ -0,0 +1,249 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "esp_partition.h"
+#include "esp_private/partition_linux.h"
+#include "mqtt_config.h"
+#include "mqtt_msg.h"
+#include "mqtt_outbox.h"
+#include "mqtt_outbox_flash.h"
+
+#if MQTT_OUTBOX_PERSISTENT
+
+namespace {
+
+const char *PARTITION = "mqtt_outbox";
+
+using unique_outbox = std::unique_ptr < std::remove_pointer_t<outbox_handle_t>, decltype([](outbox_handle_t outbox)
+{
+    outbox_destroy(outbox);
+}) >;
+
+using unique_flash = std::unique_ptr < std::remove_pointer_t<outbox_flash_handle_t>, decltype([](outbox_flash_handle_t flash)
+{
+    outbox_flash_close(flash);
+}) >;
+
+void erase_partition()
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PARTITION);
+    REQUIRE(partition != nullptr);
+    REQUIRE(esp_partition_erase_range(partition, 0, partition->size) == ESP_OK);
+}
+
+outbox_item_handle_t enqueue(outbox_handle_t outbox, int msg_id, const std::string &data, int qos = 1,
+                             int msg_type = MQTT_MSG_TYPE_PUBLISH)
+{
+    outbox_message_t message = {};
+    message.data = (uint8_t *) data.data();
+    message.len = data.size() / 2;
+    message.remaining_data = (uint8_t *) data.data() + message.len;
+    message.remaining_len = data.size() - message.len;
+    message.msg_id = msg_id;
+    message.msg_type = msg_type;
+    message.msg_qos = qos;
+    return outbox_enqueue(outbox, &message, 0);
+}
+
+std::string data_of(outbox_item_handle_t item)
+{
+    size_t len;
+    uint16_t msg_id;
+    int msg_type, qos;
+    uint8_t *data = outbox_item_get_data(item, &len, &msg_id, &msg_type, &qos);
+    REQUIRE(data != nullptr);
+    return std::string((char *) data, len);
+}
+
+std::string message(int msg_id, size_t len)
+{
+    std::string data(len, 'a' + msg_id % 26);
+    data[0] = (char) msg_id;
+    return data;
+}
+
+/* Messages in the log by msg_id */
+std::map<int, std::string> messages_of(outbox_flash_handle_t flash)
+{
+    std::map<int, std::string> messages;
+    std::vector<uint8_t> data(outbox_flash_max_len(flash));
+    for (size_t i = 0; i < outbox_flash_count(flash); i++) {
+        outbox_flash_record_t record;
+        REQUIRE(outbox_flash_load(flash, i, &record, data.data()) == ESP_OK);
+        messages[record.msg_id] = std::string((char *) data.data(), record.len);
+    }
+    return messages;
+}
+
+esp_err_t append(outbox_flash_handle_t flash, int msg_id, const std::string &data, uint32_t *seq)
+{
+    outbox_flash_record_t record = {};
+    record.msg_id = msg_id;
+    record.msg_type = MQTT_MSG_TYPE_PUBLISH;
+    record.msg_qos = 1;
+    size_t len = data.size() / 2;
+    esp_err_t err = outbox_flash_append(flash, &record, (const uint8_t *) data.data(), len,
+                                        (const uint8_t *) data.data() + len, data.size() - len);
+    *seq = record.seq;
+    return err;
+}
+
+} // namespace
+
+TEST_CASE("persistent outbox restores unacknowledged messages", "[outbox][flash]")
+{
+    erase_partition();
+    {
+        auto outbox = unique_outbox{outbox_init()};
+        REQUIRE(outbox_restore(outbox.get(), PARTITION, 0) == ESP_OK);
+        CHECK(outbox_get_size(outbox.get()) == 0);
+        CHECK(outbox_get_last_msg_id(outbox.get()) == -1);
+        /* More data than kept in memory, later messages are read from flash */
+        for (int msg_id = 1; msg_id <= 20; msg_id++) {
+            REQUIRE(enqueue(outbox.get(), msg_id, message(msg_id, 500)) != nullptr);
+        }
+        REQUIRE(enqueue(outbox.get(), 21, "qos0", 0) != nullptr);
+        REQUIRE(enqueue(outbox.get(), 22, "pubrel", 1, MQTT_MSG_TYPE_PUBREL) != nullptr);
+        for (int msg_id = 1; msg_id <= 20; msg_id++) {
+            CHECK(data_of(outbox_get(outbox.get(), msg_id)) == message(msg_id, 500));
+        }
+        CHECK(outbox_delete(outbox.get(), 3, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+        CHECK(outbox_delete(outbox.get(), 15, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+        CHECK(outbox_delete_expired(outbox.get(), 1000, 100) == 20);
+        for (int msg_id = 1; msg_id <= 10; msg_id++) {
+            REQUIRE(enqueue(outbox.get(), msg_id + 100, message(msg_id + 100, 500)) != nullptr);
+        }
+        CHECK(outbox_delete(outbox.get(), 105, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+        CHECK(outbox_set_pending(outbox.get(), 101, TRANSMITTED) == ESP_OK);
+        /* A reset, messages not acknowledged stay */
+    }
+
+    for (int restart = 0; restart < 2; restart++) {
+        auto outbox = unique_outbox{outbox_init()};
+        REQUIRE(outbox_restore(outbox.get(), PARTITION, 5000) == ESP_OK);
+        CHECK(outbox_restore(outbox.get(), PARTITION, 5000) == ESP_OK);
+        CHECK(outbox_get_size(outbox.get()) == 9 * 500);
+        /* New message IDs continue after the restored ones */
+        CHECK(outbox_get_last_msg_id(outbox.get()) == 110);
+        for (int msg_id = 101; msg_id <= 110; msg_id++) {
+            auto item = outbox_get(outbox.get(), msg_id);
+            if (msg_id == 105) {
+                CHECK(item == nullptr);
+                continue;
+            }
+            REQUIRE(item != nullptr);
+            CHECK(data_of(item) == message(msg_id, 500));
+            CHECK(outbox_item_get_pending(item) == QUEUED);
+        }
+        CHECK(outbox_get(outbox.get(), 21) == nullptr);
+        CHECK(outbox_get(outbox.get(), 22) == nullptr);
+        /* Sent again in the order of publishing */
+        CHECK(outbox_dequeue(outbox.get(), QUEUED, nullptr) == outbox_get(outbox.get(), 101));
+        CHECK(outbox_delete_expired(outbox.get(), 5050, 100) == 0);
+
+        /* Stopping the client keeps the messages as well */
+        outbox_delete_all_items(outbox.get());
+        CHECK(outbox_get_size(outbox.get()) == 0);
+        REQUIRE(outbox_restore(outbox.get(), PARTITION, 5000) == ESP_OK);
+        CHECK(outbox_get_size(outbox.get()) == 9 * 500);
+    }
+}
+
+TEST_CASE("persistent outbox reuses flash of acknowledged messages", "[outbox][flash]")
+{
+    erase_partition();
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PARTITION);
+    const int MESSAGES = 2000;
+    std::mt19937 random(1);
+    esp_partition_clear_stats();
+    {
+        auto outbox = unique_outbox{outbox_init()};
+        REQUIRE(outbox_restore(outbox.get(), PARTITION, 0) == ESP_OK);
+        /* A message never acknowledged, moved along while sectors are reused */
+        REQUIRE(enqueue(outbox.get(), 1, message(1, 300)) != nullptr);
+        std::vector<int> queued;
+        for (int msg_id = 2; msg_id < MESSAGES; msg_id++) {
+            REQUIRE(enqueue(outbox.get(), msg_id, message(msg_id, 1 + random() % 600)) != nullptr);
+            queued.push_back(msg_id);
+            if (queued.size() > 8) {
+                auto acked = queued.begin() + random() % queued.size();
+                CHECK(outbox_delete(outbox.get(), *acked, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+                queued.erase(acked);
+            }
+        }
+        for (int msg_id : queued) {
+            CHECK(outbox_delete(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+        }
+    }
+    /* Sectors are erased as they fill up, leaving at most a record unused */
+    size_t sectors_written = esp_partition_get_write_bytes() / (partition->erase_size * 3 / 4);
+    CHECK(esp_partition_get_erase_ops() <= sectors_written + 2);
+
+    auto outbox = unique_outbox{outbox_init()};
+    REQUIRE(outbox_restore(outbox.get(), PARTITION, 0) == ESP_OK);
+    CHECK(outbox_get_size(outbox.get()) == 300);
+    CHECK(data_of(outbox_get(outbox.get(), 1)) == message(1, 300));
+}
+
+TEST_CASE("outbox log keeps messages when writing is interrupted", "[outbox][flash]")
+{
+    /* Power is lost after a growing number of words written or sectors erased,
+     * the log then has the messages from before or after the interrupted operation */
+    for (size_t cycles = 1;; cycles++) {
+        erase_partition();
+        std::map<int, std::string> before, after;
+        bool interrupted = false;
+        {
+            auto flash = unique_flash{outbox_flash_open(PARTITION)};
+            REQUIRE(flash != nullptr);
+            std::map<int, uint32_t> seqs;
+            std::mt19937 random(1);
+            esp_partition_fail_after(cycles, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+            /* Message 1 is never acknowledged, it is moved whenever sectors are reused */
+            for (int msg_id = 1; msg_id <= 250 && !interrupted; msg_id++) {
+                before = after;
+                if (after.size() < 8 && (after.empty() || random() % 3)) {
+                    size_t max_len = (random() % 4) ? 200 : outbox_flash_max_len(flash.get());
+                    after[msg_id] = message(msg_id, 1 + random() % max_len);
+                    esp_err_t err = append(flash.get(), msg_id, after[msg_id], &seqs[msg_id]);
+                    if (err == ESP_ERR_NO_MEM) {
+                        after.erase(msg_id);
+                    } else {
+                        interrupted = err != ESP_OK;
+                    }
+                } else if (after.size() > 1) {
+                    auto acked = std::next(after.begin(), 1 + random() % (after.size() - 1));
+                    interrupted = outbox_flash_remove(flash.get(), seqs[acked->first]) != ESP_OK;
+                    after.erase(acked);
+                }
+            }
+            esp_partition_fail_after(SIZE_MAX, 0);
+        }
+        auto flash = unique_flash{outbox_flash_open(PARTITION)};
+        REQUIRE(flash != nullptr);
+        auto messages = messages_of(flash.get());
+        CHECK((messages == before || messages == after));
+        if (!interrupted) {
+            break;
+        }
+        /* The log is usable after the interruption */
+        uint32_t seq;
+        REQUIRE(append(flash.get(), 1000, "again", &seq) == ESP_OK);
+        flash.reset(outbox_flash_open(PARTITION));
+        REQUIRE(flash != nullptr);
+        CHECK(messages_of(flash.get())[1000] == "again");
+    }
+}
+
+#endif
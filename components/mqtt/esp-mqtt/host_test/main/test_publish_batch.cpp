@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "client_fixture.hpp"
+#include "mqtt_config.h"
+extern "C" {
+    void test_client_set_connected(esp_mqtt_client_handle_t client, esp_transport_handle_t transport);
+}
+
+namespace {
+
+std::string payload(int i, size_t len = 40)
+{
+    std::string data = "sample " + std::to_string(i) + " ";
+    data.resize(len, 'x');
+    return data;
+}
+
+/* Client connected to the mock broker */
+unique_mqtt_client connected_client(mock_broker &mock)
+{
+    static int transport;
+    /* Disconnection after a failed write */
+    esp_transport_close_IgnoreAndReturn(0);
+    esp_transport_get_error_handle_IgnoreAndReturn(nullptr);
+    esp_transport_get_errno_IgnoreAndReturn(0);
+    esp_event_post_to_IgnoreAndReturn(ESP_OK);
+    esp_event_loop_run_IgnoreAndReturn(ESP_OK);
+
+    esp_mqtt_client_config_t config{};
+    auto client = init_client(config);
+
+    broker = &mock;
+    esp_transport_write_Stub(broker_write);
+    test_client_set_connected(client.get(), reinterpret_cast<esp_transport_handle_t>(&transport));
+    return client;
+}
+
+} // namespace
+
+TEST_CASE("batched publish writes messages together", "[client][batch]")
+{
+    mock_broker mock;
+    auto client = connected_client(mock);
+    const int COUNT = 60;
+    std::vector<std::string> payloads;
+    std::vector<esp_mqtt_publish_t> messages;
+    for (int i = 0; i < COUNT; i++) {
+        /* A message larger than the buffer in between, written in fragments */
+        payloads.push_back(payload(i, i == 31 ? 3000 : 40));
+    }
+    for (int i = 0; i < COUNT; i++) {
+        messages.push_back({"sensors/sample", payloads[i].data(), (int) payloads[i].size(), i % 3 == 0 ? 0 : 1, 0});
+    }
+    std::vector<int> msg_ids(COUNT);
+    REQUIRE(esp_mqtt_client_publish_batch(client.get(), messages.data(), COUNT, msg_ids.data()) == COUNT);
+
+    /* The messages arrive in order, with the ids returned */
+    REQUIRE(mock.publishes.size() == COUNT);
+    CHECK(mock.written.empty());
+    CHECK(mock.others.empty());
+    size_t outbox_size = 0;
+    for (int i = 0; i < COUNT; i++) {
+        CHECK(mock.publishes[i].topic == "sensors/sample");
+        CHECK(mock.publishes[i].payload == payloads[i]);
+        CHECK(mock.publishes[i].qos == messages[i].qos);
+        CHECK(mock.publishes[i].msg_id == msg_ids[i]);
+        if (messages[i].qos > 0) {
+            CHECK(msg_ids[i] > 0);
+            outbox_size += mock.publishes[i].size;
+        }
+    }
+    /* Messages with QoS>0 stay in the outbox until acknowledged */
+    CHECK(esp_mqtt_client_get_outbox_size(client.get()) == (int) outbox_size);
+    /* The small messages fill the buffer before being written, the large one takes
+     * one write for the messages before it and three for its fragments */
+    CHECK(mock.writes <= (int) mock.bytes / 1024 + 5);
+
+    /* Messages published on their own are written on their own */
+    int writes = mock.writes;
+    REQUIRE(esp_mqtt_client_publish(client.get(), "sensors/sample", "single", 0, 1, 0) > 0);
+    CHECK(mock.writes == writes + (MQTT_PUBLISH_COALESCE_MS > 0 ? 0 : 1));
+}
+
+TEST_CASE("batched publish keeps messages in the outbox if writing fails", "[client][batch]")
+{
+    mock_broker mock;
+    auto client = connected_client(mock);
+    std::vector<std::string> payloads;
+    std::vector<esp_mqtt_publish_t> messages;
+    for (int i = 0; i < 10; i++) {
+        payloads.push_back(payload(i));
+    }
+    for (int i = 0; i < 10; i++) {
+        messages.push_back({"sensors/sample", payloads[i].data(), 0, 1, 0});
+    }
+    mock.fail = true;
+    std::vector<int> msg_ids(10);
+    CHECK(esp_mqtt_client_publish_batch(client.get(), messages.data(), 10, msg_ids.data()) == -1);
+    CHECK(mock.writes == 0);
+    for (int msg_id : msg_ids) {
+        CHECK(msg_id > 0);
+    }
+    CHECK(esp_mqtt_client_get_outbox_size(client.get()) == 10 * (40 + 4 + 16));
+
+    /* Not connected anymore, QoS 1 messages are queued for the reconnection, QoS 0 ones fail */
+    messages[5].qos = 0;
+    CHECK(esp_mqtt_client_publish_batch(client.get(), messages.data(), 10, msg_ids.data()) == 5);
+    CHECK(msg_ids[5] == -1);
+    CHECK(esp_mqtt_client_get_outbox_size(client.get()) == 15 * (40 + 4 + 16));
+    CHECK(mock.writes == 0);
+}
+
+TEST_CASE("batched publish benchmark", "[client][batch][bench]")
+{
+    const int MESSAGES = 64 * 320;
+    /* Estimated overhead of each write: a TLS record (header, nonce and tag of AES-GCM)
+     * and TCP/IP headers of a segment */
+    const int WRITE_OVERHEAD = 5 + 8 + 16 + 40;
+    std::vector<std::string> payloads;
+    for (int i = 0; i < MESSAGES; i++) {
+        payloads.push_back(payload(i));
+    }
+
+    for (int batch : {1, 4, 16, 64}) {
+        mock_broker mock;
+        auto client = connected_client(mock);
+        std::vector<esp_mqtt_publish_t> messages(batch);
+        auto start = std::chrono::steady_clock::now();
+        /* A batch of one message is written as by esp_mqtt_client_publish() without coalescing */
+        for (int i = 0; i < MESSAGES; i += batch) {
+            for (int j = 0; j < batch; j++) {
+                messages[j] = {"sensors/sample", payloads[i + j].data(), (int) payloads[i + j].size(), 0, 0};
+            }
+            esp_mqtt_client_publish_batch(client.get(), messages.data(), batch, nullptr);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(mock.publishes.size() == MESSAGES);
+        printf("%2d messages per batch: %7lld messages/s, %5d writes, %7zu bytes, ~%7zu bytes on the wire\n", batch,
+               MESSAGES * 1000000LL / (elapsed ? elapsed : 1), mock.writes, mock.bytes, mock.bytes + (size_t) mock.writes * WRITE_OVERHEAD);
+    }
+}
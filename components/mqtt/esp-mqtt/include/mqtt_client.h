@@ -81,7 +81,8 @@ typedef enum esp_mqtt_event_id_t {
     MQTT_EVENT_DELETED,        /*!< Notification on delete of one message from the
                                 internal outbox,        if the message couldn't have been sent
                                 or acknowledged before expiring        defined in
-                                OUTBOX_EXPIRED_TIMEOUT_MS.        (events are not posted upon
+                                OUTBOX_EXPIRED_TIMEOUT_MS, or if it couldn't be read
+                                from the outbox partition.        (events are not posted upon
                                 deletion of successfully acknowledged messages)
                                   - This event id is posted only if
                                 MQTT_REPORT_DELETED_MESSAGES==1
@@ -224,6 +225,15 @@ typedef struct esp_mqtt_event_t {
 
 typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
 
+/**
+ * @brief Receives the data of published messages in place of MQTT_EVENT_DATA events
+ *
+ * Called from the *MQTT* task for every part of the data as it is read from the
+ * transport, `event` has the same content as the MQTT_EVENT_DATA event would have.
+ * `data` points to the receive buffer of the client, it's valid only during the call.
+ */
+typedef void (*esp_mqtt_data_sink_t)(void *sink_arg, esp_mqtt_event_handle_t event);
+
 /**
  * *MQTT* client configuration structure
  *
@@ -375,6 +385,9 @@ typedef struct esp_mqtt_client_config_t {
      */
     struct outbox_config_t {
         uint64_t limit; /*!< Size limit for the outbox in bytes.*/
+        const char *partition_label; /*!< Label of a data partition keeping QoS 1 and QoS 2 messages until they
+                                          are acknowledged, also across restarts. Requires
+                                          CONFIG_MQTT_OUTBOX_PERSISTENT */
     } outbox; /*!< Outbox configuration. */
 } esp_mqtt_client_config_t;
 
@@ -386,6 +399,17 @@ typedef struct topic_t {
     int qos; /*!< Max QoS level of the subscription */
 } esp_mqtt_topic_t;
 
+/**
+ * Publish message struct
+ */
+typedef struct publish_t {
+    const char *topic; /*!< Topic of the message */
+    const char *data;  /*!< Payload of the message, NULL for an empty payload */
+    int len;           /*!< Length of the payload, if set to 0, length is calculated from payload string */
+    int qos;           /*!< QoS of the message */
+    int retain;        /*!< Retain flag of the message */
+} esp_mqtt_publish_t;
+
 /**
  * @brief Creates *MQTT* client handle based on the configuration
  *
@@ -568,6 +592,33 @@ int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client,
 int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic,
                             const char *data, int len, int qos, int retain);
 
+/**
+ * @brief Client to send several publish messages to the broker in as few
+ * transport writes as possible
+ *
+ * Notes:
+ * - The messages are built one after the other as by esp_mqtt_client_publish()
+ *   and written to the transport together, messages which don't fit the
+ *   internal buffer are written on their own. The message ids and the outbox
+ *   handling of the messages are the same as for esp_mqtt_client_publish().
+ * - Publishing stops at the first message which fails, the messages before it
+ *   are still written.
+ * - It is thread safe, please refer to `esp_mqtt_client_subscribe` for details
+ *
+ * @param client    *MQTT* client handle
+ * @param messages  messages to publish
+ * @param count     number of messages
+ * @param msg_ids   if not NULL, receives what esp_mqtt_client_publish() would
+ * return for each of the messages published, and -1 or -2 for the one which failed
+ *
+ * @return number of messages published, which is less than count if publishing
+ * a message failed. -1 if the client is not initialized or writing the messages
+ * failed, messages with QoS>0 are then retransmitted from the outbox.
+ */
+int esp_mqtt_client_publish_batch(esp_mqtt_client_handle_t client,
+                                  const esp_mqtt_publish_t *messages, int count,
+                                  int *msg_ids);
+
 /**
  * @brief Enqueue a message to the outbox, to be sent later. Typically used for
  * messages with qos>0, but could be also used for qos=0 messages if store=true.
@@ -642,6 +693,22 @@ esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client,
                                          esp_event_handler_t event_handler,
                                          void *event_handler_arg);
 
+/**
+ * @brief Registers a sink for the data of published messages
+ *
+ * The data is passed to the sink directly, without going through the event loop,
+ * MQTT_EVENT_DATA events are not posted while a sink is registered. Messages longer
+ * than the receive buffer are passed in parts of up to the buffer size.
+ *
+ * @param client    *MQTT* client handle
+ * @param sink      sink callback, NULL to receive MQTT_EVENT_DATA events again
+ * @param sink_arg  context passed to the sink
+ *
+ * @return ESP_ERR_INVALID_ARG on wrong initialization
+ *         ESP_OK on success
+ */
+esp_err_t esp_mqtt_client_register_data_sink(esp_mqtt_client_handle_t client, esp_mqtt_data_sink_t sink, void *sink_arg);
+
 /**
  * @brief Unregisters mqtt event
  *
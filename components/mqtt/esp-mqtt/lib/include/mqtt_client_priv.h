@@ -100,6 +100,7 @@ typedef struct {
     uint8_t ecdsa_key_efuse_blk;
     int message_retransmit_timeout;
     uint64_t outbox_limit;
+    char *outbox_partition_label;
     esp_transport_handle_t transport;
     struct ifreq * if_name;
     esp_transport_keep_alive_t tcp_keep_alive_cfg;
@@ -134,6 +135,12 @@ struct esp_mqtt_client {
     EventGroupHandle_t status_bits;
     SemaphoreHandle_t  api_lock;
     TaskHandle_t       task_handle;
+    uint8_t *batch;          // PUBLISH messages not written to the transport yet
+    int batch_len;
+    int batch_size;
+    uint64_t batch_tick;     // When the oldest message of the batch was published
+    esp_mqtt_data_sink_t data_sink;
+    void *data_sink_arg;
 #if MQTT_EVENT_QUEUE_SIZE > 1
     atomic_int         queued_events;
 #endif
@@ -108,11 +108,30 @@
 #define MQTT_EVENT_QUEUE_SIZE       1
 #endif
 
+#ifdef CONFIG_MQTT_PUBLISH_COALESCE_MS
+#define MQTT_PUBLISH_COALESCE_MS    CONFIG_MQTT_PUBLISH_COALESCE_MS
+#else
+#define MQTT_PUBLISH_COALESCE_MS    0
+#endif
+
 #ifdef CONFIG_MQTT_OUTBOX_DATA_ON_EXTERNAL_MEMORY
 #define MQTT_OUTBOX_MEMORY MALLOC_CAP_SPIRAM
 #else
 #define MQTT_OUTBOX_MEMORY MALLOC_CAP_DEFAULT
 #endif
 
+#ifdef CONFIG_MQTT_OUTBOX_RING_SIZE
+#define OUTBOX_RING_SIZE            CONFIG_MQTT_OUTBOX_RING_SIZE
+#else
+#define OUTBOX_RING_SIZE            0
+#endif
+
+#ifdef CONFIG_MQTT_OUTBOX_PERSISTENT
+#define MQTT_OUTBOX_PERSISTENT      1
+#define OUTBOX_CACHE_SIZE           CONFIG_MQTT_OUTBOX_PERSISTENT_CACHE_SIZE
+#else
+#define MQTT_OUTBOX_PERSISTENT      0
+#endif
+
 #define OUTBOX_MAX_SIZE             (4*1024)
 #endif
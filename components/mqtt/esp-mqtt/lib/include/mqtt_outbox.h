@@ -58,6 +58,23 @@ uint64_t outbox_get_size(outbox_handle_t outbox);
 void outbox_destroy(outbox_handle_t outbox);
 void outbox_delete_all_items(outbox_handle_t outbox);
 
+/**
+ * @brief Keeps QoS>0 PUBLISH messages of the outbox in a log on a data partition
+ *
+ * Messages left in the log since it was last used are enqueued as QUEUED with the given tick.
+ * The log is closed by outbox_delete_all_items(), keeping the messages in it.
+ *
+ * @return ESP_OK on success, also if the log is already open
+ */
+esp_err_t outbox_restore(outbox_handle_t outbox, const char *partition_label, outbox_tick_t tick);
+
+/**
+ * @brief Returns the message ID of the message enqueued last, e.g. the last one restored by outbox_restore()
+ *
+ * @return message ID, or -1 if the outbox is empty
+ */
+int outbox_get_last_msg_id(outbox_handle_t outbox);
+
 #ifdef  __cplusplus
 }
 #endif
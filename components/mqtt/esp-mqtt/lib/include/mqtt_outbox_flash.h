@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _MQTT_OUTBOX_FLASH_H_
+#define _MQTT_OUTBOX_FLASH_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Log of outbox messages on a data partition
+ *
+ * Messages are appended to the sectors of the partition one after the other,
+ * deleting a message appends a record of the deletion. A sector is erased
+ * once none of its messages is left, if the oldest sector still holds messages
+ * when the log runs out of sectors, these are moved to the newest one first.
+ * Opening the log finds the messages not deleted, also if writing was
+ * interrupted by a reset.
+ */
+
+typedef struct outbox_flash *outbox_flash_handle_t;
+
+typedef struct outbox_flash_record {
+    uint32_t seq;       /* Identifies the message in the log, never 0 */
+    int msg_id;
+    int msg_type;
+    int msg_qos;
+    size_t len;
+} outbox_flash_record_t;
+
+/**
+ * @brief Opens the log on the data partition with the given label
+ *
+ * @return handle of the log, NULL if the partition is not found or too small
+ */
+outbox_flash_handle_t outbox_flash_open(const char *partition_label);
+
+/**
+ * @brief Largest message which is written to the log
+ */
+size_t outbox_flash_max_len(outbox_flash_handle_t flash);
+
+/**
+ * @brief Appends a message made of two parts to the log
+ *
+ * @param[inout] record  message to append, seq is set on success
+ *
+ * @return ESP_OK on success
+ *         ESP_ERR_INVALID_SIZE if the message is larger than outbox_flash_max_len()
+ *         ESP_ERR_NO_MEM if the log is full
+ *         ESP_FAIL if the log could not be written, the log is not written anymore
+ */
+esp_err_t outbox_flash_append(outbox_flash_handle_t flash, outbox_flash_record_t *record,
+                              const uint8_t *data, size_t len, const uint8_t *remaining_data, size_t remaining_len);
+
+/**
+ * @brief Deletes a message from the log
+ */
+esp_err_t outbox_flash_remove(outbox_flash_handle_t flash, uint32_t seq);
+
+/**
+ * @brief Reads the data of a message
+ *
+ * @param[out] data  data of the message, outbox_flash_max_len() bytes large
+ */
+esp_err_t outbox_flash_read(outbox_flash_handle_t flash, uint32_t seq, uint8_t *data, size_t len);
+
+/**
+ * @brief Number of messages in the log
+ */
+size_t outbox_flash_count(outbox_flash_handle_t flash);
+
+/**
+ * @brief Reads a message of the log, messages are counted in the order they were appended
+ *
+ * @param[out] data  data of the message, outbox_flash_max_len() bytes large
+ */
+esp_err_t outbox_flash_load(outbox_flash_handle_t flash, size_t index, outbox_flash_record_t *record, uint8_t *data);
+
+/**
+ * @brief Closes the log, messages not deleted stay in it
+ */
+void outbox_flash_close(outbox_flash_handle_t flash);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif
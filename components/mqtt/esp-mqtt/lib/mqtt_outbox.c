@@ -1,4 +1,5 @@
 #include "mqtt_outbox.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,10 +7,29 @@
 #include "sys/queue.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#if MQTT_OUTBOX_PERSISTENT
+#include "mqtt_msg.h"
+#include "mqtt_outbox_flash.h"
+#endif
 
 #ifndef CONFIG_MQTT_CUSTOM_OUTBOX
 static const char *TAG = "outbox";
 
+/*
+ * Items are kept in the order they were enqueued, and besides in
+ *  - a hash index by msg_id, as acks look them up by it
+ *  - a list ordered by tick, so that expired items are found at its head
+ * Item structures are taken from slabs of OUTBOX_SLAB_ITEMS, message data
+ * from a ring of OUTBOX_RING_SIZE bytes if configured, so that a message
+ * usually needs no heap allocation. Data not fitting into the ring is
+ * allocated separately.
+ * With a persistent outbox, QoS>0 PUBLISH messages are also appended to a log
+ * on flash. Their data stays in memory while OUTBOX_CACHE_SIZE is not exceeded,
+ * otherwise it is read back from flash when the message is sent.
+ */
+#define OUTBOX_SLAB_ITEMS   16
+#define OUTBOX_INDEX_MIN    16
+
 typedef struct outbox_item {
     char *buffer;
     int len;
@@ -18,67 +38,328 @@ typedef struct outbox_item {
     int msg_qos;
     outbox_tick_t tick;
     pending_state_t pending;
-    STAILQ_ENTRY(outbox_item) next;
+    bool in_ring;
+    TAILQ_ENTRY(outbox_item) next;
+    TAILQ_ENTRY(outbox_item) next_tick;
+    TAILQ_ENTRY(outbox_item) next_ring;
+    struct outbox_item *next_id;    /* In the index, or in the free items */
+#if MQTT_OUTBOX_PERSISTENT
+    struct outbox_t *outbox;
+    uint32_t flash_seq;             /* 0 if not in the log */
+#endif
 } outbox_item_t;
 
-STAILQ_HEAD(outbox_list_t, outbox_item);
+TAILQ_HEAD(outbox_list_t, outbox_item);
+
+typedef struct outbox_slab {
+    struct outbox_slab *next;
+    outbox_item_t items[OUTBOX_SLAB_ITEMS];
+} outbox_slab_t;
 
 struct outbox_t {
     _Atomic uint64_t size;
-    struct outbox_list_t *list;
+    struct outbox_list_t list;
+    struct outbox_list_t tick_list;
+    struct outbox_list_t ring_list;     /* Items with data in the ring, in ring order */
+    outbox_item_t **index;
+    size_t index_size;                  /* Number of buckets, a power of two */
+    size_t count;
+    size_t pending_count[CONFIRMED + 1];
+    outbox_slab_t *slabs;
+    outbox_item_t *free_items;
+    char *ring;
+#if MQTT_OUTBOX_PERSISTENT
+    outbox_flash_handle_t flash;
+    uint8_t *flash_data;                /* Data of the last message read from flash */
+    size_t cached;                      /* Bytes of the messages in the log also kept in memory */
+#endif
 };
 
 outbox_handle_t outbox_init(void)
 {
     outbox_handle_t outbox = calloc(1, sizeof(struct outbox_t));
     ESP_MEM_CHECK(TAG, outbox, return NULL);
-    outbox->list = calloc(1, sizeof(struct outbox_list_t));
-    ESP_MEM_CHECK(TAG, outbox->list, {free(outbox); return NULL;});
+    outbox->index = calloc(OUTBOX_INDEX_MIN, sizeof(outbox_item_t *));
+    ESP_MEM_CHECK(TAG, outbox->index, {free(outbox); return NULL;});
+    outbox->index_size = OUTBOX_INDEX_MIN;
     outbox->size = 0;
-    STAILQ_INIT(outbox->list);
+    TAILQ_INIT(&outbox->list);
+    TAILQ_INIT(&outbox->tick_list);
+    TAILQ_INIT(&outbox->ring_list);
     return outbox;
 }
 
-outbox_item_handle_t outbox_enqueue(outbox_handle_t outbox, outbox_message_handle_t message, outbox_tick_t tick)
+static outbox_item_t **outbox_index_bucket(outbox_handle_t outbox, int msg_id)
+{
+    return &outbox->index[(unsigned)msg_id & (outbox->index_size - 1)];
+}
+
+/* Newer items come first in a bucket, the oldest match is returned like from the list */
+static outbox_item_handle_t outbox_index_find(outbox_handle_t outbox, int msg_id, int msg_type)
+{
+    outbox_item_handle_t found = NULL;
+    for (outbox_item_handle_t item = *outbox_index_bucket(outbox, msg_id); item; item = item->next_id) {
+        if (item->msg_id == msg_id && (msg_type < 0 || (0xFF & (item->msg_type)) == msg_type)) {
+            found = item;
+        }
+    }
+    return found;
+}
+
+static void outbox_index_insert(outbox_handle_t outbox, outbox_item_handle_t item)
+{
+    outbox_item_t **bucket = outbox_index_bucket(outbox, item->msg_id);
+    item->next_id = *bucket;
+    *bucket = item;
+}
+
+static void outbox_index_remove(outbox_handle_t outbox, outbox_item_handle_t item)
+{
+    for (outbox_item_t **link = outbox_index_bucket(outbox, item->msg_id); *link; link = &(*link)->next_id) {
+        if (*link == item) {
+            *link = item->next_id;
+            return;
+        }
+    }
+}
+
+static void outbox_index_resize(outbox_handle_t outbox, size_t index_size)
+{
+    outbox_item_t **index = calloc(index_size, sizeof(outbox_item_t *));
+    if (!index) {
+        /* Keeps working with the old one, only with longer buckets */
+        return;
+    }
+    free(outbox->index);
+    outbox->index = index;
+    outbox->index_size = index_size;
+    outbox_item_handle_t item;
+    TAILQ_FOREACH(item, &outbox->list, next) {
+        outbox_index_insert(outbox, item);
+    }
+}
+
+static outbox_item_handle_t outbox_item_alloc(outbox_handle_t outbox)
+{
+    if (!outbox->free_items) {
+        outbox_slab_t *slab = calloc(1, sizeof(outbox_slab_t));
+        if (!slab) {
+            return NULL;
+        }
+        slab->next = outbox->slabs;
+        outbox->slabs = slab;
+        for (int i = OUTBOX_SLAB_ITEMS - 1; i >= 0; i--) {
+            slab->items[i].next_id = outbox->free_items;
+            outbox->free_items = &slab->items[i];
+        }
+    }
+    outbox_item_handle_t item = outbox->free_items;
+    outbox->free_items = item->next_id;
+    memset(item, 0, sizeof(outbox_item_t));
+    return item;
+}
+
+/* Gives the memory of a burst of messages back once the outbox is empty,
+ * keeping what a few messages at a time need */
+static void outbox_trim(outbox_handle_t outbox)
+{
+    outbox_slab_t *slab = outbox->slabs;
+    if (slab && slab->next) {
+        while (slab->next) {
+            outbox_slab_t *unused = slab->next;
+            slab->next = unused->next;
+            free(unused);
+        }
+        outbox->free_items = NULL;
+        for (int i = OUTBOX_SLAB_ITEMS - 1; i >= 0; i--) {
+            slab->items[i].next_id = outbox->free_items;
+            outbox->free_items = &slab->items[i];
+        }
+    }
+    if (outbox->index_size > OUTBOX_INDEX_MIN) {
+        outbox_index_resize(outbox, OUTBOX_INDEX_MIN);
+    }
+}
+
+/* Finds room for len bytes behind the newest data in the ring */
+static char *outbox_ring_alloc(outbox_handle_t outbox, int len)
+{
+    if (OUTBOX_RING_SIZE == 0 || len > OUTBOX_RING_SIZE) {
+        return NULL;
+    }
+    if (!outbox->ring) {
+        outbox->ring = heap_caps_malloc(OUTBOX_RING_SIZE, MQTT_OUTBOX_MEMORY);
+        if (!outbox->ring) {
+            return NULL;
+        }
+    }
+    if (TAILQ_EMPTY(&outbox->ring_list)) {
+        return outbox->ring;
+    }
+    outbox_item_handle_t oldest = TAILQ_FIRST(&outbox->ring_list);
+    outbox_item_handle_t newest = TAILQ_LAST(&outbox->ring_list, outbox_list_t);
+    int head = newest->buffer + newest->len - outbox->ring;
+    int tail = oldest->buffer - outbox->ring;
+    if (head > tail) {
+        if (OUTBOX_RING_SIZE - head >= len) {
+            return outbox->ring + head;
+        }
+        if (tail >= len) {
+            return outbox->ring;
+        }
+    } else if (tail - head >= len) {
+        return outbox->ring + head;
+    }
+    return NULL;
+}
+
+static void outbox_tick_insert(outbox_handle_t outbox, outbox_item_handle_t item)
+{
+    /* Ticks are usually the current time, the item mostly goes to the end */
+    outbox_item_handle_t before = TAILQ_LAST(&outbox->tick_list, outbox_list_t);
+    while (before && before->tick > item->tick) {
+        before = TAILQ_PREV(before, outbox_list_t, next_tick);
+    }
+    if (before) {
+        TAILQ_INSERT_AFTER(&outbox->tick_list, before, item, next_tick);
+    } else {
+        TAILQ_INSERT_HEAD(&outbox->tick_list, item, next_tick);
+    }
+}
+
+static void outbox_item_remove(outbox_handle_t outbox, outbox_item_handle_t item)
+{
+    outbox_index_remove(outbox, item);
+    TAILQ_REMOVE(&outbox->list, item, next);
+    TAILQ_REMOVE(&outbox->tick_list, item, next_tick);
+    if (item->in_ring) {
+        TAILQ_REMOVE(&outbox->ring_list, item, next_ring);
+    } else {
+        free(item->buffer);
+    }
+#if MQTT_OUTBOX_PERSISTENT
+    if (item->flash_seq) {
+        if (outbox->flash) {
+            outbox_flash_remove(outbox->flash, item->flash_seq);
+        }
+        if (item->buffer) {
+            outbox->cached -= item->len;
+        }
+    }
+#endif
+    outbox->size -= item->len;
+    outbox->pending_count[item->pending]--;
+    outbox->count--;
+    item->next_id = outbox->free_items;
+    outbox->free_items = item;
+    if (outbox->count == 0) {
+        outbox_trim(outbox);
+    }
+}
+
+static void outbox_item_init(outbox_handle_t outbox, outbox_item_handle_t item, outbox_message_handle_t message,
+                             outbox_tick_t tick)
 {
-    outbox_item_handle_t item = calloc(1, sizeof(outbox_item_t));
-    ESP_MEM_CHECK(TAG, item, return NULL);
     item->msg_id = message->msg_id;
     item->msg_type = message->msg_type;
     item->msg_qos = message->msg_qos;
     item->tick = tick;
     item->len =  message->len + message->remaining_len;
     item->pending = QUEUED;
-    item->buffer = heap_caps_malloc(message->len + message->remaining_len, MQTT_OUTBOX_MEMORY);
-    ESP_MEM_CHECK(TAG, item->buffer, {
-        free(item);
-        return NULL;
-    });
+    item->buffer = NULL;
+    item->in_ring = false;
+#if MQTT_OUTBOX_PERSISTENT
+    item->outbox = outbox;
+    item->flash_seq = 0;
+#endif
+}
+
+static esp_err_t outbox_item_set_data(outbox_handle_t outbox, outbox_item_handle_t item, outbox_message_handle_t message)
+{
+#if MQTT_OUTBOX_PERSISTENT
+    if (item->flash_seq && outbox->cached + item->len > OUTBOX_CACHE_SIZE) {
+        return ESP_OK;
+    }
+#endif
+    item->buffer = outbox_ring_alloc(outbox, item->len);
+    item->in_ring = item->buffer != NULL;
+    if (item->in_ring) {
+        TAILQ_INSERT_TAIL(&outbox->ring_list, item, next_ring);
+    } else {
+        item->buffer = heap_caps_malloc(item->len, MQTT_OUTBOX_MEMORY);
+    }
+#if MQTT_OUTBOX_PERSISTENT
+    if (!item->buffer && item->flash_seq) {
+        /* The data is read from flash when needed */
+        return ESP_OK;
+    }
+#endif
+    ESP_MEM_CHECK(TAG, item->buffer, return ESP_ERR_NO_MEM);
     memcpy(item->buffer, message->data, message->len);
     if (message->remaining_data) {
         memcpy(item->buffer + message->len, message->remaining_data, message->remaining_len);
     }
-    STAILQ_INSERT_TAIL(outbox->list, item, next);
+#if MQTT_OUTBOX_PERSISTENT
+    if (item->flash_seq) {
+        outbox->cached += item->len;
+    }
+#endif
+    return ESP_OK;
+}
+
+static void outbox_item_insert(outbox_handle_t outbox, outbox_item_handle_t item)
+{
+    if (outbox->count >= outbox->index_size) {
+        outbox_index_resize(outbox, outbox->index_size * 2);
+    }
+    TAILQ_INSERT_TAIL(&outbox->list, item, next);
+    outbox_tick_insert(outbox, item);
+    outbox_index_insert(outbox, item);
+    outbox->pending_count[QUEUED]++;
+    outbox->count++;
     outbox->size += item->len;
+}
+
+outbox_item_handle_t outbox_enqueue(outbox_handle_t outbox, outbox_message_handle_t message, outbox_tick_t tick)
+{
+    outbox_item_handle_t item = outbox_item_alloc(outbox);
+    ESP_MEM_CHECK(TAG, item, return NULL);
+    outbox_item_init(outbox, item, message, tick);
+#if MQTT_OUTBOX_PERSISTENT
+    if (outbox->flash && item->msg_type == MQTT_MSG_TYPE_PUBLISH && item->msg_qos > 0) {
+        outbox_flash_record_t record = {
+            .msg_id = item->msg_id,
+            .msg_type = item->msg_type,
+            .msg_qos = item->msg_qos,
+        };
+        if (outbox_flash_append(outbox->flash, &record, message->data, message->len,
+                                message->remaining_data, message->remaining_len) == ESP_OK) {
+            item->flash_seq = record.seq;
+        }
+    }
+#endif
+    if (outbox_item_set_data(outbox, item, message) != ESP_OK) {
+        item->next_id = outbox->free_items;
+        outbox->free_items = item;
+        return NULL;
+    }
+    outbox_item_insert(outbox, item);
     ESP_LOGD(TAG, "ENQUEUE msgid=%d, msg_type=%d, len=%d, size=%"PRIu64, message->msg_id, message->msg_type, message->len + message->remaining_len, outbox_get_size(outbox));
     return item;
 }
 
 outbox_item_handle_t outbox_get(outbox_handle_t outbox, int msg_id)
 {
-    outbox_item_handle_t item;
-    STAILQ_FOREACH(item, outbox->list, next) {
-        if (item->msg_id == msg_id) {
-            return item;
-        }
-    }
-    return NULL;
+    return outbox_index_find(outbox, msg_id, -1);
 }
 
 outbox_item_handle_t outbox_dequeue(outbox_handle_t outbox, pending_state_t pending, outbox_tick_t *tick)
 {
+    if (outbox->pending_count[pending] == 0) {
+        return NULL;
+    }
     outbox_item_handle_t item;
-    STAILQ_FOREACH(item, outbox->list, next) {
+    TAILQ_FOREACH(item, &outbox->list, next) {
         if (item->pending == pending) {
             if (tick) {
                 *tick = item->tick;
@@ -91,13 +372,9 @@ outbox_item_handle_t outbox_dequeue(outbox_handle_t outbox, pending_state_t pend
 
 esp_err_t outbox_delete_item(outbox_handle_t outbox, outbox_item_handle_t item_to_delete)
 {
-    outbox_item_handle_t item;
-    STAILQ_FOREACH(item, outbox->list, next) {
+    for (outbox_item_handle_t item = *outbox_index_bucket(outbox, item_to_delete->msg_id); item; item = item->next_id) {
         if (item == item_to_delete) {
-            STAILQ_REMOVE(outbox->list, item, outbox_item, next);
-            outbox->size -= item->len;
-            free(item->buffer);
-            free(item);
+            outbox_item_remove(outbox, item);
             return ESP_OK;
         }
     }
@@ -111,6 +388,16 @@ uint8_t *outbox_item_get_data(outbox_item_handle_t item,  size_t *len, uint16_t
         *msg_id = item->msg_id;
         *msg_type = item->msg_type;
         *qos = item->msg_qos;
+#if MQTT_OUTBOX_PERSISTENT
+        if (!item->buffer) {
+            outbox_handle_t outbox = item->outbox;
+            if (!outbox->flash || outbox_flash_read(outbox->flash, item->flash_seq, outbox->flash_data, item->len) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to read message msgid=%d from flash", item->msg_id);
+                return NULL;
+            }
+            return outbox->flash_data;
+        }
+#endif
         return (uint8_t *)item->buffer;
     }
     return NULL;
@@ -118,17 +405,11 @@ uint8_t *outbox_item_get_data(outbox_item_handle_t item,  size_t *len, uint16_t
 
 esp_err_t outbox_delete(outbox_handle_t outbox, int msg_id, int msg_type)
 {
-    outbox_item_handle_t item, tmp;
-    STAILQ_FOREACH_SAFE(item, outbox->list, next, tmp) {
-        if (item->msg_id == msg_id && (0xFF & (item->msg_type)) == msg_type) {
-            STAILQ_REMOVE(outbox->list, item, outbox_item, next);
-            outbox->size -= item->len;
-            free(item->buffer);
-            free(item);
-            ESP_LOGD(TAG, "DELETED msgid=%d, msg_type=%d, remain size=%"PRIu64, msg_id, msg_type, outbox_get_size(outbox));
-            return ESP_OK;
-        }
-
+    outbox_item_handle_t item = outbox_index_find(outbox, msg_id, msg_type);
+    if (item) {
+        outbox_item_remove(outbox, item);
+        ESP_LOGD(TAG, "DELETED msgid=%d, msg_type=%d, remain size=%"PRIu64, msg_id, msg_type, outbox_get_size(outbox));
+        return ESP_OK;
     }
     return ESP_FAIL;
 }
@@ -137,6 +418,8 @@ esp_err_t outbox_set_pending(outbox_handle_t outbox, int msg_id, pending_state_t
 {
     outbox_item_handle_t item = outbox_get(outbox, msg_id);
     if (item) {
+        outbox->pending_count[item->pending]--;
+        outbox->pending_count[pending]++;
         item->pending = pending;
         return ESP_OK;
     }
@@ -155,7 +438,9 @@ esp_err_t outbox_set_tick(outbox_handle_t outbox, int msg_id, outbox_tick_t tick
 {
     outbox_item_handle_t item = outbox_get(outbox, msg_id);
     if (item) {
+        TAILQ_REMOVE(&outbox->tick_list, item, next_tick);
         item->tick = tick;
+        outbox_tick_insert(outbox, item);
         return ESP_OK;
     }
     return ESP_FAIL;
@@ -164,17 +449,10 @@ esp_err_t outbox_set_tick(outbox_handle_t outbox, int msg_id, outbox_tick_t tick
 int outbox_delete_single_expired(outbox_handle_t outbox, outbox_tick_t current_tick, outbox_tick_t timeout)
 {
     int msg_id = -1;
-    outbox_item_handle_t item;
-    STAILQ_FOREACH(item, outbox->list, next) {
-        if (current_tick - item->tick > timeout) {
-            STAILQ_REMOVE(outbox->list, item, outbox_item, next);
-            free(item->buffer);
-            outbox->size -= item->len;
-            msg_id = item->msg_id;
-            free(item);
-            return msg_id;
-        }
-
+    outbox_item_handle_t item = TAILQ_FIRST(&outbox->tick_list);
+    if (item && current_tick - item->tick > timeout) {
+        msg_id = item->msg_id;
+        outbox_item_remove(outbox, item);
     }
     return msg_id;
 }
@@ -182,16 +460,8 @@ int outbox_delete_single_expired(outbox_handle_t outbox, outbox_tick_t current_t
 int outbox_delete_expired(outbox_handle_t outbox, outbox_tick_t current_tick, outbox_tick_t timeout)
 {
     int deleted_items = 0;
-    outbox_item_handle_t item, tmp;
-    STAILQ_FOREACH_SAFE(item, outbox->list, next, tmp) {
-        if (current_tick - item->tick > timeout) {
-            STAILQ_REMOVE(outbox->list, item, outbox_item, next);
-            free(item->buffer);
-            outbox->size -= item->len;
-            free(item);
-            deleted_items ++;
-        }
-
+    while (outbox_delete_single_expired(outbox, current_tick, timeout) >= 0) {
+        deleted_items ++;
     }
     return deleted_items;
 }
@@ -203,18 +473,83 @@ uint64_t outbox_get_size(outbox_handle_t outbox)
 
 void outbox_delete_all_items(outbox_handle_t outbox)
 {
-    outbox_item_handle_t item, tmp;
-    STAILQ_FOREACH_SAFE(item, outbox->list, next, tmp) {
-        STAILQ_REMOVE(outbox->list, item, outbox_item, next);
-        outbox->size -= item->len;
-        free(item->buffer);
-        free(item);
+#if MQTT_OUTBOX_PERSISTENT
+    /* Messages in the log are kept for outbox_restore() */
+    outbox_flash_handle_t flash = outbox->flash;
+    outbox->flash = NULL;
+#endif
+    outbox_item_handle_t item;
+    while ((item = TAILQ_FIRST(&outbox->list)) != NULL) {
+        outbox_item_remove(outbox, item);
     }
+#if MQTT_OUTBOX_PERSISTENT
+    if (flash) {
+        outbox_flash_close(flash);
+    }
+    free(outbox->flash_data);
+    outbox->flash_data = NULL;
+#endif
 }
+
+#if MQTT_OUTBOX_PERSISTENT
+esp_err_t outbox_restore(outbox_handle_t outbox, const char *partition_label, outbox_tick_t tick)
+{
+    if (outbox->flash) {
+        return ESP_OK;
+    }
+    outbox_flash_handle_t flash = outbox_flash_open(partition_label);
+    if (!flash) {
+        ESP_LOGE(TAG, "Failed to open outbox partition %s", partition_label);
+        return ESP_FAIL;
+    }
+    outbox->flash_data = malloc(outbox_flash_max_len(flash));
+    ESP_MEM_CHECK(TAG, outbox->flash_data, {
+        outbox_flash_close(flash);
+        return ESP_ERR_NO_MEM;
+    });
+    outbox->flash = flash;
+    size_t count = outbox_flash_count(flash);
+    for (size_t i = 0; i < count; i++) {
+        outbox_flash_record_t record;
+        if (outbox_flash_load(flash, i, &record, outbox->flash_data) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read message %u from flash", (unsigned)i);
+            continue;
+        }
+        outbox_message_t message = {
+            .data = outbox->flash_data,
+            .len = record.len,
+            .msg_id = record.msg_id,
+            .msg_qos = record.msg_qos,
+            .msg_type = record.msg_type,
+        };
+        outbox_item_handle_t item = outbox_item_alloc(outbox);
+        ESP_MEM_CHECK(TAG, item, return ESP_ERR_NO_MEM);
+        outbox_item_init(outbox, item, &message, tick);
+        item->flash_seq = record.seq;
+        outbox_item_set_data(outbox, item, &message);
+        outbox_item_insert(outbox, item);
+    }
+    ESP_LOGI(TAG, "Restored %u messages from partition %s", (unsigned)count, partition_label);
+    return ESP_OK;
+}
+
+int outbox_get_last_msg_id(outbox_handle_t outbox)
+{
+    outbox_item_handle_t item = TAILQ_LAST(&outbox->list, outbox_list_t);
+    return item ? item->msg_id : -1;
+}
+#endif
+
 void outbox_destroy(outbox_handle_t outbox)
 {
     outbox_delete_all_items(outbox);
-    free(outbox->list);
+    while (outbox->slabs) {
+        outbox_slab_t *slab = outbox->slabs;
+        outbox->slabs = slab->next;
+        free(slab);
+    }
+    free(outbox->index);
+    free(outbox->ring);
     free(outbox);
 }
 
@@ -0,0 +1,566 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "mqtt_outbox_flash.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "platform.h"
+
+static const char *TAG = "outbox_flash";
+
+/*
+ * Every sector in use starts with a header numbering the sectors in the
+ * order they were taken, the sectors in use are the ones with consecutive
+ * numbers up to the newest one. Records follow the header, aligned to
+ * 4 bytes, the first erased header ends them.
+ *
+ * A message moved out of the oldest sector keeps its seq, so that a copy
+ * left behind by a reset is recognized. A deletion is always written after
+ * the copies of the message it deletes.
+ */
+#define OUTBOX_FLASH_MAGIC      0x424f514d  /* "MQOB" */
+#define OUTBOX_FLASH_ADD        0x01
+#define OUTBOX_FLASH_DEL        0x02
+#define OUTBOX_FLASH_ALIGN(len) (((len) + 3) & ~(size_t)3)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t crc;           /* Of magic and seq */
+} outbox_flash_sector_t;
+
+typedef struct {
+    uint32_t crc;           /* Of the rest of the header and the data */
+    uint32_t seq;           /* Of the message, of the deleted one for a deletion */
+    uint16_t msg_id;
+    uint16_t len;
+    uint8_t kind;
+    uint8_t msg_type;
+    uint8_t msg_qos;
+    uint8_t reserved;
+} outbox_flash_header_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t pos;           /* Offset of the record in the partition */
+    uint32_t size;          /* Of the record, aligned */
+} outbox_flash_entry_t;
+
+struct outbox_flash {
+    const esp_partition_t *partition;
+    size_t sector_size;
+    size_t sector_count;
+    size_t head;            /* Oldest sector in use */
+    size_t used;            /* Number of sectors in use */
+    size_t write_pos;       /* Offset of the next record, in the newest sector */
+    uint32_t sector_seq;    /* Number of the newest sector */
+    uint32_t next_seq;
+    uint16_t *live;         /* Messages in each sector */
+    outbox_flash_entry_t *entries;  /* Messages in the log, by seq */
+    size_t count;
+    size_t capacity;
+    size_t live_bytes;
+    size_t max_bytes;       /* Limit of live_bytes, leaving room for moving messages */
+    uint8_t *buf;           /* A record being checked or moved */
+    bool failed;
+};
+
+static size_t outbox_flash_sector_start(outbox_flash_handle_t flash, size_t sector)
+{
+    return sector * flash->sector_size;
+}
+
+static size_t outbox_flash_newest(outbox_flash_handle_t flash)
+{
+    return (flash->head + flash->used - 1) % flash->sector_count;
+}
+
+static size_t outbox_flash_sector_of(outbox_flash_handle_t flash, size_t pos)
+{
+    return pos / flash->sector_size;
+}
+
+/* Records are a quarter of a sector at most, so that sectors can't be
+ * left mostly empty when messages are moved */
+static size_t outbox_flash_max_record(size_t sector_size)
+{
+    return ((sector_size - sizeof(outbox_flash_sector_t)) / 4) & ~(size_t)3;
+}
+
+static uint32_t outbox_flash_crc(const outbox_flash_header_t *header)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)header + sizeof(header->crc), sizeof(*header) - sizeof(header->crc));
+}
+
+static esp_err_t outbox_flash_failed(outbox_flash_handle_t flash, esp_err_t err)
+{
+    if (!flash->failed) {
+        ESP_LOGE(TAG, "Writing the log failed (%s), messages are not written anymore", esp_err_to_name(err));
+        flash->failed = true;
+    }
+    return ESP_FAIL;
+}
+
+static esp_err_t outbox_flash_write(outbox_flash_handle_t flash, size_t pos, const void *data, size_t len)
+{
+    esp_err_t err = len ? esp_partition_write(flash->partition, pos, data, len) : ESP_OK;
+    return err == ESP_OK ? ESP_OK : outbox_flash_failed(flash, err);
+}
+
+static size_t outbox_flash_lower_bound(outbox_flash_handle_t flash, uint32_t seq)
+{
+    size_t low = 0;
+    size_t high = flash->count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (flash->entries[mid].seq < seq) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static outbox_flash_entry_t *outbox_flash_find(outbox_flash_handle_t flash, uint32_t seq)
+{
+    size_t index = outbox_flash_lower_bound(flash, seq);
+    if (index < flash->count && flash->entries[index].seq == seq) {
+        return &flash->entries[index];
+    }
+    return NULL;
+}
+
+static esp_err_t outbox_flash_reserve_entry(outbox_flash_handle_t flash)
+{
+    if (flash->count < flash->capacity) {
+        return ESP_OK;
+    }
+    size_t capacity = flash->capacity ? flash->capacity * 2 : 16;
+    outbox_flash_entry_t *entries = realloc(flash->entries, capacity * sizeof(outbox_flash_entry_t));
+    ESP_MEM_CHECK(TAG, entries, return ESP_ERR_NO_MEM);
+    flash->entries = entries;
+    flash->capacity = capacity;
+    return ESP_OK;
+}
+
+/* Adds a message, or replaces an older copy of it */
+static esp_err_t outbox_flash_insert(outbox_flash_handle_t flash, uint32_t seq, size_t pos, size_t size)
+{
+    size_t index = outbox_flash_lower_bound(flash, seq);
+    if (index == flash->count || flash->entries[index].seq != seq) {
+        if (outbox_flash_reserve_entry(flash) != ESP_OK) {
+            return ESP_ERR_NO_MEM;
+        }
+        memmove(&flash->entries[index + 1], &flash->entries[index], (flash->count - index) * sizeof(outbox_flash_entry_t));
+        flash->count++;
+    }
+    flash->entries[index] = (outbox_flash_entry_t) {
+        .seq = seq, .pos = pos, .size = size
+    };
+    return ESP_OK;
+}
+
+static void outbox_flash_erase_entry(outbox_flash_handle_t flash, outbox_flash_entry_t *entry)
+{
+    size_t index = entry - flash->entries;
+    memmove(entry, entry + 1, (flash->count - index - 1) * sizeof(outbox_flash_entry_t));
+    flash->count--;
+}
+
+/* Takes the erased sector after the newest one */
+static esp_err_t outbox_flash_open_sector(outbox_flash_handle_t flash)
+{
+    if (flash->used == flash->sector_count) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t sector = (flash->head + flash->used) % flash->sector_count;
+    outbox_flash_sector_t header = {
+        .magic = OUTBOX_FLASH_MAGIC,
+        .seq = flash->sector_seq + 1,
+    };
+    header.crc = esp_rom_crc32_le(0, (const uint8_t *)&header, offsetof(outbox_flash_sector_t, crc));
+    if (outbox_flash_write(flash, outbox_flash_sector_start(flash, sector), &header, sizeof(header)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    flash->sector_seq = header.seq;
+    flash->used++;
+    flash->live[sector] = 0;
+    flash->write_pos = outbox_flash_sector_start(flash, sector) + sizeof(header);
+    return ESP_OK;
+}
+
+static esp_err_t outbox_flash_free_oldest(outbox_flash_handle_t flash)
+{
+    esp_err_t err = esp_partition_erase_range(flash->partition, outbox_flash_sector_start(flash, flash->head), flash->sector_size);
+    if (err != ESP_OK) {
+        return outbox_flash_failed(flash, err);
+    }
+    flash->head = (flash->head + 1) % flash->sector_count;
+    flash->used--;
+    return ESP_OK;
+}
+
+/* Frees the oldest sectors without messages, the newest one stays in use */
+static esp_err_t outbox_flash_reclaim(outbox_flash_handle_t flash)
+{
+    while (flash->used > 1 && flash->live[flash->head] == 0) {
+        if (outbox_flash_free_oldest(flash) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+static bool outbox_flash_fits(outbox_flash_handle_t flash, size_t size)
+{
+    return flash->used && flash->write_pos + size <= outbox_flash_sector_start(flash, outbox_flash_newest(flash)) + flash->sector_size;
+}
+
+/* Moves the messages of the oldest sector to the newest ones, and frees it */
+static esp_err_t outbox_flash_collect(outbox_flash_handle_t flash)
+{
+    size_t oldest = flash->head;
+    for (size_t i = 0; i < flash->count; i++) {
+        outbox_flash_entry_t *entry = &flash->entries[i];
+        if (outbox_flash_sector_of(flash, entry->pos) != oldest) {
+            continue;
+        }
+        esp_err_t err = outbox_flash_fits(flash, entry->size) ? ESP_OK : outbox_flash_open_sector(flash);
+        if (err != ESP_OK) {
+            return err;
+        }
+        err = esp_partition_read(flash->partition, entry->pos, flash->buf, entry->size);
+        if (err != ESP_OK) {
+            return outbox_flash_failed(flash, err);
+        }
+        if (outbox_flash_write(flash, flash->write_pos, flash->buf, entry->size) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        flash->live[oldest]--;
+        flash->live[outbox_flash_newest(flash)]++;
+        entry->pos = flash->write_pos;
+        flash->write_pos += entry->size;
+    }
+    return outbox_flash_free_oldest(flash);
+}
+
+/* Makes room for a record in the newest sector */
+static esp_err_t outbox_flash_reserve(outbox_flash_handle_t flash, size_t size)
+{
+    for (size_t steps = 0; steps <= flash->sector_count; steps++) {
+        if (outbox_flash_fits(flash, size)) {
+            return ESP_OK;
+        }
+        /* The last erased sector is kept for moving the messages of the oldest one */
+        esp_err_t err = (flash->used + 1 < flash->sector_count) ? outbox_flash_open_sector(flash) : outbox_flash_collect(flash);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+size_t outbox_flash_max_len(outbox_flash_handle_t flash)
+{
+    return MIN(outbox_flash_max_record(flash->sector_size) - sizeof(outbox_flash_header_t), UINT16_MAX & ~3);
+}
+
+esp_err_t outbox_flash_append(outbox_flash_handle_t flash, outbox_flash_record_t *record,
+                              const uint8_t *data, size_t len, const uint8_t *remaining_data, size_t remaining_len)
+{
+    if (flash->failed) {
+        return ESP_FAIL;
+    }
+    if (len + remaining_len > outbox_flash_max_len(flash)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t size = OUTBOX_FLASH_ALIGN(sizeof(outbox_flash_header_t) + len + remaining_len);
+    if (flash->live_bytes + size > flash->max_bytes || outbox_flash_reserve_entry(flash) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = outbox_flash_reserve(flash, size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    outbox_flash_header_t header = {
+        .seq = flash->next_seq,
+        .msg_id = record->msg_id,
+        .len = len + remaining_len,
+        .kind = OUTBOX_FLASH_ADD,
+        .msg_type = record->msg_type,
+        .msg_qos = record->msg_qos,
+        .reserved = 0xFF,
+    };
+    /* The record is written at once, padded to the alignment */
+    uint8_t *buf = flash->buf;
+    memcpy(buf + sizeof(header), data, len);
+    if (remaining_len) {
+        memcpy(buf + sizeof(header) + len, remaining_data, remaining_len);
+    }
+    memset(buf + sizeof(header) + header.len, 0xFF, size - sizeof(header) - header.len);
+    header.crc = esp_rom_crc32_le(outbox_flash_crc(&header), buf + sizeof(header), header.len);
+    memcpy(buf, &header, sizeof(header));
+    size_t pos = flash->write_pos;
+    if (outbox_flash_write(flash, pos, buf, size) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    flash->write_pos += size;
+    flash->next_seq++;
+    flash->live[outbox_flash_newest(flash)]++;
+    flash->live_bytes += size;
+    flash->entries[flash->count++] = (outbox_flash_entry_t) {
+        .seq = header.seq, .pos = pos, .size = size
+    };
+    record->seq = header.seq;
+    record->len = header.len;
+    return ESP_OK;
+}
+
+esp_err_t outbox_flash_remove(outbox_flash_handle_t flash, uint32_t seq)
+{
+    if (!outbox_flash_find(flash, seq)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (flash->failed || outbox_flash_reserve(flash, sizeof(outbox_flash_header_t)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    outbox_flash_header_t header = {
+        .seq = seq,
+        .msg_id = UINT16_MAX,
+        .kind = OUTBOX_FLASH_DEL,
+        .msg_type = 0xFF,
+        .msg_qos = 0xFF,
+        .reserved = 0xFF,
+    };
+    header.crc = outbox_flash_crc(&header);
+    if (outbox_flash_write(flash, flash->write_pos, &header, sizeof(header)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    flash->write_pos += sizeof(header);
+    /* Reserving may have moved the message */
+    outbox_flash_entry_t *entry = outbox_flash_find(flash, seq);
+    flash->live[outbox_flash_sector_of(flash, entry->pos)]--;
+    flash->live_bytes -= entry->size;
+    outbox_flash_erase_entry(flash, entry);
+    return outbox_flash_reclaim(flash);
+}
+
+esp_err_t outbox_flash_read(outbox_flash_handle_t flash, uint32_t seq, uint8_t *data, size_t len)
+{
+    outbox_flash_entry_t *entry = outbox_flash_find(flash, seq);
+    if (!entry) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return esp_partition_read(flash->partition, entry->pos + sizeof(outbox_flash_header_t), data, OUTBOX_FLASH_ALIGN(len));
+}
+
+size_t outbox_flash_count(outbox_flash_handle_t flash)
+{
+    return flash->count;
+}
+
+esp_err_t outbox_flash_load(outbox_flash_handle_t flash, size_t index, outbox_flash_record_t *record, uint8_t *data)
+{
+    if (index >= flash->count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    outbox_flash_header_t header;
+    esp_err_t err = esp_partition_read(flash->partition, flash->entries[index].pos, &header, sizeof(header));
+    if (err == ESP_OK) {
+        err = esp_partition_read(flash->partition, flash->entries[index].pos + sizeof(header), data, OUTBOX_FLASH_ALIGN(header.len));
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    record->seq = header.seq;
+    record->msg_id = header.msg_id;
+    record->msg_type = header.msg_type;
+    record->msg_qos = header.msg_qos;
+    record->len = header.len;
+    return ESP_OK;
+}
+
+static bool outbox_flash_is_erased(outbox_flash_handle_t flash, size_t pos, size_t end)
+{
+    size_t chunk = outbox_flash_max_record(flash->sector_size);
+    for (; pos < end; pos += chunk) {
+        size_t len = MIN(chunk, end - pos);
+        if (esp_partition_read(flash->partition, pos, flash->buf, len) != ESP_OK) {
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (flash->buf[i] != 0xFF) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Reads the records of a sector in use, returns the offset after the last valid one */
+static size_t outbox_flash_scan(outbox_flash_handle_t flash, size_t sector, esp_err_t *err)
+{
+    size_t pos = outbox_flash_sector_start(flash, sector) + sizeof(outbox_flash_sector_t);
+    size_t end = outbox_flash_sector_start(flash, sector) + flash->sector_size;
+    static const outbox_flash_header_t erased = {
+        .crc = UINT32_MAX, .seq = UINT32_MAX, .msg_id = UINT16_MAX, .len = UINT16_MAX,
+        .kind = 0xFF, .msg_type = 0xFF, .msg_qos = 0xFF, .reserved = 0xFF
+    };
+    outbox_flash_header_t header;
+    while (pos + sizeof(header) <= end) {
+        if (esp_partition_read(flash->partition, pos, &header, sizeof(header)) != ESP_OK ||
+                memcmp(&header, &erased, sizeof(header)) == 0) {
+            break;
+        }
+        size_t size = OUTBOX_FLASH_ALIGN(sizeof(header) + header.len);
+        if ((header.kind != OUTBOX_FLASH_ADD && header.kind != OUTBOX_FLASH_DEL) ||
+                size > end - pos || size > outbox_flash_max_record(flash->sector_size) ||
+                (header.len && esp_partition_read(flash->partition, pos + sizeof(header), flash->buf, size - sizeof(header)) != ESP_OK) ||
+                esp_rom_crc32_le(outbox_flash_crc(&header), flash->buf, header.len) != header.crc) {
+            /* Interrupted while written */
+            break;
+        }
+        if (header.kind == OUTBOX_FLASH_ADD) {
+            *err = outbox_flash_insert(flash, header.seq, pos, size);
+        } else {
+            outbox_flash_entry_t *entry = outbox_flash_find(flash, header.seq);
+            if (entry) {
+                outbox_flash_erase_entry(flash, entry);
+            }
+        }
+        if (*err != ESP_OK) {
+            break;
+        }
+        flash->next_seq = MAX(flash->next_seq, header.seq + 1);
+        pos += size;
+    }
+    return pos;
+}
+
+static esp_err_t outbox_flash_replay(outbox_flash_handle_t flash)
+{
+    uint32_t *sector_seqs = calloc(flash->sector_count, sizeof(uint32_t));
+    ESP_MEM_CHECK(TAG, sector_seqs, return ESP_ERR_NO_MEM);
+    size_t newest = 0;
+    for (size_t sector = 0; sector < flash->sector_count; sector++) {
+        outbox_flash_sector_t header;
+        if (esp_partition_read(flash->partition, outbox_flash_sector_start(flash, sector), &header, sizeof(header)) == ESP_OK &&
+                header.magic == OUTBOX_FLASH_MAGIC &&
+                header.crc == esp_rom_crc32_le(0, (const uint8_t *)&header, offsetof(outbox_flash_sector_t, crc))) {
+            sector_seqs[sector] = header.seq;
+            if (header.seq > sector_seqs[newest]) {
+                newest = sector;
+            }
+        }
+    }
+
+    esp_err_t err = ESP_OK;
+    flash->next_seq = 1;
+    if (sector_seqs[newest]) {
+        /* The sectors in use are numbered consecutively up to the newest one */
+        flash->head = newest;
+        flash->used = 1;
+        while (flash->used < flash->sector_count) {
+            size_t prev = (flash->head + flash->sector_count - 1) % flash->sector_count;
+            if (sector_seqs[prev] == 0 || sector_seqs[prev] != sector_seqs[flash->head] - 1) {
+                break;
+            }
+            flash->head = prev;
+            flash->used++;
+        }
+        flash->sector_seq = sector_seqs[newest];
+        for (size_t i = 0; i < flash->used && err == ESP_OK; i++) {
+            size_t sector = (flash->head + i) % flash->sector_count;
+            flash->write_pos = outbox_flash_scan(flash, sector, &err);
+        }
+        size_t end = outbox_flash_sector_start(flash, newest) + flash->sector_size;
+        if (!outbox_flash_is_erased(flash, flash->write_pos, end)) {
+            /* Nothing is written after a record that was interrupted */
+            flash->write_pos = end;
+        }
+    }
+    free(sector_seqs);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* Sectors not in use are expected to be erased */
+    for (size_t i = flash->used; i < flash->sector_count; i++) {
+        size_t sector = (flash->head + i) % flash->sector_count;
+        size_t start = outbox_flash_sector_start(flash, sector);
+        if (!outbox_flash_is_erased(flash, start, start + flash->sector_size)) {
+            err = esp_partition_erase_range(flash->partition, start, flash->sector_size);
+            if (err != ESP_OK) {
+                return outbox_flash_failed(flash, err);
+            }
+        }
+    }
+    for (size_t i = 0; i < flash->count; i++) {
+        flash->live[outbox_flash_sector_of(flash, flash->entries[i].pos)]++;
+        flash->live_bytes += flash->entries[i].size;
+    }
+    if (flash->used == flash->sector_count && flash->live[flash->head]) {
+        /* Interrupted while moving the messages of the oldest sector, the newest
+         * one holds nothing but copies of them and is taken again */
+        err = esp_partition_erase_range(flash->partition, outbox_flash_sector_start(flash, outbox_flash_newest(flash)), flash->sector_size);
+        if (err != ESP_OK) {
+            return outbox_flash_failed(flash, err);
+        }
+        flash->count = 0;
+        flash->live_bytes = 0;
+        memset(flash->live, 0, flash->sector_count * sizeof(uint16_t));
+        return outbox_flash_replay(flash);
+    }
+    return outbox_flash_reclaim(flash);
+}
+
+outbox_flash_handle_t outbox_flash_open(const char *partition_label)
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (!partition) {
+        ESP_LOGE(TAG, "Partition %s not found", partition_label);
+        return NULL;
+    }
+    if (partition->erase_size == 0 || partition->size / partition->erase_size < 3) {
+        ESP_LOGE(TAG, "Partition %s is too small, at least 3 sectors are needed", partition_label);
+        return NULL;
+    }
+    outbox_flash_handle_t flash = calloc(1, sizeof(struct outbox_flash));
+    ESP_MEM_CHECK(TAG, flash, return NULL);
+    flash->partition = partition;
+    flash->sector_size = partition->erase_size;
+    flash->sector_count = partition->size / partition->erase_size;
+    /* Messages have to fit into all sectors but the newest and the erased one,
+     * with room for the sectors not filled up */
+    flash->max_bytes = (flash->sector_count - 2) * (flash->sector_size - sizeof(outbox_flash_sector_t)) / 4 * 3;
+    flash->live = calloc(flash->sector_count, sizeof(uint16_t));
+    flash->buf = malloc(outbox_flash_max_record(flash->sector_size));
+    ESP_MEM_CHECK(TAG, flash->live && flash->buf, {
+        outbox_flash_close(flash);
+        return NULL;
+    });
+    if (outbox_flash_replay(flash) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read the log of partition %s", partition_label);
+        outbox_flash_close(flash);
+        return NULL;
+    }
+    ESP_LOGD(TAG, "Opened partition %s, %u messages", partition_label, (unsigned)flash->count);
+    return flash;
+}
+
+void outbox_flash_close(outbox_flash_handle_t flash)
+{
+    free(flash->entries);
+    free(flash->live);
+    free(flash->buf);
+    free(flash);
+}
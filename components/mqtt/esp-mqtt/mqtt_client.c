@@ -631,6 +631,12 @@ esp_err_t esp_mqtt_set_config(esp_mqtt_client_handle_t client, const esp_mqtt_cl
         }
     }
     client->config->outbox_limit = config->outbox.limit;
+    ESP_MEM_CHECK(TAG, esp_mqtt_set_if_config(config->outbox.partition_label, &client->config->outbox_partition_label), goto _mqtt_set_config_failed);
+#if !MQTT_OUTBOX_PERSISTENT
+    if (client->config->outbox_partition_label) {
+        ESP_LOGW(TAG, "Outbox partition set, but CONFIG_MQTT_OUTBOX_PERSISTENT is disabled, the outbox is not kept on flash");
+    }
+#endif
     esp_err_t config_has_conflict = esp_mqtt_check_cfg_conflict(client->config, config);
 
     MQTT_API_UNLOCK(client);
@@ -653,6 +659,7 @@ void esp_mqtt_destroy_config(esp_mqtt_client_handle_t client)
     free(client->config->uri);
     free(client->config->path);
     free(client->config->scheme);
+    free(client->config->outbox_partition_label);
     for (int i = 0; i < client->config->num_alpn_protos; i++) {
         free(client->config->alpn_protos[i]);
     }
@@ -713,12 +720,12 @@ static esp_err_t process_keepalive(esp_mqtt_client_handle_t client)
     return ESP_OK;
 }
 
-static inline esp_err_t esp_mqtt_write(esp_mqtt_client_handle_t client)
+static esp_err_t esp_mqtt_write_data(esp_mqtt_client_handle_t client, const uint8_t *data, int len)
 {
-    int wlen = 0, widx = 0, len = client->mqtt_state.connection.outbound_message.length;
+    int wlen = 0, widx = 0;
     while (len > 0) {
         wlen = esp_transport_write(client->transport,
-                                   (char *)client->mqtt_state.connection.outbound_message.data + widx,
+                                   (const char *)data + widx,
                                    len,
                                    client->config->network_timeout_ms);
         if (wlen < 0) {
@@ -737,6 +744,61 @@ static inline esp_err_t esp_mqtt_write(esp_mqtt_client_handle_t client)
     return ESP_OK;
 }
 
+/**
+ * @brief Writes the publish messages kept in the batch, they are dropped if writing fails
+ */
+static esp_err_t esp_mqtt_flush_batch(esp_mqtt_client_handle_t client)
+{
+    int len = client->batch_len;
+    client->batch_len = 0;
+    return len > 0 ? esp_mqtt_write_data(client, client->batch, len) : ESP_OK;
+}
+
+/**
+ * @brief Adds the publish message of the outbound buffer to the batch
+ *
+ * @return ESP_OK if added, ESP_ERR_INVALID_SIZE or ESP_ERR_NO_MEM if the message has to be written
+ *         on its own, other errors if writing the batch failed
+ */
+static esp_err_t esp_mqtt_batch_message(esp_mqtt_client_handle_t client)
+{
+    mqtt_message_t *msg = &client->mqtt_state.connection.outbound_message;
+    if (client->batch == NULL) {
+        client->batch = malloc(client->mqtt_state.connection.buffer_length);
+        ESP_MEM_CHECK(TAG, client->batch, return ESP_ERR_NO_MEM);
+        client->batch_size = client->mqtt_state.connection.buffer_length;
+    }
+    // fragmented messages are only partially in the buffer
+    if (msg->length > client->batch_size || mqtt_get_total_length(msg->data, msg->length, NULL) != msg->length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (client->batch_len + msg->length > client->batch_size) {
+        esp_err_t err = esp_mqtt_flush_batch(client);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (client->batch_len == 0) {
+        client->batch_tick = platform_tick_get_ms();
+    }
+    memcpy(client->batch + client->batch_len, msg->data, msg->length);
+    client->batch_len += msg->length;
+    return ESP_OK;
+}
+
+/**
+ * @brief Writes the message of the outbound buffer, after the publish messages kept in the batch
+ */
+static inline esp_err_t esp_mqtt_write(esp_mqtt_client_handle_t client)
+{
+    esp_err_t err = esp_mqtt_flush_batch(client);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_mqtt_write_data(client, client->mqtt_state.connection.outbound_message.data,
+                               client->mqtt_state.connection.outbound_message.length);
+}
+
 static esp_err_t esp_mqtt_connect(esp_mqtt_client_handle_t client, int timeout_ms)
 {
     int read_len, connect_rsp_code = 0;
@@ -839,6 +901,7 @@ static void esp_mqtt_abort_connection(esp_mqtt_client_handle_t client)
 {
     MQTT_API_LOCK(client);
     esp_transport_close(client->transport);
+    client->batch_len = 0;
     client->wait_timeout_ms = client->config->reconnect_timeout_ms;
     client->reconnect_tick = platform_tick_get_ms();
     client->state = MQTT_STATE_WAIT_RECONNECT;
@@ -931,6 +994,7 @@ esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
         vSemaphoreDelete(client->api_lock);
     }
     free(client->event.error_handle);
+    free(client->batch);
     free(client);
     return ESP_OK;
 }
@@ -1052,12 +1116,18 @@ static esp_err_t esp_mqtt_dispatch_event(esp_mqtt_client_handle_t client)
     client->event.protocol_ver = client->mqtt_state.connection.information.protocol_ver;
     esp_err_t ret = ESP_FAIL;
 
+    if (client->event.event_id == MQTT_EVENT_DATA && client->data_sink) {
+        // data goes to the sink as read, without a copy of the event to the event loop
+        client->data_sink(client->data_sink_arg, &client->event);
+        ret = ESP_OK;
+    } else {
 #ifdef MQTT_SUPPORTED_FEATURE_EVENT_LOOP
-    esp_event_post_to(client->config->event_loop_handle, MQTT_EVENTS, client->event.event_id, &client->event, sizeof(client->event), portMAX_DELAY);
-    ret = esp_event_loop_run(client->config->event_loop_handle, 0);
+        esp_event_post_to(client->config->event_loop_handle, MQTT_EVENTS, client->event.event_id, &client->event, sizeof(client->event), portMAX_DELAY);
+        ret = esp_event_loop_run(client->config->event_loop_handle, 0);
 #else
-    return ESP_FAIL;
+        return ESP_FAIL;
 #endif
+    }
     if (client->mqtt_state.connection.information.protocol_ver == MQTT_PROTOCOL_V_5) {
 #ifdef MQTT_PROTOCOL_5
         esp_mqtt5_client_delete_user_property(client->event.property->user_property);
@@ -1548,6 +1618,20 @@ static esp_err_t mqtt_resend_queued(esp_mqtt_client_handle_t client, outbox_item
     // decode queued data
     client->mqtt_state.connection.outbound_message.data = outbox_item_get_data(item, &client->mqtt_state.connection.outbound_message.length, &client->mqtt_state.pending_msg_id,
             &client->mqtt_state.pending_msg_type, &client->mqtt_state.pending_publish_qos);
+    if (client->mqtt_state.connection.outbound_message.data == NULL) {
+        // data of a persistent outbox could not be read, drop the message so that the ones after it are sent
+        int msg_id = client->mqtt_state.pending_msg_id;
+        ESP_LOGE(TAG, "Deleting unreadable message id=%d from the outbox", msg_id);
+        outbox_delete_item(client->outbox, item);
+#if MQTT_REPORT_DELETED_MESSAGES
+        client->event.event_id = MQTT_EVENT_DELETED;
+        client->event.msg_id = msg_id;
+        if (esp_mqtt_dispatch_event(client) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to post event on deleting message id=%d", msg_id);
+        }
+#endif
+        return ESP_FAIL;
+    }
     // set duplicate flag for QoS-1 and QoS-2 messages
     if (client->mqtt_state.pending_msg_type == MQTT_MSG_TYPE_PUBLISH && client->mqtt_state.pending_publish_qos > 0 && (outbox_item_get_pending(item) == TRANSMITTED)) {
         mqtt_set_dup(client->mqtt_state.connection.outbound_message.data);
@@ -1592,6 +1676,14 @@ static esp_err_t mqtt_resend_pubrel(esp_mqtt_client_handle_t client, outbox_item
 
 static void mqtt_delete_expired_messages(esp_mqtt_client_handle_t client)
 {
+#if MQTT_OUTBOX_PERSISTENT
+    // Messages kept on the partition wait for the broker while disconnected, they only expire
+    // after OUTBOX_EXPIRED_TIMEOUT_MS of connection
+    if (client->config->outbox_partition_label &&
+            (client->state != MQTT_STATE_CONNECTED || !has_timed_out(client->refresh_connection_tick, OUTBOX_EXPIRED_TIMEOUT_MS))) {
+        return;
+    }
+#endif
     // Delete message after OUTBOX_EXPIRED_TIMEOUT_MS milliseconds
 #if MQTT_REPORT_DELETED_MESSAGES
     // also report the deleted items as MQTT_EVENT_DELETED events if enabled
@@ -1610,9 +1702,16 @@ static void mqtt_delete_expired_messages(esp_mqtt_client_handle_t client)
 
 /**
  * @brief When using multiple queued item, we'd like to reduce the poll timeout to proceed with event loop exacution
+ *
+ * Coalesced publish messages are written within MQTT_PUBLISH_COALESCE_MS, the poll timeout doesn't exceed it either.
  */
 static inline int max_poll_timeout(esp_mqtt_client_handle_t client, int max_timeout)
 {
+#if MQTT_PUBLISH_COALESCE_MS > 0
+    if (max_timeout > MQTT_PUBLISH_COALESCE_MS) {
+        max_timeout = MQTT_PUBLISH_COALESCE_MS;
+    }
+#endif
     return
 #if MQTT_EVENT_QUEUE_SIZE > 1
         atomic_load(&client->queued_events) > 0 ? 10 : max_timeout;
@@ -1778,6 +1877,15 @@ static void esp_mqtt_task(void *pv)
                 }
             }
 
+#if MQTT_PUBLISH_COALESCE_MS > 0
+            if (client->batch_len > 0 && has_timed_out(client->batch_tick, MQTT_PUBLISH_COALESCE_MS)) {
+                if (esp_mqtt_flush_batch(client) != ESP_OK) {
+                    esp_mqtt_abort_connection(client);
+                    break;
+                }
+            }
+#endif
+
             if (process_keepalive(client) != ESP_OK) {
                 break;
             }
@@ -1824,6 +1932,7 @@ static void esp_mqtt_task(void *pv)
 
     }
     esp_transport_close(client->transport);
+    client->batch_len = 0;
     outbox_delete_all_items(client->outbox);
     client->state = MQTT_STATE_DISCONNECTED;
     xEventGroupSetBits(client->status_bits, STOPPED_BIT);
@@ -1844,6 +1953,23 @@ esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
         return ESP_FAIL;
     }
     esp_err_t err = ESP_OK;
+#if MQTT_OUTBOX_PERSISTENT
+    if (client->config->outbox_partition_label) {
+        // messages not acknowledged before the last stop or reset are sent again
+        err = outbox_restore(client->outbox, client->config->outbox_partition_label, platform_tick_get_ms());
+        if (err != ESP_OK) {
+            MQTT_API_UNLOCK(client);
+            return err;
+        }
+#if MQTT_MSG_ID_INCREMENTAL
+        // the restored messages keep their IDs, new IDs continue after them
+        int last_msg_id = outbox_get_last_msg_id(client->outbox);
+        if (last_msg_id > 0) {
+            client->mqtt_state.connection.last_message_id = (uint16_t)last_msg_id;
+        }
+#endif
+    }
+#endif
 #if MQTT_CORE_SELECTION_ENABLED
     ESP_LOGD(TAG, "Core selection enabled on %u", MQTT_TASK_CORE);
     if (xTaskCreatePinnedToCore(esp_mqtt_task, "mqtt_task", client->config->task_stack, client, client->config->task_prio, &client->task_handle, MQTT_TASK_CORE) != pdTRUE) {
@@ -2145,25 +2271,18 @@ static inline int mqtt_client_enqueue_publish(esp_mqtt_client_handle_t client, c
     return pending_msg_id;
 }
 
-int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos, int retain)
+/**
+ * @brief Publishes a message, with the API lock taken
+ *
+ * @param coalesce  keep the message in the batch, to be written with the messages published next
+ */
+static int mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos, int retain,
+                               bool coalesce)
 {
-    if (!client) {
-        ESP_LOGE(TAG, "Client was not initialized");
-        return -1;
-    }
-#if MQTT_SKIP_PUBLISH_IF_DISCONNECTED
-    if (client->state != MQTT_STATE_CONNECTED) {
-        ESP_LOGI(TAG, "Publishing skipped: client is not connected");
-        return -1;
-    }
-#endif
-
-MQTT_API_LOCK(client);
 #ifdef MQTT_PROTOCOL_5
     if (client->mqtt_state.connection.information.protocol_ver == MQTT_PROTOCOL_V_5) {
         if (esp_mqtt5_client_publish_check(client, qos, retain) != ESP_OK) {
             ESP_LOGI(TAG, "MQTT5 publish check fail");
-            MQTT_API_UNLOCK(client);
             return -1;
         }
     }
@@ -2180,14 +2299,12 @@ MQTT_API_LOCK(client);
 
     if (client->config->outbox_limit > 0 && qos > 0) {
         if (len + outbox_get_size(client->outbox) > client->config->outbox_limit) {
-            MQTT_API_UNLOCK(client);
             return -2;
         }
     }
 
     int pending_msg_id = mqtt_client_enqueue_publish(client, topic, data, len, qos, retain, false);
     if (pending_msg_id < 0) {
-        MQTT_API_UNLOCK(client);
         return -1;
     }
     int ret = 0;
@@ -2204,10 +2321,21 @@ MQTT_API_LOCK(client);
         goto cannot_publish;
     }
 
+    bool sending = true;
+    if (coalesce) {
+        esp_err_t err = esp_mqtt_batch_message(client);
+        if (err == ESP_OK) {
+            sending = false;
+        } else if (err != ESP_ERR_INVALID_SIZE && err != ESP_ERR_NO_MEM) {
+            esp_mqtt_abort_connection(client);
+            ret = -1;
+            goto cannot_publish;
+        }
+    }
+
     /* Provide support for sending fragmented message if it doesn't fit buffer */
     int remaining_len = len;
     const char *current_data = data;
-    bool sending = true;
 
     while (sending)  {
 
@@ -2247,7 +2375,6 @@ MQTT_API_LOCK(client);
         outbox_set_tick(client->outbox, pending_msg_id, platform_tick_get_ms());
         outbox_set_pending(client->outbox, pending_msg_id, TRANSMITTED);
     }
-    MQTT_API_UNLOCK(client);
     return pending_msg_id;
 
 cannot_publish:
@@ -2256,11 +2383,62 @@ cannot_publish:
     if (qos == 0) {
         ESP_LOGW(TAG, "Publish: Losing qos0 data when client not connected");
     }
-    MQTT_API_UNLOCK(client);
 
     return ret;
 }
 
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos, int retain)
+{
+    if (!client) {
+        ESP_LOGE(TAG, "Client was not initialized");
+        return -1;
+    }
+#if MQTT_SKIP_PUBLISH_IF_DISCONNECTED
+    if (client->state != MQTT_STATE_CONNECTED) {
+        ESP_LOGI(TAG, "Publishing skipped: client is not connected");
+        return -1;
+    }
+#endif
+
+    MQTT_API_LOCK(client);
+    int ret = mqtt_client_publish(client, topic, data, len, qos, retain, MQTT_PUBLISH_COALESCE_MS > 0);
+    MQTT_API_UNLOCK(client);
+    return ret;
+}
+
+int esp_mqtt_client_publish_batch(esp_mqtt_client_handle_t client, const esp_mqtt_publish_t *messages, int count, int *msg_ids)
+{
+    if (!client) {
+        ESP_LOGE(TAG, "Client was not initialized");
+        return -1;
+    }
+#if MQTT_SKIP_PUBLISH_IF_DISCONNECTED
+    if (client->state != MQTT_STATE_CONNECTED) {
+        ESP_LOGI(TAG, "Publishing skipped: client is not connected");
+        return -1;
+    }
+#endif
+
+    MQTT_API_LOCK(client);
+    int published = 0;
+    for (; published < count; published++) {
+        const esp_mqtt_publish_t *message = &messages[published];
+        int ret = mqtt_client_publish(client, message->topic, message->data, message->len, message->qos, message->retain, true);
+        if (msg_ids) {
+            msg_ids[published] = ret;
+        }
+        if (ret < 0) {
+            break;
+        }
+    }
+    if (client->state == MQTT_STATE_CONNECTED && esp_mqtt_flush_batch(client) != ESP_OK) {
+        esp_mqtt_abort_connection(client);
+        published = -1;
+    }
+    MQTT_API_UNLOCK(client);
+    return published;
+}
+
 int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos, int retain, bool store)
 {
     if (!client) {
@@ -2317,6 +2495,18 @@ esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mq
 #endif
 }
 
+esp_err_t esp_mqtt_client_register_data_sink(esp_mqtt_client_handle_t client, esp_mqtt_data_sink_t sink, void *sink_arg)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    MQTT_API_LOCK(client);
+    client->data_sink = sink;
+    client->data_sink_arg = sink_arg;
+    MQTT_API_UNLOCK(client);
+    return ESP_OK;
+}
+
 esp_err_t esp_mqtt_client_unregister_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event, esp_event_handler_t event_handler)
 {
     if (client == NULL) {
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <string>
 #include <random>
+#include <chrono>
 #include "test_fixtures.hpp"
 #include "spi_flash_mmap.h"
 
@@ -264,9 +265,9 @@ TEST_CASE("Page validates blob size", "[nvs]")
 
 class HashListTestHelper : public nvs::HashList {
 public:
-    size_t getBlockCount()
+    size_t getHeapSize()
     {
-        return mBlockList.size();
+        return mNodes ? CAPACITY * sizeof(HashListNode) : 0;
     }
 };
 
@@ -274,33 +275,84 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
 {
     HashListTestHelper hashlist;
     // Add items
-    const size_t count = 128;
+    const size_t count = nvs::Page::ENTRY_COUNT;
     for (size_t i = 0; i < count; ++i) {
         char key[16];
         snprintf(key, sizeof(key), "i%ld", (long int)i);
         nvs::Item item(1, nvs::ItemType::U32, 1, key);
-        hashlist.insert(item, i);
+        TEST_ESP_OK(hashlist.insert(item, i));
     }
-    INFO("Added " << count << " items, " << hashlist.getBlockCount() << " blocks");
+    INFO("Added " << count << " items, " << hashlist.getHeapSize() << " bytes");
     // Remove them in reverse order
     for (size_t i = count; i > 0; --i) {
         // Make sure that the element existed before it's erased
         CHECK(hashlist.erase(i - 1) == true);
     }
-    CHECK(hashlist.getBlockCount() == 0);
+    CHECK(hashlist.getHeapSize() == 0);
     // Add again
     for (size_t i = 0; i < count; ++i) {
         char key[16];
         snprintf(key, sizeof(key), "i%ld", (long int)i);
         nvs::Item item(1, nvs::ItemType::U32, 1, key);
-        hashlist.insert(item, i);
+        TEST_ESP_OK(hashlist.insert(item, i));
     }
-    INFO("Added " << count << " items, " << hashlist.getBlockCount() << " blocks");
+    INFO("Added " << count << " items, " << hashlist.getHeapSize() << " bytes");
     // Remove them in the same order
     for (size_t i = 0; i < count; ++i) {
         CHECK(hashlist.erase(i) == true);
     }
-    CHECK(hashlist.getBlockCount() == 0);
+    CHECK(hashlist.getHeapSize() == 0);
+    CHECK(hashlist.erase(0) == false);
+}
+
+TEST_CASE("HashList finds the lowest matching index at or after start", "[nvs]")
+{
+    HashListTestHelper hashlist;
+    nvs::Item item(1, nvs::ItemType::U32, 1, "dup");
+    nvs::Item other(1, nvs::ItemType::U32, 1, "other");
+    TEST_ESP_OK(hashlist.insert(item, 50));
+    TEST_ESP_OK(hashlist.insert(other, 2));
+    TEST_ESP_OK(hashlist.insert(item, 3));
+    TEST_ESP_OK(hashlist.insert(item, 10));
+    CHECK(hashlist.find(0, item) == 3);
+    CHECK(hashlist.find(4, item) == 10);
+    CHECK(hashlist.find(11, item) == 50);
+    CHECK(hashlist.find(51, item) == SIZE_MAX);
+    CHECK(hashlist.find(0, other) == 2);
+
+    uint32_t hash = 0;
+    CHECK(hashlist.erase(10, &hash) == true);
+    CHECK(hash == nvs::HashList::hashOf(item));
+    CHECK(hashlist.find(4, item) == 50);
+
+    // erase items in random order from a full table and compare with a plain list
+    std::mt19937 gen(42);
+    std::vector<std::pair<uint32_t, size_t>> reference;
+    hashlist.clear();
+    std::vector<nvs::Item> items;
+    for (size_t i = 0; i < nvs::Page::ENTRY_COUNT; ++i) {
+        char key[16];
+        // a few keys are used twice to get duplicate hashes
+        snprintf(key, sizeof(key), "k%d", static_cast<int>(i % 100));
+        items.emplace_back(1, nvs::ItemType::U8, 1, key);
+        TEST_ESP_OK(hashlist.insert(items.back(), i));
+        reference.emplace_back(nvs::HashList::hashOf(items.back()), i);
+    }
+    while (!reference.empty()) {
+        size_t pos = gen() % reference.size();
+        CHECK(hashlist.erase(reference[pos].second) == true);
+        reference.erase(reference.begin() + pos);
+        for (size_t i = 0; i < items.size(); i += 7) {
+            size_t expected = SIZE_MAX;
+            for (auto& node : reference) {
+                if (node.first == nvs::HashList::hashOf(items[i]) && node.second < expected) {
+                    expected = node.second;
+                }
+            }
+            CHECK(hashlist.find(0, items[i]) == expected);
+        }
+    }
+    CHECK(hashlist.getHeapSize() == 0);
 }
 
 TEST_CASE("can init PageManager in empty flash", "[nvs]")
@@ -3973,6 +4025,1075 @@ TEST_CASE("nvs find key tests", "[nvs]")
     nvs_close(handle_2);
     TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
 }
+
+TEST_CASE("storage key index finds the same items as the page scan", "[nvs][key_index]")
+{
+    PartitionEmulationFixture f(0, 8);
+
+    // write with the index active, so that it is kept up to date across page reclaims
+    nvs::Storage storage(f.part());
+    storage.setItemIndexEnabled(true);
+    TEST_ESP_OK(storage.init(0, 8));
+    CHECK(storage.isItemIndexActive());
+
+    uint8_t ns_index;
+    TEST_ESP_OK(storage.createOrOpenNamespace("index_ns", true, ns_index));
+
+    char key[16];
+    char value[48];
+    for (int round = 0; round < 6; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            snprintf(key, sizeof(key), "key_%d", i);
+            if ((i + round) % 7 == 0) {
+                TEST_ESP_OK(storage.writeItem(ns_index, key, static_cast<uint32_t>(round)));
+            } else {
+                snprintf(value, sizeof(value), "value %d of round %d", i, round);
+                TEST_ESP_OK(storage.writeItem(ns_index, nvs::ItemType::SZ, key, value, strlen(value) + 1));
+            }
+            if (i % 11 == round) {
+                TEST_ESP_OK(storage.eraseItem(ns_index, key));
+            }
+        }
+    }
+    CHECK(storage.isItemIndexActive());
+
+    // a second storage on the same flash without the index is the reference
+    nvs::Storage reference(f.part());
+    reference.setItemIndexEnabled(false);
+    TEST_ESP_OK(reference.init(0, 8));
+    CHECK_FALSE(reference.isItemIndexActive());
+
+    for (int i = 0; i < 100; ++i) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        nvs::ItemType type_indexed = nvs::ItemType::ANY;
+        nvs::ItemType type_scanned = nvs::ItemType::ANY;
+        esp_err_t err_indexed = storage.findKey(ns_index, key, &type_indexed);
+        CHECK(err_indexed == reference.findKey(ns_index, key, &type_scanned));
+        CHECK(type_indexed == type_scanned);
+        if (err_indexed == ESP_OK && type_indexed == nvs::ItemType::SZ) {
+            char value_indexed[48];
+            char value_scanned[48];
+            TEST_ESP_OK(storage.readItem(ns_index, nvs::ItemType::SZ, key, value_indexed, sizeof(value_indexed)));
+            TEST_ESP_OK(reference.readItem(ns_index, nvs::ItemType::SZ, key, value_scanned, sizeof(value_scanned)));
+            CHECK(strcmp(value_indexed, value_scanned) == 0);
+        }
+    }
+}
+
+TEST_CASE("storage key index lookup benchmark", "[nvs][key_index]")
+{
+    const uint32_t SECTOR_COUNT = 16;
+    const int KEY_COUNT = 300;
+    const int ROUNDS = 20;
+    PartitionEmulationFixture f(0, SECTOR_COUNT);
+
+    uint8_t ns_index;
+    char key[16];
+    char value[64];
+    {
+        // spread 300 keys over the pages, strings take 3 entries each
+        nvs::Storage writer(f.part());
+        writer.setItemIndexEnabled(false);
+        TEST_ESP_OK(writer.init(0, SECTOR_COUNT));
+        TEST_ESP_OK(writer.createOrOpenNamespace("bench", true, ns_index));
+        for (int i = 0; i < KEY_COUNT; ++i) {
+            snprintf(key, sizeof(key), "key_%d", i);
+            snprintf(value, sizeof(value), "string value number %d", i);
+            TEST_ESP_OK(writer.writeItem(ns_index, nvs::ItemType::SZ, key, value, strlen(value) + 1));
+        }
+    }
+
+    for (bool use_index : {false, true}) {
+        nvs::Storage storage(f.part());
+        storage.setItemIndexEnabled(use_index);
+        TEST_ESP_OK(storage.init(0, SECTOR_COUNT));
+        CHECK(storage.isItemIndexActive() == use_index);
+
+        esp_partition_clear_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (int i = 0; i < KEY_COUNT; ++i) {
+                snprintf(key, sizeof(key), "key_%d", i);
+                size_t size;
+                TEST_ESP_OK(storage.getItemDataSize(ns_index, nvs::ItemType::SZ, key, size));
+                // lookups of keys which don't exist are common at boot and have to visit all pages without the index
+                snprintf(key, sizeof(key), "missing_%d", i);
+                TEST_ESP_ERR(storage.getItemDataSize(ns_index, nvs::ItemType::SZ, key, size), ESP_ERR_NVS_NOT_FOUND);
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        s_perf << "Lookup of " << KEY_COUNT << " existing and " << KEY_COUNT << " missing keys in " << SECTOR_COUNT << " pages, "
+               << (use_index ? "storage key index" : "per-page scan") << ": "
+               << elapsed / (ROUNDS * KEY_COUNT * 2) << " ns per lookup ("
+               << esp_partition_get_read_ops() / ROUNDS << " flash reads per round, index size " << storage.getItemIndexSize() << ")" << std::endl;
+    }
+}
+
+TEST_CASE("nvs_set_batch writes, replaces and validates items", "[nvs][batch]")
+{
+    PartitionEmulationFixture f(0, 4);
+    TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 4));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+
+    TEST_ESP_OK(nvs_set_u32(handle, "channel", 1));
+    TEST_ESP_OK(nvs_set_str(handle, "ssid", "old network"));
+    TEST_ESP_OK(nvs_set_u8(handle, "retries", 3));
+    size_t used_before;
+    TEST_ESP_OK(nvs_get_used_entry_count(handle, &used_before));
+
+    const uint32_t channel = 11;
+    const uint8_t retries = 3;
+    const int16_t offset = -42;
+    const uint8_t bssid[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+    const nvs_batch_item_t items[] = {
+        {"channel", NVS_TYPE_U32, &channel, 0},
+        {"ssid", NVS_TYPE_STR, "new network", 0},
+        {"retries", NVS_TYPE_U8, &retries, 0},
+        {"offset", NVS_TYPE_I16, &offset, 0},
+        {"bssid", NVS_TYPE_BLOB, bssid, sizeof(bssid)},
+    };
+    TEST_ESP_OK(nvs_set_batch(handle, items, sizeof(items) / sizeof(items[0])));
+
+    uint32_t channel_read;
+    TEST_ESP_OK(nvs_get_u32(handle, "channel", &channel_read));
+    CHECK(channel_read == channel);
+    char ssid_read[16];
+    size_t len = sizeof(ssid_read);
+    TEST_ESP_OK(nvs_get_str(handle, "ssid", ssid_read, &len));
+    CHECK(strcmp(ssid_read, "new network") == 0);
+    uint8_t retries_read;
+    TEST_ESP_OK(nvs_get_u8(handle, "retries", &retries_read));
+    CHECK(retries_read == retries);
+    int16_t offset_read;
+    TEST_ESP_OK(nvs_get_i16(handle, "offset", &offset_read));
+    CHECK(offset_read == offset);
+    uint8_t bssid_read[6];
+    len = sizeof(bssid_read);
+    TEST_ESP_OK(nvs_get_blob(handle, "bssid", bssid_read, &len));
+    CHECK(memcmp(bssid_read, bssid, sizeof(bssid)) == 0);
+
+    // replaced values are gone, the unchanged one was not rewritten: two new primitives, a blob in 1 + 1 + 1 entries
+    size_t used_after;
+    TEST_ESP_OK(nvs_get_used_entry_count(handle, &used_after));
+    CHECK(used_after == used_before + 1 + 3);
+
+    // writing the same batch again doesn't touch the flash
+    esp_partition_clear_stats();
+    TEST_ESP_OK(nvs_set_batch(handle, items, sizeof(items) / sizeof(items[0])));
+    CHECK(esp_partition_get_write_ops() == 0);
+    CHECK(esp_partition_get_erase_ops() == 0);
+
+    // the batch is validated as a whole before anything is written
+    const uint32_t other_channel = 6;
+    const nvs_batch_item_t duplicate[] = {
+        {"channel", NVS_TYPE_U32, &other_channel, 0},
+        {"channel", NVS_TYPE_U32, &channel, 0},
+    };
+    TEST_ESP_ERR(nvs_set_batch(handle, duplicate, 2), ESP_ERR_INVALID_ARG);
+    const nvs_batch_item_t bad[] = {
+        {"channel", NVS_TYPE_U32, &other_channel, 0},
+        {"too_long_key_name", NVS_TYPE_U8, &retries, 0},
+    };
+    TEST_ESP_ERR(nvs_set_batch(handle, bad, 2), ESP_ERR_NVS_KEY_TOO_LONG);
+    const nvs_batch_item_t any[] = {
+        {"channel", NVS_TYPE_ANY, &other_channel, 0},
+    };
+    TEST_ESP_ERR(nvs_set_batch(handle, any, 1), ESP_ERR_INVALID_ARG);
+    static uint8_t big_blob[nvs::Page::CHUNK_MAX_SIZE / 2];
+    const nvs_batch_item_t too_big[] = {
+        {"blob_1", NVS_TYPE_BLOB, big_blob, sizeof(big_blob)},
+        {"blob_2", NVS_TYPE_BLOB, big_blob, sizeof(big_blob)},
+    };
+    TEST_ESP_ERR(nvs_set_batch(handle, too_big, 2), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    TEST_ESP_OK(nvs_get_u32(handle, "channel", &channel_read));
+    CHECK(channel_read == channel);
+
+    nvs_handle_t handle_ro;
+    TEST_ESP_OK(nvs_open("batch", NVS_READONLY, &handle_ro));
+    TEST_ESP_ERR(nvs_set_batch(handle_ro, items, 1), ESP_ERR_NVS_READ_ONLY);
+    nvs_close(handle_ro);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+}
+
+TEST_CASE("nvs_set_batch replaces a value of another type under the same key like nvs_set", "[nvs][batch]")
+{
+    PartitionEmulationFixture f(0, 4);
+    TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 4));
+    const int8_t v8 = 12;
+    const uint8_t blob[4] = {1, 2, 3, 4};
+
+    // the same updates of keys holding a value of another type, once with single writes and once as a batch
+    const char *namespaces[] = {"single", "batch"};
+    for (const char *ns : namespaces) {
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open(ns, NVS_READWRITE, &handle));
+        TEST_ESP_OK(nvs_set_i32(handle, "foo", 12345678));
+        TEST_ESP_OK(nvs_set_blob(handle, "bar", blob, sizeof(blob)));
+        if (strcmp(ns, "single") == 0) {
+            TEST_ESP_OK(nvs_set_i8(handle, "foo", v8));
+            TEST_ESP_OK(nvs_set_str(handle, "bar", "string"));
+        } else {
+            const nvs_batch_item_t items[] = {
+                {"foo", NVS_TYPE_I8, &v8, 0},
+                {"bar", NVS_TYPE_STR, "string", 0},
+            };
+            TEST_ESP_OK(nvs_set_batch(handle, items, 2));
+        }
+        nvs_close(handle);
+    }
+
+    for (int reload = 0; reload < 2; ++reload) {
+        esp_err_t results[2][4];
+        size_t used[2];
+        for (int i = 0; i < 2; ++i) {
+            nvs_handle_t handle;
+            TEST_ESP_OK(nvs_open(namespaces[i], NVS_READONLY, &handle));
+            int32_t i32_read;
+            int8_t i8_read;
+            uint8_t blob_read[sizeof(blob)];
+            char str_read[8];
+            size_t len = sizeof(blob_read);
+            results[i][0] = nvs_get_i32(handle, "foo", &i32_read);
+            results[i][1] = nvs_get_i8(handle, "foo", &i8_read);
+            results[i][2] = nvs_get_blob(handle, "bar", blob_read, &len);
+            len = sizeof(str_read);
+            results[i][3] = nvs_get_str(handle, "bar", str_read, &len);
+            TEST_ESP_OK(nvs_get_used_entry_count(handle, &used[i]));
+            nvs_close(handle);
+        }
+#ifndef CONFIG_NVS_LEGACY_DUP_KEYS_COMPATIBILITY
+        CHECK(results[0][1] == ESP_OK);
+        CHECK(results[0][3] == ESP_OK);
+#endif
+        for (int j = 0; j < 4; ++j) {
+            CHECK(results[1][j] == results[0][j]);
+        }
+        CHECK(used[1] == used[0]);
+
+        // the values left by finishing the batch on load are the same
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 4));
+    }
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+}
+
+TEST_CASE("nvs_set_batch is atomic across power-off", "[nvs][batch]")
+{
+    const uint32_t SECTOR_COUNT = 4;
+    const size_t CAL_COUNT = 12;
+    PartitionEmulationFixture f(0, SECTOR_COUNT);
+
+    uint32_t cal_new[CAL_COUNT];
+    char cal_keys[CAL_COUNT][16];
+    uint8_t blob_old[40];
+    uint8_t blob_new[70];
+    std::fill_n(blob_old, sizeof(blob_old), 0x0a);
+    std::fill_n(blob_new, sizeof(blob_new), 0x0b);
+    const uint8_t provisioned = 1;
+
+    nvs_batch_item_t items[CAL_COUNT + 3];
+    for (size_t i = 0; i < CAL_COUNT; ++i) {
+        snprintf(cal_keys[i], sizeof(cal_keys[i]), "cal_%d", static_cast<int>(i));
+        cal_new[i] = 2000 + i;
+        items[i] = {cal_keys[i], NVS_TYPE_U32, &cal_new[i], 0};
+    }
+    items[CAL_COUNT] = {"ssid", NVS_TYPE_STR, "new network name", 0};
+    items[CAL_COUNT + 1] = {"bssid", NVS_TYPE_BLOB, blob_new, sizeof(blob_new)};
+    // key which doesn't exist before the batch
+    items[CAL_COUNT + 2] = {"provisioned", NVS_TYPE_U8, &provisioned, 0};
+    const size_t item_count = sizeof(items) / sizeof(items[0]);
+
+    // returns 1 if the handle sees all values of the batch, 0 if it sees all the previous values, -1 otherwise
+    auto check_values = [&](nvs_handle_t handle) -> int {
+        size_t new_count = 0;
+        size_t old_count = 0;
+        for (size_t i = 0; i < CAL_COUNT; ++i) {
+            uint32_t value = 0;
+            TEST_ESP_OK(nvs_get_u32(handle, cal_keys[i], &value));
+            new_count += (value == cal_new[i]);
+            old_count += (value == 1000 + i);
+        }
+        char ssid[32];
+        size_t len = sizeof(ssid);
+        TEST_ESP_OK(nvs_get_str(handle, "ssid", ssid, &len));
+        new_count += (strcmp(ssid, "new network name") == 0);
+        old_count += (strcmp(ssid, "old network") == 0);
+        uint8_t blob[sizeof(blob_new)];
+        len = sizeof(blob);
+        TEST_ESP_OK(nvs_get_blob(handle, "bssid", blob, &len));
+        new_count += (len == sizeof(blob_new) && memcmp(blob, blob_new, len) == 0);
+        old_count += (len == sizeof(blob_old) && memcmp(blob, blob_old, len) == 0);
+        uint8_t value;
+        esp_err_t err = nvs_get_u8(handle, "provisioned", &value);
+        new_count += (err == ESP_OK && value == provisioned);
+        old_count += (err == ESP_ERR_NVS_NOT_FOUND);
+
+        if (new_count == item_count) {
+            return 1;
+        }
+        return (old_count == item_count) ? 0 : -1;
+    };
+
+    size_t interrupted = 0;
+    for (size_t delay = 0; ; ++delay) {
+        INFO(delay);
+        for (uint32_t i = 0; i < SECTOR_COUNT; ++i) {
+            f.erase(i);
+        }
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+        for (size_t i = 0; i < CAL_COUNT; ++i) {
+            TEST_ESP_OK(nvs_set_u32(handle, cal_keys[i], 1000 + i));
+        }
+        TEST_ESP_OK(nvs_set_str(handle, "ssid", "old network"));
+        TEST_ESP_OK(nvs_set_blob(handle, "bssid", blob_old, sizeof(blob_old)));
+
+        esp_partition_fail_after(delay, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+        esp_err_t err = nvs_set_batch(handle, items, item_count);
+        esp_partition_fail_after(SIZE_MAX, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        // "reboot"
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+        int state = check_values(handle);
+        CHECK(state >= 0);
+        if (err == ESP_OK) {
+            CHECK(state == 1);
+        }
+
+        // no leftovers of the interrupted batch, a new one goes through
+        TEST_ESP_OK(nvs_set_batch(handle, items, item_count));
+        CHECK(check_values(handle) == 1);
+        nvs_stats_t stats;
+        TEST_ESP_OK(nvs_get_stats(f.part()->get_partition_name(), &stats));
+        // namespace entry and the items: calibration values, string in 2 entries, blob in 4 + 1 entries and a flag
+        CHECK(stats.used_entries == 1 + CAL_COUNT + 2 + 5 + 1);
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        if (err == ESP_OK) {
+            break;
+        }
+        ++interrupted;
+    }
+    CHECK(interrupted > 0);
+}
+
+TEST_CASE("nvs_set_batch interrupted by a flash error is finished before other writes", "[nvs][batch]")
+{
+    const uint32_t SECTOR_COUNT = 4;
+    const size_t KEY_COUNT = 8;
+    const size_t FILL_COUNT = 300;
+    PartitionEmulationFixture f(0, SECTOR_COUNT);
+
+    char keys[KEY_COUNT][16];
+    uint32_t values[KEY_COUNT];
+    nvs_batch_item_t items[KEY_COUNT];
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        snprintf(keys[i], sizeof(keys[i]), "key_%d", static_cast<int>(i));
+        values[i] = 2000 + i;
+        items[i] = {keys[i], NVS_TYPE_U32, &values[i], 0};
+    }
+
+    size_t interrupted = 0;
+    size_t continued = 0;
+    for (size_t delay = 0; ; ++delay) {
+        INFO(delay);
+        for (uint32_t i = 0; i < SECTOR_COUNT; ++i) {
+            f.erase(i);
+        }
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            TEST_ESP_OK(nvs_set_u32(handle, keys[i], 1000 + i));
+        }
+        // the old values stay in the first page, the batch goes to the next one
+        for (size_t i = 0; i < nvs::Page::ENTRY_COUNT; ++i) {
+            TEST_ESP_OK(nvs_set_u32(handle, "fill", i));
+        }
+
+        esp_partition_fail_after(delay, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+        esp_err_t err = nvs_set_batch(handle, items, KEY_COUNT);
+        esp_partition_fail_after(SIZE_MAX, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+
+        // the process goes on after the error, the writes fill several pages unless the page was left in an
+        // invalid state
+        size_t filled = 0;
+        while (filled < FILL_COUNT && nvs_set_u32(handle, "fill", filled) == ESP_OK) {
+            ++filled;
+        }
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        // "reboot"
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+        size_t new_count = 0;
+        size_t old_count = 0;
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            uint32_t value = 0;
+            TEST_ESP_OK(nvs_get_u32(handle, keys[i], &value));
+            new_count += (value == values[i]);
+            old_count += (value == 1000 + i);
+        }
+        CHECK((new_count == KEY_COUNT || old_count == KEY_COUNT));
+        uint32_t fill = 0;
+        TEST_ESP_OK(nvs_get_u32(handle, "fill", &fill));
+        CHECK(fill == (filled > 0 ? filled - 1 : nvs::Page::ENTRY_COUNT - 1));
+        // no duplicates or markers left: namespace entry, the keys and the fill value
+        nvs_stats_t stats;
+        TEST_ESP_OK(nvs_get_stats(f.part()->get_partition_name(), &stats));
+        CHECK(stats.used_entries == 1 + KEY_COUNT + 1);
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        if (err == ESP_OK) {
+            break;
+        }
+        ++interrupted;
+        continued += (filled > 0);
+    }
+    CHECK(interrupted > 0);
+    CHECK(continued > 0);
+}
+
+TEST_CASE("nvs_set_batch flash usage compared to single writes", "[nvs][batch]")
+{
+    const uint32_t SECTOR_COUNT = 8;
+    const size_t KEY_COUNT = 16;
+    PartitionEmulationFixture f(0, SECTOR_COUNT);
+    char keys[KEY_COUNT][16];
+    uint32_t values[KEY_COUNT];
+    nvs_batch_item_t items[KEY_COUNT];
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        snprintf(keys[i], sizeof(keys[i]), "cal_%d", static_cast<int>(i));
+        items[i] = {keys[i], NVS_TYPE_U32, &values[i], 0};
+    }
+
+    for (bool use_batch : {false, true}) {
+        for (uint32_t i = 0; i < SECTOR_COUNT; ++i) {
+            f.erase(i);
+        }
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("batch", NVS_READWRITE, &handle));
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            TEST_ESP_OK(nvs_set_u32(handle, keys[i], 0));
+        }
+
+        // provisioning overwrites every key
+        const size_t ROUNDS = 10;
+        esp_partition_clear_stats();
+        for (size_t round = 1; round <= ROUNDS; ++round) {
+            for (size_t i = 0; i < KEY_COUNT; ++i) {
+                values[i] = round * 100 + i;
+            }
+            if (use_batch) {
+                TEST_ESP_OK(nvs_set_batch(handle, items, KEY_COUNT));
+            } else {
+                for (size_t i = 0; i < KEY_COUNT; ++i) {
+                    TEST_ESP_OK(nvs_set_u32(handle, keys[i], values[i]));
+                }
+                TEST_ESP_OK(nvs_commit(handle));
+            }
+        }
+
+        s_perf << "Update of " << KEY_COUNT << " u32 keys, " << (use_batch ? "nvs_set_batch" : "nvs_set_u32 per key") << ": "
+               << esp_partition_get_write_ops() / ROUNDS << " flash writes of "
+               << esp_partition_get_write_bytes() / ROUNDS << " bytes, "
+               << esp_partition_get_erase_ops() << " sector erases in " << ROUNDS << " rounds, "
+               << esp_partition_get_total_time() / ROUNDS << " us per round" << std::endl;
+
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            uint32_t value;
+            TEST_ESP_OK(nvs_get_u32(handle, keys[i], &value));
+            CHECK(value == values[i]);
+        }
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+    }
+}
+
+TEST_CASE("nvs_get_blob_view maps single page blobs and copies the others", "[nvs][blob_view]")
+{
+    PartitionEmulationFixture f(0, 8);
+    TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 8));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("view", NVS_READWRITE, &handle));
+
+    const size_t CERT_SIZE = 2048;
+    const size_t LARGE_SIZE = 3 * 4000;
+    std::unique_ptr<uint8_t[]> cert(new uint8_t[CERT_SIZE]);
+    std::unique_ptr<uint8_t[]> large(new uint8_t[LARGE_SIZE]);
+    for (size_t i = 0; i < CERT_SIZE; ++i) {
+        cert[i] = static_cast<uint8_t>(i * 7);
+    }
+    for (size_t i = 0; i < LARGE_SIZE; ++i) {
+        large[i] = static_cast<uint8_t>(i * 13);
+    }
+    TEST_ESP_OK(nvs_set_blob(handle, "cert", cert.get(), CERT_SIZE));
+    TEST_ESP_OK(nvs_set_blob(handle, "large", large.get(), LARGE_SIZE));
+    TEST_ESP_OK(nvs_set_blob(handle, "empty", "", 0));
+    TEST_ESP_OK(nvs_set_str(handle, "name", "value"));
+
+    nvs_blob_view_t view;
+    esp_partition_clear_stats();
+    TEST_ESP_OK(nvs_get_blob_view(handle, "cert", &view));
+    CHECK(view.mapped);
+    CHECK(view.length == CERT_SIZE);
+    CHECK(memcmp(view.data, cert.get(), CERT_SIZE) == 0);
+    // only entry headers are read from flash, the data itself is not copied
+    CHECK(esp_partition_get_read_bytes() < CERT_SIZE);
+    nvs_release_blob_view(&view);
+    CHECK(view.data == nullptr);
+    nvs_release_blob_view(&view);
+
+    // the chunks of a multi-page blob are copied from the mapping as a whole, not entry by entry
+    esp_partition_clear_stats();
+    TEST_ESP_OK(nvs_get_blob_view(handle, "large", &view));
+    CHECK_FALSE(view.mapped);
+    CHECK(view.length == LARGE_SIZE);
+    CHECK(memcmp(view.data, large.get(), LARGE_SIZE) == 0);
+    CHECK(esp_partition_get_read_bytes() < LARGE_SIZE / 4);
+    nvs_release_blob_view(&view);
+
+    TEST_ESP_OK(nvs_get_blob_view(handle, "empty", &view));
+    CHECK(view.length == 0);
+    nvs_release_blob_view(&view);
+
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "missing", &view), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "name", &view), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "cert", nullptr), ESP_ERR_INVALID_ARG);
+
+    // a view taken after an update sees the new value, which may have been split across pages
+    cert[0] ^= 0xff;
+    TEST_ESP_OK(nvs_set_blob(handle, "cert", cert.get(), CERT_SIZE));
+    TEST_ESP_OK(nvs_get_blob_view(handle, "cert", &view));
+    CHECK(view.length == CERT_SIZE);
+    CHECK(memcmp(view.data, cert.get(), CERT_SIZE) == 0);
+    nvs_release_blob_view(&view);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("nvs_get_blob_view detects corrupted data", "[nvs][blob_view]")
+{
+    PartitionEmulationFixture f(0, 3);
+    TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 3));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("view", NVS_READWRITE, &handle));
+
+    uint8_t blob[256];
+    memset(blob, 0x5a, sizeof(blob));
+    TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, sizeof(blob)));
+
+    const void *base = nullptr;
+    esp_partition_mmap_handle_t map_handle;
+    TEST_ESP_OK(esp_partition_mmap(f.get_esp_partition(), 0, 3 * SPI_FLASH_SEC_SIZE, ESP_PARTITION_MMAP_DATA, &base, &map_handle));
+
+    nvs_blob_view_t view;
+    TEST_ESP_OK(nvs_get_blob_view(handle, "blob", &view));
+    REQUIRE(view.mapped);
+    size_t offset = static_cast<const uint8_t*>(view.data) - static_cast<const uint8_t*>(base);
+    nvs_release_blob_view(&view);
+    esp_partition_munmap(map_handle);
+
+    // clear some bits of the data, the crc32 stored in the entry header doesn't match anymore
+    const uint32_t zero = 0;
+    TEST_ESP_OK(esp_partition_write_raw(f.get_esp_partition(), offset + 64, &zero, sizeof(zero)));
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "blob", &view), ESP_ERR_NVS_NOT_FOUND);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("nvs_get_blob_view read cost compared to nvs_get_blob", "[nvs][blob_view]")
+{
+    const size_t ROUNDS = 1000;
+
+    // the largest size spans three pages and is copied from the mapping chunk by chunk
+    for (size_t cert_size : {512, 2048, 3900, 10000}) {
+        PartitionEmulationFixture f(0, 8);
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, 8));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("view", NVS_READWRITE, &handle));
+
+        std::unique_ptr<uint8_t[]> cert(new uint8_t[cert_size]);
+        for (size_t i = 0; i < cert_size; ++i) {
+            cert[i] = static_cast<uint8_t>(i);
+        }
+        TEST_ESP_OK(nvs_set_blob(handle, "cert", cert.get(), cert_size));
+        std::unique_ptr<uint8_t[]> buf(new uint8_t[cert_size]);
+
+        for (bool use_view : {false, true}) {
+            uint32_t sum = 0;
+            bool mapped = false;
+            esp_partition_clear_stats();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t round = 0; round < ROUNDS; ++round) {
+                if (use_view) {
+                    nvs_blob_view_t view;
+                    TEST_ESP_OK(nvs_get_blob_view(handle, "cert", &view));
+                    sum += static_cast<const uint8_t*>(view.data)[cert_size - 1];
+                    mapped = view.mapped;
+                    nvs_release_blob_view(&view);
+                } else {
+                    size_t length = cert_size;
+                    TEST_ESP_OK(nvs_get_blob(handle, "cert", buf.get(), &length));
+                    sum += buf[cert_size - 1];
+                }
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            CHECK(sum == ROUNDS * static_cast<uint8_t>(cert_size - 1));
+            if (use_view) {
+                CHECK(mapped == (cert_size < 4000));
+            }
+
+            s_perf << "Read of a " << cert_size << " byte blob, "
+                   << (use_view ? (mapped ? "nvs_get_blob_view (mapped)" : "nvs_get_blob_view (copied)") : "nvs_get_blob") << ": "
+                   << elapsed / ROUNDS << " ns per read, "
+                   << esp_partition_get_read_ops() / ROUNDS << " flash reads and "
+                   << esp_partition_get_read_bytes() / ROUNDS << " bytes read from flash per read" << std::endl;
+        }
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+}
+
+// Writes values which are never updated afterwards, the pages holding them can only be reclaimed by moving them
+static void gc_write_static_values(nvs_handle_t handle)
+{
+    uint8_t blob[100];
+    for (size_t i = 0; i < sizeof(blob); ++i) {
+        blob[i] = static_cast<uint8_t>(i);
+    }
+    TEST_ESP_OK(nvs_set_blob(handle, "static_blob", blob, sizeof(blob)));
+    char key[16];
+    for (uint32_t i = 0; i < 6; ++i) {
+        snprintf(key, sizeof(key), "static_%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_set_u32(handle, key, 100 + i));
+    }
+}
+
+// Returns the number of entries used by the values written by gc_write_static_values
+static size_t gc_check_static_values(nvs_handle_t handle)
+{
+    uint8_t blob[100];
+    size_t len = sizeof(blob);
+    TEST_ESP_OK(nvs_get_blob(handle, "static_blob", blob, &len));
+    CHECK(len == sizeof(blob));
+    for (size_t i = 0; i < sizeof(blob); ++i) {
+        CHECK(blob[i] == static_cast<uint8_t>(i));
+    }
+    char key[16];
+    for (uint32_t i = 0; i < 6; ++i) {
+        uint32_t value = 0;
+        snprintf(key, sizeof(key), "static_%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+        CHECK(value == 100 + i);
+    }
+    // blob index, blob data in 1 + 4 entries and the integers
+    return 1 + 5 + 6;
+}
+
+TEST_CASE("nvs_gc_step reclaims pages outside of the write path", "[nvs][gc]")
+{
+    const uint32_t SECTOR_COUNT = 6;
+    const int KEY_COUNT = 30;
+    const int UPDATES = 3000;
+    const int FIXED_EVERY = 50;
+    char key[16];
+    char value[32];
+
+    for (bool use_gc : {false, true}) {
+        PartitionEmulationFixture f(0, SECTOR_COUNT);
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("gc", NVS_READWRITE, &handle));
+        gc_write_static_values(handle);
+
+        size_t max_write_time = 0;
+        size_t max_step_time = 0;
+        size_t write_erases = 0;
+        size_t steps = 0;
+        for (int i = 0; i < UPDATES; ++i) {
+            snprintf(key, sizeof(key), "key_%d", i % KEY_COUNT);
+            snprintf(value, sizeof(value), "value %d", i);
+            esp_partition_clear_stats();
+            TEST_ESP_OK(nvs_set_str(handle, key, value));
+            if (i % FIXED_EVERY == 0) {
+                // keys which are never updated again end up in every page, reclaiming a page means moving them
+                snprintf(key, sizeof(key), "fixed_%d", i);
+                TEST_ESP_OK(nvs_set_u32(handle, key, i));
+            }
+            max_write_time = std::max(max_write_time, esp_partition_get_total_time());
+            write_erases += esp_partition_get_erase_ops();
+
+            if (use_gc) {
+                // one step after every write, as an idle task would do
+                bool pending;
+                esp_partition_clear_stats();
+                TEST_ESP_OK(nvs_gc_step(NULL, 8, &pending));
+                max_step_time = std::max(max_step_time, esp_partition_get_total_time());
+                steps += (esp_partition_get_write_ops() + esp_partition_get_erase_ops() > 0);
+            }
+        }
+
+        for (int k = 0; k < KEY_COUNT; ++k) {
+            int last = UPDATES - KEY_COUNT + k;
+            snprintf(key, sizeof(key), "key_%d", last % KEY_COUNT);
+            snprintf(value, sizeof(value), "value %d", last);
+            char read_value[32];
+            size_t len = sizeof(read_value);
+            TEST_ESP_OK(nvs_get_str(handle, key, read_value, &len));
+            CHECK(strcmp(read_value, value) == 0);
+        }
+        for (int i = 0; i < UPDATES; i += FIXED_EVERY) {
+            uint32_t fixed = 0;
+            snprintf(key, sizeof(key), "fixed_%d", i);
+            TEST_ESP_OK(nvs_get_u32(handle, key, &fixed));
+            CHECK(fixed == static_cast<uint32_t>(i));
+        }
+        size_t static_entries = gc_check_static_values(handle);
+        nvs_stats_t stats;
+        TEST_ESP_OK(nvs_get_stats(NULL, &stats));
+        CHECK(stats.used_entries == 1 + static_entries + KEY_COUNT * 2 + (UPDATES + FIXED_EVERY - 1) / FIXED_EVERY);
+
+        if (use_gc) {
+            // all sectors were erased by the steps, none by a write
+            CHECK(write_erases == 0);
+            CHECK(steps > 0);
+        } else {
+            CHECK(write_erases > 0);
+        }
+
+        s_perf << UPDATES << " string updates in " << SECTOR_COUNT << " pages, "
+               << (use_gc ? "nvs_gc_step after each write" : "reclaim on write") << ": max "
+               << max_write_time << " us per write, " << write_erases << " sector erases during writes";
+        if (use_gc) {
+            s_perf << ", " << steps << " steps doing work, max " << max_step_time << " us per step";
+        }
+        s_perf << std::endl;
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+}
+
+TEST_CASE("nvs_gc_step is safe across power-off", "[nvs][gc]")
+{
+    const uint32_t SECTOR_COUNT = 4;
+    const int KEY_COUNT = 10;
+    const int UPDATES = 150;
+    const int FIXED_EVERY = 8;
+    PartitionEmulationFixture f(0, SECTOR_COUNT);
+    char key[16];
+    char value[32];
+
+    auto check_values = [&](nvs_handle_t handle) {
+        for (int k = 0; k < KEY_COUNT; ++k) {
+            int last = UPDATES - KEY_COUNT + k;
+            snprintf(key, sizeof(key), "key_%d", last % KEY_COUNT);
+            snprintf(value, sizeof(value), "value %d", last);
+            char read_value[32];
+            size_t len = sizeof(read_value);
+            TEST_ESP_OK(nvs_get_str(handle, key, read_value, &len));
+            CHECK(strcmp(read_value, value) == 0);
+        }
+        for (int i = 0; i < UPDATES; i += FIXED_EVERY) {
+            uint32_t fixed = 0;
+            snprintf(key, sizeof(key), "fixed_%d", i);
+            TEST_ESP_OK(nvs_get_u32(handle, key, &fixed));
+            CHECK(fixed == static_cast<uint32_t>(i));
+        }
+        size_t static_entries = gc_check_static_values(handle);
+        nvs_stats_t stats;
+        TEST_ESP_OK(nvs_get_stats(NULL, &stats));
+        CHECK(stats.used_entries == 1 + static_entries + KEY_COUNT * 2 + (UPDATES + FIXED_EVERY - 1) / FIXED_EVERY);
+    };
+
+    size_t interrupted = 0;
+    for (size_t delay = 0; ; ++delay) {
+        INFO(delay);
+        for (uint32_t i = 0; i < SECTOR_COUNT; ++i) {
+            f.erase(i);
+        }
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("gc", NVS_READWRITE, &handle));
+        gc_write_static_values(handle);
+        for (int i = 0; i < UPDATES; ++i) {
+            snprintf(key, sizeof(key), "key_%d", i % KEY_COUNT);
+            snprintf(value, sizeof(value), "value %d", i);
+            TEST_ESP_OK(nvs_set_str(handle, key, value));
+            if (i % FIXED_EVERY == 0) {
+                snprintf(key, sizeof(key), "fixed_%d", i);
+                TEST_ESP_OK(nvs_set_u32(handle, key, i));
+            }
+        }
+
+        esp_partition_fail_after(delay, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+        esp_err_t err = ESP_OK;
+        bool pending = true;
+        int steps = 0;
+        while (err == ESP_OK && pending) {
+            err = nvs_gc_step(NULL, 4, &pending);
+            ++steps;
+        }
+        esp_partition_fail_after(SIZE_MAX, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+        if (err == ESP_OK) {
+            // the static values have to be moved before their page is erased
+            CHECK(steps > 2);
+            check_values(handle);
+        }
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        // "reboot"
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        TEST_ESP_OK(nvs_open("gc", NVS_READWRITE, &handle));
+        check_values(handle);
+        do {
+            TEST_ESP_OK(nvs_gc_step(NULL, 4, &pending));
+        } while (pending);
+        check_values(handle);
+        TEST_ESP_OK(nvs_set_str(handle, "key_0", "after reboot"));
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part()->get_partition_name()));
+
+        if (err == ESP_OK) {
+            break;
+        }
+        ++interrupted;
+    }
+    CHECK(interrupted > 0);
+}
+
+/* The HashList replaced by the open-addressed table: blocks of nodes in a list, searched from the first node on.
+ * Kept here so the lookup benchmark can compare both. */
+class BlockChainHashList
+{
+public:
+    ~BlockChainHashList()
+    {
+        for (auto it = mBlockList.begin(); it != mBlockList.end();) {
+            auto tmp = it;
+            ++it;
+            mBlockList.erase(tmp);
+            delete static_cast<Block*>(tmp);
+        }
+    }
+
+    esp_err_t insert(const nvs::Item& item, size_t index)
+    {
+        const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
+        if (mBlockList.size() && mBlockList.back().mCount < Block::ENTRY_COUNT) {
+            auto& block = mBlockList.back();
+            block.mNodes[block.mCount++] = {static_cast<uint32_t>(index), hash_24};
+            return ESP_OK;
+        }
+        Block* newBlock = new (std::nothrow) Block;
+        if (!newBlock) {
+            return ESP_ERR_NO_MEM;
+        }
+        mBlockList.push_back(newBlock);
+        newBlock->mNodes[newBlock->mCount++] = {static_cast<uint32_t>(index), hash_24};
+        return ESP_OK;
+    }
+
+    size_t find(size_t start, const nvs::Item& item)
+    {
+        const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
+        for (auto it = mBlockList.begin(); it != mBlockList.end(); ++it) {
+            for (size_t index = 0; index < it->mCount; ++index) {
+                const Node& e = it->mNodes[index];
+                if (e.mIndex >= start && e.mHash == hash_24 && e.mIndex != 0xff) {
+                    return e.mIndex;
+                }
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    size_t getHeapSize()
+    {
+        return mBlockList.size() * sizeof(Block);
+    }
+
+private:
+    struct Node {
+        uint32_t mIndex : 8;
+        uint32_t mHash  : 24;
+    };
+
+    struct Block : public intrusive_list_node<Block>, public ExceptionlessAllocatable {
+        static const size_t BYTE_SIZE = 128;
+        static const size_t ENTRY_COUNT = (BYTE_SIZE - sizeof(intrusive_list_node<Block>) - sizeof(size_t)) / 4;
+
+        size_t mCount = 0;
+        Node mNodes[ENTRY_COUNT];
+    };
+
+    intrusive_list<Block> mBlockList;
+};
+
+template<typename THashList>
+static void benchmark_hashlist(const char *name, size_t item_count)
+{
+    const size_t ROUNDS = 2000;
+
+    THashList hashlist;
+    std::vector<nvs::Item> items;
+    std::vector<nvs::Item> missing;
+    for (size_t i = 0; i < item_count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key_%d", static_cast<int>(i));
+        items.emplace_back(1, nvs::ItemType::U32, 1, key);
+        snprintf(key, sizeof(key), "missing_%d", static_cast<int>(i));
+        missing.emplace_back(1, nvs::ItemType::U32, 1, key);
+    }
+    for (size_t i = 0; i < item_count; ++i) {
+        TEST_ESP_OK(hashlist.insert(items[i], i));
+    }
+    size_t heap_size = hashlist.getHeapSize();
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < item_count; ++i) {
+            found += (hashlist.find(0, items[i]) == i);
+        }
+    }
+    auto hit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(found == ROUNDS * item_count);
+
+    size_t not_found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < item_count; ++i) {
+            not_found += (hashlist.find(0, missing[i]) == SIZE_MAX);
+        }
+    }
+    auto miss_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    // 24-bit hashes of different keys may collide, but hardly ever
+    CHECK(not_found + 2 * ROUNDS >= ROUNDS * item_count);
+
+    s_perf << name << " with " << item_count << " items: " << heap_size << " bytes of heap, "
+           << hit_ns / (ROUNDS * item_count) << " ns per hit, "
+           << miss_ns / (ROUNDS * item_count) << " ns per miss" << std::endl;
+}
+
+TEST_CASE("HashList lookup time and heap usage", "[nvs][hashlist]")
+{
+    // a page full of integers and a page of strings taking 3 entries each
+    for (size_t item_count : {nvs::Page::ENTRY_COUNT, nvs::Page::ENTRY_COUNT / 3}) {
+        benchmark_hashlist<BlockChainHashList>("HashList block chain (before)", item_count);
+        benchmark_hashlist<HashListTestHelper>("HashList open addressing", item_count);
+    }
+}
+
+TEST_CASE("nvs init benchmark for several partitions with whole page reads", "[nvs][fast_init]")
+{
+    struct BenchPartition {
+        const char *name;
+        uint32_t baseSector;
+        uint32_t sectorCount;
+        int keyCount;
+    };
+    // layout of a typical application: default partition, factory data and a small one for keys
+    const BenchPartition partitions[] = {
+        {NVS_DEFAULT_PART_NAME, 0, 8, 300},
+        {"nvs_factory", 8, 4, 80},
+        {"nvs_keys", 12, 2, 4},
+    };
+    const uint32_t TOTAL_SECTORS = 14;
+    PartitionEmulationFixture f_default(0, TOTAL_SECTORS, partitions[0].name);
+    PartitionEmulationFixture f_factory(0, TOTAL_SECTORS, partitions[1].name);
+    PartitionEmulationFixture f_keys(0, TOTAL_SECTORS, partitions[2].name);
+    nvs::Partition *parts[] = {f_default.part(), f_factory.part(), f_keys.part()};
+
+    char key[16];
+    char value[32];
+    for (size_t p = 0; p < 3; ++p) {
+        nvs::Storage writer(parts[p]);
+        TEST_ESP_OK(writer.init(partitions[p].baseSector, partitions[p].sectorCount));
+        uint8_t ns_index;
+        TEST_ESP_OK(writer.createOrOpenNamespace("boot", true, ns_index));
+        for (int i = 0; i < partitions[p].keyCount; ++i) {
+            snprintf(key, sizeof(key), "key_%d", i);
+            if (i % 3 == 0) {
+                snprintf(value, sizeof(value), "value %d", i);
+                TEST_ESP_OK(writer.writeItem(ns_index, nvs::ItemType::SZ, key, value, strlen(value) + 1));
+            } else {
+                TEST_ESP_OK(writer.writeItem(ns_index, key, static_cast<uint32_t>(i)));
+            }
+        }
+        // updates leave erased entries behind
+        for (int i = 1; i < partitions[p].keyCount; i += 3) {
+            snprintf(key, sizeof(key), "key_%d", i);
+            TEST_ESP_OK(writer.writeItem(ns_index, key, static_cast<uint32_t>(i + 1)));
+        }
+    }
+
+    nvs_stats_t reference_stats[3];
+    size_t flash_time[2];
+    size_t read_ops[2];
+    size_t read_bytes[2];
+    long long elapsed[2];
+    for (bool whole_pages : {false, true}) {
+        esp_partition_clear_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < 3; ++p) {
+            nvs::Storage storage(parts[p]);
+            storage.setReadWholePages(whole_pages);
+            TEST_ESP_OK(storage.init(partitions[p].baseSector, partitions[p].sectorCount));
+
+            nvs_stats_t stats;
+            TEST_ESP_OK(storage.fillStats(stats));
+            if (!whole_pages) {
+                reference_stats[p] = stats;
+            } else {
+                CHECK(stats.used_entries == reference_stats[p].used_entries);
+                CHECK(stats.free_entries == reference_stats[p].free_entries);
+                CHECK(stats.namespace_count == reference_stats[p].namespace_count);
+
+                uint8_t ns_index;
+                TEST_ESP_OK(storage.createOrOpenNamespace("boot", false, ns_index));
+                uint32_t u32;
+                TEST_ESP_OK(storage.readItem(ns_index, "key_1", u32));
+                CHECK(u32 == 2);
+                TEST_ESP_OK(storage.readItem(ns_index, nvs::ItemType::SZ, "key_0", value, sizeof(value)));
+                CHECK(strcmp(value, "value 0") == 0);
+            }
+        }
+        elapsed[whole_pages] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        flash_time[whole_pages] = esp_partition_get_total_time();
+        read_ops[whole_pages] = esp_partition_get_read_ops();
+        read_bytes[whole_pages] = esp_partition_get_read_bytes();
+    }
+
+    // a few reads per page instead of one per item and scan. The emulated flash time is charged by the number
+    // of bytes rather than by the number of reads and doesn't show the difference.
+    CHECK(read_ops[true] * 10 < read_ops[false]);
+    s_perf << "Init of 3 partitions (" << TOTAL_SECTORS << " pages), per-entry reads: " << elapsed[false] << " us ("
+           << read_ops[false] << "R " << read_bytes[false] << "Rb, emulated flash time " << flash_time[false] << " us)"
+           << ", whole page reads: " << elapsed[true] << " us (" << read_ops[true] << "R " << read_bytes[true]
+           << "Rb, emulated flash time " << flash_time[true] << " us)" << std::endl;
+}
+
 /* Add new tests above */
 /* This test has to be the final one */
 
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -39,3 +39,28 @@ TEST_CASE("nvs_flash_init_partition_ptr inits one partition", "[nvs_custom_part]
     CHECK(nvs::NVSPartitionManager::get_instance()->lookup_storage_from_name("test") != nullptr);
     CHECK(nvs::NVSPartitionManager::get_instance()->deinit_partition("test") == ESP_OK);
 }
+
+TEST_CASE("nvs_flash_init_partitions inits every listed partition once", "[nvs_custom_part]")
+{
+    uint8_t *p_part_desc_addr_start;
+    CHECK(esp_partition_file_mmap((const uint8_t **)&p_part_desc_addr_start) == ESP_OK);
+
+    CHECK(nvs_flash_init_partitions(nullptr, 1) == ESP_ERR_INVALID_ARG);
+
+    // nothing is initialized if one of the partitions doesn't exist
+    const char *with_missing[] = {NVS_DEFAULT_PART_NAME, "missing"};
+    CHECK(nvs_flash_init_partitions(with_missing, 2) == ESP_ERR_NOT_FOUND);
+    CHECK(nvs::NVSPartitionManager::get_instance()->lookup_storage_from_name(NVS_DEFAULT_PART_NAME) == nullptr);
+
+    const char *names[] = {NVS_DEFAULT_PART_NAME, NVS_DEFAULT_PART_NAME};
+    CHECK(nvs_flash_init_partitions(names, 2) == ESP_OK);
+    CHECK(nvs::NVSPartitionManager::get_instance()->lookup_storage_from_name(NVS_DEFAULT_PART_NAME) != nullptr);
+    CHECK(nvs_flash_init_partitions(names, 1) == ESP_OK);
+
+    nvs_handle_t handle;
+    CHECK(nvs_open("init", NVS_READWRITE, &handle) == ESP_OK);
+    CHECK(nvs_set_u8(handle, "value", 1) == ESP_OK);
+    nvs_close(handle);
+
+    CHECK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME) == ESP_OK);
+}
@@ -122,6 +122,27 @@ typedef struct {
     nvs_type_t type;                            /*!< Type of stored key-value pair */
 } nvs_entry_info_t;
 
+/**
+ * @brief One key-value pair to be written by nvs_set_batch function
+ */
+typedef struct {
+    const char *key;        /*!< Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters */
+    nvs_type_t type;        /*!< Type of the value: one of the integer types, NVS_TYPE_STR or NVS_TYPE_BLOB */
+    const void *value;      /*!< Pointer to an integer of the matching width, to a zero-terminated string or to the blob data */
+    size_t length;          /*!< Length of the blob data in bytes, ignored for the other types */
+} nvs_batch_item_t;
+
+/**
+ * @brief Read-only view of a blob value obtained with nvs_get_blob_view function
+ */
+typedef struct {
+    const void *data;       /*!< Pointer to the blob data, must not be written to */
+    size_t length;          /*!< Length of the blob data in bytes */
+    bool mapped;            /*!< true if data points into the memory mapped partition, false if it points to a copy on the heap */
+    uint32_t map_handle;    /*!< Handle of the mapping, used by nvs_release_blob_view */
+    void *partition;        /*!< Partition the data is mapped from, used by nvs_release_blob_view */
+} nvs_blob_view_t;
+
 /**
  * Opaque pointer type representing iterator to nvs entries
  */
@@ -345,6 +366,42 @@ esp_err_t nvs_set_str (nvs_handle_t handle, const char* key, const char* value);
  */
 esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
 
+/**
+ * @brief      set several key-value pairs as one atomic update
+ *
+ * All items are staged in RAM first and then written in one pass into a single NVS page, followed by
+ * the erasure of the values they replace. The update is atomic with respect to power loss: if the power
+ * goes off before the batch is complete, the next initialization of NVS restores the previous values of
+ * all keys of the batch, if it goes off afterwards, all new values are kept.
+ *
+ * Items whose value is identical to the stored one are not written again. Each key may appear only once
+ * in a batch. Blobs are stored in one chunk, so the whole batch, including 2 entries of overhead, has to fit
+ * into the 126 entries of one page.
+ *
+ * @param[in]  handle  Handle obtained from nvs_open function.
+ *                     Handles that were opened read only cannot be used.
+ * @param[in]  items   Array of items to write.
+ * @param[in]  count   Number of items in the array.
+ *
+ * @return
+ *             - ESP_OK if all values were set successfully
+ *             - ESP_FAIL if there is an internal error; most likely due to corrupted
+ *               NVS partition (only if NVS assertion checks are disabled)
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if storage handle was opened as read only
+ *             - ESP_ERR_INVALID_ARG if items is NULL, an item has no key, no value or an unsupported type,
+ *               or a key appears more than once
+ *             - ESP_ERR_NVS_KEY_TOO_LONG if a key name is too long
+ *             - ESP_ERR_NVS_VALUE_TOO_LONG if a string or blob does not fit into one page
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if the batch does not fit into one page or there is not enough
+ *               space in the underlying storage to save it
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the values were written, but erasing the replaced values
+ *               failed. The update will be finished after re-initialization of nvs, provided that
+ *               flash operation doesn't fail again.
+ *             - ESP_ERR_NO_MEM if memory for staging the batch couldn't be allocated
+ */
+esp_err_t nvs_set_batch(nvs_handle_t handle, const nvs_batch_item_t *items, size_t count);
+
 /**@{*/
 /**
  * @brief      get int8_t value for given key
@@ -501,6 +558,55 @@ esp_err_t nvs_get_str (nvs_handle_t handle, const char* key, char* out_value, si
 esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
 /**@}*/
 
+/**
+ * @brief      get read-only view of blob value for given key
+ *
+ * Unlike nvs_get_blob, this function doesn't copy the data if the blob is stored in a single page:
+ * the data is mapped with esp_partition_mmap and out_view->data points directly into the mapped flash.
+ * Blobs spread over several pages, empty blobs and blobs in partitions which can't be mapped
+ * (e.g. encrypted NVS partitions or partitions on external flash) are copied into a buffer
+ * allocated on the heap instead, out_view->mapped tells which case applies.
+ * The integrity of the data is checked in both cases.
+ *
+ * The view has to be released with nvs_release_blob_view. The mapped data only stays valid
+ * as long as the page holding it is not changed. Any write to the partition may reclaim that page
+ * and nvs_gc_step may move the blob and erase its page: release the view before any value of the
+ * partition is set or erased (with any handle), before nvs_gc_step is called for the partition,
+ * and before the partition is erased or deinitialized. Copy the data if it is needed for longer.
+ *
+ * \code{c}
+ * // Example (without error checking) of passing a certificate stored in NVS to a TLS library:
+ * nvs_blob_view_t view;
+ * nvs_get_blob_view(my_handle, "client_cert", &view);
+ * tls_set_client_cert(view.data, view.length);
+ * nvs_release_blob_view(&view);
+ * \endcode
+ *
+ * @param[in]  handle    Handle obtained from nvs_open function.
+ * @param[in]  key       Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[out] out_view  Pointer to the view to be filled in. Not modified in case of an error.
+ *
+ * @return
+ *             - ESP_OK if the value was retrieved successfully
+ *             - ESP_FAIL if there is an internal error; most likely due to corrupted
+ *               NVS partition (only if NVS assertion checks are disabled)
+ *             - ESP_ERR_NVS_NOT_FOUND if the requested key doesn't exist
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_NAME if key name doesn't satisfy constraints
+ *             - ESP_ERR_INVALID_ARG if out_view is NULL
+ *             - ESP_ERR_NO_MEM if the blob had to be copied and memory for the copy couldn't be allocated
+ */
+esp_err_t nvs_get_blob_view(nvs_handle_t handle, const char* key, nvs_blob_view_t* out_view);
+
+/**
+ * @brief      release view obtained with nvs_get_blob_view
+ *
+ * Unmaps the data or frees the copy. The view is cleared and may be released again afterwards.
+ *
+ * @param[in]  view  Pointer to the view, may be NULL.
+ */
+void nvs_release_blob_view(nvs_blob_view_t* view);
+
 /**
  * @brief      Lookup key-value pair with given key name.
  *
@@ -635,6 +741,46 @@ typedef struct {
  */
 esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats);
 
+/**
+ * @brief      Do a bounded amount of page reclaim work ahead of time
+ *
+ * When the active page of a partition fills up and fewer than two pages are free, the write which
+ * needs a new page reclaims one synchronously: it copies all live entries of the page with the most
+ * erased entries and erases the flash sector. That makes a single nvs_set_* call take a long time.
+ *
+ * This function does the same work in small steps outside of the write path, so that the partition
+ * keeps a spare free page. Each call either moves items of at most max_entries entries (32 bytes
+ * each, at least one item is moved even if it is larger) or erases one emptied sector. It does
+ * nothing while two or more pages are free. Call it from a low priority task, e.g. whenever the
+ * application is idle, until out_pending is false.
+ *
+ * Moving an item is power-off safe in the same way as updating its value. If the steps don't keep up
+ * with the writes, the synchronous reclaim still takes place. Like a write, a step may move a blob
+ * mapped by nvs_get_blob_view, views of the partition have to be released before.
+ *
+ * \code{c}
+ * // Example (without error checking) of a low priority task doing the reclaim work:
+ * bool pending = true;
+ * while (pending) {
+ *     nvs_gc_step(NULL, 16, &pending);
+ *     vTaskDelay(1);
+ * }
+ * \endcode
+ *
+ * @param[in]   part_name    Partition name NVS in the partition table.
+ *                           If pass a NULL than will use NVS_DEFAULT_PART_NAME ("nvs").
+ * @param[in]   max_entries  Maximum number of entries moved by this call.
+ * @param[out]  out_pending  Set to true if another call can make further progress. May be NULL.
+ *
+ * @return
+ *             - ESP_OK if the step was done or there was nothing to do
+ *             - ESP_ERR_NVS_NOT_INITIALIZED if the storage driver is not initialized
+ *             - ESP_ERR_NVS_INVALID_STATE if the partition is in an inconsistent state due to a previous error
+ *             - ESP_ERR_NO_MEM if memory for moving an item couldn't be allocated
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_gc_step(const char *part_name, size_t max_entries, bool *out_pending);
+
 /**
  * @brief      Calculate all entries in a namespace.
  *
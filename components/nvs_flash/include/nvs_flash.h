@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -92,6 +92,25 @@ esp_err_t nvs_flash_init(void);
  */
 esp_err_t nvs_flash_init_partition(const char *partition_label);
 
+/**
+ * @brief Initialize NVS flash storage for several partitions at once.
+ *
+ * The partitions are looked up in the partition table as with nvs_flash_init_partition. Their pages are then
+ * loaded concurrently, each partition on a task of its own with the priority of the calling task, which shortens
+ * startup if there are several NVS partitions. Partitions which are initialized already are skipped.
+ * If one of the partitions is not found in the partition table, or memory for it could not be allocated, none of
+ * the partitions is initialized. If the pages of a partition fail to load, the other partitions are still initialized.
+ *
+ * @param[in]  part_names   Array of partition labels, each no longer than 16 characters.
+ * @param[in]  count        Number of labels in part_names.
+ *
+ * @return
+ *      - ESP_OK if all partitions were successfully initialized.
+ *      - ESP_ERR_INVALID_ARG if part_names is NULL or one of the labels is too long
+ *      - the first error nvs_flash_init_partition would return for one of the partitions
+ */
+esp_err_t nvs_flash_init_partitions(const char *const *part_names, size_t count);
+
 /**
  * @brief Initialize NVS flash storage for the partition specified by partition pointer.
  *
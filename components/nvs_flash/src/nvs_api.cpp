@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -133,6 +133,22 @@ extern "C" esp_err_t nvs_flash_init_partition(const char *part_name)
     return NVSPartitionManager::get_instance()->init_partition(part_name);
 }
 
+extern "C" esp_err_t nvs_flash_init_partitions(const char *const *part_names, size_t count)
+{
+    esp_err_t lock_result = Lock::init();
+    if (lock_result != ESP_OK) {
+        return lock_result;
+    }
+    Lock lock;
+
+    if (part_names == nullptr && count != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    assert(nvs::Page::SEC_SIZE == esp_partition_get_main_flash_sector_size());
+    return NVSPartitionManager::get_instance()->init_partitions(part_names, count);
+}
+
 extern "C" esp_err_t nvs_flash_init(void)
 {
 #ifdef CONFIG_NVS_ENCRYPTION
@@ -444,6 +460,17 @@ extern "C" esp_err_t nvs_set_blob(nvs_handle_t c_handle, const char* key, const
     return handle->set_blob(key, value, length);
 }
 
+extern "C" esp_err_t nvs_set_batch(nvs_handle_t c_handle, const nvs_batch_item_t* items, size_t count)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, static_cast<int>(count));
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->set_batch(items, count);
+}
 
 template<typename T>
 static esp_err_t nvs_get(nvs_handle_t c_handle, const char* key, T* out_value)
@@ -538,6 +565,35 @@ extern "C" esp_err_t nvs_get_blob(nvs_handle_t c_handle, const char* key, void*
     return nvs_get_str_or_blob(c_handle, nvs::ItemType::BLOB, key, out_value, length);
 }
 
+extern "C" esp_err_t nvs_get_blob_view(nvs_handle_t c_handle, const char* key, nvs_blob_view_t* out_view)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s", __func__, key);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->get_blob_view(key, out_view);
+}
+
+extern "C" void nvs_release_blob_view(nvs_blob_view_t* view)
+{
+    if (view == nullptr) {
+        return;
+    }
+    if (view->mapped) {
+        static_cast<Partition*>(view->partition)->munmap(view->map_handle);
+    } else {
+        delete[] static_cast<const uint8_t*>(view->data);
+    }
+    view->data = nullptr;
+    view->length = 0;
+    view->mapped = false;
+    view->map_handle = 0;
+    view->partition = nullptr;
+}
+
 extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats)
 {
     Lock lock;
@@ -564,6 +620,32 @@ extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
     return pStorage->fillStats(*nvs_stats);
 }
 
+extern "C" esp_err_t nvs_gc_step(const char* part_name, size_t max_entries, bool* out_pending)
+{
+    Lock lock;
+    nvs::Storage* pStorage;
+    bool pending = false;
+
+    if (out_pending != nullptr) {
+        *out_pending = false;
+    }
+
+    pStorage = lookup_storage_from_name((part_name == nullptr) ? NVS_DEFAULT_PART_NAME : part_name);
+    if (pStorage == nullptr) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if(!pStorage->isValid()){
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    auto err = pStorage->gcStep(max_entries, pending);
+    if (out_pending != nullptr) {
+        *out_pending = pending;
+    }
+    return err;
+}
+
 extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* used_entries)
 {
     Lock lock;
@@ -33,6 +33,19 @@ public:
 
     esp_err_t write(size_t dst_offset, const void* src, size_t size) override;
 
+    /**
+     * Mapped memory holds the encrypted data, readers have to go through read().
+     */
+    esp_err_t mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle) override
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    bool get_encrypted() override
+    {
+        return true;
+    }
+
 protected:
     mbedtls_aes_xts_context mEctxt;
     mbedtls_aes_xts_context mDctxt;
@@ -44,6 +44,44 @@ esp_err_t NVSHandleSimple::set_blob(const char *key, const void* blob, size_t le
     return mStoragePtr->writeItem(mNsIndex, nvs::ItemType::BLOB, key, blob, len);
 }
 
+esp_err_t NVSHandleSimple::set_batch(const nvs_batch_item_t *items, size_t count)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (items == nullptr && count != 0) return ESP_ERR_INVALID_ARG;
+
+    std::unique_ptr<Storage::BatchItem[]> batch(new (std::nothrow) Storage::BatchItem[count]);
+    if (count != 0 && !batch) return ESP_ERR_NO_MEM;
+
+    for (size_t i = 0; i < count; ++i) {
+        const nvs_batch_item_t &item = items[i];
+        Storage::BatchItem &batchItem = batch[i];
+        if (item.value == nullptr) return ESP_ERR_INVALID_ARG;
+
+        batchItem.key = item.key;
+        batchItem.data = item.value;
+        switch (item.type) {
+        case NVS_TYPE_STR:
+            batchItem.datatype = ItemType::SZ;
+            batchItem.dataSize = strlen(static_cast<const char*>(item.value)) + 1;
+            break;
+        case NVS_TYPE_BLOB:
+            batchItem.datatype = ItemType::BLOB;
+            batchItem.dataSize = item.length;
+            break;
+        case NVS_TYPE_ANY:
+            return ESP_ERR_INVALID_ARG;
+        default:
+            // the lower nibble of the integer types is their size
+            batchItem.datatype = static_cast<ItemType>(item.type);
+            batchItem.dataSize = item.type & 0x0f;
+            break;
+        }
+    }
+
+    return mStoragePtr->writeBatch(mNsIndex, batch.get(), count);
+}
+
 esp_err_t NVSHandleSimple::get_string(const char *key, char* out_str, size_t len)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
@@ -58,6 +96,43 @@ esp_err_t NVSHandleSimple::get_blob(const char *key, void* out_blob, size_t len)
     return mStoragePtr->readItem(mNsIndex, nvs::ItemType::BLOB, key, out_blob, len);
 }
 
+esp_err_t NVSHandleSimple::get_blob_view(const char *key, nvs_blob_view_t *view)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (view == nullptr) return ESP_ERR_INVALID_ARG;
+
+    const void *data = nullptr;
+    size_t size = 0;
+    uint32_t mapHandle = 0;
+    esp_err_t err = mStoragePtr->mapBlob(mNsIndex, key, data, size, mapHandle);
+    if (err == ESP_OK) {
+        view->data = data;
+        view->length = size;
+        view->mapped = true;
+        view->map_handle = mapHandle;
+        view->partition = const_cast<Partition*>(mStoragePtr->getPart());
+        return ESP_OK;
+    }
+    if (err != ESP_ERR_NOT_SUPPORTED) return err;
+
+    err = mStoragePtr->getItemDataSize(mNsIndex, nvs::ItemType::BLOB, key, size);
+    if (err != ESP_OK) return err;
+
+    std::unique_ptr<uint8_t[]> copy(new (std::nothrow) uint8_t[size]);
+    if (!copy) return ESP_ERR_NO_MEM;
+
+    // the blob spans several pages or the partition can't be mapped
+    err = mStoragePtr->readBlobMapped(mNsIndex, key, copy.get(), size);
+    if (err != ESP_OK) return err;
+
+    view->data = copy.release();
+    view->length = size;
+    view->mapped = false;
+    view->map_handle = 0;
+    view->partition = nullptr;
+    return ESP_OK;
+}
+
 esp_err_t NVSHandleSimple::get_item_size(ItemType datatype, const char *key, size_t &size)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
@@ -45,10 +45,17 @@ public:
 
     esp_err_t set_blob(const char *key, const void *blob, size_t len) override;
 
+    esp_err_t set_batch(const nvs_batch_item_t *items, size_t count);
+
     esp_err_t get_string(const char *key, char *out_str, size_t len) override;
 
     esp_err_t get_blob(const char *key, void *out_blob, size_t len) override;
 
+    /**
+     * Maps the blob if possible, otherwise reads a copy allocated with new[], see nvs_get_blob_view.
+     */
+    esp_err_t get_blob_view(const char *key, nvs_blob_view_t *view);
+
     esp_err_t get_item_size(ItemType datatype, const char *key, size_t &size) override;
 
     esp_err_t find_key(const char *key, nvs_type_t &nvstype) override;
@@ -1,16 +1,8 @@
-// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
-//
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-
-//     http://www.apache.org/licenses/LICENSE-2.0
-//
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
+/*
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
 
 #include "nvs_item_hash_list.hpp"
 
@@ -23,12 +15,9 @@ HashList::HashList()
 
 void HashList::clear()
 {
-    for (auto it = mBlockList.begin(); it != mBlockList.end();) {
-        auto tmp = it;
-        ++it;
-        mBlockList.erase(tmp);
-        delete static_cast<HashListBlock*>(tmp);
-    }
+    delete[] mNodes;
+    mNodes = nullptr;
+    mCount = 0;
 }
 
 HashList::~HashList()
@@ -36,87 +25,93 @@ HashList::~HashList()
     clear();
 }
 
-HashList::HashListBlock::HashListBlock()
-{
-    static_assert(sizeof(HashListBlock) == HashListBlock::BYTE_SIZE,
-                  "cache block size calculation incorrect");
-}
-
 esp_err_t HashList::insert(const Item& item, size_t index)
 {
-    const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
-    // add entry to the end of last block if possible
-    if (mBlockList.size()) {
-        auto& block = mBlockList.back();
-        if (block.mCount < HashListBlock::ENTRY_COUNT) {
-            block.mNodes[block.mCount++] = HashListNode(hash_24, index);
-            return ESP_OK;
-        }
+    if (!mNodes) {
+        mNodes = new (std::nothrow) HashListNode[CAPACITY];
+        if (!mNodes) return ESP_ERR_NO_MEM;
     }
-    // if the above failed, create a new block and add entry to it
-    HashListBlock* newBlock = new (std::nothrow) HashListBlock;
-
-    if (!newBlock) return ESP_ERR_NO_MEM;
 
-    mBlockList.push_back(newBlock);
-    newBlock->mNodes[0] = HashListNode(hash_24, index);
-    newBlock->mCount++;
+    // a page never holds more items than it has entries, the last free slot is kept to terminate probing
+    if (index >= 0xff || mCount >= CAPACITY - 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    // robin hood insertion: a node takes the slot of a resident which is closer to its home slot
+    HashListNode node(hashOf(item), index);
+    size_t i = slotFor(node.mHash);
+    size_t distance = 0;
+    while (mNodes[i].mIndex != 0xff) {
+        size_t residentDistance = distanceOf(i);
+        if (residentDistance < distance) {
+            HashListNode tmp = mNodes[i];
+            mNodes[i] = node;
+            node = tmp;
+            distance = residentDistance;
+        }
+        i = (i + 1) & (CAPACITY - 1);
+        ++distance;
+    }
+    mNodes[i] = node;
+    ++mCount;
     return ESP_OK;
 }
 
-bool HashList::erase(size_t index)
+bool HashList::erase(size_t index, uint32_t* hash)
 {
-    for (auto it = mBlockList.begin(); it != mBlockList.end();) {
-        bool haveEntries = false;
-        bool foundIndex = false;
-        for (size_t i = 0; i < it->mCount; ++i) {
-            if (it->mNodes[i].mIndex == index) {
-                it->mNodes[i].mIndex = 0xff;
-                foundIndex = true;
-                /* found the item and removed it */
-            }
-            if (it->mNodes[i].mIndex != 0xff) {
-                haveEntries = true;
-            }
-            if (haveEntries && foundIndex) {
-                /* item was found, and HashListBlock still has some items */
-                return true;
-            }
-        }
-        /* no items left in HashListBlock, can remove */
-        if (!haveEntries) {
-            auto tmp = it;
-            ++it;
-            mBlockList.erase(tmp);
-            delete static_cast<HashListBlock*>(tmp);
-        } else {
-            ++it;
-        }
-        if (foundIndex) {
-            /* item was found and empty HashListBlock was removed */
-            return true;
-        }
+    if (!mNodes) {
+        return false;
+    }
+
+    size_t i = 0;
+    while (i < CAPACITY && mNodes[i].mIndex != index) {
+        ++i;
+    }
+    if (i == CAPACITY) {
+        // item hasn't been present in cache
+        return false;
+    }
+    if (hash) {
+        *hash = mNodes[i].mHash;
     }
 
-    // item hasn't been present in cache");
-    return false;
+    if (--mCount == 0) {
+        // no items left, release the table until the page is written again
+        clear();
+        return true;
+    }
+
+    // backward shift deletion: move the following nodes one slot back until one is found at its home slot
+    size_t next = (i + 1) & (CAPACITY - 1);
+    while (mNodes[next].mIndex != 0xff && distanceOf(next) != 0) {
+        mNodes[i] = mNodes[next];
+        i = next;
+        next = (next + 1) & (CAPACITY - 1);
+    }
+    mNodes[i] = HashListNode();
+    return true;
 }
 
 size_t HashList::find(size_t start, const Item& item)
 {
-    const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
-    for (auto it = mBlockList.begin(); it != mBlockList.end(); ++it) {
-        for (size_t index = 0; index < it->mCount; ++index) {
-            HashListNode& e = it->mNodes[index];
-            if (e.mIndex >= start &&
-                    e.mHash == hash_24 &&
-                    e.mIndex != 0xff) {
-                return e.mIndex;
-            }
+    if (!mNodes) {
+        return SIZE_MAX;
+    }
+
+    // nodes with the same hash share the home slot and are therefore adjacent. The same hash may be present more
+    // than once, e.g. while an updated item and its old version coexist, so all of them are visited. Probing ends
+    // at a node which is closer to its home slot than the searched one would be.
+    const uint32_t hash_24 = hashOf(item);
+    size_t found = SIZE_MAX;
+    size_t distance = 0;
+    for (size_t i = slotFor(hash_24); mNodes[i].mIndex != 0xff && distanceOf(i) >= distance; i = (i + 1) & (CAPACITY - 1)) {
+        const HashListNode& e = mNodes[i];
+        if (e.mHash == hash_24 && e.mIndex >= start && e.mIndex < found) {
+            found = e.mIndex;
         }
+        ++distance;
     }
-    return SIZE_MAX;
+    return found;
 }
 
 
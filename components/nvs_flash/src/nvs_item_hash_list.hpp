@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -9,12 +9,20 @@
 
 #include "nvs.h"
 #include "nvs_types.hpp"
+#include "nvs_constants.h"
 #include "nvs_memory_management.hpp"
-#include "intrusive_list.h"
 
 namespace nvs
 {
 
+/**
+ * Per-page index which maps the 24-bit hash of (namespace index, key, chunk index) of every item to the index of
+ * its first entry in the page.
+ *
+ * The nodes live in one open-addressed table with linear probing in robin hood order, which keeps lookups short
+ * even if the page is full of single entry items. The capacity covers all entries of a page, so the table is
+ * allocated once with the first insert and released when the last item is erased.
+ */
 class HashList
 {
 public:
@@ -22,17 +30,52 @@ public:
     ~HashList();
 
     esp_err_t insert(const Item& item, size_t index);
-    bool erase(const size_t index);
+    bool erase(const size_t index, uint32_t* hash = nullptr);
+
+    /**
+     * Returns the lowest index at or after start which holds an item with the hash of the given one,
+     * or SIZE_MAX if there is none.
+     */
     size_t find(size_t start, const Item& item);
     void clear();
 
+    static uint32_t hashOf(const Item& item)
+    {
+        return item.calculateCrc32WithoutValue() & 0xffffff;
+    }
+
+    /**
+     * Mixes a hash from hashOf before its low bits pick a slot of a power of two sized table, see also ItemIndex.
+     */
+    static uint32_t mixHash(uint32_t hash)
+    {
+        // spread the crc bits a bit more, neighbouring keys like "key1", "key2" differ only in a few of them
+        return (hash * 2654435761u) >> 8;
+    }
+
+    /**
+     * Calls fn(hash, index) for every item in the list.
+     */
+    template<typename TFunc>
+    void forEach(TFunc fn)
+    {
+        if (!mNodes) {
+            return;
+        }
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            if (mNodes[i].mIndex != 0xff) {
+                fn(static_cast<uint32_t>(mNodes[i].mHash), static_cast<size_t>(mNodes[i].mIndex));
+            }
+        }
+    }
+
 private:
     HashList(const HashList& other);
     const HashList& operator= (const HashList& rhs);
 
 protected:
 
-    struct HashListNode {
+    struct HashListNode : public ExceptionlessAllocatable {
         HashListNode() :
             mIndex(0xff), mHash(0)
         {
@@ -47,18 +90,23 @@ protected:
         uint32_t mHash  : 24;
     };
 
-    struct HashListBlock : public intrusive_list_node<HashList::HashListBlock>, public ExceptionlessAllocatable {
-        HashListBlock();
+    // one more slot than a page has entries, so that there is always an empty slot which ends a probe sequence
+    static const size_t CAPACITY = 128;
+    static_assert(CAPACITY > NVS_CONST_ENTRY_COUNT, "hash list capacity has to exceed the number of entries of a page");
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "hash list capacity has to be a power of two");
 
-        static const size_t BYTE_SIZE = 128;
-        static const size_t ENTRY_COUNT = (BYTE_SIZE - sizeof(intrusive_list_node<HashListBlock>) - sizeof(size_t)) / 4;
+    size_t slotFor(uint32_t hash) const
+    {
+        return mixHash(hash) & (CAPACITY - 1);
+    }
 
-        size_t mCount = 0;
-        HashListNode mNodes[ENTRY_COUNT];
-    };
+    size_t distanceOf(size_t slot) const
+    {
+        return (slot - slotFor(mNodes[slot].mHash)) & (CAPACITY - 1);
+    }
 
-    typedef intrusive_list<HashListBlock> TBlockList;
-    TBlockList mBlockList;
+    HashListNode* mNodes = nullptr;
+    size_t mCount = 0;
 }; // class HashList
 
 } // namespace nvs
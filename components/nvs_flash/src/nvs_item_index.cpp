@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nvs_item_index.hpp"
+
+namespace nvs
+{
+
+ItemIndex::ItemIndex()
+{
+}
+
+ItemIndex::~ItemIndex()
+{
+    delete[] mNodes;
+}
+
+void ItemIndex::clear()
+{
+    delete[] mNodes;
+    mNodes = nullptr;
+    mCapacity = 0;
+    mCount = 0;
+    mValid = true;
+}
+
+void ItemIndex::invalidate()
+{
+    clear();
+    mValid = false;
+}
+
+void ItemIndex::place(const Node& node)
+{
+    size_t i = slotFor(node.mHash);
+    while (mNodes[i].mPage != nullptr) {
+        i = (i + 1) & (mCapacity - 1);
+    }
+    mNodes[i] = node;
+}
+
+esp_err_t ItemIndex::grow()
+{
+    size_t newCapacity = (mCapacity == 0) ? MIN_CAPACITY : mCapacity * 2;
+    Node* newNodes = new (std::nothrow) Node[newCapacity];
+    if (!newNodes) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    Node* oldNodes = mNodes;
+    size_t oldCapacity = mCapacity;
+    mNodes = newNodes;
+    mCapacity = newCapacity;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldNodes[i].mPage != nullptr) {
+            place(oldNodes[i]);
+        }
+    }
+    delete[] oldNodes;
+    return ESP_OK;
+}
+
+esp_err_t ItemIndex::insert(uint32_t hash, Page* page, size_t index)
+{
+    if (!mValid) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // keep the load factor below 3/4 so that probe sequences stay short
+    if ((mCount + 1) * 4 > mCapacity * 3) {
+        if (grow() != ESP_OK) {
+            // an incomplete index would produce false "not found" answers, drop it altogether
+            invalidate();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    Node node;
+    node.mPage = page;
+    node.mHash = hash & HASH_MASK;
+    node.mIndex = static_cast<uint32_t>(index);
+    place(node);
+    ++mCount;
+    return ESP_OK;
+}
+
+void ItemIndex::erase(uint32_t hash, const Page* page, size_t index)
+{
+    if (!mCount) {
+        return;
+    }
+
+    hash &= HASH_MASK;
+    const size_t mask = mCapacity - 1;
+    size_t i = slotFor(hash);
+    while (true) {
+        if (mNodes[i].mPage == nullptr) {
+            // not present
+            return;
+        }
+        if (mNodes[i].mPage == page && mNodes[i].mHash == hash && mNodes[i].mIndex == index) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // backward shift deletion: pull following nodes of the cluster into the hole unless they already sit
+    // between their home slot and the hole
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (mNodes[j].mPage == nullptr) {
+            break;
+        }
+        size_t home = slotFor(mNodes[j].mHash);
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) {
+            continue;
+        }
+        mNodes[i] = mNodes[j];
+        i = j;
+    }
+    mNodes[i] = Node();
+    --mCount;
+}
+
+} // namespace nvs
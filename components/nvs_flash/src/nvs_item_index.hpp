@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef nvs_item_index_hpp
+#define nvs_item_index_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "nvs_item_hash_list.hpp"
+#include "nvs_memory_management.hpp"
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Storage-wide index of all items held in the pages of one nvs::Storage.
+ *
+ * Every node maps the 24-bit hash of (namespace index, key, chunk index) - the same hash the per-page HashList
+ * uses - to the page and the entry index where an item with that hash lives. The data type is not part of the hash,
+ * the page resolves it when the candidate entry is read back from flash.
+ *
+ * The table is open-addressed with linear probing and grows by doubling. If growing fails, the index marks itself
+ * invalid and the owner is expected to fall back to scanning page by page.
+ */
+class ItemIndex
+{
+public:
+    ItemIndex();
+    ~ItemIndex();
+
+    esp_err_t insert(uint32_t hash, Page* page, size_t index);
+    void erase(uint32_t hash, const Page* page, size_t index);
+    void clear();
+
+    bool isValid() const
+    {
+        return mValid;
+    }
+
+    void invalidate();
+
+    size_t size() const
+    {
+        return mCount;
+    }
+
+    size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    /**
+     * Calls fn(page, index) for every node with the given hash. Iteration stops if fn returns false.
+     */
+    template<typename TFunc>
+    void forEach(uint32_t hash, TFunc fn) const
+    {
+        if (!mCount) {
+            return;
+        }
+        hash &= HASH_MASK;
+        for (size_t i = slotFor(hash); mNodes[i].mPage != nullptr; i = (i + 1) & (mCapacity - 1)) {
+            if (mNodes[i].mHash == hash && !fn(mNodes[i].mPage, static_cast<size_t>(mNodes[i].mIndex))) {
+                return;
+            }
+        }
+    }
+
+    static const uint32_t HASH_MASK = 0xffffff;
+
+private:
+    ItemIndex(const ItemIndex& other);
+    const ItemIndex& operator= (const ItemIndex& rhs);
+
+protected:
+    struct Node : public ExceptionlessAllocatable {
+        Node() : mPage(nullptr), mHash(0), mIndex(0)
+        {
+        }
+
+        Page* mPage;
+        uint32_t mHash  : 24;
+        uint32_t mIndex : 8;
+    };
+
+    size_t slotFor(uint32_t hash) const
+    {
+        return HashList::mixHash(hash) & (mCapacity - 1);
+    }
+
+    esp_err_t grow();
+
+    void place(const Node& node);
+
+    static const size_t MIN_CAPACITY = 64;
+
+    Node* mNodes = nullptr;
+    size_t mCapacity = 0;
+    size_t mCount = 0;
+    bool mValid = true;
+}; // class ItemIndex
+
+} // namespace nvs
+
+#endif /* nvs_item_index_hpp */
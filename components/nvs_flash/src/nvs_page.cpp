@@ -8,6 +8,7 @@
 #include <esp_rom_crc.h>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include "nvs_internal.h"
 #include "esp_partition.h"
 
@@ -24,7 +25,7 @@ uint32_t Page::Header::calculateCrc32()
                             offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
-esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
+esp_err_t Page::load(Partition *partition, uint32_t sectorNumber, uint8_t* sectorBuffer)
 {
     if (partition == nullptr) {
         return ESP_ERR_INVALID_ARG;
@@ -36,7 +37,15 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     mErasedEntryCount = 0;
 
     Header header;
-    auto rc = mPartition->read_raw(mBaseAddress, &header, sizeof(header));
+    esp_err_t rc;
+    if (sectorBuffer) {
+        rc = mPartition->read_raw(mBaseAddress, sectorBuffer, SEC_SIZE);
+        if (rc == ESP_OK) {
+            memcpy(&header, sectorBuffer + HEADER_OFFSET, sizeof(header));
+        }
+    } else {
+        rc = mPartition->read_raw(mBaseAddress, &header, sizeof(header));
+    }
     if (rc != ESP_OK) {
         mState = PageState::INVALID;
         return rc;
@@ -45,27 +54,38 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
         mState = header.mState;
         // check if the whole page is really empty
         // reading the whole page takes ~40 times less than erasing it
-        const int BLOCK_SIZE = 128;
-        uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
-
-        if (!block) {
-            return ESP_ERR_NO_MEM;
-        }
-
-        for (uint32_t i = 0; i < SEC_SIZE; i += 4 * BLOCK_SIZE) {
-            rc = mPartition->read_raw(mBaseAddress + i, block, 4 * BLOCK_SIZE);
-            if (rc != ESP_OK) {
-                mState = PageState::INVALID;
-                delete[] block;
-                return rc;
-            }
-            if (std::any_of(block, block + BLOCK_SIZE, [](uint32_t val) -> bool { return val != 0xffffffff; })) {
+        auto isErased = [](const uint32_t* begin, const uint32_t* end) -> bool {
+            return std::all_of(begin, end, [](uint32_t val) -> bool { return val == 0xffffffff; });
+        };
+        if (sectorBuffer) {
+            const uint32_t* words = reinterpret_cast<const uint32_t*>(sectorBuffer);
+            if (!isErased(words, words + SEC_SIZE / 4)) {
                 // page isn't as empty after all, mark it as corrupted
                 mState = PageState::CORRUPT;
-                break;
             }
+        } else {
+            const int BLOCK_SIZE = 128;
+            uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
+
+            if (!block) {
+                return ESP_ERR_NO_MEM;
+            }
+
+            for (uint32_t i = 0; i < SEC_SIZE; i += 4 * BLOCK_SIZE) {
+                rc = mPartition->read_raw(mBaseAddress + i, block, 4 * BLOCK_SIZE);
+                if (rc != ESP_OK) {
+                    mState = PageState::INVALID;
+                    delete[] block;
+                    return rc;
+                }
+                if (!isErased(block, block + BLOCK_SIZE)) {
+                    // page isn't as empty after all, mark it as corrupted
+                    mState = PageState::CORRUPT;
+                    break;
+                }
+            }
+            delete[] block;
         }
-        delete[] block;
     } else if (header.mCrc32 != header.calculateCrc32()) {
         header.mState = PageState::CORRUPT;
     } else {
@@ -84,9 +104,13 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
 
     case PageState::FULL:
     case PageState::ACTIVE:
-    case PageState::FREEING:
-        return mLoadEntryTable();
-        break;
+    case PageState::FREEING: {
+        // entries only change their state while the page is loaded, the data in the buffer stays valid
+        mSectorBuffer = sectorBuffer;
+        rc = mLoadEntryTable();
+        mSectorBuffer = nullptr;
+        return rc;
+    }
 
     default:
         mState = PageState::CORRUPT;
@@ -96,6 +120,34 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     return ESP_OK;
 }
 
+esp_err_t Page::attachSectorBuffer(uint8_t* sectorBuffer)
+{
+    NVS_ASSERT_OR_RETURN(sectorBuffer != nullptr, ESP_ERR_INVALID_ARG);
+    NVS_ASSERT_OR_RETURN(mPartition != nullptr, ESP_ERR_INVALID_STATE);
+    if (mPartition->get_encrypted()) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        // nothing to read
+        return ESP_OK;
+    }
+    // only the entries which are in use, the buffer keeps the layout of the sector
+    const size_t end = (mNextFreeEntry < ENTRY_COUNT) ? mNextFreeEntry : ENTRY_COUNT;
+    uint32_t address;
+    auto rc = getEntryAddress(mFirstUsedEntry, &address);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (end > mFirstUsedEntry) {
+        rc = mPartition->read_raw(address, sectorBuffer + (address - mBaseAddress), (end - mFirstUsedEntry) * ENTRY_SIZE);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+    }
+    mSectorBuffer = sectorBuffer;
+    return ESP_OK;
+}
+
 esp_err_t Page::writeEntry(const Item &item)
 {
     uint32_t phyAddr;
@@ -203,7 +255,7 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     // write first item
     size_t span = (totalSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
     item = Item(nsIndex, datatype, span, key, chunkIdx);
-    err = mHashList.insert(item, mNextFreeEntry);
+    err = hashListInsert(item, mNextFreeEntry);
 
     if (err != ESP_OK) {
         return err;
@@ -250,6 +302,171 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     return ESP_OK;
 }
 
+esp_err_t Page::writeItems(const NewItem* items, size_t count)
+{
+    esp_err_t err;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (mState == PageState::UNINITIALIZED) {
+        err = initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (mState == PageState::FULL) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    size_t entriesCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const NewItem& newItem = items[i];
+        if (strlen(newItem.key) > Item::MAX_KEY_LENGTH) {
+            return ESP_ERR_NVS_KEY_TOO_LONG;
+        }
+        if (newItem.dataSize > Page::CHUNK_MAX_SIZE) {
+            return ESP_ERR_NVS_VALUE_TOO_LONG;
+        }
+        if (!isVariableLengthType(newItem.datatype)) {
+            if (newItem.dataSize > 8) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            entriesCount += 1;
+        } else {
+            entriesCount += 1 + (newItem.dataSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
+        }
+    }
+
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    if (mNextFreeEntry == INVALID_ENTRY || mNextFreeEntry + entriesCount > ENTRY_COUNT) {
+        // page will not fit this amount of data
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    // lay out all entries in RAM, each one has the size of an Item
+    std::unique_ptr<Item[]> entries(new (std::nothrow) Item[entriesCount]);
+    if (!entries) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t entryIndex = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const NewItem& newItem = items[i];
+        size_t span = 1;
+        if (isVariableLengthType(newItem.datatype)) {
+            span += (newItem.dataSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
+        }
+
+        Item& item = entries[entryIndex];
+        item = Item(newItem.nsIndex, newItem.datatype, span, newItem.key, newItem.chunkIdx);
+        if (!isVariableLengthType(newItem.datatype)) {
+            memcpy(item.data, newItem.data, newItem.dataSize);
+        } else {
+            const uint8_t* src = static_cast<const uint8_t*>(newItem.data);
+            item.varLength.dataCrc32 = Item::calculateCrc32(src, newItem.dataSize);
+            item.varLength.dataSize = newItem.dataSize;
+            item.varLength.reserved = 0xffff;
+
+            uint8_t* dst = reinterpret_cast<uint8_t*>(&entries[entryIndex + 1]);
+            std::fill_n(dst, (span - 1) * ENTRY_SIZE, 0xff);
+            if (newItem.dataSize > 0) {
+                memcpy(dst, src, newItem.dataSize);
+            }
+        }
+        item.crc32 = item.calculateCrc32();
+
+        err = hashListInsert(item, mNextFreeEntry + entryIndex);
+        if (err != ESP_OK) {
+            return err;
+        }
+        entryIndex += span;
+    }
+
+    return writeEntries(entries.get(), entriesCount);
+}
+
+esp_err_t Page::writeEntries(const Item* entries, size_t count)
+{
+    uint32_t phyAddr;
+    esp_err_t err = getEntryAddress(mNextFreeEntry, &phyAddr);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = mPartition->write(phyAddr, entries, count * ENTRY_SIZE);
+    if (err != ESP_OK) {
+        mState = PageState::INVALID;
+        return err;
+    }
+
+    err = alterEntryRangeState(mNextFreeEntry, mNextFreeEntry + count, EntryState::WRITTEN);
+    if (err != ESP_OK) {
+        mState = PageState::INVALID;
+        return err;
+    }
+
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        mFirstUsedEntry = mNextFreeEntry;
+    }
+    mUsedEntryCount += count;
+    mNextFreeEntry += count;
+    return ESP_OK;
+}
+
+esp_err_t Page::moveItem(size_t index, Page& other)
+{
+    if (mState == PageState::INVALID || other.mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    Item header;
+    esp_err_t err = readEntry(index, header);
+    if (err != ESP_OK) {
+        return err;
+    }
+    size_t span = isVariableLengthType(header.datatype) ? header.span : 1;
+    NVS_ASSERT_OR_RETURN(index + span <= ENTRY_COUNT, ESP_FAIL);
+
+    if (other.mState == PageState::UNINITIALIZED) {
+        err = other.initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (other.getFreeEntryCount() < span) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    std::unique_ptr<Item[]> entries(new (std::nothrow) Item[span]);
+    if (!entries) {
+        return ESP_ERR_NO_MEM;
+    }
+    entries[0] = header;
+    for (size_t i = 1; i < span; ++i) {
+        err = readEntry(index + i, entries[i]);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    err = other.hashListInsert(header, other.mNextFreeEntry);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = other.writeEntries(entries.get(), span);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // if power goes off before this, load() finds the copy as the last item and erases the original as a duplicate
+    return eraseEntryAndSpan(index);
+}
+
 // Reads the data entries of the variable length item.
 // The metadata entry is already read in the item object.
 // index is the index of the metadata entry on the page.
@@ -287,6 +504,34 @@ esp_err_t Page::readVariableLengthItemData(const Item& item, const size_t index,
     return ESP_OK;
 }
 
+esp_err_t Page::mapVariableLengthItemData(const Item& item, const size_t index, const void** data, uint32_t* handle)
+{
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    // the data entries directly follow the header entry, so the data is contiguous in flash
+    uint32_t dataAddress;
+    esp_err_t rc = getEntryAddress(index + 1, &dataAddress);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (mPartition->mmap(dataAddress, item.varLength.dataSize, data, handle) != ESP_OK) {
+        // e.g. external flash or no free MMU pages, the data is still readable with readVariableLengthItemData
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (Item::calculateCrc32(reinterpret_cast<const uint8_t * >(*data), item.varLength.dataSize) != item.varLength.dataCrc32) {
+        mPartition->munmap(*handle);
+        *data = nullptr;
+        rc = eraseEntryAndSpan(index);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
 esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -427,7 +672,7 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
             return rc;
         }
         if (!item.checkHeaderConsistency(index)) {
-            mHashList.erase(index);
+            hashListErase(index);
             rc = alterEntryState(index, EntryState::ERASED);
             --mUsedEntryCount;
             ++mErasedEntryCount;
@@ -435,7 +680,7 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
                 return rc;
             }
         } else {
-            mHashList.erase(index);
+            hashListErase(index);
             span = item.span;
             for (ptrdiff_t i = index + span - 1; i >= static_cast<ptrdiff_t>(index); --i) {
                 rc = mEntryTable.get(i, &state);
@@ -477,6 +722,86 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
     return ESP_OK;
 }
 
+esp_err_t Page::eraseEntries(const uint8_t* indices, size_t count)
+{
+    // alter the states in RAM first and collect the words of the entry state table which changed
+    uint32_t changedWords = 0;
+    esp_err_t err;
+    for (size_t n = 0; n < count; ++n) {
+        const size_t index = indices[n];
+        NVS_ASSERT_OR_RETURN(index < ENTRY_COUNT, ESP_FAIL);
+
+        EntryState state;
+        err = mEntryTable.get(index, &state);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        size_t span = 1;
+        if (state == EntryState::WRITTEN) {
+            Item item;
+            err = readEntry(index, item);
+            if (err != ESP_OK) {
+                return err;
+            }
+            hashListErase(index);
+            if (item.checkHeaderConsistency(index)) {
+                span = item.span;
+            }
+            for (size_t i = index; i < index + span; ++i) {
+                err = mEntryTable.get(i, &state);
+                if (err != ESP_OK) {
+                    return err;
+                }
+                if (state == EntryState::WRITTEN) {
+                    --mUsedEntryCount;
+                }
+                ++mErasedEntryCount;
+            }
+        }
+
+        for (size_t i = index; i < index + span; ++i) {
+            err = mEntryTable.set(i, EntryState::ERASED);
+            if (err != ESP_OK) {
+                return err;
+            }
+            changedWords |= 1u << TEntryTable::getWordIndex(i);
+        }
+
+        if (index + span > mNextFreeEntry) {
+            mNextFreeEntry = index + span;
+        }
+    }
+
+    if (mFirstUsedEntry != INVALID_ENTRY) {
+        EntryState state;
+        err = mEntryTable.get(mFirstUsedEntry, &state);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (state != EntryState::WRITTEN) {
+            err = updateFirstUsedEntry(mFirstUsedEntry, 1);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+
+    for (size_t wordIndex = 0; changedWords != 0; ++wordIndex, changedWords >>= 1) {
+        if (!(changedWords & 1)) {
+            continue;
+        }
+        uint32_t word = mEntryTable.data()[wordIndex];
+        err = mPartition->write_raw(mBaseAddress + ENTRY_TABLE_OFFSET + static_cast<uint32_t>(wordIndex) * 4,
+                                    &word, sizeof(word));
+        if (err != ESP_OK) {
+            mState = PageState::INVALID;
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
 esp_err_t Page::updateFirstUsedEntry(size_t index, size_t span)
 {
     NVS_ASSERT_OR_RETURN(index == mFirstUsedEntry, ESP_FAIL);
@@ -500,6 +825,44 @@ esp_err_t Page::updateFirstUsedEntry(size_t index, size_t span)
     return ESP_OK;
 }
 
+esp_err_t Page::hashListInsert(const Item& item, size_t index)
+{
+    esp_err_t err = mHashList.insert(item, index);
+    if (err == ESP_OK && mItemIndex) {
+        // a failure here only invalidates the storage-wide index, the page itself stays consistent
+        mItemIndex->insert(HashList::hashOf(item), this, index);
+    }
+    return err;
+}
+
+void Page::hashListErase(size_t index)
+{
+    uint32_t hash;
+    if (mHashList.erase(index, &hash) && mItemIndex) {
+        mItemIndex->erase(hash, this, index);
+    }
+}
+
+void Page::hashListClear()
+{
+    if (mItemIndex) {
+        mHashList.forEach([this](uint32_t hash, size_t index) {
+            mItemIndex->erase(hash, this, index);
+        });
+    }
+    mHashList.clear();
+}
+
+void Page::setItemIndex(ItemIndex* itemIndex)
+{
+    mItemIndex = itemIndex;
+    if (mItemIndex) {
+        mHashList.forEach([this](uint32_t hash, size_t index) {
+            mItemIndex->insert(hash, this, index);
+        });
+    }
+}
+
 esp_err_t Page::copyItems(Page &other)
 {
     if (mFirstUsedEntry == INVALID_ENTRY) {
@@ -533,7 +896,7 @@ esp_err_t Page::copyItems(Page &other)
             return err;
         }
 
-        err = other.mHashList.insert(entry, other.mNextFreeEntry);
+        err = other.hashListInsert(entry, other.mNextFreeEntry);
         if (err != ESP_OK) {
             return err;
         }
@@ -569,45 +932,50 @@ esp_err_t Page::mLoadEntryTable()
     if (mState == PageState::ACTIVE ||
             mState == PageState::FULL ||
             mState == PageState::FREEING) {
-        auto rc = mPartition->read_raw(mBaseAddress + ENTRY_TABLE_OFFSET, mEntryTable.data(),
-                                       mEntryTable.byteSize());
-        if (rc != ESP_OK) {
-            mState = PageState::INVALID;
-            return rc;
+        if (mSectorBuffer) {
+            memcpy(mEntryTable.data(), mSectorBuffer + ENTRY_TABLE_OFFSET, mEntryTable.byteSize());
+        } else {
+            auto rc = mPartition->read_raw(mBaseAddress + ENTRY_TABLE_OFFSET, mEntryTable.data(),
+                                           mEntryTable.byteSize());
+            if (rc != ESP_OK) {
+                mState = PageState::INVALID;
+                return rc;
+            }
         }
     }
 
-    EntryState state;
+    // decode the states of 16 entries at a time
+    EntryState state = EntryState::EMPTY;
     esp_err_t err;
     mErasedEntryCount = 0;
     mUsedEntryCount = 0;
-    for (size_t i = 0; i < ENTRY_COUNT; ++i) {
-        err = mEntryTable.get(i, &state);
-        if (err != ESP_OK) {
-            return err;
+    size_t firstEmptyEntry = INVALID_ENTRY;
+    for (size_t w = 0; w < mEntryTable.byteSize() / sizeof(uint32_t); ++w) {
+        const uint32_t word = mEntryTable.data()[w];
+        const size_t base = w * ENTRIES_PER_STATE_WORD;
+        uint32_t valid = 0x55555555;
+        if (ENTRY_COUNT - base < ENTRIES_PER_STATE_WORD) {
+            // the last word has unused bits
+            valid >>= 2 * (ENTRIES_PER_STATE_WORD - (ENTRY_COUNT - base));
         }
-        if (state == EntryState::WRITTEN) {
-            if (mFirstUsedEntry == INVALID_ENTRY) {
-                mFirstUsedEntry = i;
-            }
-            ++mUsedEntryCount;
-        } else if (state == EntryState::ERASED) {
-            ++mErasedEntryCount;
+        const uint32_t written = entryStateMask(word, EntryState::WRITTEN) & valid;
+        const uint32_t erased = entryStateMask(word, EntryState::ERASED) & valid;
+        const uint32_t empty = entryStateMask(word, EntryState::EMPTY) & valid;
+        if (written && mFirstUsedEntry == INVALID_ENTRY) {
+            mFirstUsedEntry = base + __builtin_ctz(written) / 2;
+        }
+        if (empty && firstEmptyEntry == INVALID_ENTRY) {
+            firstEmptyEntry = base + __builtin_ctz(empty) / 2;
         }
+        mUsedEntryCount += __builtin_popcount(written);
+        mErasedEntryCount += __builtin_popcount(erased);
     }
 
     // for PageState::ACTIVE, we may have more data written to this page
     // as such, we need to figure out where the first unused entry is
     if (mState == PageState::ACTIVE) {
-        for (size_t i = 0; i < ENTRY_COUNT; ++i) {
-            err = mEntryTable.get(i, &state);
-            if (err != ESP_OK) {
-                return err;
-            }
-            if (state == EntryState::EMPTY) {
-                mNextFreeEntry = i;
-                break;
-            }
+        if (firstEmptyEntry != INVALID_ENTRY) {
+            mNextFreeEntry = firstEmptyEntry;
         }
 
         // however, if power failed after some data was written into the entry.
@@ -621,7 +989,12 @@ esp_err_t Page::mLoadEntryTable()
                 return err;
             }
             uint32_t header;
-            auto rc = mPartition->read_raw(entryAddress, &header, sizeof(header));
+            esp_err_t rc = ESP_OK;
+            if (mSectorBuffer) {
+                memcpy(&header, mSectorBuffer + (entryAddress - mBaseAddress), sizeof(header));
+            } else {
+                rc = mPartition->read_raw(entryAddress, &header, sizeof(header));
+            }
             if (rc != ESP_OK) {
                 mState = PageState::INVALID;
                 return rc;
@@ -650,6 +1023,9 @@ esp_err_t Page::mLoadEntryTable()
         // check that all variable-length items are written or erased fully
         Item item;
         size_t lastItemIndex = INVALID_ENTRY;
+        // items following the begin marker of a batch are not checked for duplicates, the older values
+        // are needed if the batch has to be undone, see PageManager::finishBatch
+        bool inBatch = false;
         size_t end = mNextFreeEntry;
         if (end > ENTRY_COUNT) {
             end = ENTRY_COUNT;
@@ -693,7 +1069,7 @@ esp_err_t Page::mLoadEntryTable()
                 continue;
             }
 
-            err = mHashList.insert(item, i);
+            err = hashListInsert(item, i);
             if (err != ESP_OK) {
                 mState = PageState::INVALID;
                 return err;
@@ -722,17 +1098,22 @@ esp_err_t Page::mLoadEntryTable()
                 }
             }
 
+            if (item.nsIndex == BATCH_MARKER_NS && item.datatype == ItemType::U32 && item.chunkIndex == BATCH_MARKER_CHUNK
+                    && strncmp(item.key, BATCH_BEGIN_KEY, Item::MAX_KEY_LENGTH) == 0) {
+                inBatch = true;
+            }
+
             /* Note that logic for duplicate detections works fine even
              * when old-format blob is present along with new-format blob-index
              * for same key on active page. Since datatype is not used in hash calculation,
              * old-format blob will be removed.*/
-            if (duplicateIndex < i) {
+            if (duplicateIndex < i && !inBatch) {
                 eraseEntryAndSpan(duplicateIndex);
             }
         }
 
         // check that last item is not duplicate
-        if (lastItemIndex != INVALID_ENTRY) {
+        if (lastItemIndex != INVALID_ENTRY && !inBatch) {
             size_t findItemIndex = 0;
             Item dupItem;
             if (findItem(item.nsIndex, item.datatype, item.key, findItemIndex, dupItem) == ESP_OK) {
@@ -775,7 +1156,7 @@ esp_err_t Page::mLoadEntryTable()
 
             NVS_ASSERT_OR_RETURN(item.span > 0, ESP_FAIL);
 
-            err = mHashList.insert(item, i);
+            err = hashListInsert(item, i);
             if (err != ESP_OK) {
                 mState = PageState::INVALID;
                 return err;
@@ -892,6 +1273,10 @@ esp_err_t Page::readEntry(size_t index, Item &dst) const
     if (rc != ESP_OK) {
         return rc;
     }
+    if (mSectorBuffer && !mPartition->get_encrypted()) {
+        memcpy(&dst, mSectorBuffer + (phyAddr - mBaseAddress), sizeof(dst));
+        return ESP_OK;
+    }
     rc = mPartition->read(phyAddr, &dst, sizeof(dst));
     if (rc != ESP_OK) {
         return rc;
@@ -1031,6 +1416,28 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
+esp_err_t Page::findBatchMarker(const char* key, size_t& itemIndex)
+{
+    if (mState == PageState::CORRUPT || mState == PageState::INVALID || mState == PageState::UNINITIALIZED) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // findItem takes the marker namespace index for any namespace, look the marker up by its hash instead
+    const Item marker(BATCH_MARKER_NS, ItemType::U32, 0, key, BATCH_MARKER_CHUNK);
+    Item item;
+    for (itemIndex = mHashList.find(0, marker); itemIndex < ENTRY_COUNT; itemIndex = mHashList.find(itemIndex + 1, marker)) {
+        auto err = readEntry(itemIndex, item);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (item.nsIndex == BATCH_MARKER_NS && item.datatype == ItemType::U32 && item.chunkIndex == BATCH_MARKER_CHUNK
+                && strncmp(item.key, key, Item::MAX_KEY_LENGTH) == 0) {
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
 esp_err_t Page::getSeqNumber(uint32_t &seqNumber) const
 {
     if (mState != PageState::UNINITIALIZED && mState != PageState::INVALID && mState != PageState::CORRUPT) {
@@ -1070,7 +1477,7 @@ esp_err_t Page::erase()
     mFirstUsedEntry = INVALID_ENTRY;
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
-    mHashList.clear();
+    hashListClear();
     return ESP_OK;
 }
 
@@ -1101,6 +1508,16 @@ size_t Page::getVarDataTailroom() const
     return ((mNextFreeEntry < (ENTRY_COUNT - 1)) ? ((ENTRY_COUNT - mNextFreeEntry - 1) * ENTRY_SIZE) : 0);
 }
 
+size_t Page::getFreeEntryCount() const
+{
+    if (mState == PageState::UNINITIALIZED) {
+        return ENTRY_COUNT;
+    } else if (mState != PageState::ACTIVE || mNextFreeEntry == INVALID_ENTRY) {
+        return 0;
+    }
+    return ENTRY_COUNT - mNextFreeEntry;
+}
+
 const char* Page::pageStateToName(PageState ps)
 {
     switch (ps) {
@@ -15,6 +15,7 @@
 #include "compressed_enum_table.hpp"
 #include "intrusive_list.h"
 #include "nvs_item_hash_list.hpp"
+#include "nvs_item_index.hpp"
 #include "nvs_memory_management.hpp"
 #include "partition.hpp"
 #include "nvs_constants.h"
@@ -49,6 +50,14 @@ public:
 
     static const uint8_t NVS_VERSION = NVS_CONST_NVS_VERSION; // Decrement to upgrade
 
+    // Markers bracketing a batch of items written by Storage::writeBatch, see PageManager::finishBatch.
+    // They use namespace index 255, which is never assigned to a namespace, under a chunk index plain values
+    // never use. Firmware without batch support only loads NS_INDEX items as namespaces and ignores them.
+    static constexpr const char* BATCH_BEGIN_KEY = "nvs:batch";
+    static constexpr const char* BATCH_COMMIT_KEY = "nvs:batch:done";
+    static const uint8_t BATCH_MARKER_NS = NS_ANY;
+    static const uint8_t BATCH_MARKER_CHUNK = 0;
+
     enum class PageState : uint32_t {
         // All bits set, default state after flash erase. Page has not been initialized yet.
         UNINITIALIZED = NVS_CONST_PAGE_STATE_UNINITIALIZED,
@@ -78,7 +87,25 @@ public:
         return mState;
     }
 
-    esp_err_t load(Partition *partition, uint32_t sectorNumber);
+    /**
+     * Loads the page from the given sector. If sectorBuffer of SEC_SIZE bytes is given, the whole sector is read
+     * into it with a single request and the header, the entry state table and, unless the partition is encrypted,
+     * the entries are decoded from there. The buffer is only used during the call.
+     */
+    esp_err_t load(Partition *partition, uint32_t sectorNumber, uint8_t* sectorBuffer = nullptr);
+
+    /**
+     * Reads all entries in use into sectorBuffer of SEC_SIZE bytes with a single request. Entries are then read from
+     * the buffer instead of flash until detachSectorBuffer() is called, which speeds up scans of all items.
+     * Only the states of entries may change in between, i.e. items may be erased but not written.
+     * Returns ESP_ERR_NOT_SUPPORTED for encrypted partitions, which have to decrypt every entry on its own.
+     */
+    esp_err_t attachSectorBuffer(uint8_t* sectorBuffer);
+
+    void detachSectorBuffer()
+    {
+        mSectorBuffer = nullptr;
+    }
 
     esp_err_t getSeqNumber(uint32_t& seqNumber) const;
 
@@ -88,8 +115,32 @@ public:
 
     esp_err_t writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY);
 
+    /**
+     * Item to be written by writeItems, the fields have the same meaning as the arguments of writeItem.
+     */
+    struct NewItem {
+        uint8_t nsIndex;
+        ItemType datatype;
+        const char* key;
+        const void* data;
+        size_t dataSize;
+        uint8_t chunkIdx;
+    };
+
+    /**
+     * Writes all items into consecutive entries with a single flash write, followed by the update of the entry state
+     * table. Either all items fit into the page or none is written.
+     */
+    esp_err_t writeItems(const NewItem* items, size_t count);
+
     esp_err_t readVariableLengthItemData(const Item& item, const size_t index, void* data);
 
+    /**
+     * Same as readVariableLengthItemData, but maps the data of the item with Partition::mmap instead of copying it.
+     * On success, the caller releases the mapping with Partition::munmap.
+     */
+    esp_err_t mapVariableLengthItemData(const Item& item, const size_t index, const void** data, uint32_t* handle);
+
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
@@ -102,6 +153,13 @@ public:
 
     esp_err_t eraseEntryAndSpan(size_t index);
 
+    /**
+     * Same as eraseEntryAndSpan for each of the indices, but every word of the entry state table is written only once.
+     */
+    esp_err_t eraseEntries(const uint8_t* indices, size_t count);
+
+    esp_err_t findBatchMarker(const char* key, size_t& itemIndex);
+
     template<typename T>
     esp_err_t writeItem(uint8_t nsIndex, const char* key, const T& value)
     {
@@ -137,18 +195,28 @@ public:
     }
     size_t getVarDataTailroom() const ;
 
+    size_t getFreeEntryCount() const;
+
     esp_err_t markFull();
 
     esp_err_t markFreeing();
 
     esp_err_t copyItems(Page& other);
 
+    /**
+     * Writes a copy of the item at index, including its data entries, into the other page and erases the original.
+     * For load() this looks the same as an update of the item with the same value.
+     */
+    esp_err_t moveItem(size_t index, Page& other);
+
     esp_err_t erase();
 
     void debugDump() const;
 
     esp_err_t calcEntries(nvs_stats_t &nvsStats);
 
+    void setItemIndex(ItemIndex* index);
+
 protected:
 
     class Header
@@ -178,6 +246,19 @@ protected:
 
     esp_err_t mLoadEntryTable();
 
+    static const size_t ENTRIES_PER_STATE_WORD = 16;
+
+    /**
+     * Returns a word with the lower bit of every 2-bit entry state in word set where that state equals the given one.
+     */
+    static uint32_t entryStateMask(uint32_t word, EntryState state)
+    {
+        const uint32_t lo = word & 0x55555555;
+        const uint32_t hi = (word >> 1) & 0x55555555;
+        const uint32_t s = static_cast<uint32_t>(state);
+        return ((s & 1) ? lo : ~lo) & ((s & 2) ? hi : ~hi) & 0x55555555;
+    }
+
     esp_err_t initialize();
 
     esp_err_t alterEntryState(size_t index, EntryState state);
@@ -192,8 +273,16 @@ protected:
 
     esp_err_t writeEntryData(const uint8_t* data, size_t size);
 
+    esp_err_t writeEntries(const Item* entries, size_t count);
+
     esp_err_t updateFirstUsedEntry(size_t index, size_t span);
 
+    esp_err_t hashListInsert(const Item& item, size_t index);
+
+    void hashListErase(size_t index);
+
+    void hashListClear();
+
     static constexpr size_t getAlignmentForType(ItemType type)
     {
         return static_cast<uint8_t>(type) & 0x0f;
@@ -226,6 +315,16 @@ protected:
      */
     HashList mHashList;
 
+    /**
+     * Optional storage-wide index which mirrors the content of mHashList, owned by nvs::Storage.
+     */
+    ItemIndex *mItemIndex = nullptr;
+
+    /**
+     * Copy of the sector while load() is running or while attached, nullptr otherwise.
+     */
+    const uint8_t *mSectorBuffer = nullptr;
+
     Partition *mPartition;
 
     static const uint32_t HEADER_OFFSET = NVS_CONST_PAGE_HEADER_OFFSET;
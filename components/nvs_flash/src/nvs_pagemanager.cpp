@@ -9,7 +9,24 @@ using namespace std;
 
 namespace nvs
 {
-esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount)
+// Whether a batch item replaces an older item under the same key, the same way Storage::writeItem would
+static bool batchItemReplaces(const Item& batchItem, const Item& oldItem)
+{
+#ifdef CONFIG_NVS_LEGACY_DUP_KEYS_COMPATIBILITY
+    // values of other types under the same key are kept, the chunks and the index of a blob replace an older blob
+    auto isBlobPart = [](ItemType datatype) {
+        return datatype == ItemType::BLOB_DATA || datatype == ItemType::BLOB_IDX;
+    };
+    if (isBlobPart(batchItem.datatype)) {
+        return isBlobPart(oldItem.datatype);
+    }
+    return oldItem.datatype == batchItem.datatype;
+#else
+    return true;
+#endif
+}
+
+esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, uint8_t* sectorBuffer)
 {
     if (partition == nullptr) {
         return ESP_ERR_INVALID_ARG;
@@ -17,6 +34,7 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
 
     mBaseSector = baseSector;
     mPageCount = sectorCount;
+    mGcPage = nullptr;
     mPageList.clear();
     mFreePageList.clear();
     mPages.reset(new (nothrow) Page[sectorCount]);
@@ -24,7 +42,7 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
     if (!mPages) return ESP_ERR_NO_MEM;
 
     for (uint32_t i = 0; i < sectorCount; ++i) {
-        auto err = mPages[i].load(partition, baseSector + i);
+        auto err = mPages[i].load(partition, baseSector + i, sectorBuffer);
         if (err != ESP_OK) {
             return err;
         }
@@ -59,14 +77,24 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
     // if power went out after a new item for the given key was written,
     // but before the old one was erased, we end up with a duplicate item
     if (!partition->get_readonly()) {
+        // same for a batch of items, which has to be either undone or completed as a whole
+        auto err = finishBatch();
+        if (err != ESP_OK) {
+            return err;
+        }
+
         Page& lastPage = back();
         size_t lastItemIndex = SIZE_MAX;
         Item item;
         size_t itemIndex = 0;
+        if (sectorBuffer) {
+            lastPage.attachSectorBuffer(sectorBuffer);
+        }
         while (lastPage.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
             itemIndex += item.span;
             lastItemIndex = itemIndex;
         }
+        lastPage.detachSectorBuffer();
 
         if (lastItemIndex != SIZE_MAX) {
             auto last = PageManager::TPageListIterator(&lastPage);
@@ -142,6 +170,12 @@ esp_err_t PageManager::requestNewPage()
         return ESP_ERR_NVS_INVALID_STATE;
     }
 
+    // the markers of a batch must stay in the last page until it is finished
+    esp_err_t err = finishPendingBatch();
+    if (err != ESP_OK) {
+        return err;
+    }
+
     // do we have at least two free pages? in that case no erasing is required
     if (mFreePageList.size() >= 2) {
         return activatePage();
@@ -163,7 +197,7 @@ esp_err_t PageManager::requestNewPage()
         return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
     }
 
-    esp_err_t err = activatePage();
+    err = activatePage();
     if (err != ESP_OK) {
         return err;
     }
@@ -199,6 +233,84 @@ esp_err_t PageManager::requestNewPage()
     return ESP_OK;
 }
 
+esp_err_t PageManager::gcStep(size_t maxEntries, bool& pending)
+{
+    pending = false;
+
+    esp_err_t err = finishPendingBatch();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // with two free pages, the next page switch doesn't have to reclaim anything
+    if (mPageList.empty() || mFreePageList.size() >= 2) {
+        mGcPage = nullptr;
+        return ESP_OK;
+    }
+
+    Page& activePage = back();
+    if (mGcPage == nullptr || mGcPage->state() != Page::PageState::FULL) {
+        // same choice as requestNewPage, but the items have to fit into the active page as no free page may be used up
+        mGcPage = nullptr;
+        size_t maxUnusedItems = 0;
+        for (auto it = begin(); it != end(); ++it) {
+            if (it->state() != Page::PageState::FULL || it->getUsedEntryCount() > activePage.getFreeEntryCount()) {
+                continue;
+            }
+            auto unused = Page::ENTRY_COUNT - it->getUsedEntryCount();
+            if (unused > maxUnusedItems) {
+                mGcPage = it;
+                maxUnusedItems = unused;
+            }
+        }
+        if (mGcPage == nullptr) {
+            // nothing can be reclaimed without using up a free page, that is left to requestNewPage
+            return ESP_OK;
+        }
+    }
+
+    size_t itemIndex = 0;
+    Item item;
+    err = mGcPage->findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        // all items have been moved or erased, the erase is a step of its own
+        err = mGcPage->erase();
+        if (err != ESP_OK) {
+            return err;
+        }
+        mPageList.erase(mGcPage);
+        mFreePageList.push_back(mGcPage);
+        mGcPage = nullptr;
+        pending = mFreePageList.size() < 2;
+        return ESP_OK;
+    }
+
+    size_t movedEntries = 0;
+    while (err == ESP_OK) {
+        size_t span = isVariableLengthType(item.datatype) ? item.span : 1;
+        if (span > activePage.getFreeEntryCount()) {
+            // the active page filled up in the meantime
+            return ESP_OK;
+        }
+        // move at least one item per step, even if it is larger than maxEntries
+        if (movedEntries > 0 && movedEntries + span > maxEntries) {
+            break;
+        }
+        err = mGcPage->moveItem(itemIndex, activePage);
+        if (err != ESP_OK) {
+            return err;
+        }
+        movedEntries += span;
+        err = mGcPage->findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item);
+    }
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+
+    pending = true;
+    return ESP_OK;
+}
+
 esp_err_t PageManager::activatePage()
 {
     if (mFreePageList.empty()) {
@@ -218,6 +330,112 @@ esp_err_t PageManager::activatePage()
     return ESP_OK;
 }
 
+esp_err_t PageManager::finishBatch()
+{
+    if (mPageList.empty()) {
+        return ESP_OK;
+    }
+
+    // the whole batch including both markers is always written to one page, which stays the last one until the batch is finished
+    Page& page = back();
+    if (page.state() == Page::PageState::INVALID) {
+        // left so by a flash error, the batch is finished when the storage is initialized again
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    size_t beginIndex;
+    size_t commitIndex;
+    esp_err_t beginErr = page.findBatchMarker(Page::BATCH_BEGIN_KEY, beginIndex);
+    if (beginErr != ESP_OK && beginErr != ESP_ERR_NVS_NOT_FOUND) {
+        return beginErr;
+    }
+    esp_err_t commitErr = page.findBatchMarker(Page::BATCH_COMMIT_KEY, commitIndex);
+    if (commitErr != ESP_OK && commitErr != ESP_ERR_NVS_NOT_FOUND) {
+        return commitErr;
+    }
+
+    if (beginErr == ESP_ERR_NVS_NOT_FOUND) {
+        // power went out after the begin marker was erased, the batch is complete apart from the commit marker
+        if (commitErr == ESP_OK) {
+            auto err = page.eraseEntryAndSpan(commitIndex);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        mBatchPending = false;
+        return ESP_OK;
+    }
+
+    uint8_t indices[Page::ENTRY_COUNT];
+    size_t count = 0;
+    Item item;
+    esp_err_t err;
+    if (commitErr == ESP_ERR_NVS_NOT_FOUND) {
+        // batch is incomplete, erase everything written after the begin marker
+        for (size_t itemIndex = beginIndex + 1;
+                page.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK; itemIndex += item.span) {
+            indices[count++] = static_cast<uint8_t>(itemIndex);
+        }
+        err = page.eraseEntries(indices, count);
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else {
+        // batch is complete, erase the values it replaces, on the batch page they can only precede the begin marker
+        for (auto it = begin(); it != end(); ++it) {
+            if (it->state() == Page::PageState::FREEING) {
+                continue;
+            }
+            const size_t limit = (&*it == &page) ? beginIndex : Page::ENTRY_COUNT;
+            count = 0;
+            for (size_t batchIndex = beginIndex + 1;
+                    page.findItem(Page::NS_ANY, ItemType::ANY, nullptr, batchIndex, item) == ESP_OK && batchIndex < commitIndex;
+                    batchIndex += item.span) {
+                Item oldItem;
+                for (size_t itemIndex = 0;
+                        it->findItem(item.nsIndex, ItemType::ANY, item.key, itemIndex, oldItem, item.chunkIndex) == ESP_OK && itemIndex < limit;
+                        itemIndex += oldItem.span) {
+                    if (!batchItemReplaces(item, oldItem)) {
+                        continue;
+                    }
+                    // the data chunks and the index of a blob may find the same old entries
+                    if (std::find(indices, indices + count, itemIndex) == indices + count) {
+                        indices[count++] = static_cast<uint8_t>(itemIndex);
+                    }
+                }
+            }
+            err = it->eraseEntries(indices, count);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+
+    // the begin marker goes first, a commit marker on its own means the batch is complete
+    err = page.eraseEntryAndSpan(beginIndex);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (commitErr == ESP_OK) {
+        err = page.eraseEntryAndSpan(commitIndex);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    mBatchPending = false;
+    return ESP_OK;
+}
+
+void PageManager::setItemIndex(ItemIndex* index)
+{
+    if (!mPages) {
+        return;
+    }
+    // free pages are included as well, they start feeding the index once activated
+    for (uint32_t i = 0; i < mPageCount; ++i) {
+        mPages[i].setItemIndex(index);
+    }
+}
+
 esp_err_t PageManager::fillStats(nvs_stats_t& nvsStats)
 {
     nvsStats.used_entries      = 0;
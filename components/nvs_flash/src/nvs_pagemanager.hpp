@@ -31,7 +31,11 @@ public:
 
     PageManager() {}
 
-    esp_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount);
+    /**
+     * Loads all pages of the partition. If sectorBuffer of Page::SEC_SIZE bytes is given, every page is read with
+     * a single request into it, see Page::load.
+     */
+    esp_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, uint8_t* sectorBuffer = nullptr);
 
     TPageListIterator begin()
     {
@@ -61,6 +65,42 @@ public:
         return mBaseSector;
     }
 
+    void setItemIndex(ItemIndex* index);
+
+    /**
+     * Called by Storage::writeBatch before the begin marker is written to the last page. Until finishBatch succeeds,
+     * the batch is pending: no new page is activated and no page is reclaimed, so that the markers stay in the last
+     * page, where finishBatch looks for them on the next load.
+     */
+    void beginBatch()
+    {
+        mBatchPending = true;
+    }
+
+    /**
+     * Completes the batch of items bracketed by the begin and commit markers in the last page, see Storage::writeBatch.
+     * If the commit marker is missing, the items written after the begin marker are erased. Otherwise the older
+     * values of the batch items, of the types Storage::writeItem would replace, are erased from all other pages.
+     * Both markers are erased at the end.
+     * Does nothing if there is no begin marker.
+     */
+    esp_err_t finishBatch();
+
+    /**
+     * Retries finishBatch for a batch left pending by a flash error, before anything else is written.
+     */
+    esp_err_t finishPendingBatch()
+    {
+        return mBatchPending ? finishBatch() : ESP_OK;
+    }
+
+    /**
+     * Does a bounded part of the page reclaim requestNewPage would otherwise do synchronously once fewer than two
+     * pages are free: moves items of at most maxEntries entries from the page with the most unused entries to the
+     * active page, or erases that page once all items have left it. pending is set if another step can make progress.
+     */
+    esp_err_t gcStep(size_t maxEntries, bool& pending);
+
 protected:
     friend class Iterator;
 
@@ -72,6 +112,8 @@ protected:
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+    Page* mGcPage = nullptr;
+    bool mBatchPending = false;
 }; // class PageManager
 
 
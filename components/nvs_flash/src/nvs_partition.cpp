@@ -56,6 +56,21 @@ esp_err_t NVSPartition::erase_range(size_t dst_offset, size_t size)
     return esp_partition_erase_range(mESPPartition, dst_offset, size);
 }
 
+esp_err_t NVSPartition::mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle)
+{
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(mESPPartition, src_offset, size, ESP_PARTITION_MMAP_DATA, out_ptr, &handle);
+    if (err == ESP_OK) {
+        *out_handle = handle;
+    }
+    return err;
+}
+
+void NVSPartition::munmap(uint32_t handle)
+{
+    esp_partition_munmap(handle);
+}
+
 uint32_t NVSPartition::get_address()
 {
     return mESPPartition->address;
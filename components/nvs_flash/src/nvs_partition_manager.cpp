@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,6 +7,7 @@
 #include "nvs_partition_manager.hpp"
 #include "nvs_partition_lookup.hpp"
 #include "nvs_internal.h"
+#include "nvs_platform.hpp"
 
 #ifndef LINUX_TARGET
 #include "nvs_encrypted_partition.hpp"
@@ -67,6 +68,93 @@ error:
     delete p;
     return result;
 }
+
+namespace {
+
+struct PartitionInitJob {
+    NVSPartition *partition;
+    Storage *storage;
+    uint32_t sectorCount;
+    esp_err_t result;
+};
+
+void init_storage_job(void *arg, size_t index)
+{
+    PartitionInitJob &job = static_cast<PartitionInitJob*>(arg)[index];
+    job.result = job.storage->init(0, job.sectorCount);
+}
+
+} // namespace
+
+esp_err_t NVSPartitionManager::init_partitions(const char *const *partition_labels, size_t count)
+{
+    const uint32_t sec_size = esp_partition_get_main_flash_sector_size();
+    NVS_ASSERT_OR_RETURN(sec_size != 0, ESP_FAIL);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (partition_labels[i] == nullptr || strlen(partition_labels[i]) > NVS_PART_NAME_MAX_SIZE) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    unique_ptr<PartitionInitJob[]> jobs(new (std::nothrow) PartitionInitJob[count]);
+    if (!jobs) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // look up all partitions first, only the loading of the pages runs concurrently
+    esp_err_t result = ESP_OK;
+    size_t jobCount = 0;
+    for (size_t i = 0; i < count && result == ESP_OK; ++i) {
+        const char *label = partition_labels[i];
+        bool initialized = lookup_storage_from_name(label) != nullptr;
+        for (size_t j = 0; j < jobCount && !initialized; ++j) {
+            initialized = strcmp(jobs[j].partition->get_partition_name(), label) == 0;
+        }
+        if (initialized) {
+            continue;
+        }
+
+        NVSPartition *p = nullptr;
+        result = partition_lookup::lookup_nvs_partition(label, &p);
+        if (result != ESP_OK) {
+            break;
+        }
+        Storage *storage = new (std::nothrow) Storage(p);
+        if (storage == nullptr) {
+            delete p;
+            result = ESP_ERR_NO_MEM;
+            break;
+        }
+        jobs[jobCount++] = {p, storage, p->get_size() / sec_size, ESP_OK};
+    }
+
+    if (result != ESP_OK) {
+        for (size_t i = 0; i < jobCount; ++i) {
+            delete jobs[i].storage;
+            delete jobs[i].partition;
+        }
+        return result;
+    }
+
+    run_concurrently(init_storage_job, jobs.get(), jobCount);
+
+    // keep the partitions which loaded successfully, as if they were initialized one by one
+    for (size_t i = 0; i < jobCount; ++i) {
+        if (jobs[i].result == ESP_OK) {
+            nvs_storage_list.push_back(jobs[i].storage);
+            nvs_partition_list.push_back(jobs[i].partition);
+            continue;
+        }
+        if (result == ESP_OK) {
+            result = jobs[i].result;
+        }
+        delete jobs[i].storage;
+        delete jobs[i].partition;
+    }
+
+    return result;
+}
 #endif // ESP_PLATFORM
 
 esp_err_t NVSPartitionManager::init_custom(Partition *partition, uint32_t baseSector, uint32_t sectorCount)
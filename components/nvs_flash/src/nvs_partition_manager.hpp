@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -22,6 +22,12 @@ public:
 
     esp_err_t init_partition(const char *partition_label);
 
+    /**
+     * Same as init_partition for every label, the partitions are loaded concurrently, see nvs::run_concurrently.
+     * Partitions which are initialized already are skipped, the first error is returned.
+     */
+    esp_err_t init_partitions(const char *const *partition_labels, size_t count);
+
     esp_err_t init_custom(Partition *partition, uint32_t baseSector, uint32_t sectorCount);
 
     esp_err_t secure_init_partition(const char *part_name, nvs_sec_cfg_t* cfg);
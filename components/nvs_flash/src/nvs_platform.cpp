@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -12,9 +12,20 @@ Lock::Lock() {}
 Lock::~Lock() {}
 esp_err_t nvs::Lock::init() {return ESP_OK;}
 void Lock::uninit() {}
+
+void nvs::run_concurrently(void (*fn)(void* arg, size_t index), void* arg, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        fn(arg, i);
+    }
+}
 #else
 
+#include <new>
 #include "sys/lock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 Lock::Lock()
 {
@@ -47,4 +58,60 @@ void Lock::uninit()
 
 _lock_t Lock::mSemaphore = 0;
 
+namespace {
+
+struct ConcurrentCall {
+    void (*fn)(void* arg, size_t index);
+    void* arg;
+    size_t index;
+    SemaphoreHandle_t done;
+};
+
+// stack of the tasks started by run_concurrently, enough for loading a partition
+const uint32_t CONCURRENT_CALL_STACK_SIZE = 4096;
+
+void concurrent_call_task(void* param)
+{
+    ConcurrentCall* call = static_cast<ConcurrentCall*>(param);
+    call->fn(call->arg, call->index);
+    xSemaphoreGive(call->done);
+    vTaskDelete(nullptr);
+}
+
+} // namespace
+
+void nvs::run_concurrently(void (*fn)(void* arg, size_t index), void* arg, size_t count)
+{
+    ConcurrentCall* calls = nullptr;
+    SemaphoreHandle_t done = nullptr;
+    if (count > 1) {
+        calls = new (std::nothrow) ConcurrentCall[count];
+        done = xSemaphoreCreateCounting(count, 0);
+    }
+
+    size_t started = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (calls && done) {
+            calls[i] = {fn, arg, i, done};
+            if (xTaskCreate(concurrent_call_task, "nvs_init", CONCURRENT_CALL_STACK_SIZE, &calls[i],
+                            uxTaskPriorityGet(nullptr), nullptr) == pdPASS) {
+                ++started;
+                continue;
+            }
+        }
+        fn(arg, i);
+    }
+    if (count > 0) {
+        fn(arg, 0);
+    }
+
+    for (size_t i = 0; i < started; ++i) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    if (done) {
+        vSemaphoreDelete(done);
+    }
+    delete[] calls;
+}
+
 #endif
@@ -1,10 +1,11 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #pragma once
 
+#include <cstddef>
 #include "esp_err.h"
 #ifndef LINUX_TARGET
 #include <sys/lock.h>
@@ -24,4 +25,11 @@ namespace nvs
         static _lock_t mSemaphore;
 #endif
     };
+
+    /**
+     * Calls fn(arg, index) for every index below count and returns when all calls have returned.
+     * On FreeRTOS, all calls but the first run on tasks of their own with the priority of the caller,
+     * elsewhere or if a task can't be created, they run one after another in the calling task.
+     */
+    void run_concurrently(void (*fn)(void* arg, size_t index), void* arg, size_t count);
 } // namespace nvs
@@ -49,10 +49,13 @@ void Storage::clearNamespaces()
     mNamespaces.clearAndFreeNodes();
 }
 
-esp_err_t Storage::populateBlobIndices(TBlobIndexList& blobIdxList)
+esp_err_t Storage::populateBlobIndices(TBlobIndexList& blobIdxList, uint8_t* sectorBuffer)
 {
     for(auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
+        if(sectorBuffer) {
+            p.attachSectorBuffer(sectorBuffer);
+        }
         size_t itemIndex = 0;
         Item item;
 
@@ -76,6 +79,7 @@ esp_err_t Storage::populateBlobIndices(TBlobIndexList& blobIdxList)
             blobIdxList.push_back(entry);
             itemIndex += item.span;
         }
+        p.detachSectorBuffer();
     }
 
     return ESP_OK;
@@ -87,10 +91,13 @@ esp_err_t Storage::populateBlobIndices(TBlobIndexList& blobIdxList)
 // or wrong number of chunks are checked. Mismatched BLOB_INDEX data are deleted
 // and removed from the blobIdxList. The BLOB_DATA are left as orphans and removed
 // later by the call to eraseOrphanDataBlobs().
-void Storage::eraseMismatchedBlobIndexes(TBlobIndexList& blobIdxList)
+void Storage::eraseMismatchedBlobIndexes(TBlobIndexList& blobIdxList, uint8_t* sectorBuffer)
 {
     for(auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
+        if(sectorBuffer) {
+            p.attachSectorBuffer(sectorBuffer);
+        }
         size_t itemIndex = 0;
         Item item;
         /* Chunks with same <ns,key> and with chunkIndex in the following ranges
@@ -114,6 +121,7 @@ void Storage::eraseMismatchedBlobIndexes(TBlobIndexList& blobIdxList)
             }
             itemIndex += item.span;
         }
+        p.detachSectorBuffer();
     }
 
     auto iter = blobIdxList.begin();
@@ -151,10 +159,14 @@ void Storage::eraseMismatchedBlobIndexes(TBlobIndexList& blobIdxList)
     }
 }
 
-void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
+void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList, uint8_t* sectorBuffer)
 {
     for(auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
+        if(sectorBuffer) {
+            // items are only erased during the scan, which keeps the buffer valid
+            p.attachSectorBuffer(sectorBuffer);
+        }
         size_t itemIndex = 0;
         Item item;
         /* Chunks with same <ns,key> and with chunkIndex in the following ranges
@@ -177,28 +189,52 @@ void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
 
             itemIndex += item.span;
         }
+        p.detachSectorBuffer();
     }
 }
 
 esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 {
-    auto err = mPageManager.load(mPartition, baseSector, sectorCount);
+    // the index refers to Page objects which are re-created by the page manager
+    mItemIndexActive = false;
+    mItemIndex.clear();
+
+    // every page is read with one request into this buffer, both when it is loaded and when it is scanned below
+    std::unique_ptr<uint8_t[]> sectorBuffer;
+    if(mReadWholePages) {
+        sectorBuffer.reset(new (std::nothrow) uint8_t[Page::SEC_SIZE]);
+    }
+
+    auto err = mPageManager.load(mPartition, baseSector, sectorCount, sectorBuffer.get());
     if(err != ESP_OK) {
         mState = StorageState::INVALID;
         return err;
     }
 
+    if(mItemIndexRequested) {
+        mPageManager.setItemIndex(&mItemIndex);
+        mItemIndexActive = true;
+    }
+
     // load namespaces list
     clearNamespaces();
     std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
     for(auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
+        if(sectorBuffer) {
+            p.attachSectorBuffer(sectorBuffer.get());
+        }
         size_t itemIndex = 0;
         Item item;
-        while(p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == ESP_OK) {
+        while(true) {
+            err = p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item);
+            if(err != ESP_OK) {
+                break;
+            }
             NamespaceEntry* entry = new (std::nothrow) NamespaceEntry;
 
             if(!entry) {
+                p.detachSectorBuffer();
                 mState = StorageState::INVALID;
                 return ESP_ERR_NO_MEM;
             }
@@ -206,16 +242,19 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
             item.getKey(entry->mName, sizeof(entry->mName));
             err = item.getValue(entry->mIndex);
             if(err != ESP_OK) {
+                p.detachSectorBuffer();
                 delete entry;
                 return err;
             }
             if(mNamespaceUsage.set(entry->mIndex, true) != ESP_OK) {
+                p.detachSectorBuffer();
                 delete entry;
                 return ESP_FAIL;
             }
             mNamespaces.push_back(entry);
             itemIndex += item.span;
         }
+        p.detachSectorBuffer();
     }
     if(mNamespaceUsage.set(0, true) != ESP_OK) {
         return ESP_FAIL;
@@ -226,17 +265,17 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 
     // Populate list of multi-page index entries.
     TBlobIndexList blobIdxList;
-    err = populateBlobIndices(blobIdxList);
+    err = populateBlobIndices(blobIdxList, sectorBuffer.get());
     if(err != ESP_OK) {
         mState = StorageState::INVALID;
         return ESP_ERR_NO_MEM;
     }
 
     // remove blob indexes with mismatched blob data length or chunk count
-    eraseMismatchedBlobIndexes(blobIdxList);
+    eraseMismatchedBlobIndexes(blobIdxList, sectorBuffer.get());
 
     // Remove the entries for which there is no parent multi-page index.
-    eraseOrphanDataBlobs(blobIdxList);
+    eraseOrphanDataBlobs(blobIdxList, sectorBuffer.get());
 
     // Purge the blob index list
     blobIdxList.clearAndFreeNodes();
@@ -256,6 +295,59 @@ bool Storage::isValid() const
 
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart, size_t* itemIndex)
 {
+    // The index can be used for the same lookups the per-page hash lists serve, see Page::findItem
+    if(isItemIndexActive() && nsIndex != Page::NS_ANY && key != nullptr
+            && (datatype != ItemType::BLOB_DATA || chunkIdx != Page::CHUNK_ANY)) {
+        struct Candidate {
+            Page* page;
+            uint32_t seqNumber;
+            size_t index;
+        };
+        Candidate candidates[ITEM_INDEX_MAX_CANDIDATES];
+        size_t count = 0;
+        bool overflow = false;
+
+        mItemIndex.forEach(HashList::hashOf(Item(nsIndex, datatype, 0, key, chunkIdx)), [&](Page* p, size_t index) -> bool {
+            for(size_t i = 0; i < count; ++i) {
+                if(candidates[i].page == p) {
+                    candidates[i].index = std::min(candidates[i].index, index);
+                    return true;
+                }
+            }
+            uint32_t seqNumber;
+            if(p->getSeqNumber(seqNumber) != ESP_OK) {
+                // page not in use, it can't contain the item
+                return true;
+            }
+            if(count == ITEM_INDEX_MAX_CANDIDATES) {
+                overflow = true;
+                return false;
+            }
+            candidates[count++] = {p, seqNumber, index};
+            return true;
+        });
+
+        if(!overflow) {
+            // Visit the candidate pages in the order of the page list, i.e. by sequence number, so that
+            // the same item is returned as by the page by page search below.
+            std::sort(candidates, candidates + count, [](const Candidate& a, const Candidate& b) {
+                return a.seqNumber < b.seqNumber;
+            });
+            for(size_t i = 0; i < count; ++i) {
+                size_t tmpItemIndex = candidates[i].index;
+                auto err = candidates[i].page->findItem(nsIndex, datatype, key, tmpItemIndex, item, chunkIdx, chunkStart);
+                if(err == ESP_OK) {
+                    page = candidates[i].page;
+                    if(itemIndex) {
+                        *itemIndex = tmpItemIndex;
+                    }
+                    return ESP_OK;
+                }
+            }
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+    }
+
     for(auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t tmpItemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, tmpItemIndex, item, chunkIdx, chunkStart);
@@ -383,6 +475,11 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    esp_err_t batchErr = mPageManager.finishPendingBatch();
+    if(batchErr != ESP_OK) {
+        return batchErr;
+    }
+
     // pointer to the page where the existing item was found
     Page* findPage = nullptr;
     // index of the item in the page where the existing item was found
@@ -574,6 +671,223 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
     return err;
 }
 
+esp_err_t Storage::writeBatch(uint8_t nsIndex, const BatchItem* items, size_t count)
+{
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    esp_err_t batchErr = mPageManager.finishPendingBatch();
+    if(batchErr != ESP_OK) {
+        return batchErr;
+    }
+
+    if(items == nullptr && count != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Validate the whole batch before anything is written
+    for(size_t i = 0; i < count; ++i) {
+        const BatchItem& batchItem = items[i];
+        if(batchItem.key == nullptr || (batchItem.data == nullptr && batchItem.dataSize != 0)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if(strlen(batchItem.key) > Item::MAX_KEY_LENGTH) {
+            return ESP_ERR_NVS_KEY_TOO_LONG;
+        }
+        switch(batchItem.datatype) {
+        case ItemType::U8:
+        case ItemType::I8:
+        case ItemType::U16:
+        case ItemType::I16:
+        case ItemType::U32:
+        case ItemType::I32:
+        case ItemType::U64:
+        case ItemType::I64:
+            if(batchItem.dataSize > sizeof(Item::data)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            break;
+        case ItemType::SZ:
+        case ItemType::BLOB:
+            if(batchItem.dataSize > Page::CHUNK_MAX_SIZE) {
+                return ESP_ERR_NVS_VALUE_TOO_LONG;
+            }
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+        }
+        // each key may appear only once, which of its values wins would be up to the order of the lookups otherwise
+        for(size_t j = 0; j < i; ++j) {
+            if(strncmp(batchItem.key, items[j].key, Item::MAX_KEY_LENGTH) == 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+
+    struct StagedItem {
+        // datatype of the value being replaced, ANY if there is none, and the version of its chunks if it is a multi-page blob
+        ItemType oldDatatype;
+        VerOffset oldChunkStart;
+        // version of the chunk of a blob being written and the data of its index
+        VerOffset chunkStart;
+        Item blobIndex;
+        bool unchanged;
+    };
+
+    std::unique_ptr<StagedItem[]> staged(new (std::nothrow) StagedItem[count]);
+    // blobs take two items, the data chunk and the index
+    std::unique_ptr<Page::NewItem[]> newItems(new (std::nothrow) Page::NewItem[2 * count]);
+    if(count != 0 && (!staged || !newItems)) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err;
+    size_t entriesNeeded = 2;
+    size_t newItemCount = 0;
+    for(size_t i = 0; i < count; ++i) {
+        const BatchItem& batchItem = items[i];
+        StagedItem& stagedItem = staged[i];
+        Page* findPage = nullptr;
+        Item item;
+        bool matchedTypePageFound = false;
+
+        stagedItem.oldDatatype = ItemType::ANY;
+        stagedItem.oldChunkStart = VerOffset::VER_ANY;
+        stagedItem.chunkStart = VerOffset::VER_0_OFFSET;
+        stagedItem.unchanged = false;
+
+        // Look up the value being replaced the same way as writeItem does
+        ItemType findType = (batchItem.datatype == ItemType::BLOB) ? ItemType::BLOB_IDX : batchItem.datatype;
+        err = findItem(nsIndex, findType, batchItem.key, findPage, item);
+        if(err == ESP_OK && findPage != nullptr) {
+            matchedTypePageFound = true;
+        }
+#ifndef CONFIG_NVS_LEGACY_DUP_KEYS_COMPATIBILITY
+        if(findPage == nullptr) {
+            err = findItem(nsIndex, nvs::ItemType::ANY, batchItem.key, findPage, item);
+        }
+#endif
+        if(err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+        if(findPage != nullptr) {
+            stagedItem.oldDatatype = item.datatype;
+            if(item.datatype == ItemType::BLOB_IDX) {
+                stagedItem.oldChunkStart = item.blobIndex.chunkStart;
+            }
+        }
+
+        if(batchItem.datatype == ItemType::BLOB) {
+            if(matchedTypePageFound) {
+                if(cmpMultiPageBlob(nsIndex, batchItem.key, batchItem.data, batchItem.dataSize) == ESP_OK) {
+                    stagedItem.unchanged = true;
+                    continue;
+                }
+                NVS_ASSERT_OR_RETURN(stagedItem.oldChunkStart == VerOffset::VER_0_OFFSET
+                        || stagedItem.oldChunkStart == VerOffset::VER_1_OFFSET, ESP_FAIL);
+                stagedItem.chunkStart = (stagedItem.oldChunkStart == VerOffset::VER_1_OFFSET)
+                        ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
+            }
+            Item& blobIndex = stagedItem.blobIndex;
+            std::fill_n(blobIndex.data, sizeof(blobIndex.data), 0xff);
+            blobIndex.blobIndex.dataSize = batchItem.dataSize;
+            blobIndex.blobIndex.chunkCount = 1;
+            blobIndex.blobIndex.chunkStart = stagedItem.chunkStart;
+            newItems[newItemCount++] = {nsIndex, ItemType::BLOB_DATA, batchItem.key, batchItem.data, batchItem.dataSize,
+                    static_cast<uint8_t>(stagedItem.chunkStart)};
+            newItems[newItemCount++] = {nsIndex, ItemType::BLOB_IDX, batchItem.key, blobIndex.data, sizeof(blobIndex.data),
+                    Page::CHUNK_ANY};
+            entriesNeeded += 2 + (batchItem.dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+        } else {
+            if(matchedTypePageFound &&
+                    findPage->cmpItem(nsIndex, batchItem.datatype, batchItem.key, batchItem.data, batchItem.dataSize) == ESP_OK) {
+                stagedItem.unchanged = true;
+                continue;
+            }
+            newItems[newItemCount++] = {nsIndex, batchItem.datatype, batchItem.key, batchItem.data, batchItem.dataSize, Page::CHUNK_ANY};
+            entriesNeeded += 1;
+            if(batchItem.datatype == ItemType::SZ) {
+                entriesNeeded += (batchItem.dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+            }
+        }
+    }
+
+    if(newItemCount == 0) {
+        // everything is up to date already
+        return ESP_OK;
+    }
+
+    if(entriesNeeded > Page::ENTRY_COUNT) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    // The whole batch goes to one page, request new pages until it fits
+    for(uint32_t attempt = 0; getCurrentPage().getFreeEntryCount() < entriesNeeded; ++attempt) {
+        if(attempt >= mPageManager.getPageCount()) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        Page& page = getCurrentPage();
+        if(page.state() != Page::PageState::FULL) {
+            err = page.markFull();
+            if(err != ESP_OK) {
+                return err;
+            }
+        }
+        err = mPageManager.requestNewPage();
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Write the batch between the markers. Nothing below may request a new page.
+    Page& page = getCurrentPage();
+    uint32_t markerValue = static_cast<uint32_t>(newItemCount);
+    mPageManager.beginBatch();
+    err = page.writeItem(Page::BATCH_MARKER_NS, ItemType::U32, Page::BATCH_BEGIN_KEY,
+            &markerValue, sizeof(markerValue), Page::BATCH_MARKER_CHUNK);
+    if(err == ESP_OK) {
+        err = page.writeItems(newItems.get(), newItemCount);
+    }
+    if(err == ESP_OK) {
+        err = page.writeItem(Page::BATCH_MARKER_NS, ItemType::U32, Page::BATCH_COMMIT_KEY,
+                &markerValue, sizeof(markerValue), Page::BATCH_MARKER_CHUNK);
+    }
+    if(err != ESP_OK) {
+        // Without the commit marker this erases whatever part of the batch made it to flash.
+        // If the flash fails again, the next write or the next initialization does the same.
+        mPageManager.finishBatch();
+        NVS_ASSERT_OR_RETURN(err != ESP_ERR_NVS_PAGE_FULL, err);
+        return err;
+    }
+
+    // The batch is committed now. Multi-page blobs being replaced are erased here together with all their chunks,
+    // any other replaced value is erased by finishBatch.
+    for(size_t i = 0; i < count; ++i) {
+        const StagedItem& stagedItem = staged[i];
+        if(stagedItem.unchanged || stagedItem.oldDatatype != ItemType::BLOB_IDX) {
+            continue;
+        }
+        err = eraseMultiPageBlob(nsIndex, items[i].key, stagedItem.oldChunkStart);
+        if(err == ESP_ERR_FLASH_OP_FAIL) {
+            return ESP_ERR_NVS_REMOVE_FAILED;
+        }
+        if(err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+    }
+
+    err = mPageManager.finishBatch();
+    if(err == ESP_ERR_FLASH_OP_FAIL) {
+        return ESP_ERR_NVS_REMOVE_FAILED;
+    }
+
+#ifdef DEBUG_STORAGE
+    debugCheck();
+#endif
+    return err;
+}
+
 esp_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uint8_t& nsIndex)
 {
     if(mState != StorageState::ACTIVE) {
@@ -627,7 +941,7 @@ esp_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uin
     return ESP_OK;
 }
 
-esp_err_t Storage::readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize)
+esp_err_t Storage::readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize, bool mapChunks)
 {
     Item item;
     Page* findPage = nullptr;
@@ -663,7 +977,18 @@ esp_err_t Storage::readMultiPageBlob(uint8_t nsIndex, const char* key, void* dat
             break;
         }
 
-        err = findPage->readVariableLengthItemData(item, itemIndex, static_cast<uint8_t*>(data) + offset);
+        if(mapChunks && item.varLength.dataSize != 0) {
+            // one copy of the whole chunk instead of one flash read per entry
+            const void* chunkData = nullptr;
+            uint32_t mapHandle = 0;
+            err = findPage->mapVariableLengthItemData(item, itemIndex, &chunkData, &mapHandle);
+            if(err == ESP_OK) {
+                memcpy(static_cast<uint8_t*>(data) + offset, chunkData, item.varLength.dataSize);
+                mPartition->munmap(mapHandle);
+            }
+        } else {
+            err = findPage->readVariableLengthItemData(item, itemIndex, static_cast<uint8_t*>(data) + offset);
+        }
         if(err != ESP_OK) {
             return err;
         }
@@ -762,6 +1087,61 @@ esp_err_t Storage::readItem(uint8_t nsIndex, ItemType datatype, const char* key,
 
 }
 
+esp_err_t Storage::readBlobMapped(uint8_t nsIndex, const char* key, void* data, size_t dataSize)
+{
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    auto err = readMultiPageBlob(nsIndex, key, data, dataSize, true);
+    if(err != ESP_ERR_NOT_SUPPORTED && err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    // the partition can't be mapped or the blob is stored with earlier version format without index
+    return readItem(nsIndex, ItemType::BLOB, key, data, dataSize);
+}
+
+esp_err_t Storage::mapBlob(uint8_t nsIndex, const char* key, const void*& data, size_t& dataSize, uint32_t& handle)
+{
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    Item item;
+    Page* findPage = nullptr;
+    size_t itemIndex = 0;
+
+    auto err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if(err == ESP_OK) {
+        if(item.blobIndex.chunkCount != 1 || item.blobIndex.dataSize == 0) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        size_t blobSize = item.blobIndex.dataSize;
+        uint8_t chunkIdx = static_cast<uint8_t> (item.blobIndex.chunkStart);
+        err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, chunkIdx, nvs::VerOffset::VER_ANY, &itemIndex);
+        if(err == ESP_ERR_NVS_NOT_FOUND || (err == ESP_OK && item.varLength.dataSize != blobSize)) {
+            // inconsistent blob, leave the cleanup to readMultiPageBlob
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    } else if(err == ESP_ERR_NVS_NOT_FOUND) {
+        // blob stored with earlier version format without index, the data is in a single page as well
+        err = findItem(nsIndex, ItemType::BLOB, key, findPage, item, Page::CHUNK_ANY, nvs::VerOffset::VER_ANY, &itemIndex);
+        if(err == ESP_OK && item.varLength.dataSize == 0) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    err = findPage->mapVariableLengthItemData(item, itemIndex, &data, &handle);
+    if(err != ESP_OK) {
+        return err;
+    }
+    dataSize = item.varLength.dataSize;
+    return ESP_OK;
+}
+
 esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffset chunkStart)
 {
     if(mState != StorageState::ACTIVE) {
@@ -869,6 +1249,11 @@ esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    esp_err_t batchErr = mPageManager.finishPendingBatch();
+    if(batchErr != ESP_OK) {
+        return batchErr;
+    }
+
     Item item;
     Page* findPage = nullptr;
     esp_err_t err = ESP_OK;
@@ -892,6 +1277,11 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    esp_err_t batchErr = mPageManager.finishPendingBatch();
+    if(batchErr != ESP_OK) {
+        return batchErr;
+    }
+
     for(auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         while(true) {
             auto err = it->eraseItem(nsIndex, ItemType::ANY, nullptr);
@@ -997,6 +1387,18 @@ esp_err_t Storage::fillStats(nvs_stats_t& nvsStats)
     return mPageManager.fillStats(nvsStats);
 }
 
+esp_err_t Storage::gcStep(size_t maxEntries, bool& pending)
+{
+    pending = false;
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if(mPartition->get_readonly()) {
+        return ESP_OK;
+    }
+    return mPageManager.gcStep(maxEntries, pending);
+}
+
 esp_err_t Storage::calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries)
 {
     usedEntries = 0;
@@ -1065,6 +1467,7 @@ bool Storage::findEntryNs(nvs_opaque_iterator_t* it, uint8_t nsIndex)
 inline bool isIterableItem(Item& item)
 {
     return (item.nsIndex != 0 &&
+            item.nsIndex != Page::BATCH_MARKER_NS &&
             item.datatype != ItemType::BLOB &&
             item.datatype != ItemType::BLOB_IDX);
 }
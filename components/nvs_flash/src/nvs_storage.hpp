@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -13,6 +13,7 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_item_index.hpp"
 #include "nvs_memory_management.hpp"
 #include "partition.hpp"
 
@@ -72,8 +73,35 @@ public:
 
     esp_err_t writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
 
+    struct BatchItem {
+        ItemType datatype;
+        const char* key;
+        const void* data;
+        size_t dataSize;
+    };
+
+    /**
+     * Writes all items in one page, bracketed by the begin and commit markers of PageManager, and erases the values
+     * they replace afterwards. If the write is interrupted, PageManager::load undoes or completes the whole batch.
+     * Supported types are the primitive ones, SZ and BLOB; blobs are written as a single chunk.
+     */
+    esp_err_t writeBatch(uint8_t nsIndex, const BatchItem* items, size_t count);
+
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize);
 
+    /**
+     * Maps the data of a blob stored in a single chunk instead of copying it, see Page::mapVariableLengthItemData.
+     * Returns ESP_ERR_NOT_SUPPORTED if the blob spans several chunks, is empty or the partition can't be mapped,
+     * the caller reads a copy with readItem then.
+     */
+    esp_err_t mapBlob(uint8_t nsIndex, const char* key, const void*& data, size_t& dataSize, uint32_t& handle);
+
+    /**
+     * Same as readItem for a blob, but every data chunk is copied from the mapped partition at once instead of
+     * being read entry by entry. Falls back to readItem if the partition can't be mapped.
+     */
+    esp_err_t readBlobMapped(uint8_t nsIndex, const char* key, void* data, size_t dataSize);
+
     esp_err_t findKey(const uint8_t nsIndex, const char* key, ItemType* datatype);
 
     esp_err_t getItemDataSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize);
@@ -116,7 +144,7 @@ public:
 
     esp_err_t writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart);
 
-    esp_err_t readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize);
+    esp_err_t readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize, bool mapChunks = false);
 
     esp_err_t cmpMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize);
 
@@ -128,6 +156,11 @@ public:
 
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
+    /**
+     * See PageManager::gcStep, does nothing for read-only partitions.
+     */
+    esp_err_t gcStep(size_t maxEntries, bool& pending);
+
     esp_err_t calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries);
 
     bool findEntry(nvs_opaque_iterator_t* it, const char* name);
@@ -136,6 +169,35 @@ public:
 
     bool nextEntry(nvs_opaque_iterator_t* it);
 
+    /**
+     * Enables or disables the RAM-resident index of all items across pages. Takes effect on the next init().
+     * The default is given by CONFIG_NVS_STORAGE_KEY_INDEX.
+     */
+    void setItemIndexEnabled(bool enabled)
+    {
+        mItemIndexRequested = enabled;
+    }
+
+    bool isItemIndexActive() const
+    {
+        return mItemIndexActive && mItemIndex.isValid();
+    }
+
+    size_t getItemIndexSize() const
+    {
+        return mItemIndex.size();
+    }
+
+    /**
+     * Enables or disables reading every page with a single request in init(), both when pages are loaded and when
+     * their items are scanned for namespaces and blobs, see Page::attachSectorBuffer.
+     * The default is given by CONFIG_NVS_FAST_INIT.
+     */
+    void setReadWholePages(bool enabled)
+    {
+        mReadWholePages = enabled;
+    }
+
 protected:
 
     Page& getCurrentPage()
@@ -145,16 +207,19 @@ protected:
 
     void clearNamespaces();
 
-    esp_err_t populateBlobIndices(TBlobIndexList&);
+    esp_err_t populateBlobIndices(TBlobIndexList&, uint8_t* sectorBuffer = nullptr);
 
-    void eraseMismatchedBlobIndexes(TBlobIndexList&);
+    void eraseMismatchedBlobIndexes(TBlobIndexList&, uint8_t* sectorBuffer = nullptr);
 
-    void eraseOrphanDataBlobs(TBlobIndexList&);
+    void eraseOrphanDataBlobs(TBlobIndexList&, uint8_t* sectorBuffer = nullptr);
 
     void fillEntryInfo(Item &item, nvs_entry_info_t &info);
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY, size_t* itemIndex = NULL);
 
+    // Maximum number of distinct pages holding the same item hash the indexed lookup handles, more fall back to the scan
+    static const size_t ITEM_INDEX_MAX_CANDIDATES = 8;
+
 protected:
     Partition *mPartition;
     size_t mPageCount;
@@ -162,6 +227,18 @@ protected:
     TNamespaces mNamespaces;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
     StorageState mState = StorageState::INVALID;
+    ItemIndex mItemIndex;
+#ifdef CONFIG_NVS_STORAGE_KEY_INDEX
+    bool mItemIndexRequested = true;
+#else
+    bool mItemIndexRequested = false;
+#endif
+    bool mItemIndexActive = false;
+#ifdef CONFIG_NVS_FAST_INIT
+    bool mReadWholePages = true;
+#else
+    bool mReadWholePages = false;
+#endif
 };
 
 } // namespace nvs
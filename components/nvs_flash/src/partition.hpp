@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2019-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2019-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -35,6 +35,17 @@ public:
 
     virtual esp_err_t erase_range(size_t dst_offset, size_t size) = 0;
 
+    /**
+     * Map size bytes at src_offset read-only into the data address space, the handle is released with munmap.
+     * Partitions which can't be mapped or which transform the data on read return ESP_ERR_NOT_SUPPORTED.
+     */
+    virtual esp_err_t mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    virtual void munmap(uint32_t handle) { }
+
     /**
      * Return the address of the beginning of the partition.
      */
@@ -49,6 +60,14 @@ public:
      * Return true if the partition is read-only.
      */
     virtual bool get_readonly() = 0;
+
+    /**
+     * Return true if read() decrypts the data, i.e. it differs from what read_raw() returns.
+     */
+    virtual bool get_encrypted()
+    {
+        return false;
+    }
 };
 
 } // nvs